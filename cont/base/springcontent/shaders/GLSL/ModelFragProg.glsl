@@ -27,11 +27,6 @@ uniform float specularExponent;
 uniform float gammaExponent;
 
 uniform vec4 fogColor;
-// in opaque passes tc.a is always 1.0 [all objects], and alphaPass is 0.0
-// in alpha passes tc.a is either one of alphaValues.xyzw [for units] *or*
-// contains a distance fading factor [for features], and alphaPass is 1.0
-// texture alpha-masking is done in both passes
-uniform vec4 teamColor;
 uniform vec4 nanoColor;
 // uniform float alphaPass;
 
@@ -47,6 +42,13 @@ in vec3 cameraDir;
 in vec2 texCoord0;
 // in vec2 texCoord1;
 
+// in opaque passes tc.a is always 1.0 [all objects], and alphaPass is 0.0
+// in alpha passes tc.a is either one of alphaValues.xyzw [for units] *or*
+// contains a distance fading factor [for features], and alphaPass is 1.0
+// texture alpha-masking is done in both passes
+// (either the teamColor uniform or per-instance data, see vertex shader)
+flat in vec4 instTeamColor;
+
 in float fogFactor;
 
 #ifdef use_normalmapping
@@ -154,7 +156,7 @@ void main(void)
 
 
 	float shadow = GetShadowCoeff(-0.00005);
-	float alpha = teamColor.a * shadingColor.a; // apply one-bit mask
+	float alpha = instTeamColor.a * shadingColor.a; // apply one-bit mask
 
 	#if (DEFERRED_MODE == 0)
 	float alphaTestGreater = float(alpha > alphaTestCtrl.x) * alphaTestCtrl.y;
@@ -175,7 +177,7 @@ void main(void)
 
 	#if (DEFERRED_MODE == 0)
 	fragColor     = diffuseColor;
-	fragColor.rgb = mix(fragColor.rgb, teamColor.rgb, fragColor.a); // teamcolor
+	fragColor.rgb = mix(fragColor.rgb, instTeamColor.rgb, fragColor.a); // teamcolor
 	fragColor.rgb = fragColor.rgb * reflectColor + specularColor;
 	#endif
 
@@ -185,10 +187,10 @@ void main(void)
 
 	#if (DEFERRED_MODE == 1)
 	fragData[GBUFFER_NORMTEX_IDX] = vec4((wsNormal + vec3(1.0, 1.0, 1.0)) * 0.5, 1.0);
-	fragData[GBUFFER_DIFFTEX_IDX] = vec4(mix(                 diffuseColor.rgb, teamColor.rgb, diffuseColor.a), alpha);
+	fragData[GBUFFER_DIFFTEX_IDX] = vec4(mix(                 diffuseColor.rgb, instTeamColor.rgb, diffuseColor.a), alpha);
 	fragData[GBUFFER_DIFFTEX_IDX] = vec4(mix(fragData[GBUFFER_DIFFTEX_IDX].rgb, nanoColor.rgb, nanoColor.a), alpha);
 	// do not premultiply reflection, leave it to the deferred lighting pass
-	// fragData[GBUFFER_DIFFTEX_IDX] = vec4(mix(diffuseColor.rgb, teamColor.rgb, diffuseColor.a) * reflectColor, alpha);
+	// fragData[GBUFFER_DIFFTEX_IDX] = vec4(mix(diffuseColor.rgb, instTeamColor.rgb, diffuseColor.a) * reflectColor, alpha);
 	// allows standard-lighting reconstruction by lazy LuaMaterials using us
 	fragData[GBUFFER_SPECTEX_IDX] = vec4(shadingColor.rgb, alpha);
 	fragData[GBUFFER_EMITTEX_IDX] = vec4(0.0, 0.0, 0.0, 0.0);
@@ -14,10 +14,19 @@ layout(location = 6) in uint pieceIdxAttr;
 
 uniform mat4 pieceMatrices[128];
 
+// instanced path; per-instance data is laid out as
+//   [0, 4) model-matrix columns
+//   [4, 5) team-color
+//   [5, 5 + numPieces * 4) piece-matrix columns
+// x := texels per instance (0 if not instanced), y := first texel
+uniform samplerBuffer instanceDataTex;
+uniform ivec2 instanceParams;
+
 uniform mat4 modelMatrix;
 uniform mat4  viewMatrix;
 uniform mat4  projMatrix;
 
+uniform vec4 teamColor;
 uniform vec3 cameraPos;
 uniform vec3 fogParams;
 
@@ -30,6 +39,7 @@ out vec4 worldPos;
 out vec3 cameraDir;
 
 out vec2 texCoord0;
+flat out vec4 instTeamColor;
 // out vec2 texCoord1;
 
 out float gl_ClipDistance[MDL_CLIP_PLANE_IDX + 1];
@@ -46,12 +56,31 @@ mat4 mat4mix(mat4 a, mat4 b, float alpha) {
 	return (a * (1.0 - alpha) + b * alpha);
 }
 
+mat4 GetInstanceMatrix(int texelIdx) {
+	return (mat4(
+		texelFetch(instanceDataTex, texelIdx + 0),
+		texelFetch(instanceDataTex, texelIdx + 1),
+		texelFetch(instanceDataTex, texelIdx + 2),
+		texelFetch(instanceDataTex, texelIdx + 3)
+	));
+}
+
 void main(void)
 {
 	// mat4 pieceMatrix = mat4mix(mat4(1.0), pieceMatrices[pieceIdxAttr], pieceMatrices[0][3][3]);
 	mat4 pieceMatrix = pieceMatrices[pieceIdxAttr];
 	mat4 modelPieceMatrix = modelMatrix * pieceMatrix;
 
+	instTeamColor = teamColor;
+
+	if (instanceParams.x > 0) {
+		int texelIdx = instanceParams.y + gl_InstanceID * instanceParams.x;
+
+		pieceMatrix = GetInstanceMatrix(texelIdx + 5 + int(pieceIdxAttr) * 4);
+		modelPieceMatrix = GetInstanceMatrix(texelIdx) * pieceMatrix;
+		instTeamColor = texelFetch(instanceDataTex, texelIdx + 4);
+	}
+
 	vec4 vertexPos = vec4(positionAttr, 1.0);
 	vec4 vertexModelPos = modelPieceMatrix * vertexPos;
 	vec4 vertexViewPos = viewMatrix * vertexModelPos;
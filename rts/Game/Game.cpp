@@ -2,6 +2,7 @@
 
 #include "Rendering/GL/myGL.h"
 
+
 #include "Game.h"
 #include "Camera.h"
 #include "CameraHandler.h"
@@ -22,6 +23,7 @@
 #include "SyncedGameCommands.h"
 #include "UnsyncedActionExecutor.h"
 #include "UnsyncedGameCommands.h"
+#include "GameVersion.h"
 #include "Game/Players/Player.h"
 #include "Game/Players/PlayerHandler.h"
 #include "Game/UI/PlayerRoster.h"
@@ -112,6 +114,10 @@
 #include "System/SafeUtil.h"
 #include "System/SpringExitCode.h"
 #include "System/SpringMath.h"
+#include "System/FileSystem/ArchiveScanner.h"
+#include "System/FileSystem/CacheFile.h"
+#include "System/FileSystem/DataDirsAccess.h"
+#include "System/FileSystem/FileQueryFlags.h"
 #include "System/FileSystem/FileSystem.h"
 #include "System/LoadSave/LoadSaveHandler.h"
 #include "System/LoadSave/DemoRecorder.h"
@@ -121,6 +127,8 @@
 #include "System/Sound/ISound.h"
 #include "System/Sound/ISoundChannels.h"
 #include "System/Sync/DumpState.h"
+#include "System/Sync/HsiehHash.h"
+#include "System/Threading/TaskGraph.h"
 #include "System/TimeProfiler.h"
 
 
@@ -138,6 +146,7 @@ CONFIG(bool, ShowSpeed).defaultValue(false).description("Displays current game s
 CONFIG(int, ShowPlayerInfo).defaultValue(1).headlessValue(0);
 CONFIG(float, GuiOpacity).defaultValue(0.8f).minimumValue(0.0f).maximumValue(1.0f).description("Sets the opacity of the built-in Spring UI. Generally has no effect on LuaUI widgets. Can be set in-game using shift+, to decrease and shift+. to increase.");
 CONFIG(std::string, InputTextGeo).defaultValue("");
+CONFIG(bool, UseDefsCache).defaultValue(true).description("Store the table returned by gamedata/defs.lua in the cache directory so later starts of the same game, map and options can skip running it.");
 
 
 CGame* game = nullptr;
@@ -355,77 +364,89 @@ void CGame::Load(const std::string& mapFileName)
 	GL::SetMatrixStatePointer(Threading::IsMainThread());
 
 	auto& globalQuit = gu->globalQuit;
-	bool  forcedQuit = false;
+	std::atomic<bool> forcedQuit = {false};
+
+	// set when a stage of the phase failed, which skips its remaining stages
+	// phase 0 holds the asynchronous stages, which are never skipped
+	std::array<std::atomic<bool>, 7> phaseFailed = {};
 
 	LuaParser baseDefsParser("gamedata/defs.lua", SPRING_VFS_MOD_BASE, SPRING_VFS_ZIP, {true}, {false});
 	LuaParser nullDefsParser("return {UnitDefs = {}, FeatureDefs = {}, WeaponDefs = {}, ArmorDefs = {}, MoveDefs = {}}", SPRING_VFS_ZIP, 0, {true}, {true});
 
 	LuaParser* defsParser = &baseDefsParser;
 
-	try {
-		LOG("[Game::%s][1] globalQuit=%d threaded=%d", __func__, globalQuit.load(), !Threading::IsMainThread());
+	// everything touching synced state or GL runs on this thread in the
+	// order added below, which is the order the stages always had; only
+	// the stages which do neither (and only read their inputs from the
+	// VFS) are asynchronous, their dependents wait for them explicitly
+	CTaskGraph loadGraph;
+
+	const auto AddStage = [&](const char* name, int phase, CTaskGraph::TaskFunc func, const std::vector<int>& deps, bool async = false) {
+		return loadGraph.AddTask(name, [&, name, phase, func = std::move(func)]() {
+			// skip Lua handlers in case of forced exit
+			// makes the specific error(s) more obvious
+			if ((phase == 4 || phase == 5) && forcedQuit)
+				return;
+			if (phase > 0 && phaseFailed[phase])
+				return;
+
+			try {
+				func();
+			} catch (const content_error& e) {
+				LOG_L(L_WARNING, "[Game::Load][%d] forced quit with exception \"%s\" in %s", phase, e.what(), name);
+
+				phaseFailed[phase] = true;
+				forcedQuit = true;
+			}
+		}, deps, async);
+	};
 
+	const int soundDefsStage = AddStage("LoadSoundDefs", 0, [&]() { LoadSoundDefs(); }, {}, true);
+	const int explTablesStage = AddStage("ParseExplosionTables", 0, [&]() { explGenHandler.Init(); }, {}, true);
+
+	const int mapStage = AddStage("LoadMap", 1, [&]() {
+		LOG("[Game::%s][1] globalQuit=%d threaded=%d", "Load", globalQuit.load(), !Threading::IsMainThread());
 		LoadMap(mapFileName);
-		LoadDefs(defsParser);
-	} catch (const content_error& e) {
-		LOG_L(L_WARNING, "[Game::%s][1] forced quit with exception \"%s\"", __func__, e.what());
+	}, {});
+	const int defsStage = AddStage("LoadDefs", 1, [&]() { LoadDefs(defsParser); }, {mapStage});
 
-		defsParser = &nullDefsParser;
-		defsParser->Execute();
+	const int nullDefsStage = loadGraph.AddTask("SelectDefs", [&]() {
+		if (!phaseFailed[1])
+			return;
 
 		// we can not (yet) do a clean early exit here because the dtor assumes
 		// all loading stages proceeded normally; just force automatic shutdown
-		forcedQuit = true;
-	}
-
-	try {
-		LOG("[Game::%s][2] globalQuit=%d forcedQuit=%d", __func__, globalQuit.load(), forcedQuit);
+		defsParser = &nullDefsParser;
+		defsParser->Execute();
+	}, {defsStage});
 
+	const int preSimStage = AddStage("PreLoadSimulation", 2, [&]() {
+		LOG("[Game::%s][2] globalQuit=%d forcedQuit=%d", "Load", globalQuit.load(), forcedQuit.load());
 		PreLoadSimulation(defsParser);
-		PreLoadRendering();
-	} catch (const content_error& e) {
-		LOG_L(L_WARNING, "[Game::%s][2] forced quit with exception \"%s\"", __func__, e.what());
-		forcedQuit = true;
-	}
-
-	try {
-		LOG("[Game::%s][3] globalQuit=%d forcedQuit=%d", __func__, globalQuit.load(), forcedQuit);
+	}, {nullDefsStage});
+	const int preRenderStage = AddStage("PreLoadRendering", 2, [&]() { PreLoadRendering(); }, {mapStage});
 
+	// weapon and unit defs resolve sound names and CEG tags while parsing
+	const int postSimStage = AddStage("PostLoadSimulation", 3, [&]() {
+		LOG("[Game::%s][3] globalQuit=%d forcedQuit=%d", "Load", globalQuit.load(), forcedQuit.load());
 		PostLoadSimulation(defsParser);
-		PostLoadRendering();
-	} catch (const content_error& e) {
-		LOG_L(L_WARNING, "[Game::%s][3] forced quit with exception \"%s\"", __func__, e.what());
-		forcedQuit = true;
-	}
-
-	// skip Lua handlers in case of forced exit
-	// makes the specific error(s) more obvious
-	if (!forcedQuit) {
-		try {
-			LOG("[Game::%s][4] globalQuit=%d forcedQuit=%d", __func__, globalQuit.load(), forcedQuit);
-
-			LoadInterface();
-			LoadLua(saveFileHandler != nullptr, false);
-		} catch (const content_error& e) {
-			LOG_L(L_WARNING, "[Game::%s][4] forced quit with exception \"%s\"", __func__, e.what());
-			forcedQuit = true;
-		}
-	}
+	}, {preSimStage, preRenderStage, soundDefsStage, explTablesStage});
+	const int postRenderStage = AddStage("PostLoadRendering", 3, [&]() { PostLoadRendering(); }, {postSimStage});
 
-	if (!forcedQuit) {
-		try {
-			LOG("[Game::%s][5] globalQuit=%d forcedQuit=%d", __func__, globalQuit.load(), forcedQuit);
+	const int interfaceStage = AddStage("LoadInterface", 4, [&]() {
+		LOG("[Game::%s][4] globalQuit=%d forcedQuit=%d", "Load", globalQuit.load(), forcedQuit.load());
+		LoadInterface();
+	}, {postRenderStage});
+	const int luaStage = AddStage("LoadLua", 4, [&]() { LoadLua(saveFileHandler != nullptr, false); }, {interfaceStage});
 
-			LoadFinalize();
-			LoadSkirmishAIs();
-		} catch (const content_error& e) {
-			LOG_L(L_WARNING, "[Game::%s][5] forced quit with exception \"%s\"", __func__, e.what());
-			forcedQuit = true;
-		}
-	}
+	const int finalizeStage = AddStage("LoadFinalize", 5, [&]() {
+		LOG("[Game::%s][5] globalQuit=%d forcedQuit=%d", "Load", globalQuit.load(), forcedQuit.load());
+		LoadFinalize();
+	}, {luaStage});
+	const int skirmishAIsStage = AddStage("LoadSkirmishAIs", 5, [&]() { LoadSkirmishAIs(); }, {finalizeStage});
 
-	try {
-		LOG("[Game::%s][6] globalQuit=%d forcedQuit=%d", __func__, globalQuit.load(), forcedQuit);
+	AddStage("LoadSavedGame", 6, [&]() {
+		LOG("[Game::%s][6] globalQuit=%d forcedQuit=%d", "Load", globalQuit.load(), forcedQuit.load());
 
 		if (!globalQuit && saveFileHandler != nullptr) {
 			loadscreen->SetLoadMessage("Loading Saved Game");
@@ -436,13 +457,13 @@ void CGame::Load(const std::string& mapFileName)
 		{
 			char msgBuf[512];
 
-			SNPRINTF(msgBuf, sizeof(msgBuf), "[Game::%s][lua{Rules,Gaia}={%p,%p}][locale=\"%s\"]", __func__, luaRules, luaGaia, setlocale(LC_ALL, nullptr));
+			SNPRINTF(msgBuf, sizeof(msgBuf), "[Game::%s][lua{Rules,Gaia}={%p,%p}][locale=\"%s\"]", "Load", luaRules, luaGaia, setlocale(LC_ALL, nullptr));
 			CLIENT_NETLOG(gu->myPlayerNum, LOG_LEVEL_INFO, msgBuf);
 		}
-	} catch (const content_error& e) {
-		LOG_L(L_WARNING, "[Game::%s][6] forced quit with exception \"%s\"", __func__, e.what());
-		forcedQuit = true;
-	}
+	}, {skirmishAIsStage});
+
+	loadGraph.Run([]() { Watchdog::ClearTimer(WDT_LOAD); });
+	loadGraph.LogReport("Game::Load");
 
 	Watchdog::DeregisterThread(WDT_LOAD);
 	AddTimedJobs();
@@ -478,6 +499,99 @@ void CGame::LoadMap(const std::string& mapFileName)
 }
 
 
+static constexpr std::uint32_t DEFS_CACHE_VERSION = 2;
+
+// cache-files are keyed by GetDefsCacheHash, their data is the serialized
+// LuaTableSnapshot of the table returned by defs.lua
+static constexpr char DEFS_CACHE_MAGIC[8] = {'S', 'P', 'R', 'I', 'N', 'G', 'D', 'F'};
+
+static const std::string GetDefsCacheDir() {
+	return (FileSystem::GetCacheDir() + "/defs/");
+}
+
+// everything defs.lua can see that is not a file in the game or map archives
+static std::uint32_t GetDefsCacheHash(LuaParser* defsParser)
+{
+	const auto HashOptions = [](const spring::unordered_map<std::string, std::string>& options, std::uint32_t hash) {
+		std::vector<std::pair<std::string, std::string>> sortedOptions(options.begin(), options.end());
+		std::sort(sortedOptions.begin(), sortedOptions.end());
+
+		for (const auto& option: sortedOptions) {
+			hash = HsiehHash(option.first.c_str(), option.first.size() + 1, hash);
+			hash = HsiehHash(option.second.c_str(), option.second.size() + 1, hash);
+		}
+
+		return hash;
+	};
+
+	const sha512::raw_digest& modChecksum = archiveScanner->GetArchiveCompleteChecksumBytes(archiveScanner->ArchiveFromName(gameSetup->modName));
+	const sha512::raw_digest& mapChecksum = archiveScanner->GetArchiveCompleteChecksumBytes(archiveScanner->ArchiveFromName(gameSetup->mapName));
+	const std::string& syncVersion = SpringVersion::GetSync();
+
+	std::vector<std::uint8_t> gameTable;
+	std::uint32_t hash = DEFS_CACHE_VERSION;
+
+	hash = HsiehHash(modChecksum.data(), modChecksum.size(), hash);
+	hash = HsiehHash(mapChecksum.data(), mapChecksum.size(), hash);
+
+	// defs.lua itself and the default handlers live in the base content, which
+	// is always mapped even if neither the game nor the map depend on it
+	for (const std::string& archiveName: CArchiveScanner::GetBaseContentArchives()) {
+		const std::string& archivePath = archiveScanner->GetArchivePath(archiveName);
+
+		if (archivePath.empty())
+			continue;
+
+		const sha512::raw_digest& archiveChecksum = archiveScanner->GetArchiveSingleChecksumBytes(archivePath + archiveName);
+
+		hash = HsiehHash(archiveName.c_str(), archiveName.size() + 1, hash);
+		hash = HsiehHash(archiveChecksum.data(), archiveChecksum.size(), hash);
+	}
+
+	hash = HsiehHash(syncVersion.c_str(), syncVersion.size(), hash);
+	hash = HashOptions(gameSetup->GetModOptionsCont(), hash);
+	hash = HashOptions(gameSetup->GetMapOptionsCont(), hash);
+
+	// Game.* depends on map, game setup and engine limits
+	if (defsParser->WriteGlobalTable("Game", gameTable))
+		hash = HsiehHash(gameTable.data(), gameTable.size(), hash);
+
+	return hash;
+}
+
+static const std::string GetDefsCacheFileName(std::uint32_t hash) {
+	return (GetDefsCacheDir() + "defs-" + IntToString(hash, "%x") + ".bin");
+}
+
+static bool ReadDefsCache(LuaParser* defsParser, std::uint32_t hash)
+{
+	CCacheFile cacheFile;
+
+	if (!cacheFile.Open(dataDirsAccess.LocateFile(GetDefsCacheFileName(hash)), DEFS_CACHE_MAGIC, DEFS_CACHE_VERSION, hash))
+		return (cacheFile.Remove());
+	if (!defsParser->ReadSnapshot(cacheFile.GetData(), cacheFile.GetDataSize()))
+		return (cacheFile.Remove());
+
+	return true;
+}
+
+static bool WriteDefsCache(const LuaParser* defsParser, std::uint32_t hash)
+{
+	if (!FileSystem::CreateDirectory(GetDefsCacheDir()))
+		return false;
+
+	std::vector<std::uint8_t> data;
+
+	if (!defsParser->WriteSnapshot(data))
+		return false;
+
+	// another instance might be reading the same entry
+	const std::string cacheFilePath = dataDirsAccess.LocateFile(GetDefsCacheFileName(hash), FileQueryFlags::WRITE);
+
+	return (CCacheFile::Write(cacheFilePath, DEFS_CACHE_MAGIC, DEFS_CACHE_VERSION, hash, data));
+}
+
+
 void CGame::LoadDefs(LuaParser* defsParser)
 {
 	ENTER_SYNCED_CODE();
@@ -493,9 +607,26 @@ void CGame::LoadDefs(LuaParser* defsParser)
 		defsParser->AddFunc("GetMapOptions", LuaSyncedRead::GetMapOptions);
 		defsParser->EndTable();
 
-		// run the parser
-		if (!defsParser->Execute())
-			throw content_error("Defs-Parser: " + defsParser->GetErrorLog());
+		const bool useCache = configHandler->GetBool("UseDefsCache");
+		const std::uint32_t cacheHash = useCache? GetDefsCacheHash(defsParser): 0;
+
+		if (!useCache || !ReadDefsCache(defsParser, cacheHash)) {
+			const auto rngState = gsRNG.GetGenState();
+
+			// run the parser
+			if (!defsParser->Execute())
+				throw content_error("Defs-Parser: " + defsParser->GetErrorLog());
+
+			// all def-handlers read from the snapshot, whether it was cached or not
+			if (!defsParser->CreateSnapshot())
+				throw content_error("Defs-Parser: could not copy the returned table");
+
+			// a cache-hit must leave the synced RNG where executing defs.lua would
+			if (useCache && gsRNG.GetGenState() == rngState)
+				WriteDefsCache(defsParser, cacheHash);
+		} else {
+			LOG("[Game::%s] read gamedata definitions from cache (hash=%x)", __func__, cacheHash);
+		}
 
 		const LuaTable& root = defsParser->GetRoot();
 
@@ -525,21 +656,22 @@ void CGame::LoadDefs(LuaParser* defsParser)
 		loadscreen->SetLoadMessage("Loading Radar Icons");
 		icon::iconHandler.Init();
 	}
-	{
-		ScopedOnceTimer timer("Game::LoadDefs (Sound)");
-		loadscreen->SetLoadMessage("Loading Sound Definitions");
+	LEAVE_SYNCED_CODE();
+}
 
-		LuaParser soundDefsParser("gamedata/sounds.lua", SPRING_VFS_MOD_BASE, SPRING_VFS_MOD_BASE);
-		soundDefsParser.GetTable("Spring");
-		soundDefsParser.AddFunc("GetModOptions", LuaSyncedRead::GetModOptions);
-		soundDefsParser.AddFunc("GetMapOptions", LuaSyncedRead::GetMapOptions);
-		soundDefsParser.EndTable();
+void CGame::LoadSoundDefs()
+{
+	// runs asynchronously; no loadscreen messages from here
+	ScopedOnceTimer timer("Game::LoadSoundDefs");
 
-		sound->LoadSoundDefs(&soundDefsParser);
-		chatSound = sound->GetDefSoundId("IncomingChat");
-	}
+	LuaParser soundDefsParser("gamedata/sounds.lua", SPRING_VFS_MOD_BASE, SPRING_VFS_MOD_BASE);
+	soundDefsParser.GetTable("Spring");
+	soundDefsParser.AddFunc("GetModOptions", LuaSyncedRead::GetModOptions);
+	soundDefsParser.AddFunc("GetMapOptions", LuaSyncedRead::GetMapOptions);
+	soundDefsParser.EndTable();
 
-	LEAVE_SYNCED_CODE();
+	sound->LoadSoundDefs(&soundDefsParser);
+	chatSound = sound->GetDefSoundId("IncomingChat");
 }
 
 
@@ -550,11 +682,11 @@ void CGame::PreLoadSimulation(LuaParser* defsParser)
 	loadscreen->SetLoadMessage("Creating Smooth Height Mesh");
 	smoothGround.Init(float3::maxxpos, float3::maxzpos, SQUARE_SIZE * 2, SQUARE_SIZE * 40);
 
-	loadscreen->SetLoadMessage("Creating QuadField & CEGs");
+	// CEG tables are parsed asynchronously, see Load
+	loadscreen->SetLoadMessage("Creating QuadField");
 	moveDefHandler.Init(defsParser);
 	quadField.Init(int2(mapDims.mapx, mapDims.mapy), CQuadField::BASE_QUAD_SIZE);
 	damageArrayHandler.Init(defsParser);
-	explGenHandler.Init();
 }
 
 void CGame::PostLoadSimulation(LuaParser* defsParser)
@@ -647,6 +779,8 @@ void CGame::LoadInterface()
 	mouse->ReloadCursors();
 
 	selectedUnitsHandler.Init(playerHandler.ActivePlayers());
+	// batched orders must not be overtaken by any other message
+	clientNet->SetPreSendFunc([]() { selectedUnitsHandler.SendPendingCommands(); });
 
 	// NB: these are also added to word-completion
 	syncedGameCommands->AddDefaultActionExecutors();
@@ -886,6 +1020,10 @@ void CGame::KillInterface()
 	LOG("[Game::%s][1]", __func__);
 	ProfileDrawer::SetEnabled(false);
 	camHandler->Kill();
+
+	if (clientNet != nullptr)
+		clientNet->SetPreSendFunc(nullptr);
+
 	spring::SafeDelete(guihandler);
 	spring::SafeDelete(minimap);
 	spring::SafeDelete(resourceBar);
@@ -1093,6 +1231,9 @@ bool CGame::Update()
 
 	LEAVE_SYNCED_CODE();
 
+	// orders queued since the last update that no other message flushed
+	selectedUnitsHandler.SendPendingCommands();
+
 	{
 		SLuaAllocError error = {};
 
@@ -1247,6 +1388,7 @@ bool CGame::UpdateUnsynced(const spring_time currentTime)
 		SCOPED_TIMER("Update::EventHandler");
 		eventHandler.Update();
 	}
+
 	eventHandler.DbgTimingInfo(TIMING_UNSYNCED, currentTime, spring_now());
 	return false;
 }
@@ -50,6 +50,7 @@ private:
 
 	void LoadMap(const std::string& mapName);
 	void LoadDefs(LuaParser* defsParser);
+	void LoadSoundDefs();
 	void PreLoadSimulation(LuaParser* defsParser);
 	void PostLoadSimulation(LuaParser* defsParser);
 	void PreLoadRendering();
@@ -130,6 +131,7 @@ private:
 
 	void SendClientProcUsage();
 	void ClientReadNet();
+	void SendGameSnapshot(int joinerNum);
 	void UpdateNumQueuedSimFrames();
 	void UpdateNetMessageProcessingTimeLeft();
 	void SimFrame();
@@ -33,6 +33,7 @@
 #include "System/Exceptions.h"
 #include "System/SafeUtil.h"
 #include "System/SpringExitCode.h"
+#include "System/StringUtil.h"
 #include "System/TimeProfiler.h"
 #include "System/TdfParser.h"
 #include "System/Input/KeyInput.h"
@@ -41,6 +42,7 @@
 #include "System/FileSystem/VFSHandler.h"
 #include "System/LoadSave/DemoRecorder.h"
 #include "System/LoadSave/DemoReader.h"
+#include "System/LoadSave/CregLoadSaveHandler.h"
 #include "System/LoadSave/LoadSaveHandler.h"
 #include "System/Log/ILog.h"
 #include "System/Net/RawPacket.h"
@@ -379,6 +381,73 @@ void CPreGame::UpdateClientNet()
 				GameDataReceived(packet);
 			} break;
 
+			case NETMSG_SNAPSHOT_DATA: {
+				// server sends these between NETMSG_GAMEDATA and NETMSG_SETPLAYERNUM
+				// if we are joining mid-game from a savestate made by another client
+				try {
+					netcode::UnpackPacket pckt(packet, 3);
+
+					uint8_t donorNum;
+					uint8_t joinerNum;
+					int32_t frameNum;
+					uint32_t totalSize;
+					uint32_t chunkOffset;
+
+					pckt >> donorNum;
+					pckt >> joinerNum;
+					pckt >> frameNum;
+					pckt >> totalSize;
+					pckt >> chunkOffset;
+
+					constexpr uint32_t headerSize = sizeof(uint8_t) + sizeof(uint16_t) + sizeof(donorNum) + sizeof(joinerNum) + sizeof(frameNum) + sizeof(totalSize) + sizeof(chunkOffset);
+
+					std::vector<std::uint8_t> chunkData(packet->length - headerSize);
+					pckt >> chunkData;
+
+					if (chunkOffset != snapshotData.size())
+						throw content_error("Invalid savestate received from server");
+
+					snapshotData.insert(snapshotData.end(), chunkData.begin(), chunkData.end());
+
+					if (snapshotData.size() < totalSize)
+						break;
+					if (snapshotData.size() > totalSize)
+						throw content_error("Invalid savestate received from server");
+
+					const std::vector<std::uint8_t> stateData = zlib::inflate(snapshotData);
+
+					if (stateData.empty())
+						throw content_error("Invalid savestate received from server");
+
+					std::unique_ptr<CCregLoadSaveHandler> snapshotHandler(new CCregLoadSaveHandler());
+
+					// a state from a different engine build can not be loaded (LoadBadSaves does not apply)
+					if (!snapshotHandler->LoadGameStateInfo(std::string(stateData.begin(), stateData.end())))
+						throw content_error("Incompatible savestate received from server");
+
+					saveFileHandler = snapshotHandler.release();
+					snapshotData.clear();
+
+					LOG("[PreGame::%s] received savestate of frame %d (%u bytes) from player %d", __func__, frameNum, totalSize, donorNum);
+				} catch (const netcode::UnpackPacketException& ex) {
+					LOG_L(L_ERROR, "[PreGame::%s][NETMSG_SNAPSHOT_DATA] exception \"%s\"", __func__, ex.what());
+				} catch (const content_error& ex) {
+					// the server only sends the packets after the savestate, so there is nothing to fall back to
+					LOG_L(L_ERROR, "[PreGame::%s][NETMSG_SNAPSHOT_DATA] %s", __func__, ex.what());
+
+					clientNet->Send(CBaseNetProtocol::Get().SendQuit(ex.what()));
+					snapshotData.clear();
+
+					if (CLuaMenuController::ActivateInstance(ex.what())) {
+						assert(pregame == this);
+						spring::SafeDelete(pregame);
+						return;
+					}
+
+					handleerror(nullptr, ex.what(), "Savestate error", MBF_OK | MBF_EXCL);
+				}
+			} break;
+
 			case NETMSG_SETPLAYERNUM: {
 				// this is sent after NETMSG_GAMEDATA, to let us know which
 				// player number we have (server assigns them based on order
@@ -3,8 +3,10 @@
 #ifndef PREGAME_H
 #define PREGAME_H
 
+#include <cinttypes>
 #include <string>
 #include <memory>
+#include <vector>
 
 #include "GameController.h"
 #include "System/Misc/SpringTime.h"
@@ -76,6 +78,9 @@ private:
 	std::string modFileName;
 	ILoadSaveHandler* saveFileHandler;
 
+	/// compressed savestate for a mid-game join, assembled from NETMSG_SNAPSHOT_DATA
+	std::vector<std::uint8_t> snapshotData;
+
 	spring_time connectTimer;
 
 	bool wantDemo;
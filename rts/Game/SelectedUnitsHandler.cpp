@@ -36,11 +36,15 @@
 #include "System/StringUtil.h"
 #include "Net/Protocol/NetProtocol.h"
 #include "System/Net/PackPacket.h"
+#include "System/Net/UnpackPacket.h"
 #include "System/FileSystem/SimpleParser.h"
 #include "System/Input/KeyInput.h"
 #include "System/Sound/ISound.h"
 #include "System/Sound/ISoundChannels.h"
 
+#include <climits>
+#include <cstring>
+
 #include <SDL_mouse.h>
 #include <SDL_keycode.h>
 
@@ -53,6 +57,124 @@ CONFIG(bool, AutoAddBuiltUnitsToSelectedGroup).defaultValue(false);
 CSelectedUnitsHandler selectedUnitsHandler;
 
 
+// per-command flags in NETMSG_COMMANDS; fields which are
+// equal to those of the previous command are left out
+enum {
+	PACKED_CMD_SAME_ID      = 1 << 0,
+	PACKED_CMD_SAME_OPTS    = 1 << 1,
+	PACKED_CMD_SAME_NPARAMS = 1 << 2,
+	PACKED_CMD_HAS_TIMEOUT  = 1 << 3,
+};
+
+// also the limit for NETMSG_AICOMMANDS
+static constexpr unsigned int MAX_COMMANDS_PACKET_SIZE = 8192;
+// msg type, msg size, player ID, #commands
+static constexpr unsigned int COMMANDS_HEADER_SIZE = sizeof(uint8_t) + sizeof(uint16_t) + sizeof(uint8_t) + sizeof(uint16_t);
+// msg type, msg size, player ID, AI ID, pairwise, refCmd{ID,Opts,Size}, #units, #commands
+static constexpr unsigned int AICOMMANDS_HEADER_SIZE = 3 + 3 + (4 + 1 + 2) + 2 + 2;
+
+
+static std::uint32_t ZigZagEncode(std::int32_t v) { return ((static_cast<std::uint32_t>(v) << 1) ^ static_cast<std::uint32_t>(v >> 31)); }
+static std::int32_t ZigZagDecode(std::uint32_t v) { return (static_cast<std::int32_t>(v >> 1) ^ -static_cast<std::int32_t>(v & 1)); }
+
+static std::uint32_t GetParamBits(const Command& c, unsigned int i)
+{
+	if (i >= c.GetNumParams())
+		return 0;
+
+	const float f = c.GetParam(i);
+	std::uint32_t u;
+	std::memcpy(&u, &f, sizeof(u));
+	return u;
+}
+
+static void PackVarInt(std::vector<std::uint8_t>& data, std::uint32_t v)
+{
+	for (; v >= 0x80; v >>= 7) {
+		data.push_back((v & 0x7F) | 0x80);
+	}
+
+	data.push_back(v);
+}
+
+static std::uint32_t UnpackVarInt(netcode::UnpackPacket& pckt)
+{
+	std::uint32_t v = 0;
+
+	for (std::uint32_t shift = 0; shift < 32; shift += 7) {
+		std::uint8_t b; pckt >> b;
+
+		v |= (static_cast<std::uint32_t>(b & 0x7F) << shift);
+
+		if ((b & 0x80) == 0)
+			return v;
+	}
+
+	throw netcode::UnpackPacketException("Invalid variable-length integer");
+}
+
+// worst case, every field present and no delta smaller than 32 bits
+static unsigned int GetMaxPackedCommandSize(const Command& c) { return (1 + 5 + 1 + 5 + 5 + c.GetNumParams() * 5); }
+
+// params are sent as (zigzagged) differences between their bit-patterns and
+// those of the previous command's; queued orders which differ only slightly,
+// e.g. the positions along a build-line, mostly need less than four bytes
+static void PackCommand(std::vector<std::uint8_t>& data, const Command& c, const Command& p)
+{
+	std::uint8_t flags = 0;
+
+	flags |= (PACKED_CMD_SAME_ID      * (c.GetID()        == p.GetID()       ));
+	flags |= (PACKED_CMD_SAME_OPTS    * (c.GetOpts()      == p.GetOpts()     ));
+	flags |= (PACKED_CMD_SAME_NPARAMS * (c.GetNumParams() == p.GetNumParams()));
+	flags |= (PACKED_CMD_HAS_TIMEOUT  * (c.GetTimeOut()   != INT_MAX         ));
+
+	data.push_back(flags);
+
+	if ((flags & PACKED_CMD_SAME_ID) == 0)
+		PackVarInt(data, ZigZagEncode(c.GetID()));
+	if ((flags & PACKED_CMD_SAME_OPTS) == 0)
+		data.push_back(c.GetOpts());
+	if ((flags & PACKED_CMD_SAME_NPARAMS) == 0)
+		PackVarInt(data, c.GetNumParams());
+	if ((flags & PACKED_CMD_HAS_TIMEOUT) != 0)
+		PackVarInt(data, ZigZagEncode(c.GetTimeOut()));
+
+	for (unsigned int i = 0, n = c.GetNumParams(); i < n; i++) {
+		PackVarInt(data, ZigZagEncode(static_cast<std::int32_t>(GetParamBits(c, i) - GetParamBits(p, i))));
+	}
+}
+
+static void UnpackCommand(netcode::UnpackPacket& pckt, Command& c, const Command& p)
+{
+	std::uint8_t flags; pckt >> flags;
+
+	std::int32_t cmdID = p.GetID();
+	std::int32_t cmdTimeOut = INT_MAX;
+	std::uint8_t cmdOpts = p.GetOpts();
+	std::uint32_t numParams = p.GetNumParams();
+
+	if ((flags & PACKED_CMD_SAME_ID) == 0)
+		cmdID = ZigZagDecode(UnpackVarInt(pckt));
+	if ((flags & PACKED_CMD_SAME_OPTS) == 0)
+		pckt >> cmdOpts;
+	if ((flags & PACKED_CMD_SAME_NPARAMS) == 0)
+		numParams = UnpackVarInt(pckt);
+	if ((flags & PACKED_CMD_HAS_TIMEOUT) != 0)
+		cmdTimeOut = ZigZagDecode(UnpackVarInt(pckt));
+
+	c = Command(cmdID, cmdOpts);
+	c.SetTimeOut(cmdTimeOut);
+
+	for (std::uint32_t i = 0; i < numParams; i++) {
+		const std::uint32_t u = GetParamBits(p, i) + static_cast<std::uint32_t>(ZigZagDecode(UnpackVarInt(pckt)));
+
+		float f;
+		std::memcpy(&f, &u, sizeof(f));
+		c.PushParam(f);
+	}
+}
+
+
 
 void CSelectedUnitsHandler::Init(unsigned numPlayers)
 {
@@ -724,6 +846,25 @@ void CSelectedUnitsHandler::NetOrder(Command& c, int playerId)
 	eoh->PlayerCommandGiven(netSelected[playerId], c, playerId);
 }
 
+// handles NETMSG_COMMANDS's; equivalent to one NETMSG_COMMAND per packed order
+void CSelectedUnitsHandler::NetOrders(netcode::UnpackPacket& pckt, int playerId)
+{
+	std::uint16_t numCommands;
+	pckt >> numCommands;
+
+	Command prvCmd;
+	Command curCmd;
+
+	for (std::uint16_t n = 0; n < numCommands; n++) {
+		UnpackCommand(pckt, curCmd, prvCmd);
+
+		// NetOrder may modify its argument
+		prvCmd = curCmd;
+
+		NetOrder(curCmd, playerId);
+	}
+}
+
 void CSelectedUnitsHandler::ClearNetSelect(int playerId)
 {
 	netSelected[playerId].clear();
@@ -987,9 +1128,19 @@ void CSelectedUnitsHandler::SetCommandPage(int page)
 
 
 
+// orders are not sent right away but queued until this client sends any
+// other message (clientNet's pre-send function flushes them), or the end of
+// GiveCommandsNow or CGame::Update; a row of queued orders then costs only
+// one (server-broadcast, demo-recorded) message
 void CSelectedUnitsHandler::SendCommand(const Command& c)
 {
+	// keep selection- and unit-orders in the sequence they were given
+	SendPendingUnitCommands();
+
 	if (selectionChanged) {
+		// pending orders still apply to the previous selection
+		SendPendingSelectionCommands();
+
 		// send new selection; first gather unit IDs
 		selectedUnitIDs.clear();
 		selectedUnitIDs.resize(selectedUnits.size(), 0);
@@ -1000,12 +1151,108 @@ void CSelectedUnitsHandler::SendCommand(const Command& c)
 		selectionChanged = false;
 	}
 
-	clientNet->Send(CBaseNetProtocol::Get().SendCommand(gu->myPlayerNum, c.GetID(), c.GetTimeOut(), c.GetOpts(), c.GetNumParams(), c.GetParams()));
+	const unsigned int cmdSize = GetMaxPackedCommandSize(c);
+
+	if ((COMMANDS_HEADER_SIZE + pendingCommandsSize + cmdSize) > MAX_COMMANDS_PACKET_SIZE)
+		SendPendingSelectionCommands();
+
+	pendingCommands.push_back(c);
+	pendingCommandsSize += cmdSize;
+}
+
+// services LuaUnsyncedCtrl::GiveOrderToUnit, which widgets tend to call for
+// every unit of a custom formation; queued like SendCommand's orders
+void CSelectedUnitsHandler::SendCommandToUnit(int unitID, const Command& c)
+{
+	SendPendingSelectionCommands();
+
+	// NETMSG_AICOMMANDS has no room for timeouts or AI command IDs
+	if (c.GetID(true) != -1 || c.GetTimeOut() != INT_MAX) {
+		SendPendingUnitCommands();
+		clientNet->Send(CBaseNetProtocol::Get().SendAICommand(gu->myPlayerNum, MAX_AIS, MAX_TEAMS, unitID, c.GetID(false), c.GetID(true), c.GetTimeOut(), c.GetOpts(), c.GetNumParams(), c.GetParams()));
+		return;
+	}
+
+	// unit ID, cmd ID, cmd opts, #cmd params, params
+	const unsigned int cmdSize = sizeof(int16_t) + sizeof(int32_t) + sizeof(uint8_t) + sizeof(uint16_t) + c.GetNumParams() * sizeof(float);
+
+	if ((AICOMMANDS_HEADER_SIZE + pendingUnitCommandsSize + cmdSize) > MAX_COMMANDS_PACKET_SIZE)
+		SendPendingUnitCommands();
+
+	pendingUnitIDs.push_back(unitID);
+	pendingUnitCommands.push_back(c);
+	pendingUnitCommandsSize += cmdSize;
+}
+
+void CSelectedUnitsHandler::SendPendingCommands()
+{
+	// at most one of these has anything queued
+	SendPendingSelectionCommands();
+	SendPendingUnitCommands();
+}
+
+void CSelectedUnitsHandler::SendPendingSelectionCommands()
+{
+	if (pendingCommands.empty())
+		return;
+
+	CBaseNetProtocol::PacketType packet;
+
+	if (pendingCommands.size() == 1) {
+		const Command& c = pendingCommands[0];
+
+		packet = CBaseNetProtocol::Get().SendCommand(gu->myPlayerNum, c.GetID(), c.GetTimeOut(), c.GetOpts(), c.GetNumParams(), c.GetParams());
+	} else {
+		const Command nullCmd;
+
+		pendingCommandsData.clear();
+		pendingCommandsData.reserve(pendingCommandsSize);
+
+		for (size_t i = 0, n = pendingCommands.size(); i < n; i++) {
+			PackCommand(pendingCommandsData, pendingCommands[i], (i > 0)? pendingCommands[i - 1]: nullCmd);
+		}
+
+		packet = CBaseNetProtocol::Get().SendCommands(gu->myPlayerNum, pendingCommands.size(), pendingCommandsData);
+	}
+
+	// clear before sending, Send re-enters through the pre-send function
+	pendingCommands.clear();
+	pendingCommandsSize = 0;
+
+	clientNet->Send(packet);
+}
+
+void CSelectedUnitsHandler::SendPendingUnitCommands()
+{
+	if (pendingUnitCommands.empty())
+		return;
+
+	// take the queue before sending, Send re-enters through the pre-send function
+	std::vector<int> unitIDs = std::move(pendingUnitIDs);
+	std::vector<Command> commands = std::move(pendingUnitCommands);
+
+	pendingUnitIDs.clear();
+	pendingUnitCommands.clear();
+	pendingUnitCommandsSize = 0;
+
+	if (commands.size() == 1) {
+		const Command& c = commands[0];
+
+		clientNet->Send(CBaseNetProtocol::Get().SendAICommand(gu->myPlayerNum, MAX_AIS, MAX_TEAMS, unitIDs[0], c.GetID(false), c.GetID(true), c.GetTimeOut(), c.GetOpts(), c.GetNumParams(), c.GetParams()));
+	} else {
+		SendAICommands(unitIDs, commands, true);
+	}
 }
 
 
-// despite the NETMSG_AICOMMANDS packet-id, this only services LuaUnsyncedCtrl
 void CSelectedUnitsHandler::SendCommandsToUnits(const std::vector<int>& unitIDs, const std::vector<Command>& commands, bool pairwise)
+{
+	SendPendingCommands();
+	SendAICommands(unitIDs, commands, pairwise);
+}
+
+// despite the NETMSG_AICOMMANDS packet-id, this only services LuaUnsyncedCtrl
+void CSelectedUnitsHandler::SendAICommands(const std::vector<int>& unitIDs, const std::vector<Command>& commands, bool pairwise)
 {
 	// do not waste bandwidth (units can be selected
 	// by any spectator, but not given orders without
@@ -1064,7 +1311,7 @@ void CSelectedUnitsHandler::SendCommandsToUnits(const std::vector<int>& unitIDs,
 	totalPacketLen += (commandCount * optBytesPerCmd);
 	totalPacketLen += (totalParams * sizeof(float)); // params are floats
 
-	if (totalPacketLen > 8192) {
+	if (totalPacketLen > MAX_COMMANDS_PACKET_SIZE) {
 		LOG_L(L_WARNING, "[%s] discarded oversized (len=%i) NETMSG_AICOMMANDS packet", __func__, totalPacketLen);
 		return; // do not send oversized packets
 	}
@@ -3,6 +3,7 @@
 #ifndef SELECTED_UNITS_H
 #define SELECTED_UNITS_H
 
+#include <cinttypes>
 #include <vector>
 #include <string>
 
@@ -15,6 +16,10 @@ class CUnit;
 class CFeature;
 struct SCommandDescription;
 
+namespace netcode {
+	class UnpackPacket;
+}
+
 class CSelectedUnitsHandler : public CObject
 {
 public:
@@ -24,6 +29,7 @@ public:
 	int GetDefaultCmd(const CUnit* unit, const CFeature* feature);
 
 	void NetOrder(Command& c, int playerId);
+	void NetOrders(netcode::UnpackPacket& pckt, int playerId);
 	void NetSelect(std::vector<int>& s, int playerId);
 	void ClearNetSelect(int playerId);
 	void DependentDied(CObject* o) override;
@@ -51,7 +57,11 @@ public:
 	std::string GetTooltip();
 	void SetCommandPage(int page);
 	void SendCommand(const Command& c);
+	void SendCommandToUnit(int unitID, const Command& c);
 	void SendCommandsToUnits(const std::vector<int>& unitIDs, const std::vector<Command>& commands, bool pairwise = false);
+	/// flushes orders queued by Send{Command,CommandToUnit}; runs before any other
+	/// message this client sends, at the end of GiveCommandsNow and in CGame::Update
+	void SendPendingCommands();
 
 	bool CommandsChanged() const { return possibleCommandsChanged; }
 	bool IsUnitSelected(const CUnit* unit) const;
@@ -64,6 +74,11 @@ public:
 	void SelectUnits(const std::string& line);
 	void SelectCycle(const std::string& command);
 
+private:
+	void SendPendingSelectionCommands();
+	void SendPendingUnitCommands();
+	void SendAICommands(const std::vector<int>& unitIDs, const std::vector<Command>& commands, bool pairwise);
+
 private:
 	int selectedGroup = -1;
 	int soundMultiselID = 0;
@@ -82,6 +97,17 @@ public:
 private:
 	// buffer for SendCommand unordered_set->vector conversion
 	std::vector<int16_t> selectedUnitIDs;
+
+	// orders for the current selection, sent as one NETMSG_COMMANDS
+	std::vector<Command> pendingCommands;
+	// orders for individual units (from Lua), sent as one pairwise NETMSG_AICOMMANDS
+	std::vector<Command> pendingUnitCommands;
+	std::vector<int> pendingUnitIDs;
+	// delta-encoded payload of the next NETMSG_COMMANDS
+	std::vector<std::uint8_t> pendingCommandsData;
+
+	unsigned int pendingCommandsSize = 0;
+	unsigned int pendingUnitCommandsSize = 0;
 };
 
 extern CSelectedUnitsHandler selectedUnitsHandler;
@@ -19,6 +19,7 @@
 #include "Sim/Weapons/PlasmaRepulser.h"
 #include "Sim/Weapons/WeaponDef.h"
 #include "System/SpringMath.h"
+#include "System/Threading/ThreadPool.h"
 
 #include <algorithm>
 #include <vector>
@@ -158,6 +159,75 @@ inline static bool TestTrajectoryConeHelper(
 
 
 
+/**
+ * shared by TestCone and TestTrajectoryCone (and their batched form)
+ * @return true if any allied or neutral unit or feature in the given quads
+ *   is inside the query's cone, false otherwise; only reads the quadfield
+ */
+static bool TestConeQuads(const TraceRay::SConeQuery& q, const int* quads, size_t numQuads)
+{
+	const bool scanForAllies   = ((q.traceFlags & Collision::NOFRIENDLIES) == 0);
+	const bool scanForNeutrals = ((q.traceFlags & Collision::NONEUTRALS  ) == 0);
+	const bool scanForFeatures = ((q.traceFlags & Collision::NOFEATURES  ) == 0);
+
+	const auto TestObject = [&](const CSolidObject* obj) {
+		if (q.trajectory)
+			return (TestTrajectoryConeHelper(q.from, q.dir, q.length, q.linear, q.quadratic, q.spread, 0.0f, obj));
+
+		return (TestConeHelper(q.from, q.dir, q.length, q.spread, obj));
+	};
+
+	for (size_t i = 0; i < numQuads; i++) {
+		const CQuadField::Quad& quad = quadField.GetQuad(quads[i]);
+
+		// friendly units in this quad
+		if (scanForAllies) {
+			for (const CUnit* u: quad.teamUnits[q.allyteam]) {
+				if (u == q.owner)
+					continue;
+				if (!u->HasCollidableStateBit(CSolidObject::CSTATE_BIT_QUADMAPRAYS))
+					continue;
+
+				if (TestObject(u))
+					return true;
+			}
+		}
+
+		// neutral units in this quad
+		if (scanForNeutrals) {
+			for (const CUnit* u: quad.units) {
+				if (!u->IsNeutral())
+					continue;
+				if (u == q.owner)
+					continue;
+				if (!u->HasCollidableStateBit(CSolidObject::CSTATE_BIT_QUADMAPRAYS))
+					continue;
+
+				if (TestObject(u))
+					return true;
+			}
+		}
+
+		// features in this quad
+		if (scanForFeatures) {
+			for (const CFeature* f: quad.features) {
+				if (!f->HasCollidableStateBit(CSolidObject::CSTATE_BIT_QUADMAPRAYS))
+					continue;
+
+				if (TestObject(f))
+					return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+// non-null while a caller is collecting cone queries
+static std::vector<TraceRay::SConeQuery>* coneQueryBatch = nullptr;
+
+
+
 //////////////////////////////////////////////////////////////////////
 // Raytracing
 //////////////////////////////////////////////////////////////////////
@@ -485,57 +555,20 @@ bool TestCone(
 	int traceFlags,
 	CUnit* owner
 ) {
+	const SConeQuery query = {from, dir, length, 0.0f, 0.0f, spread, allyteam, traceFlags, owner, false};
+
+	if (coneQueryBatch != nullptr) {
+		coneQueryBatch->push_back(query);
+		return false;
+	}
+
 	QuadFieldQuery qfQuery;
 	quadField.GetQuadsOnRay(qfQuery, from, dir, length);
 
 	if (qfQuery.quads->empty())
 		return true;
 
-	const bool scanForAllies   = ((traceFlags & Collision::NOFRIENDLIES) == 0);
-	const bool scanForNeutrals = ((traceFlags & Collision::NONEUTRALS  ) == 0);
-	const bool scanForFeatures = ((traceFlags & Collision::NOFEATURES  ) == 0);
-
-	for (const int quadIdx: *qfQuery.quads) {
-		const CQuadField::Quad& quad = quadField.GetQuad(quadIdx);
-
-		if (scanForAllies) {
-			for (const CUnit* u: quad.teamUnits[allyteam]) {
-				if (u == owner)
-					continue;
-				if (!u->HasCollidableStateBit(CSolidObject::CSTATE_BIT_QUADMAPRAYS))
-					continue;
-
-				if (TestConeHelper(from, dir, length, spread, u))
-					return true;
-			}
-		}
-
-		if (scanForNeutrals) {
-			for (const CUnit* u: quad.units) {
-				if (!u->IsNeutral())
-					continue;
-				if (u == owner)
-					continue;
-				if (!u->HasCollidableStateBit(CSolidObject::CSTATE_BIT_QUADMAPRAYS))
-					continue;
-
-				if (TestConeHelper(from, dir, length, spread, u))
-					return true;
-			}
-		}
-
-		if (scanForFeatures) {
-			for (const CFeature* f: quad.features) {
-				if (!f->HasCollidableStateBit(CSolidObject::CSTATE_BIT_QUADMAPRAYS))
-					continue;
-
-				if (TestConeHelper(from, dir, length, spread, f))
-					return true;
-			}
-		}
-	}
-
-	return false;
+	return (TestConeQuads(query, qfQuery.quads->data(), qfQuery.quads->size()));
 }
 
 
@@ -551,61 +584,86 @@ bool TestTrajectoryCone(
 	int traceFlags,
 	CUnit* owner
 ) {
+	const SConeQuery query = {from, dir, length, linear, quadratic, spread, allyteam, traceFlags, owner, true};
+
+	if (coneQueryBatch != nullptr) {
+		coneQueryBatch->push_back(query);
+		return false;
+	}
+
 	QuadFieldQuery qfQuery;
 	quadField.GetQuadsOnRay(qfQuery, from, dir, length);
 
 	if (qfQuery.quads->empty())
 		return true;
 
-	const bool scanForAllies   = ((traceFlags & Collision::NOFRIENDLIES) == 0);
-	const bool scanForNeutrals = ((traceFlags & Collision::NONEUTRALS  ) == 0);
-	const bool scanForFeatures = ((traceFlags & Collision::NOFEATURES  ) == 0);
+	return (TestConeQuads(query, qfQuery.quads->data(), qfQuery.quads->size()));
+}
 
-	for (const int quadIdx: *qfQuery.quads) {
-		const CQuadField::Quad& quad = quadField.GetQuad(quadIdx);
 
-		// friendly units in this quad
-		if (scanForAllies) {
-			for (const CUnit* u: quad.teamUnits[allyteam]) {
-				if (u == owner)
-					continue;
-				if (!u->HasCollidableStateBit(CSolidObject::CSTATE_BIT_QUADMAPRAYS))
-					continue;
 
-				if (TestTrajectoryConeHelper(from, dir, length, linear, quadratic, spread, 0.0f, u))
-					return true;
+void BeginConeQueryBatch(std::vector<SConeQuery>* queries)
+{
+	assert(coneQueryBatch == nullptr);
+	coneQueryBatch = queries;
+}
 
-			}
-		}
+void EndConeQueryBatch()
+{
+	assert(coneQueryBatch != nullptr);
+	coneQueryBatch = nullptr;
+}
 
-		// neutral units in this quad
-		if (scanForNeutrals) {
-			for (const CUnit* u: quad.units) {
-				if (!u->IsNeutral())
-					continue;
-				if (u == owner)
-					continue;
-				if (!u->HasCollidableStateBit(CSolidObject::CSTATE_BIT_QUADMAPRAYS))
-					continue;
 
-				if (TestTrajectoryConeHelper(from, dir, length, linear, quadratic, spread, 0.0f, u))
-					return true;
-			}
+void TestConeQueries(const std::vector<SConeQuery>& queries, std::vector<uint8_t>& blocked)
+{
+	// below this many queries the thread-pool overhead outweighs the gain
+	constexpr size_t MIN_PARALLEL_QUERIES = 16;
+
+	static std::vector<int> batchQuads;
+	static std::vector<int2> batchQuadRanges;
+
+	const auto SameRay = [](const SConeQuery& a, const SConeQuery& b) {
+		return (a.from.x == b.from.x && a.from.y == b.from.y && a.from.z == b.from.z && a.dir.x == b.dir.x && a.dir.y == b.dir.y && a.dir.z == b.dir.z && a.length == b.length);
+	};
+
+	batchQuads.clear();
+	batchQuadRanges.clear();
+	blocked.clear();
+	blocked.resize(queries.size(), 0);
+
+	// gather serially, the quadfield's query vectors are not thread-safe;
+	// a weapon tends to test the same ray with both cone types in a row
+	for (size_t i = 0, n = queries.size(); i < n; i++) {
+		if (i > 0 && SameRay(queries[i], queries[i - 1])) {
+			batchQuadRanges.push_back(batchQuadRanges.back());
+			continue;
 		}
 
-		// features in this quad
-		if (scanForFeatures) {
-			for (const CFeature* f: quad.features) {
-				if (!f->HasCollidableStateBit(CSolidObject::CSTATE_BIT_QUADMAPRAYS))
-					continue;
+		QuadFieldQuery qfQuery;
+		quadField.GetQuadsOnRay(qfQuery, queries[i].from, queries[i].dir, queries[i].length);
 
-				if (TestTrajectoryConeHelper(from, dir, length, linear, quadratic, spread, 0.0f, f))
-					return true;
-			}
+		batchQuadRanges.emplace_back(batchQuads.size(), batchQuads.size() + qfQuery.quads->size());
+		batchQuads.insert(batchQuads.end(), qfQuery.quads->begin(), qfQuery.quads->end());
+	}
+
+	const auto TestQuery = [&](const int i) {
+		const int2 range = batchQuadRanges[i];
+
+		// same as TestCone, a ray that touches no quads counts as blocked
+		blocked[i] = (range.x == range.y || TestConeQuads(queries[i], batchQuads.data() + range.x, range.y - range.x));
+	};
+
+	// the debug-lines added by the cone helpers are not thread-safe
+	if (queries.size() < MIN_PARALLEL_QUERIES || globalRendering->drawDebugTraceRay) {
+		for (size_t i = 0, n = queries.size(); i < n; i++) {
+			TestQuery(i);
 		}
+
+		return;
 	}
 
-	return false;
+	for_mt(0, queries.size(), TestQuery);
 }
 
 
@@ -3,9 +3,11 @@
 #ifndef _TRACE_RAY_H
 #define _TRACE_RAY_H
 
+#include <cstdint>
 #include <vector>
 
-class float3;
+#include "System/float3.h"
+
 class CUnit;
 class CFeature;
 class CWeapon;
@@ -102,6 +104,45 @@ namespace TraceRay {
 		int allyteam,
 		int traceFlags,
 		CUnit* owner);
+
+
+	/**
+	 * parameters of a TestCone (linear and quadratic are zero)
+	 * or TestTrajectoryCone (<trajectory> is true) call
+	 */
+	struct SConeQuery {
+		float3 from;
+		float3 dir;
+
+		float length;
+		float linear;
+		float quadratic;
+		float spread;
+
+		int allyteam;
+		int traceFlags;
+
+		const CUnit* owner;
+
+		bool trajectory;
+	};
+
+	/**
+	 * while a batch is active, TestCone and TestTrajectoryCone do not test
+	 * anything but append their query to <queries> and return false (i.e.
+	 * no object in the cone), the caller evaluates the batch afterwards
+	 * batches can not be nested and are only meant for the sim-thread
+	 */
+	void BeginConeQueryBatch(std::vector<SConeQuery>* queries);
+	void EndConeQueryBatch();
+
+	/**
+	 * evaluates all queries, sharing quadfield gathers between queries
+	 * along the same ray and testing the queries concurrently if there
+	 * are enough of them; blocked[i] is set to 1 iff TestCone (or
+	 * TestTrajectoryCone) would have returned true for queries[i]
+	 */
+	void TestConeQueries(const std::vector<SConeQuery>& queries, std::vector<uint8_t>& blocked);
 }
 
 #endif // _TRACE_RAY_H
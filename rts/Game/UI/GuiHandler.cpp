@@ -927,6 +927,8 @@ void CGuiHandler::GiveCommandsNow() {
 			GiveCommand(Command(CMD_GATHERWAIT), false);
 		}
 	}
+
+	selectedUnitsHandler.SendPendingCommands();
 }
 
 
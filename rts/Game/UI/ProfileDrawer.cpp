@@ -7,6 +7,7 @@
 #include "InputReceiver.h"
 #include "Game/GlobalUnsynced.h"
 #include "Lua/LuaAllocState.h"
+#include "Map/ReadMap.h"
 #include "Rendering/GL/myGL.h"
 #include "Rendering/Fonts/glFont.h"
 #include "Rendering/GlobalRendering.h"
@@ -434,10 +435,10 @@ static void DrawInfoText(GL::RenderDataBufferC* buffer)
 
 	// background
 	buffer->SafeAppend({{             0.01f - 10.0f * globalRendering->pixelX, 0.02f - 10.0f * globalRendering->pixelY, 0.0f}, {bgColor}}); // tl
-	buffer->SafeAppend({{             0.01f - 10.0f * globalRendering->pixelX, 0.17f + 20.0f * globalRendering->pixelY, 0.0f}, {bgColor}}); // bl
-	buffer->SafeAppend({{MIN_X_COOR - 0.05f + 10.0f * globalRendering->pixelX, 0.17f + 20.0f * globalRendering->pixelY, 0.0f}, {bgColor}}); // br
+	buffer->SafeAppend({{             0.01f - 10.0f * globalRendering->pixelX, 0.19f + 20.0f * globalRendering->pixelY, 0.0f}, {bgColor}}); // bl
+	buffer->SafeAppend({{MIN_X_COOR - 0.05f + 10.0f * globalRendering->pixelX, 0.19f + 20.0f * globalRendering->pixelY, 0.0f}, {bgColor}}); // br
 
-	buffer->SafeAppend({{MIN_X_COOR - 0.05f + 10.0f * globalRendering->pixelX, 0.17f + 20.0f * globalRendering->pixelY, 0.0f}, {bgColor}}); // br
+	buffer->SafeAppend({{MIN_X_COOR - 0.05f + 10.0f * globalRendering->pixelX, 0.19f + 20.0f * globalRendering->pixelY, 0.0f}, {bgColor}}); // br
 	buffer->SafeAppend({{MIN_X_COOR - 0.05f + 10.0f * globalRendering->pixelX, 0.02f - 10.0f * globalRendering->pixelY, 0.0f}, {bgColor}}); // tr
 	buffer->SafeAppend({{             0.01f - 10.0f * globalRendering->pixelX, 0.02f - 10.0f * globalRendering->pixelY, 0.0f}, {bgColor}}); // tl
 
@@ -453,6 +454,7 @@ static void DrawInfoText(GL::RenderDataBufferC* buffer)
 	const char* luaFmtStr = "[7] Lua-allocated memory: %.1fMB (%.1fK allocs : %.5u usecs : %.1u states)";
 	const char* gpuFmtStr = "[8] GPU-allocated memory: %.1fMB / %.1fMB";
 	const char* sopFmtStr = "[9] SOP-allocated memory: {U,F,P,W}={%.1f/%.1f, %.1f/%.1f, %.1f/%.1f, %.1f/%.1f}KB";
+	const char* uhmFmtStr = "[10] UHM-rects {updated,pending}={%d, %d} (%.2fms)";
 
 	const CProjectileHandler* ph = &projectileHandler;
 	const IPathManager* pm = pathManager;
@@ -519,6 +521,12 @@ static void DrawInfoText(GL::RenderDataBufferC* buffer)
 		weaponMemPool.alloc_size() / 1024.0f,
 		weaponMemPool.freed_size() / 1024.0f
 	);
+
+	{
+		const CHeightMapUpdateScheduler::Stats& uhmStats = readMap->GetUnsyncedHeightMapUpdateStats();
+
+		font->glFormat(0.01f, 0.20f, 0.5f, DBG_FONT_FLAGS | FONT_BUFFERED, uhmFmtStr, uhmStats.numUpdatedRects, uhmStats.numPendingRects, uhmStats.updateTime);
+	}
 }
 
 
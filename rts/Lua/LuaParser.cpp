@@ -2,6 +2,7 @@
 
 
 #include "LuaParser.h"
+#include "LuaTableSnapshot.h"
 
 #include <algorithm>
 #include <climits>
@@ -298,6 +299,67 @@ LuaTable LuaParser::GetRoot()
 }
 
 
+bool LuaParser::CreateSnapshot()
+{
+	if (!IsValid() || rootRef == LUA_NOREF)
+		return false;
+
+	std::shared_ptr<LuaTableSnapshot> rootSnapshot = std::make_shared<LuaTableSnapshot>();
+
+	lua_rawgeti(L, LUA_REGISTRYINDEX, rootRef);
+
+	if (!rootSnapshot->Create(L, -1, lowerCppKeys)) {
+		lua_pop(L, 1);
+		return false;
+	}
+
+	lua_pop(L, 1);
+
+	snapshot = std::move(rootSnapshot);
+	return true;
+}
+
+bool LuaParser::ReadSnapshot(const std::uint8_t* data, size_t size)
+{
+	std::shared_ptr<LuaTableSnapshot> rootSnapshot = std::make_shared<LuaTableSnapshot>();
+
+	if (!rootSnapshot->Deserialize(data, size))
+		return false;
+
+	snapshot = std::move(rootSnapshot);
+	return (valid = true);
+}
+
+bool LuaParser::WriteSnapshot(std::vector<std::uint8_t>& buffer) const
+{
+	if (snapshot == nullptr)
+		return false;
+
+	snapshot->Serialize(buffer);
+	return true;
+}
+
+bool LuaParser::WriteGlobalTable(const std::string& name, std::vector<std::uint8_t>& buffer)
+{
+	if (!IsValid())
+		return false;
+
+	LuaTableSnapshot tableSnapshot;
+
+	lua_getglobal(L, name.c_str());
+
+	if (!tableSnapshot.Create(L, -1, lowerCppKeys)) {
+		lua_pop(L, 1);
+		return false;
+	}
+
+	lua_pop(L, 1);
+
+	tableSnapshot.Serialize(buffer);
+	return true;
+}
+
+
 /******************************************************************************/
 
 void LuaParser::PushParam()
@@ -706,7 +768,8 @@ LuaTable::LuaTable()
   isValid(false),
   parser(nullptr),
   L(nullptr),
-  refnum(LUA_NOREF)
+  refnum(LUA_NOREF),
+  snapshotNode(-1)
 {
 }
 
@@ -715,8 +778,22 @@ LuaTable::LuaTable(LuaParser* _parser)
 {
 	assert(_parser != nullptr);
 
+	path = "ROOT";
+	snapshotNode = -1;
+
+	if (_parser->snapshot != nullptr) {
+		// snapshot tables are not tracked, they own what they read from
+		parser  = nullptr;
+		L       = nullptr;
+		refnum  = LUA_NOREF;
+		isValid = true;
+
+		snapshot = _parser->snapshot;
+		snapshotNode = snapshot->GetRootNode();
+		return;
+	}
+
 	isValid = _parser->IsValid();
-	path    = "ROOT";
 	parser  = _parser;
 	L       = parser->L;
 	refnum  = parser->rootRef;
@@ -739,6 +816,15 @@ LuaTable::LuaTable(const LuaTable& tbl)
 	L      = tbl.L;
 	path   = tbl.path;
 
+	snapshot = tbl.snapshot;
+	snapshotNode = tbl.snapshotNode;
+
+	if (snapshot != nullptr) {
+		refnum  = LUA_NOREF;
+		isValid = tbl.isValid;
+		return;
+	}
+
 	if (parser != nullptr)
 		parser->AddTable(this);
 
@@ -775,6 +861,15 @@ LuaTable& LuaTable::operator=(const LuaTable& tbl)
 	L    = tbl.L;
 	path = tbl.path;
 
+	snapshot = tbl.snapshot;
+	snapshotNode = tbl.snapshotNode;
+
+	if (snapshot != nullptr) {
+		refnum  = LUA_NOREF;
+		isValid = tbl.isValid;
+		return *this;
+	}
+
 	if (tbl.PushTable()) {
 		lua_pushvalue(L, -1); // copy
 		refnum = luaL_ref(L, LUA_REGISTRYINDEX);
@@ -795,6 +890,15 @@ LuaTable LuaTable::SubTable(int key) const
 	SNPRINTF(buf, 32, "[%i]", key);
 	subTable.path = path + buf;
 
+	if (snapshot != nullptr) {
+		if ((subTable.snapshotNode = snapshot->FindTable(snapshotNode, key)) >= 0) {
+			subTable.snapshot = snapshot;
+			subTable.isValid = true;
+		}
+
+		return subTable;
+	}
+
 	if (!PushTable())
 		return subTable;
 
@@ -822,6 +926,15 @@ LuaTable LuaTable::SubTable(const std::string& mixedKey) const
 	LuaTable subTable;
 	subTable.path = path + "." + key;
 
+	if (snapshot != nullptr) {
+		if ((subTable.snapshotNode = snapshot->FindTable(snapshotNode, mixedKey)) >= 0) {
+			subTable.snapshot = snapshot;
+			subTable.isValid = true;
+		}
+
+		return subTable;
+	}
+
 	if (!PushTable())
 		return subTable;
 
@@ -1033,6 +1146,9 @@ bool LuaTable::PushValue(const std::string& mixedKey) const
 
 bool LuaTable::KeyExists(int key) const
 {
+	if (snapshot != nullptr)
+		return (snapshot->FindValue(snapshotNode, key) != nullptr);
+
 	if (!PushValue(key))
 		return false;
 
@@ -1043,6 +1159,9 @@ bool LuaTable::KeyExists(int key) const
 
 bool LuaTable::KeyExists(const std::string& key) const
 {
+	if (snapshot != nullptr)
+		return (snapshot->FindValue(snapshotNode, key) != nullptr);
+
 	if (!PushValue(key))
 		return false;
 
@@ -1057,39 +1176,45 @@ bool LuaTable::KeyExists(const std::string& key) const
 //  Value types
 //
 
+static LuaTable::DataType GetDataType(int luaType)
+{
+	switch (luaType) {
+		case LUA_TBOOLEAN: return LuaTable::BOOLEAN;
+		case LUA_TNUMBER:  return LuaTable::NUMBER;
+		case LUA_TSTRING:  return LuaTable::STRING;
+		case LUA_TTABLE:   return LuaTable::TABLE;
+		default:           return LuaTable::NIL;
+	}
+}
+
+
 LuaTable::DataType LuaTable::GetType(int key) const
 {
+	if (snapshot != nullptr)
+		return (GetDataType(snapshot->GetType(snapshot->FindValue(snapshotNode, key))));
+
 	if (!PushValue(key))
 		return NIL;
 
 	const int type = lua_type(L, -1);
 	lua_pop(L, 1);
 
-	switch (type) {
-		case LUA_TBOOLEAN: return BOOLEAN;
-		case LUA_TNUMBER:  return NUMBER;
-		case LUA_TSTRING:  return STRING;
-		case LUA_TTABLE:   return TABLE;
-		default:           return NIL;
-	}
+	return (GetDataType(type));
 }
 
 
 LuaTable::DataType LuaTable::GetType(const std::string& key) const
 {
+	if (snapshot != nullptr)
+		return (GetDataType(snapshot->GetType(snapshot->FindValue(snapshotNode, key))));
+
 	if (!PushValue(key))
 		return NIL;
 
 	const int type = lua_type(L, -1);
 	lua_pop(L, 1);
 
-	switch (type) {
-		case LUA_TBOOLEAN: return BOOLEAN;
-		case LUA_TNUMBER:  return NUMBER;
-		case LUA_TSTRING:  return STRING;
-		case LUA_TTABLE:   return TABLE;
-		default:           return NIL;
-	}
+	return (GetDataType(type));
 }
 
 
@@ -1101,6 +1226,9 @@ LuaTable::DataType LuaTable::GetType(const std::string& key) const
 
 int LuaTable::GetLength() const
 {
+	if (snapshot != nullptr)
+		return (snapshot->GetLength(snapshotNode));
+
 	if (!PushTable())
 		return 0;
 
@@ -1110,6 +1238,11 @@ int LuaTable::GetLength() const
 
 int LuaTable::GetLength(int key) const
 {
+	if (snapshot != nullptr) {
+		const LuaTableSnapshot::Value* value = snapshot->FindValue(snapshotNode, key);
+		return ((value != nullptr)? value->length: 0);
+	}
+
 	if (!PushValue(key))
 		return 0;
 
@@ -1121,6 +1254,11 @@ int LuaTable::GetLength(int key) const
 
 int LuaTable::GetLength(const std::string& key) const
 {
+	if (snapshot != nullptr) {
+		const LuaTableSnapshot::Value* value = snapshot->FindValue(snapshotNode, key);
+		return ((value != nullptr)? value->length: 0);
+	}
+
 	if (!PushValue(key))
 		return 0;
 
@@ -1138,6 +1276,9 @@ int LuaTable::GetLength(const std::string& key) const
 
 bool LuaTable::GetKeys(std::vector<int>& data) const
 {
+	if (snapshot != nullptr)
+		return (snapshot->GetKeys(snapshotNode, data));
+
 	if (!PushTable())
 		return false;
 
@@ -1155,6 +1296,9 @@ bool LuaTable::GetKeys(std::vector<int>& data) const
 
 bool LuaTable::GetKeys(std::vector<std::string>& data) const
 {
+	if (snapshot != nullptr)
+		return (snapshot->GetKeys(snapshotNode, data));
+
 	if (!PushTable())
 		return false;
 
@@ -1173,6 +1317,9 @@ bool LuaTable::GetKeys(std::vector<std::string>& data) const
 
 bool LuaTable::GetPairs(std::vector<std::pair<int, std::string>>& data) const
 {
+	if (snapshot != nullptr)
+		return (snapshot->GetPairs(snapshotNode, data));
+
 	if (!PushTable())
 		return false;
 
@@ -1201,6 +1348,9 @@ bool LuaTable::GetPairs(std::vector<std::pair<int, std::string>>& data) const
 
 bool LuaTable::GetPairs(std::vector<std::pair<std::string, float>>& data) const
 {
+	if (snapshot != nullptr)
+		return (snapshot->GetPairs(snapshotNode, data));
+
 	if (!PushTable())
 		return false;
 
@@ -1222,6 +1372,9 @@ bool LuaTable::GetPairs(std::vector<std::pair<std::string, float>>& data) const
 
 bool LuaTable::GetPairs(std::vector<std::pair<std::string, std::string>>& data) const
 {
+	if (snapshot != nullptr)
+		return (snapshot->GetPairs(snapshotNode, data));
+
 	if (!PushTable())
 		return false;
 
@@ -1257,6 +1410,9 @@ bool LuaTable::GetPairs(std::vector<std::pair<std::string, std::string>>& data)
 
 bool LuaTable::GetMap(spring::unordered_map<int, float>& data) const
 {
+	if (snapshot != nullptr)
+		return (snapshot->GetMap(snapshotNode, data));
+
 	if (!PushTable())
 		return false;
 
@@ -1274,6 +1430,9 @@ bool LuaTable::GetMap(spring::unordered_map<int, float>& data) const
 
 bool LuaTable::GetMap(spring::unordered_map<int, std::string>& data) const
 {
+	if (snapshot != nullptr)
+		return (snapshot->GetMap(snapshotNode, data));
+
 	if (!PushTable())
 		return false;
 
@@ -1298,6 +1457,9 @@ bool LuaTable::GetMap(spring::unordered_map<int, std::string>& data) const
 
 bool LuaTable::GetMap(spring::unordered_map<std::string, float>& data) const
 {
+	if (snapshot != nullptr)
+		return (snapshot->GetMap(snapshotNode, data));
+
 	if (!PushTable())
 		return false;
 
@@ -1315,6 +1477,9 @@ bool LuaTable::GetMap(spring::unordered_map<std::string, float>& data) const
 
 bool LuaTable::GetMap(spring::unordered_map<std::string, std::string>& data) const
 {
+	if (snapshot != nullptr)
+		return (snapshot->GetMap(snapshotNode, data));
+
 	if (!PushTable())
 		return false;
 
@@ -1431,6 +1596,9 @@ static bool ParseBoolean(lua_State* L, int index, bool& value)
 
 int LuaTable::Get(const std::string& key, int def) const
 {
+	if (snapshot != nullptr)
+		return (snapshot->Get(snapshot->FindValue(snapshotNode, key), def));
+
 	if (!PushValue(key))
 		return def;
 
@@ -1446,6 +1614,9 @@ int LuaTable::Get(const std::string& key, int def) const
 
 bool LuaTable::Get(const std::string& key, bool def) const
 {
+	if (snapshot != nullptr)
+		return (snapshot->Get(snapshot->FindValue(snapshotNode, key), def));
+
 	if (!PushValue(key))
 		return def;
 
@@ -1461,6 +1632,9 @@ bool LuaTable::Get(const std::string& key, bool def) const
 
 float LuaTable::Get(const std::string& key, float def) const
 {
+	if (snapshot != nullptr)
+		return (snapshot->Get(snapshot->FindValue(snapshotNode, key), def));
+
 	if (!PushValue(key))
 		return def;
 
@@ -1477,6 +1651,9 @@ float LuaTable::Get(const std::string& key, float def) const
 
 float3 LuaTable::Get(const std::string& key, const float3& def) const
 {
+	if (snapshot != nullptr)
+		return (snapshot->Get(snapshot->FindValue(snapshotNode, key), def));
+
 	if (!PushValue(key))
 		return def;
 
@@ -1491,6 +1668,9 @@ float3 LuaTable::Get(const std::string& key, const float3& def) const
 
 float4 LuaTable::Get(const std::string& key, const float4& def) const
 {
+	if (snapshot != nullptr)
+		return (snapshot->Get(snapshot->FindValue(snapshotNode, key), def));
+
 	if (!PushValue(key))
 		return def;
 
@@ -1507,6 +1687,9 @@ float4 LuaTable::Get(const std::string& key, const float4& def) const
 
 std::string LuaTable::Get(const std::string& key, const std::string& def) const
 {
+	if (snapshot != nullptr)
+		return (snapshot->Get(snapshot->FindValue(snapshotNode, key), def));
+
 	if (!PushValue(key))
 		return def;
 
@@ -1528,6 +1711,9 @@ std::string LuaTable::Get(const std::string& key, const std::string& def) const
 
 int LuaTable::Get(int key, int def) const
 {
+	if (snapshot != nullptr)
+		return (snapshot->Get(snapshot->FindValue(snapshotNode, key), def));
+
 	if (!PushValue(key))
 		return def;
 
@@ -1543,6 +1729,9 @@ int LuaTable::Get(int key, int def) const
 
 bool LuaTable::Get(int key, bool def) const
 {
+	if (snapshot != nullptr)
+		return (snapshot->Get(snapshot->FindValue(snapshotNode, key), def));
+
 	if (!PushValue(key))
 		return def;
 
@@ -1558,6 +1747,9 @@ bool LuaTable::Get(int key, bool def) const
 
 float LuaTable::Get(int key, float def) const
 {
+	if (snapshot != nullptr)
+		return (snapshot->Get(snapshot->FindValue(snapshotNode, key), def));
+
 	if (!PushValue(key))
 		return def;
 
@@ -1574,6 +1766,9 @@ float LuaTable::Get(int key, float def) const
 
 float3 LuaTable::Get(int key, const float3& def) const
 {
+	if (snapshot != nullptr)
+		return (snapshot->Get(snapshot->FindValue(snapshotNode, key), def));
+
 	if (!PushValue(key))
 		return def;
 
@@ -1588,6 +1783,9 @@ float3 LuaTable::Get(int key, const float3& def) const
 
 float4 LuaTable::Get(int key, const float4& def) const
 {
+	if (snapshot != nullptr)
+		return (snapshot->Get(snapshot->FindValue(snapshotNode, key), def));
+
 	if (!PushValue(key)) {
 		return def;
 	}
@@ -1604,6 +1802,9 @@ float4 LuaTable::Get(int key, const float4& def) const
 
 std::string LuaTable::Get(int key, const std::string& def) const
 {
+	if (snapshot != nullptr)
+		return (snapshot->Get(snapshot->FindValue(snapshotNode, key), def));
+
 	if (!PushValue(key))
 		return def;
 
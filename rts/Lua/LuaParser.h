@@ -3,6 +3,8 @@
 #ifndef LUA_PARSER_H
 #define LUA_PARSER_H
 
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -15,6 +17,7 @@ class float3;
 struct float4;
 class LuaTable;
 class LuaParser;
+class LuaTableSnapshot;
 struct lua_State;
 
 
@@ -33,7 +36,9 @@ public:
 	LuaTable SubTable(const std::string& key) const;
 	LuaTable SubTableExpr(const std::string& expr) const;
 
-	bool IsValid() const { return (parser != nullptr); }
+	bool IsValid() const { return (parser != nullptr || snapshot != nullptr); }
+	// true if backed by a LuaTableSnapshot, safe to read from multiple threads
+	bool IsSnapshot() const { return (snapshot != nullptr); }
 
 	const std::string& GetPath() const { return path; }
 
@@ -112,6 +117,9 @@ private:
 	LuaParser* parser;
 	lua_State* L;
 	int refnum;
+
+	std::shared_ptr<const LuaTableSnapshot> snapshot;
+	int snapshotNode;
 };
 
 
@@ -136,6 +144,14 @@ public:
 	bool NoTable() const { return (errorLog.find("no return table") == 0); } // parser is still valid if true
 
 	LuaTable GetRoot();
+
+	// replaces the executed root table by an immutable copy for all
+	// tables obtained from GetRoot afterwards, see LuaTableSnapshot
+	bool CreateSnapshot();
+	bool ReadSnapshot(const std::uint8_t* data, size_t size);
+	bool WriteSnapshot(std::vector<std::uint8_t>& buffer) const;
+	// serializes a global table of the (set-up) environment
+	bool WriteGlobalTable(const std::string& name, std::vector<std::uint8_t>& buffer);
 	LuaTable SubTableExpr(const std::string& expr) {
 		return GetRoot().SubTableExpr(expr);
 	}
@@ -184,6 +200,8 @@ private:
 
 	std::string errorLog;
 
+	std::shared_ptr<const LuaTableSnapshot> snapshot;
+
 	int initDepth = -1;
 	int rootRef = -1;
 	int currentRef = -1;
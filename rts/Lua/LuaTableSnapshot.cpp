@@ -0,0 +1,588 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "LuaTableSnapshot.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "LuaInclude.h"
+#include "System/BinaryBuffer.h"
+#include "System/StringUtil.h"
+
+
+static_assert(sizeof(lua_Number) == sizeof(float), "snapshot stores lua_Number's as float");
+
+
+bool LuaTableSnapshot::Create(lua_State* L, int index, bool lowerKeys)
+{
+	Clear();
+
+	if (!lua_istable(L, index))
+		return false;
+
+	spring::unsynced_map<const void*, int> nodeIndices;
+
+	lowerCppKeys = lowerKeys;
+
+	AddNode(L, (index > 0)? index: (lua_gettop(L) + index + 1), nodeIndices);
+	return true;
+}
+
+void LuaTableSnapshot::Clear()
+{
+	nodes.clear();
+	values.clear();
+}
+
+
+int LuaTableSnapshot::AddNode(lua_State* L, int index, spring::unsynced_map<const void*, int>& nodeIndices)
+{
+	// tables can be shared or reference themselves
+	const auto it = nodeIndices.find(lua_topointer(L, index));
+
+	if (it != nodeIndices.end())
+		return it->second;
+
+	const int nodeIdx = nodes.size();
+
+	nodeIndices[lua_topointer(L, index)] = nodeIdx;
+	nodes.emplace_back();
+	nodes[nodeIdx].length = lua_objlen(L, index);
+
+	// key, value, and a converted copy of either
+	lua_checkstack(L, 4);
+
+	for (lua_pushnil(L); lua_next(L, index) != 0; lua_pop(L, 1)) {
+		const int keyType = lua_type(L, -2);
+
+		// keys of other types are invisible to LuaTable
+		if (keyType != LUA_TNUMBER && keyType != LUA_TSTRING)
+			continue;
+
+		const int valueIdx = AddValue(L, lua_gettop(L), nodeIndices);
+
+		if (keyType == LUA_TSTRING) {
+			nodes[nodeIdx].strKeys.emplace_back(lua_tostring(L, -2), valueIdx);
+		} else {
+			nodes[nodeIdx].numKeys.push_back({lua_tonumber(L, -2), lua_toint(L, -2), valueIdx});
+		}
+	}
+
+	auto& strKeys = nodes[nodeIdx].strKeys;
+
+	std::stable_sort(strKeys.begin(), strKeys.end(), [](const std::pair<std::string, int>& a, const std::pair<std::string, int>& b) {
+		return (a.first < b.first);
+	});
+
+	return nodeIdx;
+}
+
+int LuaTableSnapshot::AddValue(lua_State* L, int index, spring::unsynced_map<const void*, int>& nodeIndices)
+{
+	const int valueIdx = values.size();
+
+	{
+		values.emplace_back();
+
+		Value& value = values.back();
+
+		value.type     = lua_type(L, index);
+		value.isNumber = lua_isnumber(L, index);
+		value.number   = lua_tonumber(L, index);
+		value.integer  = lua_toint(L, index);
+		value.boolean  = lua_toboolean(L, index);
+
+		if (lua_isstring(L, index)) {
+			// converting a number happens in-place, never do it to the original
+			lua_pushvalue(L, index);
+			value.str = lua_tostring(L, -1);
+			value.length = lua_objlen(L, -1);
+			lua_pop(L, 1);
+		} else {
+			value.length = lua_objlen(L, index);
+		}
+	}
+
+	if (lua_istable(L, index)) {
+		const int nodeIdx = AddNode(L, index, nodeIndices);
+		values[valueIdx].table = nodeIdx;
+	}
+
+	return valueIdx;
+}
+
+
+/******************************************************************************/
+
+// layout (native endianness): counts and flags, then all nodes, then all values
+void LuaTableSnapshot::Serialize(std::vector<std::uint8_t>& buffer) const
+{
+	BinaryWriter writer(buffer);
+
+	writer.Write(std::uint32_t(nodes.size()));
+	writer.Write(std::uint32_t(values.size()));
+	writer.Write(std::uint8_t(lowerCppKeys));
+
+	for (const Node& node: nodes) {
+		writer.Write(std::int32_t(node.length));
+		writer.Write(std::uint32_t(node.strKeys.size()));
+		writer.Write(std::uint32_t(node.numKeys.size()));
+
+		for (const auto& strKey: node.strKeys) {
+			writer.WriteString(strKey.first);
+			writer.Write(std::int32_t(strKey.second));
+		}
+		for (const NumKey& numKey: node.numKeys) {
+			writer.Write(numKey.key);
+			writer.Write(std::int32_t(numKey.intKey));
+			writer.Write(std::int32_t(numKey.value));
+		}
+	}
+
+	for (const Value& value: values) {
+		writer.WriteString(value.str);
+		writer.Write(value.number);
+		writer.Write(std::int32_t(value.integer));
+		writer.Write(std::int32_t(value.length));
+		writer.Write(std::int32_t(value.table));
+		writer.Write(value.type);
+		writer.Write(std::uint8_t(value.isNumber));
+		writer.Write(std::uint8_t(value.boolean));
+	}
+}
+
+bool LuaTableSnapshot::Deserialize(const std::uint8_t* data, size_t size)
+{
+	Clear();
+
+	BinaryReader reader(data, size);
+
+	std::uint32_t numNodes = 0;
+	std::uint32_t numValues = 0;
+	std::uint8_t lowerKeys = 0;
+
+	if (!reader.Read(numNodes) || !reader.Read(numValues) || !reader.Read(lowerKeys))
+		return false;
+	// every count below is bounded by the data actually present
+	if (numNodes == 0 || numNodes > size || numValues > size)
+		return false;
+
+	nodes.resize(numNodes);
+	values.resize(numValues);
+
+	lowerCppKeys = (lowerKeys != 0);
+
+	const auto IsValidValue = [&](std::int32_t idx) { return (idx >= 0 && std::uint32_t(idx) < numValues); };
+
+	for (Node& node: nodes) {
+		std::int32_t length = 0;
+		std::uint32_t numStrKeys = 0;
+		std::uint32_t numNumKeys = 0;
+
+		if (!reader.Read(length) || !reader.Read(numStrKeys) || !reader.Read(numNumKeys))
+			return false;
+		if (numStrKeys > size || numNumKeys > size)
+			return false;
+
+		node.length = length;
+		node.strKeys.resize(numStrKeys);
+		node.numKeys.resize(numNumKeys);
+
+		for (auto& strKey: node.strKeys) {
+			std::int32_t valueIdx = -1;
+
+			if (!reader.ReadString(strKey.first) || !reader.Read(valueIdx) || !IsValidValue(valueIdx))
+				return false;
+
+			strKey.second = valueIdx;
+		}
+		for (NumKey& numKey: node.numKeys) {
+			std::int32_t intKey = 0;
+			std::int32_t valueIdx = -1;
+
+			if (!reader.Read(numKey.key) || !reader.Read(intKey) || !reader.Read(valueIdx) || !IsValidValue(valueIdx))
+				return false;
+
+			numKey.intKey = intKey;
+			numKey.value = valueIdx;
+		}
+	}
+
+	for (Value& value: values) {
+		std::int32_t integer = 0;
+		std::int32_t length = 0;
+		std::int32_t table = -1;
+		std::uint8_t isNumber = 0;
+		std::uint8_t boolean = 0;
+
+		if (!reader.ReadString(value.str) || !reader.Read(value.number))
+			return false;
+		if (!reader.Read(integer) || !reader.Read(length) || !reader.Read(table))
+			return false;
+		if (!reader.Read(value.type) || !reader.Read(isNumber) || !reader.Read(boolean))
+			return false;
+		// FindTable hands out the index of anything that is not -1
+		if ((value.type == LUA_TTABLE) != (table != -1))
+			return false;
+		if (table != -1 && (table < 0 || std::uint32_t(table) >= numNodes))
+			return false;
+
+		value.integer = integer;
+		value.length = length;
+		value.table = table;
+		value.isNumber = (isNumber != 0);
+		value.boolean = (boolean != 0);
+	}
+
+	if (!reader.AtEnd()) {
+		Clear();
+		return false;
+	}
+
+	return true;
+}
+
+
+/******************************************************************************/
+
+const LuaTableSnapshot::Value* LuaTableSnapshot::FindStrKey(int node, const std::string& key) const
+{
+	const auto& strKeys = nodes[node].strKeys;
+	const auto pred = [](const std::pair<std::string, int>& p, const std::string& k) { return (p.first < k); };
+	const auto iter = std::lower_bound(strKeys.begin(), strKeys.end(), key, pred);
+
+	if (iter == strKeys.end() || iter->first != key)
+		return nullptr;
+
+	return &values[iter->second];
+}
+
+const LuaTableSnapshot::Value* LuaTableSnapshot::FindNumKey(int node, float key) const
+{
+	for (const NumKey& numKey: nodes[node].numKeys) {
+		if (numKey.key == key)
+			return &values[numKey.value];
+	}
+
+	return nullptr;
+}
+
+
+const LuaTableSnapshot::Value* LuaTableSnapshot::FindValue(int node, int key) const
+{
+	return (FindNumKey(node, key));
+}
+
+const LuaTableSnapshot::Value* LuaTableSnapshot::FindValue(int node, const std::string& mixedKey) const
+{
+	const std::string key = lowerCppKeys? StringToLower(mixedKey): mixedKey;
+
+	if (key.find('.') == std::string::npos)
+		return (FindStrKey(node, key));
+
+	// nested key (e.g. "subtable.subsub.mahkey"), mirrors LuaTable::PushValue
+	size_t lastpos = 0;
+	size_t dotpos = key.find('.');
+
+	do {
+		const Value* subTable = FindStrKey(node, key.substr(lastpos, dotpos));
+
+		if (subTable == nullptr || subTable->table < 0)
+			return nullptr;
+
+		node = subTable->table;
+		lastpos = dotpos + 1;
+		dotpos = key.find('.', lastpos);
+	} while (dotpos != std::string::npos);
+
+	const std::string keyname = key.substr(lastpos);
+	const Value* value = FindStrKey(node, keyname);
+
+	if (value != nullptr)
+		return value;
+
+	bool failed;
+	const int i = StringToInt(keyname, &failed);
+
+	if (failed)
+		return nullptr;
+
+	return (FindNumKey(node, i));
+}
+
+
+int LuaTableSnapshot::FindTable(int node, int key) const
+{
+	const Value* value = FindNumKey(node, key);
+
+	if (value == nullptr)
+		return -1;
+
+	return value->table;
+}
+
+int LuaTableSnapshot::FindTable(int node, const std::string& mixedKey) const
+{
+	const Value* value = FindStrKey(node, lowerCppKeys? StringToLower(mixedKey): mixedKey);
+
+	if (value == nullptr)
+		return -1;
+
+	return value->table;
+}
+
+
+/******************************************************************************/
+
+static bool IsString(const LuaTableSnapshot::Value* value) { return (value->type == LUA_TSTRING || value->type == LUA_TNUMBER); }
+
+template<typename P> static void SortPairs(std::vector<P>& data)
+{
+	std::stable_sort(data.begin(), data.end(), [](const P& a, const P& b) { return (a.first < b.first); });
+}
+
+
+bool LuaTableSnapshot::GetKeys(int node, std::vector<int>& data) const
+{
+	for (const NumKey& numKey: nodes[node].numKeys) {
+		data.push_back(numKey.intKey);
+	}
+
+	std::stable_sort(data.begin(), data.end());
+	return true;
+}
+
+bool LuaTableSnapshot::GetKeys(int node, std::vector<std::string>& data) const
+{
+	for (const auto& strKey: nodes[node].strKeys) {
+		data.emplace_back(strKey.first.c_str());
+	}
+
+	std::stable_sort(data.begin(), data.end());
+	return true;
+}
+
+
+bool LuaTableSnapshot::GetPairs(int node, std::vector<std::pair<int, std::string>>& data) const
+{
+	for (const NumKey& numKey: nodes[node].numKeys) {
+		const Value* value = &values[numKey.value];
+
+		if (!IsString(value))
+			continue;
+
+		data.emplace_back(numKey.intKey, value->str);
+	}
+
+	SortPairs(data);
+	return true;
+}
+
+bool LuaTableSnapshot::GetPairs(int node, std::vector<std::pair<std::string, float>>& data) const
+{
+	for (const auto& strKey: nodes[node].strKeys) {
+		const Value* value = &values[strKey.second];
+
+		if (!value->isNumber)
+			continue;
+
+		data.emplace_back(strKey.first.c_str(), value->number);
+	}
+
+	SortPairs(data);
+	return true;
+}
+
+bool LuaTableSnapshot::GetPairs(int node, std::vector<std::pair<std::string, std::string>>& data) const
+{
+	for (const auto& strKey: nodes[node].strKeys) {
+		const Value* value = &values[strKey.second];
+
+		if (IsString(value)) {
+			data.emplace_back(strKey.first.c_str(), value->str);
+			continue;
+		}
+		if (value->type == LUA_TBOOLEAN) {
+			data.emplace_back(strKey.first.c_str(), value->boolean ? "1" : "0");
+			continue;
+		}
+	}
+
+	SortPairs(data);
+	return true;
+}
+
+
+bool LuaTableSnapshot::GetMap(int node, spring::unordered_map<int, float>& data) const
+{
+	for (const NumKey& numKey: nodes[node].numKeys) {
+		const Value* value = &values[numKey.value];
+
+		if (!value->isNumber)
+			continue;
+
+		data[numKey.intKey] = value->number;
+	}
+
+	return true;
+}
+
+bool LuaTableSnapshot::GetMap(int node, spring::unordered_map<int, std::string>& data) const
+{
+	for (const NumKey& numKey: nodes[node].numKeys) {
+		const Value* value = &values[numKey.value];
+
+		if (!IsString(value))
+			continue;
+
+		data[numKey.intKey] = value->str;
+	}
+
+	return true;
+}
+
+bool LuaTableSnapshot::GetMap(int node, spring::unordered_map<std::string, float>& data) const
+{
+	for (const auto& strKey: nodes[node].strKeys) {
+		const Value* value = &values[strKey.second];
+
+		if (!value->isNumber)
+			continue;
+
+		data[strKey.first.c_str()] = value->number;
+	}
+
+	return true;
+}
+
+bool LuaTableSnapshot::GetMap(int node, spring::unordered_map<std::string, std::string>& data) const
+{
+	for (const auto& strKey: nodes[node].strKeys) {
+		const Value* value = &values[strKey.second];
+
+		if (IsString(value)) {
+			data[strKey.first.c_str()] = value->str;
+			continue;
+		}
+		if (value->type == LUA_TBOOLEAN) {
+			data[strKey.first.c_str()] = value->boolean ? "1" : "0";
+			continue;
+		}
+	}
+
+	return true;
+}
+
+
+/******************************************************************************/
+
+int LuaTableSnapshot::GetType(const Value* value) const
+{
+	if (value == nullptr)
+		return LUA_TNIL;
+
+	return value->type;
+}
+
+
+// these mirror the lua_State-based parsing functions in LuaParser.cpp
+bool LuaTableSnapshot::ParseTableFloat(int node, int index, float& value) const
+{
+	const Value* v = FindNumKey(node, index);
+
+	if (v == nullptr)
+		return false;
+
+	value = v->number;
+	return (value != 0.0f || v->isNumber || IsString(v));
+}
+
+
+int LuaTableSnapshot::Get(const Value* value, int def) const
+{
+	if (value == nullptr)
+		return def;
+
+	if (value->integer == 0 && !value->isNumber && !IsString(value))
+		return def;
+
+	return value->integer;
+}
+
+bool LuaTableSnapshot::Get(const Value* value, bool def) const
+{
+	if (value == nullptr)
+		return def;
+
+	if (value->type == LUA_TBOOLEAN)
+		return value->boolean;
+
+	if (value->isNumber)
+		return (value->number != 0.0f);
+
+	if (IsString(value)) {
+		const std::string str = StringToLower(value->str);
+
+		if ((str == "1") || (str == "true"))
+			return true;
+		if ((str == "0") || (str == "false"))
+			return false;
+	}
+
+	return def;
+}
+
+float LuaTableSnapshot::Get(const Value* value, float def) const
+{
+	if (value == nullptr)
+		return def;
+
+	if (value->number == 0.0f && !value->isNumber && !IsString(value))
+		return def;
+
+	return value->number;
+}
+
+float3 LuaTableSnapshot::Get(const Value* value, const float3& def) const
+{
+	if (value == nullptr)
+		return def;
+
+	float3 ret;
+
+	if (value->table >= 0) {
+		if (ParseTableFloat(value->table, 1, ret.x) && ParseTableFloat(value->table, 2, ret.y) && ParseTableFloat(value->table, 3, ret.z))
+			return ret;
+	} else if (IsString(value)) {
+		if (sscanf(value->str.c_str(), "%f %f %f", &ret.x, &ret.y, &ret.z) == 3)
+			return ret;
+	}
+
+	return def;
+}
+
+float4 LuaTableSnapshot::Get(const Value* value, const float4& def) const
+{
+	if (value == nullptr)
+		return def;
+
+	float4 ret;
+
+	if (value->table >= 0) {
+		if (ParseTableFloat(value->table, 1, ret.x) && ParseTableFloat(value->table, 2, ret.y) && ParseTableFloat(value->table, 3, ret.z) && ParseTableFloat(value->table, 4, ret.w))
+			return ret;
+	} else if (IsString(value)) {
+		if (sscanf(value->str.c_str(), "%f %f %f %f", &ret.x, &ret.y, &ret.z, &ret.w) == 4)
+			return ret;
+	}
+
+	return def;
+}
+
+std::string LuaTableSnapshot::Get(const Value* value, const std::string& def) const
+{
+	if (value == nullptr || !IsString(value))
+		return def;
+
+	return value->str;
+}
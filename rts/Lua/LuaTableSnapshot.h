@@ -0,0 +1,109 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef LUA_TABLE_SNAPSHOT_H
+#define LUA_TABLE_SNAPSHOT_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "System/float3.h"
+#include "System/float4.h"
+#include "System/UnorderedMap.hpp"
+
+struct lua_State;
+
+/**
+ * Immutable copy of a Lua table (and everything reachable from it) that
+ * LuaTable can read from instead of a lua_State. Every conversion LuaTable
+ * performs is evaluated once while copying, so snapshot-backed tables return
+ * exactly what the live ones would; unlike those they can be read from any
+ * number of threads at once and survive without the lua_State, which allows
+ * them to be stored in and restored from a cache file.
+ */
+class LuaTableSnapshot {
+public:
+	struct Value {
+		std::string str;       // lua_tostring, strings and numbers only
+		float number = 0.0f;   // lua_tonumber
+		int integer = 0;       // lua_toint
+		int length = 0;        // lua_objlen
+		int table = -1;        // node index, tables only
+		std::int8_t type = 0;  // lua_type (LUA_TNIL)
+		bool isNumber = false; // lua_isnumber, includes numeric strings
+		bool boolean = false;  // lua_toboolean
+	};
+
+	struct NumKey {
+		float key;
+		int intKey; // lua_toint
+		int value;
+	};
+
+	struct Node {
+		// sorted, for binary search
+		std::vector<std::pair<std::string, int>> strKeys;
+		// in traversal order, which LuaTable results can depend on
+		std::vector<NumKey> numKeys;
+
+		int length = 0;
+	};
+
+public:
+	bool Create(lua_State* L, int index, bool lowerCppKeys);
+	void Clear();
+
+	void Serialize(std::vector<std::uint8_t>& buffer) const;
+	bool Deserialize(const std::uint8_t* data, size_t size);
+
+	bool Empty() const { return nodes.empty(); }
+	int GetRootNode() const { return 0; }
+
+	// LuaTable::PushValue semantics (lowered and dotted keys)
+	const Value* FindValue(int node, int key) const;
+	const Value* FindValue(int node, const std::string& key) const;
+	// LuaTable::SubTable semantics
+	int FindTable(int node, int key) const;
+	int FindTable(int node, const std::string& key) const;
+
+	int GetLength(int node) const { return nodes[node].length; }
+
+	bool GetKeys(int node, std::vector<int>& data) const;
+	bool GetKeys(int node, std::vector<std::string>& data) const;
+
+	bool GetPairs(int node, std::vector<std::pair<int, std::string>>& data) const;
+	bool GetPairs(int node, std::vector<std::pair<std::string, float>>& data) const;
+	bool GetPairs(int node, std::vector<std::pair<std::string, std::string>>& data) const;
+
+	bool GetMap(int node, spring::unordered_map<int, float>& data) const;
+	bool GetMap(int node, spring::unordered_map<int, std::string>& data) const;
+	bool GetMap(int node, spring::unordered_map<std::string, float>& data) const;
+	bool GetMap(int node, spring::unordered_map<std::string, std::string>& data) const;
+
+	int GetType(const Value* value) const;
+
+	int         Get(const Value* value, int def) const;
+	bool        Get(const Value* value, bool def) const;
+	float       Get(const Value* value, float def) const;
+	float3      Get(const Value* value, const float3& def) const;
+	float4      Get(const Value* value, const float4& def) const;
+	std::string Get(const Value* value, const std::string& def) const;
+
+private:
+	int AddNode(lua_State* L, int index, spring::unsynced_map<const void*, int>& nodeIndices);
+	int AddValue(lua_State* L, int index, spring::unsynced_map<const void*, int>& nodeIndices);
+
+	const Value* FindStrKey(int node, const std::string& key) const;
+	const Value* FindNumKey(int node, float key) const;
+
+	bool ParseTableFloat(int node, int index, float& value) const;
+
+private:
+	std::vector<Node> nodes;
+	std::vector<Value> values;
+
+	bool lowerCppKeys = true;
+};
+
+#endif // LUA_TABLE_SNAPSHOT_H
@@ -2444,9 +2444,7 @@ int LuaUnsyncedCtrl::GiveOrderToUnit(lua_State* L)
 		return 1;
 	}
 
-	const Command cmd = LuaUtils::ParseCommand(L, __func__, 2);
-
-	clientNet->Send(CBaseNetProtocol::Get().SendAICommand(gu->myPlayerNum, MAX_AIS, MAX_TEAMS, unit->id, cmd.GetID(false), cmd.GetID(true), cmd.GetTimeOut(), cmd.GetOpts(), cmd.GetNumParams(), cmd.GetParams()));
+	selectedUnitsHandler.SendCommandToUnit(unit->id, LuaUtils::ParseCommand(L, __func__, 2));
 
 	lua_pushboolean(L, true);
 	return 1;
@@ -51,6 +51,8 @@ void CBasicMapDamage::Init()
 	explosionSquaresPool.resize(4 * 1024 * 1024);
 	explosionUpdateQueue.clear();
 	explosionUpdateQueue.reserve(64);
+	pendingRecalcAreas.clear();
+	pendingTerrainChanges.clear();
 
 	std::fill(explosionSquaresPool.begin(), explosionSquaresPool.end(), 0.0f);
 }
@@ -215,6 +217,11 @@ void CBasicMapDamage::Explosion(const float3& pos, float strength, float radius)
 void CBasicMapDamage::RecalcArea(int x1, int x2, int y1, int y2)
 {
 	readMap->UpdateHeightMapSynced(SRectangle(x1, y1, x2, y2));
+	NotifyTerrainChange(x1, x2, y1, y2);
+}
+
+void CBasicMapDamage::NotifyTerrainChange(int x1, int x2, int y1, int y2)
+{
 	featureHandler.TerrainChanged(x1, y1, x2, y2);
 	{
 		SCOPED_TIMER("Sim::BasicMapDamage::Los");
@@ -227,6 +234,60 @@ void CBasicMapDamage::RecalcArea(int x1, int x2, int y1, int y2)
 }
 
 
+bool CBasicMapDamage::OverlapsPendingRecalc(const Explo& e)
+{
+	// recalculation reads corner heights a few squares beyond each area
+	// (center heights, face normals, half-resolution slopes) and the path
+	// passability update reads slopes two squares beyond that, so pad it
+	constexpr int RECALC_MARGIN = 8;
+
+	const auto Overlaps = [&](int x1, int x2, int z1, int z2) {
+		const SRectangle addRect = {x1 - RECALC_MARGIN, z1 - RECALC_MARGIN, x2 + 1 + RECALC_MARGIN, z2 + 1 + RECALC_MARGIN};
+
+		for (auto it = pendingRecalcAreas.cbegin(); it != pendingRecalcAreas.cend(); ++it) {
+			if (addRect.CheckOverlap(*it))
+				return true;
+		}
+
+		return false;
+	};
+
+	if (Overlaps(e.x1, e.x2, e.y1, e.y2))
+		return true;
+
+	for (const ExploBuilding& b: e.buildings) {
+		if (Overlaps(b.tx1, b.tx2, b.tz1, b.tz2))
+			return true;
+	}
+
+	return false;
+}
+
+void CBasicMapDamage::RecalcPendingAreas()
+{
+	if (pendingRecalcAreas.empty())
+		return;
+
+	// split overlapping craters into disjoint rectangles, derived maps are
+	// pure functions of the corner heights so the merged result is the same
+	pendingRecalcAreas.Process();
+
+	for (auto it = pendingRecalcAreas.cbegin(); it != pendingRecalcAreas.cend(); ++it) {
+		readMap->UpdateHeightMapSynced(SRectangle(it->x1, it->y1, it->x2, it->y2));
+	}
+
+	// features, LOS and pathing depend on the shape and order of the areas
+	// (update-queue order, QTPFS tesselation), so they still get one change
+	// per crater exactly as if each had been recalculated on its own
+	for (const SRectangle& r: pendingTerrainChanges) {
+		NotifyTerrainChange(r.x1, r.x2, r.y1, r.y2);
+	}
+
+	pendingRecalcAreas.clear();
+	pendingTerrainChanges.clear();
+}
+
+
 void CBasicMapDamage::Update()
 {
 	SCOPED_TIMER("Sim::BasicMapDamage");
@@ -237,6 +298,11 @@ void CBasicMapDamage::Update()
 		if ((e.ttl--) <= 0)
 			continue;
 
+		// an earlier crater's area must be recalculated before this one
+		// changes any heights it depends on, otherwise defer and merge
+		if (!pendingRecalcAreas.empty() && OverlapsPendingRecalc(e))
+			RecalcPendingAreas();
+
 
 		unsigned int expSquarePoolIdx = e.idx;
 
@@ -266,9 +332,12 @@ void CBasicMapDamage::Update()
 		if (e.ttl != 0)
 			continue;
 
-		RecalcArea(e.x1 - 1, e.x2 + 1, e.y1 - 1, e.y2 + 1);
+		pendingRecalcAreas.push_back({e.x1 - 1, e.y1 - 1, e.x2 + 1, e.y2 + 1});
+		pendingTerrainChanges.push_back({e.x1 - 1, e.y1 - 1, e.x2 + 1, e.y2 + 1});
 	}
 
+	RecalcPendingAreas();
+
 
 	// pop explosions that are no longer being processed
 	while (explUpdateQueueIdx < explosionUpdateQueue.size()) {
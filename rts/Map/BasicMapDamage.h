@@ -4,6 +4,7 @@
 #define _BASIC_MAP_DAMAGE_H
 
 #include "MapDamage.h"
+#include "System/Misc/RectangleOverlapHandler.h"
 
 #include <vector>
 
@@ -21,6 +22,12 @@ public:
 	bool Disabled() const override { return false; }
 
 private:
+	struct Explo;
+
+	bool OverlapsPendingRecalc(const Explo& e);
+	void RecalcPendingAreas();
+	void NotifyTerrainChange(int x1, int x2, int y1, int y2);
+
 	void SetExplosionSquare(float v) {
 		explosionSquaresPool[explSquaresPoolIdx] = v;
 
@@ -61,6 +68,11 @@ private:
 	std::vector<float> explosionSquaresPool;
 	std::vector<Explo> explosionUpdateQueue;
 
+	// areas of craters that finished this frame, merged before recalculation
+	CRectangleOverlapHandler pendingRecalcAreas;
+	// the same areas unmerged and in crater order, for the synced consumers
+	std::vector<SRectangle> pendingTerrainChanges;
+
 	static constexpr unsigned int CRATER_TABLE_SIZE = 200;
 	static constexpr unsigned int EXPLOSION_LIFETIME = 10;
 
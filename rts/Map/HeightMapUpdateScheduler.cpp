@@ -0,0 +1,191 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+
+#include "HeightMapUpdateScheduler.h"
+#include "Sim/Misc/GlobalConstants.h"
+#include "System/SpringMath.h"
+#include "System/Misc/SpringTime.h"
+
+
+void CHeightMapUpdateScheduler::Init()
+{
+	pendingRects.clear();
+	pendingRects.reserve(256);
+	sortedRects.clear();
+	sortedRects.reserve(256);
+	splitRects.clear();
+	priorities.clear();
+	processedRects.clear();
+
+	frameNum = 0;
+	timePerSquare = 0.0f;
+
+	stats = {};
+}
+
+void CHeightMapUpdateScheduler::Kill()
+{
+	pendingRects.clear();
+	sortedRects.clear();
+	splitRects.clear();
+	priorities.clear();
+	processedRects.clear();
+}
+
+
+void CHeightMapUpdateScheduler::Push(const SRectangle& rect)
+{
+	// same filter as CRectangleOverlapHandler
+	if (rect.GetArea() <= 0)
+		return;
+
+	// terraforms and LOS-checked updates arrive as runs of neighboring rectangles
+	for (int i = int(pendingRects.size()) - 1, n = 0; i >= 0 && n < MERGE_SEARCH_DEPTH; i--, n++) {
+		SRectangle& pendingRect = pendingRects[i].rect;
+
+		if (rect.x1 > pendingRect.x2 || rect.x2 < pendingRect.x1)
+			continue;
+		if (rect.z1 > pendingRect.z2 || rect.z2 < pendingRect.z1)
+			continue;
+
+		const SRectangle mergedRect = {
+			std::min(rect.x1, pendingRect.x1), std::min(rect.z1, pendingRect.z1),
+			std::max(rect.x2, pendingRect.x2), std::max(rect.z2, pendingRect.z2),
+		};
+
+		// do not let merging add much more area than was requested
+		if (mergedRect.GetArea() > 2 * (rect.GetArea() + pendingRect.GetArea()))
+			continue;
+
+		// keeps the age of the older request
+		pendingRect = mergedRect;
+		return;
+	}
+
+	pendingRects.push_back({rect, frameNum});
+}
+
+
+float CHeightMapUpdateScheduler::GetPriority(const float3& pos, const PendingRect& pr) const
+{
+	const SRectangle& r = pr.rect;
+	const float3 nearestPos = {
+		Clamp(pos.x, r.x1 * SQUARE_SIZE * 1.0f, r.x2 * SQUARE_SIZE * 1.0f),
+		0.0f,
+		Clamp(pos.z, r.z1 * SQUARE_SIZE * 1.0f, r.z2 * SQUARE_SIZE * 1.0f),
+	};
+
+	return (pos.distance2D(nearestPos) - (frameNum - pr.pushFrame) * AGING_DISTANCE);
+}
+
+void CHeightMapUpdateScheduler::ProcessRect(const SRectangle& rect, const UpdateFunc& func)
+{
+	const spring_time startTime = spring_gettime();
+
+	func(rect);
+	processedRects.push_back(rect);
+
+	const float rectTime = (spring_gettime() - startTime).toMilliSecsf() / rect.GetArea();
+
+	if (timePerSquare <= 0.0f) {
+		timePerSquare = rectTime;
+	} else {
+		timePerSquare = mix(timePerSquare, rectTime, 0.25f);
+	}
+}
+
+
+void CHeightMapUpdateScheduler::Process(const float3& pos, float maxTime, const UpdateFunc& func)
+{
+	processedRects.clear();
+
+	stats.numUpdatedRects = 0;
+	stats.numPendingRects = pendingRects.size();
+	stats.updateTime = 0.0f;
+
+	if (pendingRects.empty())
+		return;
+
+	const spring_time startTime = spring_gettime();
+
+	// func may push new requests, these have to wait for the next call
+	sortedRects.clear();
+	sortedRects.swap(pendingRects);
+
+	if (maxTime < 0.0f) {
+		for (const PendingRect& pr: sortedRects) {
+			ProcessRect(pr.rect, func);
+		}
+	} else {
+		priorities.clear();
+
+		for (size_t i = 0; i < sortedRects.size(); i++) {
+			priorities.emplace_back(GetPriority(pos, sortedRects[i]), i);
+		}
+
+		std::sort(priorities.begin(), priorities.end());
+
+		size_t numVisited = 0;
+
+		while (numVisited < priorities.size()) {
+			const PendingRect& pr = sortedRects[priorities[numVisited].second];
+			const float remainingTime = maxTime - (spring_gettime() - startTime).toMilliSecsf();
+
+			if (!processedRects.empty() && remainingTime <= 0.0f)
+				break;
+
+			numVisited++;
+
+			// nothing to estimate from until the first update was timed
+			if (timePerSquare <= 0.0f || pr.rect.GetArea() <= (TILE_SIZE * TILE_SIZE) || (pr.rect.GetArea() * timePerSquare) <= remainingTime) {
+				ProcessRect(pr.rect, func);
+				continue;
+			}
+
+			// too large for what is left of the budget; cut it into tiles and
+			// take the nearest of those that fit, the others wait their turn
+			const SRectangle& rect = pr.rect;
+
+			splitRects.clear();
+
+			for (int tz = rect.z1 / TILE_SIZE, tz2 = (rect.z2 - 1) / TILE_SIZE; tz <= tz2; tz++) {
+				for (int tx = rect.x1 / TILE_SIZE, tx2 = (rect.x2 - 1) / TILE_SIZE; tx <= tx2; tx++) {
+					const SRectangle tileRect = {
+						std::max(rect.x1, tx * TILE_SIZE), std::max(rect.z1, tz * TILE_SIZE),
+						std::min(rect.x2, (tx + 1) * TILE_SIZE), std::min(rect.z2, (tz + 1) * TILE_SIZE),
+					};
+
+					splitRects.push_back({tileRect, pr.pushFrame});
+				}
+			}
+
+			std::stable_sort(splitRects.begin(), splitRects.end(), [&](const PendingRect& a, const PendingRect& b) {
+				return (GetPriority(pos, a) < GetPriority(pos, b));
+			});
+
+			for (const PendingRect& tile: splitRects) {
+				const float tileTime = tile.rect.GetArea() * timePerSquare;
+
+				if (processedRects.empty() || tileTime <= (maxTime - (spring_gettime() - startTime).toMilliSecsf())) {
+					ProcessRect(tile.rect, func);
+				} else {
+					pendingRects.push_back(tile);
+				}
+			}
+
+			break;
+		}
+
+		// whatever is left keeps its age for the next call
+		for (size_t i = numVisited; i < priorities.size(); i++) {
+			pendingRects.push_back(sortedRects[priorities[i].second]);
+		}
+	}
+
+	frameNum += 1;
+
+	stats.numUpdatedRects = processedRects.size();
+	stats.numPendingRects = pendingRects.size();
+	stats.updateTime = (spring_gettime() - startTime).toMilliSecsf();
+}
@@ -0,0 +1,88 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef HEIGHTMAP_UPDATE_SCHEDULER_H
+#define HEIGHTMAP_UPDATE_SCHEDULER_H
+
+#include <functional>
+#include <vector>
+
+#include "System/float3.h"
+#include "System/Rectangle.h"
+
+/**
+ * @brief spreads unsynced heightmap updates over draw-frames
+ *
+ * Requested rectangles (corner-heightmap coordinates) are merged with
+ * recent overlapping or adjacent ones and kept whole. Each frame pending
+ * rectangles are handed out closest to the camera first until the time
+ * budget is used up; how long one takes is estimated from its area and
+ * the time earlier ones took, and only a rectangle that would not fit is
+ * cut into tiles of which the nearest are handed out. Waiting rectangles
+ * move up the queue, so far away ones are not postponed indefinitely.
+ */
+class CHeightMapUpdateScheduler
+{
+public:
+	typedef std::function<void(const SRectangle&)> UpdateFunc;
+
+	struct Stats {
+		int numUpdatedRects = 0;
+		int numPendingRects = 0;
+
+		float updateTime = 0.0f; // ms
+	};
+
+	static constexpr int TILE_SIZE = 64;
+	/// pending rectangles are searched this far back for one to merge with
+	static constexpr int MERGE_SEARCH_DEPTH = 16;
+	/// how much closer (in elmos) a rectangle counts as per frame it waited
+	static constexpr float AGING_DISTANCE = TILE_SIZE * 8.0f;
+
+	void Init();
+	void Kill();
+
+	void Push(const SRectangle& rect);
+
+	/**
+	 * calls func for pending rectangles in order of their (aged) distance to
+	 * pos and stops once maxTime (ms) has passed; at least one rectangle is
+	 * always processed and a negative maxTime processes everything as is
+	 */
+	void Process(const float3& pos, float maxTime, const UpdateFunc& func);
+
+	bool empty() const { return pendingRects.empty(); }
+	size_t size() const { return pendingRects.size(); }
+
+	/// every rectangle handed to func by the last Process call, in order
+	const std::vector<SRectangle>& GetProcessedRects() const { return processedRects; }
+	const Stats& GetStats() const { return stats; }
+
+private:
+	struct PendingRect {
+		SRectangle rect;
+		// Process call it was (first) pushed before
+		int pushFrame;
+	};
+
+	void ProcessRect(const SRectangle& rect, const UpdateFunc& func);
+
+	float GetPriority(const float3& pos, const PendingRect& pr) const;
+
+private:
+	std::vector<PendingRect> pendingRects;
+	std::vector<PendingRect> sortedRects;
+	std::vector<PendingRect> splitRects;
+	std::vector<std::pair<float, int>> priorities;
+
+	std::vector<SRectangle> processedRects;
+
+	// number of Process calls so far, rectangles age by these
+	int frameNum = 0;
+
+	// running estimate of the time an update takes per heightmap square
+	float timePerSquare = 0.0f; // ms
+
+	Stats stats;
+};
+
+#endif
@@ -10,10 +10,12 @@
 #include "MetalMap.h"
 #include "Rendering/Env/MapRendering.h"
 #include "SMF/SMFReadMap.h"
+#include "Game/Camera.h"
 #include "Game/LoadScreen.h"
 #include "System/bitops.h"
 #include "System/EventHandler.h"
 #include "System/Exceptions.h"
+#include "System/Config/ConfigHandler.h"
 #include "System/SpringMath.h"
 #include "System/Threading/ThreadPool.h"
 #include "System/FileSystem/ArchiveScanner.h"
@@ -29,7 +31,10 @@
 #include "Sim/Misc/LosHandler.h"
 #endif
 
-#define MAX_UHM_RECTS_PER_FRAME static_cast<size_t>(128)
+CONFIG(float, UnsyncedHeightMapUpdateTime)
+	.defaultValue(2.0f)
+	.minimumValue(0.0f)
+	.description("Time in milliseconds per draw-frame spent on refreshing unsynced heightmap products (normals, shading) after terrain changes. Pending areas nearest to the camera are refreshed first, the remainder is deferred to later frames.");
 
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
@@ -89,7 +94,6 @@ CR_REG_METADATA(CReadMap, (
 	CR_IGNORED(sharedSlopeMaps),
 
 	CR_IGNORED(unsyncedHeightMapUpdates),
-	CR_IGNORED(unsyncedHeightMapUpdatesTemp),
 
 	/*
 	#ifdef USE_UNSYNCED_HEIGHTMAP
@@ -371,6 +375,7 @@ void CReadMap::Initialize()
 
 	// not callable here because losHandler is still uninitialized, deferred to Game::PostLoadSim
 	// InitHeightMapDigestVectors();
+	unsyncedHeightMapUpdates.Init();
 	UpdateHeightMapSynced({0, 0, mapDims.mapx, mapDims.mapy}, true);
 
 	// FIXME: sky & skyLight aren't created yet (crashes in SMFReadMap.cpp)
@@ -425,62 +430,17 @@ void CReadMap::UpdateDraw(bool firstCall)
 	if (unsyncedHeightMapUpdates.empty())
 		return;
 
-	#if 0
-	static CRectangleOverlapHandler unsyncedHeightMapUpdatesSwap;
+	// first update covers the full map and can not be deferred
+	const float maxTime = firstCall? -1.0f: configHandler->GetFloat("UnsyncedHeightMapUpdateTime");
 
-	{
-		if (!unsyncedHeightMapUpdates.empty())
-			unsyncedHeightMapUpdates.swap(unsyncedHeightMapUpdatesTemp); // swap to avoid Optimize() inside a mutex
-	}
-	{
-		if (!firstCall) {
-			if (!unsyncedHeightMapUpdatesTemp.empty()) {
-				unsyncedHeightMapUpdatesTemp.Process();
-
-				int updateArea = unsyncedHeightMapUpdatesTemp.GetTotalArea() * 0.0625f + (50 * 50);
-
-				while (updateArea > 0 && !unsyncedHeightMapUpdatesTemp.empty()) {
-					const SRectangle& rect = unsyncedHeightMapUpdatesTemp.front();
-					updateArea -= rect.GetArea();
-
-					unsyncedHeightMapUpdatesSwap.push_back(rect);
-					unsyncedHeightMapUpdatesTemp.pop_front();
-				}
-			}
-		} else {
-			// first update is full map
-			unsyncedHeightMapUpdatesTemp.swap(unsyncedHeightMapUpdatesSwap);
-		}
-	}
-
-	if (!unsyncedHeightMapUpdatesTemp.empty())
-		unsyncedHeightMapUpdates.append(unsyncedHeightMapUpdatesTemp);
-
-	// unsyncedHeightMapUpdatesTemp is now guaranteed empty
-	for (const SRectangle& rect: unsyncedHeightMapUpdatesSwap) {
+	unsyncedHeightMapUpdates.Process(camera->GetPos(), maxTime, [&](const SRectangle& rect) {
 		UpdateHeightMapUnsynced(rect);
-	}
-	for (const SRectangle& rect: unsyncedHeightMapUpdatesSwap) {
-		eventHandler.UnsyncedHeightMapUpdate(rect);
-	}
-
-	unsyncedHeightMapUpdatesSwap.clear();
-
-	#else
-
-	// TODO: quadtree or whatever
-	for (size_t i = 0, n = std::min(MAX_UHM_RECTS_PER_FRAME, unsyncedHeightMapUpdates.size()); i < n; i++) {
-		UpdateHeightMapUnsynced(*(unsyncedHeightMapUpdates.begin() + i));
-	}
-
-	for (size_t i = 0, n = std::min(MAX_UHM_RECTS_PER_FRAME, unsyncedHeightMapUpdates.size()); i < n; i++) {
-		eventHandler.UnsyncedHeightMapUpdate(*(unsyncedHeightMapUpdates.begin() + i));
-	}
+	});
 
-	for (size_t i = 0, n = std::min(MAX_UHM_RECTS_PER_FRAME, unsyncedHeightMapUpdates.size()); i < n; i++) {
-		unsyncedHeightMapUpdates.pop_front();
+	// one event per processed (merged) rectangle, after all of them are updated
+	for (const SRectangle& rect: unsyncedHeightMapUpdates.GetProcessedRects()) {
+		eventHandler.UnsyncedHeightMapUpdate(rect);
 	}
-	#endif
 }
 
 
@@ -509,7 +469,7 @@ void CReadMap::UpdateHeightMapSynced(const SRectangle& hgtMapRect, bool initiali
 	#ifdef USE_UNSYNCED_HEIGHTMAP
 	// push the unsynced update; initial one without LOS check
 	if (initialize) {
-		unsyncedHeightMapUpdates.push_back(cornerRect);
+		unsyncedHeightMapUpdates.Push(cornerRect);
 	} else {
 		#ifdef USE_HEIGHTMAP_DIGESTS
 		// convert heightmap rectangle to LOS-map space
@@ -531,7 +491,7 @@ void CReadMap::UpdateHeightMapSynced(const SRectangle& hgtMapRect, bool initiali
 		HeightMapUpdateLOSCheck(cornerRect);
 	}
 	#else
-	unsyncedHeightMapUpdates.push_back(cornerRect);
+	unsyncedHeightMapUpdates.Push(cornerRect);
 	#endif
 }
 
@@ -540,7 +500,7 @@ void CReadMap::UpdateCenterHeightmap(const SRectangle& rect, bool initialize)
 {
 	const float* heightmapSynced = GetCornerHeightMapSynced();
 
-	for (int y = rect.z1; y <= rect.z2; y++) {
+	for_mt(rect.z1, rect.z2 + 1, [&](const int y) {
 		for (int x = rect.x1; x <= rect.x2; x++) {
 			const int idxTL = (y    ) * mapDims.mapxp1 + x;
 			const int idxTR = (y    ) * mapDims.mapxp1 + x + 1;
@@ -554,7 +514,7 @@ void CReadMap::UpdateCenterHeightmap(const SRectangle& rect, bool initialize)
 				heightmapSynced[idxBR];
 			centerHeightMap[y * mapDims.mapx + x] = height * 0.25f;
 		}
-	}
+	});
 }
 
 
@@ -571,7 +531,8 @@ void CReadMap::UpdateMipHeightmaps(const SRectangle& rect, bool initialize)
 		float* topMipMap = mipPointerHeightMaps[i    ];
 		float* subMipMap = mipPointerHeightMaps[i + 1];
 
-		for (int y = sy; y < ey; y += 2) {
+		// each level depends on the previous one, rows within a level do not
+		for_mt(sy, ey, 2, [&](const int y) {
 			for (int x = sx; x < ex; x += 2) {
 				const float height =
 					topMipMap[(x    ) + (y    ) * hmapx] +
@@ -580,7 +541,7 @@ void CReadMap::UpdateMipHeightmaps(const SRectangle& rect, bool initialize)
 					topMipMap[(x + 1) + (y + 1) * hmapx];
 				subMipMap[(x / 2) + (y / 2) * hmapx / 2] = height * 0.25f;
 			}
-		}
+		});
 	}
 }
 
@@ -662,7 +623,7 @@ void CReadMap::UpdateSlopemap(const SRectangle& rect, bool initialize)
 	const int sy = std::max(0,                 (rect.z1 / 2) - 1);
 	const int ey = std::min(mapDims.hmapy - 1, (rect.z2 / 2) + 1);
 
-	for (int y = sy; y <= ey; y++) {
+	for_mt(sy, ey + 1, [&](const int y) {
 		for (int x = sx; x <= ex; x++) {
 			const int idx0 = (y*2    ) * (mapDims.mapx) + x*2;
 			const int idx1 = (y*2 + 1) * (mapDims.mapx) + x*2;
@@ -693,7 +654,7 @@ void CReadMap::UpdateSlopemap(const SRectangle& rect, bool initialize)
 
 			slopeMap[y * mapDims.hmapx + x] = 1.0f - slope;
 		}
-	}
+	});
 }
 
 
@@ -709,7 +670,7 @@ void CReadMap::HeightMapUpdateLOSCheck(const SRectangle& hgtMapRect)
 	const auto PushRect = [&](SRectangle& subRect, int hmx, int hmz) {
 		if (subRect.GetArea() > 0) {
 			subRect.ClampIn(hgtMapRect);
-			unsyncedHeightMapUpdates.push_back(subRect);
+			unsyncedHeightMapUpdates.Push(subRect);
 
 			subRect = {hmx + losSqrSize, hmz,  hmx + losSqrSize, hmz + losSqrSize};
 		} else {
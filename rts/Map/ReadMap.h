@@ -13,7 +13,7 @@
 #include "System/float3.h"
 #include "System/type2.h"
 #include "System/creg/creg_cond.h"
-#include "System/Misc/RectangleOverlapHandler.h"
+#include "HeightMapUpdateScheduler.h"
 
 #define USE_UNSYNCED_HEIGHTMAP
 #define USE_HEIGHTMAP_DIGESTS
@@ -99,6 +99,8 @@ public:
 	void BecomeSpectator();
 	void UpdateDraw(bool firstCall);
 
+	const CHeightMapUpdateScheduler::Stats& GetUnsyncedHeightMapUpdateStats() const { return unsyncedHeightMapUpdates.GetStats(); }
+
 	virtual ~CReadMap();
 
 	virtual void Update() {}
@@ -250,8 +252,7 @@ protected:
 	static std::vector<float3> centerNormals2D;
 
 
-	CRectangleOverlapHandler unsyncedHeightMapUpdates;
-	CRectangleOverlapHandler unsyncedHeightMapUpdatesTemp;
+	CHeightMapUpdateScheduler unsyncedHeightMapUpdates;
 
 private:
 	// these combine the various synced and unsynced arrays
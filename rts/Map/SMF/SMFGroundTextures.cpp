@@ -4,6 +4,7 @@
 #include <cmath>
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
 
 #include "SMFGroundTextures.h"
 #include "SMFFormat.h"
@@ -17,11 +18,13 @@
 #include "Game/GameSetup.h"
 #include "Game/LoadScreen.h"
 #include "System/Exceptions.h"
+#include "System/Config/ConfigHandler.h"
 #include "System/FastMath.h"
 #include "System/Log/ILog.h"
 #include "System/TimeProfiler.h"
 #include "System/FileSystem/FileHandler.h"
 #include "System/FileSystem/FileSystem.h"
+#include "System/FileSystem/MappedFile.h"
 #include "System/Platform/Watchdog.h"
 #include "System/Threading/ThreadPool.h" // for_mt
 
@@ -36,12 +39,18 @@ LOG_REGISTER_SECTION_GLOBAL(LOG_SECTION_SMF_GROUND_TEXTURES)
 #endif
 #define LOG_SECTION_CURRENT LOG_SECTION_SMF_GROUND_TEXTURES
 
+CONFIG(int, SMFTextureStreamingMemory)
+	.defaultValue(64)
+	.minimumValue(0)
+	.description("Memory (in MB) for map texture squares that were decoded but not yet uploaded. If 0, all MIP levels are uploaded during loading instead of on demand.");
 
 
-std::vector<CSMFGroundTextures::GroundSquare> CSMFGroundTextures::squares;
+// keeps streaming from stalling a frame, a level-0 square is 512KB
+static constexpr size_t MAX_UPLOAD_BYTES_PER_FRAME = 2 * 1024 * 1024;
+
 
-std::vector<int> CSMFGroundTextures::tileMap;
-std::vector<char> CSMFGroundTextures::tiles;
+
+std::vector<CSMFGroundTextures::GroundSquare> CSMFGroundTextures::squares;
 
 std::vector<float> CSMFGroundTextures::heightMaxima;
 std::vector<float> CSMFGroundTextures::heightMinima;
@@ -61,13 +70,42 @@ CSMFGroundTextures::GroundSquare::~GroundSquare()
 
 CSMFGroundTextures::CSMFGroundTextures(CSMFReadMap* rm): smfMap(rm)
 {
+	const size_t streamingMemory = configHandler->GetInt("SMFTextureStreamingMemory") * size_t(1024 * 1024);
+
+	tileStreamer.Init(smfMap->numBigTexX, smfMap->numBigTexY, streamingMemory);
+
 	LoadTiles(smfMap->GetMapFile());
-	LoadSquareTextures(0, 3); // preload all levels
+
+	if (streamingMemory > 0) {
+		// only the coarsest level, DrawUpdate requests the others
+		LoadSquareTextures(3, 3);
+	} else {
+		// preload all levels, tiles are not needed afterwards
+		LoadSquareTextures(0, 3);
+		tileStreamer.Kill();
+	}
+
 	ConvolveHeightMap(mapDims.mapx, 1);
 }
 
 CSMFGroundTextures::~CSMFGroundTextures()
 {
+	{
+		const CSMFTileStreamer::Stats& stats = tileStreamer.GetStats();
+
+		unsigned int numResidentSquares[CSMFTileStreamer::NUM_MIP_LEVELS] = {0};
+
+		for (const GroundSquare& square: squares) {
+			numResidentSquares[square.GetResidentLevel(0)] += 1;
+		}
+
+		LOG(
+			"[SMFGroundTextures::%s] squares per finest level {%u, %u, %u, %u}, streamed %" PRIu64 " (%" PRIu64 " evicted, %" PRIu64 " rejected, peak %uKB)",
+			__func__, numResidentSquares[0], numResidentSquares[1], numResidentSquares[2], numResidentSquares[3],
+			stats.numTaken, stats.numEvicted, stats.numRejected, unsigned(stats.peakMemory / 1024)
+		);
+	}
+
 	pbo.Release();
 	glDeleteTextures(1, &tileArrayTex);
 }
@@ -96,10 +134,13 @@ void CSMFGroundTextures::LoadTiles(CSMFMapFile& file)
 		throw content_error(tmp);
 	}
 
-	tileMap.clear();
-	tileMap.resize(smfMap->tileCount);
-	tiles.clear();
-	tiles.resize(tileHeader.numTiles * SMALL_TILE_SIZE);
+	std::vector<int>& tileMap = tileStreamer.GetTileMap();
+
+	if (tileMap.size() != size_t(smfMap->tileCount)) {
+		snprintf(tmp, sizeof(tmp), "[SMFGroundTextures::%s] smfMap->tileCount=%d does not match the number of big squares", __func__, smfMap->tileCount);
+		throw content_error(tmp);
+	}
+
 	squares.clear();
 	squares.resize(smfMap->numBigTexX * smfMap->numBigTexY);
 
@@ -114,7 +155,7 @@ void CSMFGroundTextures::LoadTiles(CSMFMapFile& file)
 		}
 	}
 
-	for (int a = 0, curTile = 0; a < tileHeader.numTileFiles; ++a) {
+	for (int a = 0; a < tileHeader.numTileFiles; ++a) {
 		int numSmallTiles = 0;
 		char fileNameBuffer[256] = {0};
 
@@ -139,8 +180,7 @@ void CSMFGroundTextures::LoadTiles(CSMFMapFile& file)
 				__func__, a, smtFilePath.c_str(), numSmallTiles
 			);
 
-			memset(&tiles[curTile * SMALL_TILE_SIZE], 0xaa, numSmallTiles * SMALL_TILE_SIZE);
-			curTile += numSmallTiles;
+			tileStreamer.AddMissingTiles(numSmallTiles);
 			continue;
 		}
 
@@ -156,9 +196,31 @@ void CSMFGroundTextures::LoadTiles(CSMFMapFile& file)
 			throw content_error(tmp);
 		}
 
-		for (int b = 0; b < numSmallTiles; ++b) {
-			tileFile.Read(&tiles[(curTile++) * SMALL_TILE_SIZE], SMALL_TILE_SIZE);
+		// tiles stay compressed in their file; only squares the camera
+		// needs are ever assembled (and thus paged in, if it is mapped)
+		const size_t tileDataPos = tileFile.GetPos();
+		const size_t tileDataEnd = tileDataPos + size_t(numSmallTiles) * SMALL_TILE_SIZE;
+
+		if (tileFile.IsBuffered()) {
+			// read from an archive, keep the VFS buffer instead of copying it
+			std::vector<std::uint8_t>& fileBuffer = tileFile.GetBuffer();
+
+			fileBuffer.resize(std::max(fileBuffer.size(), tileDataEnd), 0);
+			tileStreamer.AddTiles(std::move(fileBuffer), tileDataPos, numSmallTiles);
+			continue;
+		}
+
+		CMappedFile mappedFile(CFileHandler::GetFileAbsolutePath(smtFilePath, SPRING_VFS_RAW));
+
+		if (mappedFile.IsOpen() && mappedFile.GetSize() >= tileDataEnd) {
+			tileStreamer.AddTiles(std::move(mappedFile), tileDataPos, numSmallTiles);
+			continue;
 		}
+
+		std::vector<std::uint8_t> tileBuffer(size_t(numSmallTiles) * SMALL_TILE_SIZE, 0);
+
+		tileFile.Read(tileBuffer.data(), tileBuffer.size());
+		tileStreamer.AddTiles(std::move(tileBuffer), 0, numSmallTiles);
 	}
 
 	ifs->Read(&tileMap[0], smfMap->tileCount * sizeof(int));
@@ -231,6 +293,7 @@ void CSMFGroundTextures::LoadSquareTextures(const int minLevel, const int maxLev
 		for (int y = 0; y < nty; ++y) {
 			for (int x = 0; x < ntx; ++x) {
 				LoadSquareTexture(x, y, i);
+				squares[y * ntx + x].SetMipLevel(i);
 			}
 		}
 	}
@@ -327,6 +390,8 @@ inline bool CSMFGroundTextures::TexSquareInView(int btx, int bty) const
 
 void CSMFGroundTextures::DrawUpdate()
 {
+	UploadStreamedSquares();
+
 	const CCamera* cam = CCameraHandler::GetActiveCamera();
 
 	const float3& camPos = cam->GetPos();
@@ -405,11 +470,45 @@ void CSMFGroundTextures::DrawUpdate()
 			if (stretchFactors[y * smfMap->numBigTexX + x] > 16000 && wantedLevel > 0)
 				wantedLevel--;
 
-			square->SetMipLevel(wantedLevel);
+			square->SetMipLevel(SelectMipLevel(y * smfMap->numBigTexX + x, wantedLevel));
 		}
 	}
 }
 
+// returns the level to draw square <sqrIdx> with until <wantedLevel>
+// has been uploaded, which is requested from the streamer if needed
+int CSMFGroundTextures::SelectMipLevel(int sqrIdx, int wantedLevel)
+{
+	const GroundSquare& square = squares[sqrIdx];
+
+	if (!square.IsResidentLevel(wantedLevel))
+		tileStreamer.RequestSquare(sqrIdx, wantedLevel, globalRendering->drawFrame);
+
+	return (square.GetResidentLevel(wantedLevel));
+}
+
+void CSMFGroundTextures::UploadStreamedSquares()
+{
+	std::vector<std::uint8_t> squareData;
+
+	int sqrIdx = 0;
+	int mipLevel = 0;
+
+	if (!tileStreamer.TakeSquare(sqrIdx, mipLevel, squareData))
+		return;
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, tileArrayTex);
+
+	size_t numUploadBytes = 0;
+
+	do {
+		LoadSquareTexture(sqrIdx % smfMap->numBigTexX, sqrIdx / smfMap->numBigTexX, mipLevel, squareData.data());
+	} while (((numUploadBytes += squareData.size()) < MAX_UPLOAD_BYTES_PER_FRAME) && tileStreamer.TakeSquare(sqrIdx, mipLevel, squareData));
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
 
 
 bool CSMFGroundTextures::SetSquareLuaTexture(int texSquareX, int texSquareY, int texID) {
@@ -456,7 +555,7 @@ bool CSMFGroundTextures::GetSquareLuaTexture(int texSquareX, int texSquareY, int
 
 	pbo.Bind();
 	pbo.New(numSqBytes);
-	ExtractSquareTiles(texSquareX, texSquareY, texMipLevel, (GLint*) pbo.MapBuffer(0, pbo.bufSize, access | pbo.mapUnsyncedBit));
+	tileStreamer.ExtractSquareTiles(texSquareX, texSquareY, texMipLevel, (std::uint8_t*) pbo.MapBuffer(0, pbo.bufSize, access | pbo.mapUnsyncedBit));
 	pbo.UnmapBuffer();
 
 	glBindTexture(ttarget, texID);
@@ -471,47 +570,7 @@ bool CSMFGroundTextures::GetSquareLuaTexture(int texSquareX, int texSquareY, int
 
 
 
-void CSMFGroundTextures::ExtractSquareTiles(
-	const int texSquareX,
-	const int texSquareY,
-	const int mipLevel,
-	GLint* tileBuf
-) const {
-	if (tileBuf == nullptr)
-		return;
-
-	constexpr int TILE_MIP_OFFSET[] = {0, 512, 512+128, 512+128+32};
-	constexpr int BLOCK_SIZE = 32;
-
-	const int mipOffset = TILE_MIP_OFFSET[mipLevel];
-	const int numBlocks = SQUARE_SIZE >> mipLevel;
-	const int tileOffsetX = texSquareX * BLOCK_SIZE;
-	const int tileOffsetY = texSquareY * BLOCK_SIZE;
-
-	// extract all 32x32 sub-blocks (tiles) in the 128x128 square
-	// (each 32x32 tile covers a (bigSquareSize = 32 * tileScale) x
-	// (bigSquareSize = 32 * tileScale) heightmap chunk)
-	for (int y1 = 0; y1 < BLOCK_SIZE; y1++) {
-		for (int x1 = 0; x1 < BLOCK_SIZE; x1++) {
-			const int tileX = tileOffsetX + x1;
-			const int tileY = tileOffsetY + y1;
-			const int tileIdx = tileMap[tileY * smfMap->tileMapSizeX + tileX];
-			const GLint* tile = (GLint*) &tiles[tileIdx * SMALL_TILE_SIZE + mipOffset];
-
-			const int doff = (x1 * numBlocks) + (y1 * numBlocks * numBlocks) * BLOCK_SIZE;
-
-			for (int b = 0; b < numBlocks; b++) {
-				const GLint* sbuf = &tile[b * numBlocks * 2];
-				      GLint* dbuf = &tileBuf[(doff + b * numBlocks * BLOCK_SIZE) * 2];
-
-				// at MIP level n: ((8 >> n) * 2 * 4) = (64 >> n) bytes for each <b>
-				memcpy(dbuf, sbuf, numBlocks * 2 * sizeof(GLint));
-			}
-		}
-	}
-}
-
-void CSMFGroundTextures::LoadSquareTexture(int x, int y, int level)
+void CSMFGroundTextures::LoadSquareTexture(int x, int y, int level, const std::uint8_t* squareData)
 {
 	constexpr GLenum ttarget = GL_TEXTURE_2D_ARRAY;
 	constexpr GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
@@ -520,13 +579,23 @@ void CSMFGroundTextures::LoadSquareTexture(int x, int y, int level)
 	const int numSqBytes = (mipSqSize * mipSqSize) / 2;
 
 	GroundSquare* square = &squares[y * smfMap->numBigTexX + x];
-	square->SetMipLevel(level);
+	square->SetResidentLevel(level);
 	assert(!square->HasLuaTexture());
 
 
 	pbo.Bind();
 	pbo.New(numSqBytes);
-	ExtractSquareTiles(x, y, level, (GLint*) pbo.MapBuffer(0, pbo.bufSize, access | pbo.mapUnsyncedBit));
+
+	std::uint8_t* pboData = (std::uint8_t*) pbo.MapBuffer(0, pbo.bufSize, access | pbo.mapUnsyncedBit);
+
+	if (pboData != nullptr) {
+		if (squareData == nullptr) {
+			tileStreamer.ExtractSquareTiles(x, y, level, pboData);
+		} else {
+			std::memcpy(pboData, squareData, numSqBytes);
+		}
+	}
+
 	pbo.UnmapBuffer();
 
 	glCompressedTexSubImage3D(
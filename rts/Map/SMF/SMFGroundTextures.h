@@ -3,8 +3,10 @@
 #ifndef _SMF_GROUND_TEXTURES_H_
 #define _SMF_GROUND_TEXTURES_H_
 
+#include <cinttypes>
 #include <vector>
 
+#include "SMFTileStreamer.h"
 #include "Map/BaseGroundTextures.h"
 #include "Rendering/GL/PBO.h"
 
@@ -32,8 +34,11 @@ protected:
 	void LoadTiles(CSMFMapFile& file);
 	void LoadSquareTextures(const int minLevel, const int maxLevel);
 	void ConvolveHeightMap(const int mapWidth, const int mipLevel);
-	void ExtractSquareTiles(const int texSquareX, const int texSquareY, const int mipLevel, GLint* tileBuf) const;
-	void LoadSquareTexture(int x, int y, int level);
+	// extracts the square's tiles unless <squareData> is given
+	void LoadSquareTexture(int x, int y, int level, const std::uint8_t* squareData = nullptr);
+	void UploadStreamedSquares();
+
+	int SelectMipLevel(int sqrIdx, int wantedLevel);
 
 	inline bool TexSquareInView(int, int) const;
 
@@ -46,7 +51,7 @@ private:
 			LUA_TEX_IDX = 1,
 		};
 
-		GroundSquare(): textureIDs{0, 0}, texMipLevel(0), texDrawFrame(1) {}
+		GroundSquare(): textureIDs{0, 0}, texMipLevel(0), texDrawFrame(1), residentLevels(0) {}
 		~GroundSquare();
 
 		bool HasLuaTexture() const { return (textureIDs[LUA_TEX_IDX] != 0); }
@@ -55,29 +60,40 @@ private:
 		void SetLuaTexture(unsigned int id) { textureIDs[LUA_TEX_IDX] = id; }
 		void SetMipLevel(unsigned int l) { texMipLevel = l; }
 		void SetDrawFrame(unsigned int f) { texDrawFrame = f; }
+		void SetResidentLevel(unsigned int l) { residentLevels |= (1 << l); }
 
 		unsigned int* GetTextureIDPtr() { return &textureIDs[RAW_TEX_IDX]; }
 		unsigned int GetTextureID() const { return textureIDs[HasLuaTexture()]; }
 		unsigned int GetMipLevel() const { return texMipLevel; }
 		unsigned int GetDrawFrame() const { return texDrawFrame; }
 
+		bool IsResidentLevel(unsigned int l) const { return ((residentLevels & (1 << l)) != 0); }
+		// finest uploaded level that is not finer than <l>; the coarsest is always uploaded
+		unsigned int GetResidentLevel(unsigned int l) const {
+			while (!IsResidentLevel(l) && l < 3)
+				l++;
+
+			return l;
+		}
+
 	private:
 		unsigned int textureIDs[2];
 		unsigned int texMipLevel;
 		unsigned int texDrawFrame;
+		unsigned int residentLevels;
 	};
 
 	// note: intentionally declared static (see ReadMap)
 	static std::vector<GroundSquare> squares;
 
-	static std::vector<int> tileMap;
-	static std::vector<char> tiles;
-
 	// FIXME? these are not updated at runtime
 	static std::vector<float> heightMaxima;
 	static std::vector<float> heightMinima;
 	static std::vector<float> stretchFactors;
 
+	// tiles and squares decoded for uploading
+	CSMFTileStreamer tileStreamer;
+
 	// use Pixel Buffer Objects for async. uploading (DMA)
 	PBO pbo;
 
@@ -0,0 +1,236 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "SMFTileStreamer.h"
+#include "System/Threading/ThreadPool.h"
+
+
+constexpr int CSMFTileStreamer::TILE_MIP_SIZES[NUM_MIP_LEVELS];
+constexpr int CSMFTileStreamer::TILE_MIP_OFFSETS[NUM_MIP_LEVELS];
+
+
+void CSMFTileStreamer::Init(int numSqrsX, int numSqrsY, size_t maxMem)
+{
+	Kill();
+
+	numSquaresX = numSqrsX;
+	numSquaresY = numSqrsY;
+	maxMemory = maxMem;
+
+	tileMap.clear();
+	tileMap.resize(numSquaresX * numSquaresY * SQUARE_TILES * SQUARE_TILES, 0);
+
+	// same pattern LoadTiles used to fill in for missing tile-files
+	std::fill(missingTile.begin(), missingTile.end(), 0xaa);
+}
+
+void CSMFTileStreamer::Kill()
+{
+	{
+		std::unique_lock<spring::mutex> lock(squareMutex);
+		pendingCond.wait(lock, [&]() { return (stats.numPending == 0); });
+	}
+
+	tileMap.clear();
+	tilePtrs.clear();
+
+	mappedFiles.clear();
+	tileBuffers.clear();
+
+	squareEntries.clear();
+	decodedKeys.clear();
+
+	stats = {};
+}
+
+
+void CSMFTileStreamer::AddTiles(CMappedFile&& file, size_t offset, int numTiles)
+{
+	assert(file.GetSize() >= (offset + size_t(numTiles) * SMALL_TILE_SIZE));
+
+	mappedFiles.emplace_back(std::move(file));
+
+	for (int i = 0; i < numTiles; i++) {
+		tilePtrs.push_back(mappedFiles.back().GetData() + offset + i * SMALL_TILE_SIZE);
+	}
+}
+
+void CSMFTileStreamer::AddTiles(std::vector<std::uint8_t>&& buffer, size_t offset, int numTiles)
+{
+	assert(buffer.size() >= (offset + size_t(numTiles) * SMALL_TILE_SIZE));
+
+	// moving the vector does not move its contents
+	tileBuffers.emplace_back(std::move(buffer));
+
+	for (int i = 0; i < numTiles; i++) {
+		tilePtrs.push_back(tileBuffers.back().data() + offset + i * SMALL_TILE_SIZE);
+	}
+}
+
+void CSMFTileStreamer::AddMissingTiles(int numTiles)
+{
+	tilePtrs.insert(tilePtrs.end(), numTiles, missingTile.data());
+}
+
+
+void CSMFTileStreamer::ExtractSquareTiles(int sqrX, int sqrY, int mipLevel, std::uint8_t* squareBuf) const
+{
+	// DXT1 blocks (4x4 texels, 8 bytes) per tile-row at this level
+	const int numBlocks = 8 >> mipLevel;
+	const int rowBytes = numBlocks * 8;
+
+	const int mipOffset = TILE_MIP_OFFSETS[mipLevel];
+	const int tileMapSizeX = numSquaresX * SQUARE_TILES;
+	const int tileOffsetX = sqrX * SQUARE_TILES;
+	const int tileOffsetY = sqrY * SQUARE_TILES;
+
+	// copy every 32x32 tile into the square's block-rows
+	// (each tile covers a bigSquareSize / 32 heightmap chunk)
+	for (int y1 = 0; y1 < SQUARE_TILES; y1++) {
+		for (int x1 = 0; x1 < SQUARE_TILES; x1++) {
+			const int tileIdx = tileMap[(tileOffsetY + y1) * tileMapSizeX + (tileOffsetX + x1)];
+			const std::uint8_t* tile = tilePtrs[tileIdx] + mipOffset;
+
+			const int dstOffset = (x1 * numBlocks) + (y1 * numBlocks * numBlocks) * SQUARE_TILES;
+
+			for (int b = 0; b < numBlocks; b++) {
+				std::memcpy(&squareBuf[(dstOffset + b * numBlocks * SQUARE_TILES) * 8], &tile[b * rowBytes], rowBytes);
+			}
+		}
+	}
+}
+
+
+bool CSMFTileStreamer::RequestSquare(int sqrIdx, int mipLevel, unsigned int frameNum)
+{
+	assert(sqrIdx >= 0 && sqrIdx < (numSquaresX * numSquaresY));
+	assert(mipLevel >= 0 && mipLevel < NUM_MIP_LEVELS);
+
+	const int squareKey = sqrIdx * NUM_MIP_LEVELS + mipLevel;
+	const size_t squareSize = GetSquareSize(mipLevel);
+
+	std::uint8_t* squareBuf = nullptr;
+
+	{
+		std::lock_guard<spring::mutex> lock(squareMutex);
+
+		const auto iter = squareEntries.find(squareKey);
+
+		if (iter != squareEntries.end()) {
+			iter->second.frameNum = frameNum;
+			return true;
+		}
+
+		if ((stats.usedMemory + squareSize) > maxMemory && !EvictSquares(squareSize)) {
+			stats.numRejected += 1;
+			return false;
+		}
+
+		SquareEntry& entry = squareEntries[squareKey];
+
+		entry.data.resize(squareSize);
+		entry.frameNum = frameNum;
+
+		// buffer does not move when the entry does
+		squareBuf = entry.data.data();
+
+		stats.numRequested += 1;
+		stats.numPending += 1;
+		stats.usedMemory += squareSize;
+		stats.peakMemory = std::max(stats.peakMemory, stats.usedMemory);
+	}
+
+	// runs synchronously without a pool, so the lock must be released
+	ThreadPool::Enqueue([this, squareKey, squareBuf]() { DecodeSquare(squareKey, squareBuf); });
+	return true;
+}
+
+void CSMFTileStreamer::DecodeSquare(int squareKey, std::uint8_t* squareBuf)
+{
+	const int sqrIdx = squareKey / NUM_MIP_LEVELS;
+
+	// entry can not be evicted or taken while pending
+	ExtractSquareTiles(sqrIdx % numSquaresX, sqrIdx / numSquaresX, squareKey % NUM_MIP_LEVELS, squareBuf);
+
+	{
+		std::lock_guard<spring::mutex> lock(squareMutex);
+
+		squareEntries[squareKey].decoded = true;
+		decodedKeys.push_back(squareKey);
+
+		stats.numDecoded += 1;
+		stats.numPending -= 1;
+	}
+
+	pendingCond.notify_all();
+}
+
+bool CSMFTileStreamer::TakeSquare(int& sqrIdx, int& mipLevel, std::vector<std::uint8_t>& squareData)
+{
+	std::lock_guard<spring::mutex> lock(squareMutex);
+
+	while (!decodedKeys.empty()) {
+		const int squareKey = decodedKeys.front();
+		const auto iter = squareEntries.find(squareKey);
+
+		decodedKeys.pop_front();
+
+		// stale key of an evicted (and possibly re-requested) square
+		if (iter == squareEntries.end() || !iter->second.decoded)
+			continue;
+
+		sqrIdx = squareKey / NUM_MIP_LEVELS;
+		mipLevel = squareKey % NUM_MIP_LEVELS;
+		squareData = std::move(iter->second.data);
+
+		squareEntries.erase(iter);
+
+		stats.numTaken += 1;
+		stats.usedMemory -= squareData.size();
+		return true;
+	}
+
+	return false;
+}
+
+bool CSMFTileStreamer::EvictSquares(size_t reqMemory)
+{
+	// only decoded squares can go; the least recently requested first
+	std::vector< std::pair<unsigned int, int> > candidates;
+
+	for (const auto& p: squareEntries) {
+		if (!p.second.decoded)
+			continue;
+
+		candidates.emplace_back(p.second.frameNum, p.first);
+	}
+
+	std::sort(candidates.begin(), candidates.end());
+
+	for (const auto& candidate: candidates) {
+		if ((stats.usedMemory + reqMemory) <= maxMemory)
+			break;
+
+		const auto iter = squareEntries.find(candidate.second);
+
+		stats.numEvicted += 1;
+		stats.usedMemory -= iter->second.data.size();
+
+		squareEntries.erase(iter);
+	}
+
+	return ((stats.usedMemory + reqMemory) <= maxMemory);
+}
+
+
+CSMFTileStreamer::Stats CSMFTileStreamer::GetStats() const
+{
+	std::lock_guard<spring::mutex> lock(squareMutex);
+
+	Stats s = stats;
+	s.numWaiting = squareEntries.size() - stats.numPending;
+	return s;
+}
@@ -0,0 +1,117 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef _SMF_TILE_STREAMER_H_
+#define _SMF_TILE_STREAMER_H_
+
+#include <array>
+#include <cinttypes>
+#include <deque>
+#include <vector>
+
+#include "SMFFormat.h"
+#include "System/FileSystem/MappedFile.h"
+#include "System/Threading/SpringThreading.h"
+#include "System/UnorderedMap.hpp"
+
+/**
+ * CPU-side source of the SMF ground texture squares.
+ *
+ * Tiles stay in their (DXT1) .smt form, either in a mapping of the tile-file
+ * or in the buffer the VFS read it into. Squares are assembled from them for
+ * one MIP level at a time on ThreadPool workers, and kept until the GL thread
+ * takes them for uploading; squares that are still waiting when the memory
+ * budget runs out are evicted in least-recently-requested order.
+ * Does not touch GL, the map or any other global state.
+ */
+class CSMFTileStreamer {
+public:
+	static constexpr int NUM_MIP_LEVELS = 4;
+	// big squares are this many tiles wide and tall
+	static constexpr int SQUARE_TILES = 32;
+
+	struct Stats {
+		std::uint64_t numRequested = 0; // decodes queued
+		std::uint64_t numRejected = 0; // requests that did not fit into the budget
+		std::uint64_t numDecoded = 0;
+		std::uint64_t numEvicted = 0; // decoded squares nobody took
+		std::uint64_t numTaken = 0;
+
+		size_t numPending = 0; // queued or being decoded
+		size_t numWaiting = 0; // decoded, not yet taken
+		size_t usedMemory = 0;
+		size_t peakMemory = 0;
+	};
+
+public:
+	CSMFTileStreamer() = default;
+	CSMFTileStreamer(const CSMFTileStreamer&) = delete;
+	~CSMFTileStreamer() { Kill(); }
+
+	CSMFTileStreamer& operator = (const CSMFTileStreamer&) = delete;
+
+	void Init(int numSquaresX, int numSquaresY, size_t maxMemory);
+	// waits for all queued decodes, then releases tiles and squares
+	void Kill();
+
+	// tile sources, in tile-index order
+	void AddTiles(CMappedFile&& file, size_t offset, int numTiles);
+	void AddTiles(std::vector<std::uint8_t>&& buffer, size_t offset, int numTiles);
+	// stand-ins for a missing tile-file (drawn red)
+	void AddMissingTiles(int numTiles);
+
+	std::vector<int>& GetTileMap() { return tileMap; }
+	int GetNumTiles() const { return tilePtrs.size(); }
+
+	static size_t GetSquareSize(int mipLevel) { return (SQUARE_TILES * SQUARE_TILES * TILE_MIP_SIZES[mipLevel]); }
+
+	// assembles square (<sqrX>, <sqrY>) at <mipLevel> into <squareBuf> on the calling thread
+	void ExtractSquareTiles(int sqrX, int sqrY, int mipLevel, std::uint8_t* squareBuf) const;
+
+	// queues a decode unless the square is already queued or waiting; the
+	// (renderer's) frame number is used to rank squares for eviction
+	bool RequestSquare(int sqrIdx, int mipLevel, unsigned int frameNum);
+	// takes the oldest decoded square, returns false if there is none
+	bool TakeSquare(int& sqrIdx, int& mipLevel, std::vector<std::uint8_t>& squareData);
+
+	Stats GetStats() const;
+
+private:
+	// bytes per tile for each MIP level, stored consecutively in a .smt tile
+	static constexpr int TILE_MIP_SIZES[NUM_MIP_LEVELS] = {512, 128, 32, 8};
+	static constexpr int TILE_MIP_OFFSETS[NUM_MIP_LEVELS] = {0, 512, 512 + 128, 512 + 128 + 32};
+
+	struct SquareEntry {
+		std::vector<std::uint8_t> data;
+
+		unsigned int frameNum = 0;
+		bool decoded = false;
+	};
+
+	void DecodeSquare(int squareKey, std::uint8_t* squareBuf);
+	bool EvictSquares(size_t reqMemory);
+
+private:
+	std::vector<int> tileMap;
+	std::vector<const std::uint8_t*> tilePtrs;
+
+	std::vector<CMappedFile> mappedFiles;
+	std::vector< std::vector<std::uint8_t> > tileBuffers;
+
+	std::array<std::uint8_t, SMALL_TILE_SIZE> missingTile;
+
+	// keyed by (sqrIdx * NUM_MIP_LEVELS + mipLevel)
+	spring::unordered_map<int, SquareEntry> squareEntries;
+	std::deque<int> decodedKeys;
+
+	mutable spring::mutex squareMutex;
+	spring::condition_variable_any pendingCond;
+
+	Stats stats;
+
+	int numSquaresX = 0;
+	int numSquaresY = 0;
+
+	size_t maxMemory = 0;
+};
+
+#endif // _SMF_TILE_STREAMER_H_
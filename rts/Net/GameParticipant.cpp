@@ -47,6 +47,17 @@ void GameParticipant::Kill(const std::string& reason, const bool flush)
 	syncResponse.clear();
 #endif
 
+	ResetSnapshot();
+
 	myState = DISCONNECTED;
 }
 
+void GameParticipant::ResetSnapshot()
+{
+	snapshotDonor = -1;
+	snapshotSize = 0;
+	snapshotCacheIdx = 0;
+
+	snapshotChunks.clear();
+}
+
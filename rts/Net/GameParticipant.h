@@ -4,9 +4,11 @@
 #define _GAME_PARTICIPANT_H
 
 #include <memory>
+#include <vector>
 
 #include "Game/Players/PlayerBase.h"
 #include "Game/Players/PlayerStatistics.h"
+#include "System/Misc/SpringTime.h"
 #include "System/Net/LoopbackConnection.h"
 #include "System/UnorderedMap.hpp"
 
@@ -25,6 +27,9 @@ public:
 	void Connected(std::shared_ptr<netcode::CConnection> link, bool local);
 	void Kill(const std::string& reason, const bool flush = false);
 
+	bool IsAwaitingSnapshot() const { return (snapshotDonor != -1); }
+	void ResetSnapshot();
+
 	GameParticipant& operator=(const PlayerBase& base) { PlayerBase::operator=(base); return *this; };
 
 public:
@@ -45,6 +50,19 @@ public:
 
 	PlayerStatistics lastStats;
 
+	// mid-game join from a savestate made by another client (<snapshotDonor>);
+	// the chunks are buffered until complete and followed by every packet in
+	// the server's cache from <snapshotCacheIdx> onward
+	int snapshotDonor = -1;
+	int snapshotFrame = -1;
+
+	unsigned int snapshotSize = 0;
+	size_t snapshotCacheIdx = 0;
+
+	spring_time snapshotReqTime;
+
+	std::vector< std::shared_ptr<const netcode::RawPacket> > snapshotChunks;
+
 	struct ClientLinkData {
 		ClientLinkData(bool connect = true) {
 			if (connect)
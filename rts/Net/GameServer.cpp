@@ -55,6 +55,7 @@
 #include "System/LoadSave/DemoReader.h"
 #include "System/Log/ILog.h"
 #include "System/Platform/errorhandler.h"
+#include "System/Platform/Misc.h"
 #include "System/Platform/Threading.h"
 #include "System/Threading/SpringThreading.h"
 
@@ -69,8 +70,11 @@ using netcode::RawPacket;
 
 CONFIG(int, AutohostPort).defaultValue(0);
 CONFIG(int, ServerSleepTime).defaultValue(5).description("number of milliseconds to sleep per tick");
+CONFIG(bool, ServerEventLoop).defaultValue(false).dedicatedValue(true).description("instead of sleeping ServerSleepTime per tick, wait for incoming packets or the next sim-frame and send every tick's outgoing packets in one batch; not used while the server has a local client");
+CONFIG(int, ServerCPUReportInterval).defaultValue(0).dedicatedValue(60).minimumValue(0).description("number of seconds between logged reports of the server process' CPU usage, 0 to disable");
 CONFIG(int, SpeedControl).defaultValue(1).minimumValue(1).maximumValue(2)
 	.description("Sets how server adjusts speed according to player's load (CPU), 1: use average, 2: use highest");
+CONFIG(bool, AllowSnapshotJoin).defaultValue(false).description("let clients joining or reconnecting to a running game load a savestate made by an in-game client instead of re-simulating every frame since the start");
 CONFIG(bool, AllowSpectatorJoin).defaultValue(true).dedicatedValue(false).description("allow any unauthenticated clients to join as spectator with any name, name will be prefixed with ~");
 CONFIG(bool, WhiteListAdditionalPlayers).defaultValue(true);
 CONFIG(bool, ServerRecordDemos).defaultValue(false).dedicatedValue(true);
@@ -99,6 +103,9 @@ static constexpr unsigned SYNCCHECK_MSG_TIMEOUT = 400;
 /// The time interval in msec for sending player statistics to each client
 static const spring_time playerInfoTime = spring_secs(2);
 
+/// time a client gets to deliver a savestate for a mid-game joiner before the joiner falls back to a full replay
+static const spring_time snapshotJoinTimeout = spring_secs(30);
+
 /// every n'th frame will be a keyframe (and contain the server's framenumber)
 static constexpr unsigned serverKeyframeInterval = 16;
 
@@ -161,6 +168,7 @@ void CGameServer::Initialize()
 	// configs
 	curSpeedCtrl = configHandler->GetInt("SpeedControl");
 	allowSpecJoin = configHandler->GetBool("AllowSpectatorJoin") || myGameSetup->onlyLocal; ///!!! mantis #4418
+	allowSnapshotJoin = configHandler->GetBool("AllowSnapshotJoin");
 	whiteListAdditionalPlayers = configHandler->GetBool("WhiteListAdditionalPlayers");
 	logInfoMessages = configHandler->GetBool("ServerLogInfoMessages");
 	logDebugMessages = configHandler->GetBool("ServerLogDebugMessages");
@@ -256,10 +264,14 @@ void CGameServer::Initialize()
 	}
 
 	loopSleepTime = configHandler->GetInt("ServerSleepTime");
+	useEventLoop = configHandler->GetBool("ServerEventLoop");
+	cpuReportInterval = configHandler->GetInt("ServerCPUReportInterval");
 	linkMinPacketSize = globalConfig.linkIncomingMaxPacketRate > 0 ? (globalConfig.linkIncomingSustainedBandwidth / globalConfig.linkIncomingMaxPacketRate) : 1;
 
 	lastNewFrameTick = spring_gettime();
 	lastBandwidthUpdate = spring_gettime();
+	lastCPUReportTime = spring_gettime();
+	lastCPUReportUsecs = Platform::GetProcessCPUTime();
 
 	thread = std::move(spring::thread(std::bind(&CGameServer::UpdateLoop, this)));
 
@@ -545,6 +557,10 @@ bool CGameServer::SendDemoData(int targetFrameNum)
 void CGameServer::Broadcast(std::shared_ptr<const netcode::RawPacket> packet)
 {
 	for (GameParticipant& p: players) {
+		// gets this from the cache once its savestate has arrived
+		if (p.IsAwaitingSnapshot())
+			continue;
+
 		p.SendData(packet);
 	}
 
@@ -670,6 +686,10 @@ void CGameServer::CheckSync()
 			if (p.clientLink == nullptr)
 				continue;
 
+			// joined from a savestate made after this frame, never simulated it
+			if (outstandingSyncFrame <= p.snapshotFrame)
+				continue;
+
 			const auto pChecksumIt = p.syncResponse.find(outstandingSyncFrame);
 
 			if (pChecksumIt == p.syncResponse.end()) {
@@ -826,6 +846,9 @@ void CGameServer::Update()
 	else if (!PreSimFrame() || demoReader != nullptr)
 		CreateNewFrame(true, false);
 
+	CheckSnapshotJoins();
+	ReportCPUUsage();
+
 	if (hostif != nullptr) {
 		const std::string msg = hostif->GetChatMessage();
 
@@ -1178,6 +1201,7 @@ void CGameServer::ProcessPacket(const unsigned playerNum, std::shared_ptr<const
 		}
 
 		case NETMSG_COMMAND:
+		case NETMSG_COMMANDS:
 			try {
 				netcode::UnpackPacket pckt(packet, 3);
 				unsigned char playerNum;
@@ -1803,6 +1827,53 @@ void CGameServer::ProcessPacket(const unsigned playerNum, std::shared_ptr<const
 			break;
 		}
 
+		case NETMSG_SNAPSHOT_DATA: {
+			try {
+				netcode::UnpackPacket pckt(packet, 3);
+
+				uint8_t donorNum;
+				uint8_t joinerNum;
+				int32_t frameNum;
+				uint32_t totalSize;
+				uint32_t chunkOffset;
+
+				pckt >> donorNum;
+				pckt >> joinerNum;
+				pckt >> frameNum;
+				pckt >> totalSize;
+				pckt >> chunkOffset;
+
+				if (donorNum != a) {
+					Message(spring::format(WrongPlayer, msgCode, a, donorNum));
+					break;
+				}
+
+				// not (or no longer) waiting for this client's state, e.g. after a timeout
+				if (joinerNum >= players.size() || players[joinerNum].snapshotDonor != int(a))
+					break;
+
+				GameParticipant& joiner = players[joinerNum];
+
+				// an empty state means the donor failed to create one
+				if (totalSize == 0 || chunkOffset != joiner.snapshotSize) {
+					FinishSnapshotJoin(joiner, false);
+					break;
+				}
+
+				constexpr uint32_t headerSize = sizeof(uint8_t) + sizeof(uint16_t) + sizeof(donorNum) + sizeof(joinerNum) + sizeof(frameNum) + sizeof(totalSize) + sizeof(chunkOffset);
+
+				joiner.snapshotChunks.push_back(packet);
+				joiner.snapshotSize += (packet->length - headerSize);
+				joiner.snapshotFrame = frameNum;
+
+				if (joiner.snapshotSize >= totalSize)
+					FinishSnapshotJoin(joiner, true);
+			} catch (const netcode::UnpackPacketException& ex) {
+				Message(spring::format("Player %d sent invalid SnapshotData: %s", a, ex.what()));
+			}
+			break;
+		}
+
 #ifdef SYNCDEBUG
 		case NETMSG_SD_CHKRESPONSE:
 		case NETMSG_SD_BLKRESPONSE:
@@ -2676,17 +2747,41 @@ void CGameServer::UpdateLoop()
 		Threading::SetThreadName("netcode");
 		Threading::SetAffinity(~0);
 
+		// packets from a local client do not arrive through udpListener
+		const auto eventLoopPred = [&]() { return (useEventLoop && udpListener != nullptr && !HasLocalClient()); };
+
+		int waitTime = loopSleepTime;
+
 		while (!quitServer) {
-			spring_msecs(loopSleepTime).sleep(true);
+			const bool eventLoop = eventLoopPred();
 
-			if (udpListener != nullptr)
+			if (eventLoop) {
+				udpListener->WaitForData(waitTime);
+			} else {
+				spring_msecs(loopSleepTime).sleep(true);
+			}
+
+			if (udpListener != nullptr) {
+				udpListener->SetBatchedSends(eventLoop);
 				udpListener->Update();
+			}
 
 			std::lock_guard<spring::recursive_mutex> scoped_lock(gameServerMutex);
 			ServerReadNet();
 			Update();
+
+			if (!eventLoop)
+				continue;
+
+			// send what this tick produced now rather than after the next wait
+			udpListener->Update();
+
+			waitTime = GetEventLoopWaitTime();
 		}
 
+		if (udpListener != nullptr)
+			udpListener->SetBatchedSends(false);
+
 		if (hostif != nullptr)
 			hostif->SendQuit();
 
@@ -2711,6 +2806,48 @@ void CGameServer::UpdateLoop()
 }
 
 
+int CGameServer::GetEventLoopWaitTime() const
+{
+	// keeps the keep-alive, resend and pregame timers ticking when nothing happens
+	constexpr int maxWaitTime = 50;
+
+	// queued packets wait for their connection's send-rate limit
+	// to expire; poll for that as often as without the event-loop
+	if (udpListener->HasUnsentData())
+		return loopSleepTime;
+
+	if (!gameHasStarted || isPaused || PreSimFrame())
+		return maxWaitTime;
+
+	// see CreateNewFrame; the next frame is due once frameTimeLeft becomes positive
+	const float framesPerMsec = GAME_SPEED * 0.001f * internalSpeed;
+	const float msecsToFrame = (-frameTimeLeft / framesPerMsec) - (spring_gettime() - lastNewFrameTick).toMilliSecsf();
+
+	return (Clamp(int(math::ceil(msecsToFrame)), 0, maxWaitTime));
+}
+
+void CGameServer::ReportCPUUsage()
+{
+	if (cpuReportInterval <= 0)
+		return;
+
+	const spring_time curTime = spring_gettime();
+	const spring_time difTime = curTime - lastCPUReportTime;
+
+	if (difTime < spring_secs(cpuReportInterval))
+		return;
+
+	const std::uint64_t curUsecs = Platform::GetProcessCPUTime();
+	const std::uint64_t difUsecs = curUsecs - lastCPUReportUsecs;
+
+	// relative to one core; a value above 100% means more than one was busy
+	LOG("[GameServer::%s] %.2f%% CPU over the last %.0fs (%.3fs in total)", __func__, difUsecs * 100.0f / difTime.toMicroSecsf(), difTime.toSecsf(), curUsecs * 1e-6f);
+
+	lastCPUReportTime = curTime;
+	lastCPUReportUsecs = curUsecs;
+}
+
+
 void CGameServer::KickPlayer(int playerNum)
 {
 	// only kick connected players
@@ -2976,8 +3113,16 @@ unsigned CGameServer::BindConnection(
 	}
 
 	newPlayer.Connected(clientLink, isLocal);
+	newPlayer.ResetSnapshot();
+	newPlayer.snapshotFrame = -1;
 	newPlayer.SendData(std::shared_ptr<const RawPacket>(myGameData->Pack()));
-	newPlayer.SendData(CBaseNetProtocol::Get().SendSetPlayerNum((unsigned char)newPlayerNumber));
+
+	// a mid-game joiner loading a savestate needs it before it starts loading,
+	// playerNum is withheld until the state arrives (see FinishSnapshotJoin)
+	const int snapshotDonor = (allowSnapshotJoin && gameHasStarted && demoReader == nullptr && !packetCache.empty())? FindSnapshotDonor(newPlayerNumber): -1;
+
+	if (snapshotDonor == -1)
+		newPlayer.SendData(CBaseNetProtocol::Get().SendSetPlayerNum((unsigned char)newPlayerNumber));
 
 	// after gamedata and playerNum, the player can start loading
 	if (demoReader == nullptr || myGameSetup->demoName.empty()) {
@@ -2995,9 +3140,14 @@ unsigned CGameServer::BindConnection(
 		}
 	}
 
-	// finally send player all packets he missed until now
-	for (const std::shared_ptr<const netcode::RawPacket>& p: packetCache)
-		newPlayer.SendData(p);
+	// finally send player all packets he missed until now, or
+	// only those that follow the requested savestate's frame
+	if (snapshotDonor == -1) {
+		for (const std::shared_ptr<const netcode::RawPacket>& p: packetCache)
+			newPlayer.SendData(p);
+	} else {
+		RequestSnapshot(newPlayer, snapshotDonor);
+	}
 
 	// new connection established
 	Message(spring::format(" -> Connection established (given id %i)", newPlayerNumber));
@@ -3007,6 +3157,86 @@ unsigned CGameServer::BindConnection(
 }
 
 
+int CGameServer::FindSnapshotDonor(unsigned int joinerNum) const
+{
+	int donorNum = -1;
+
+	for (const GameParticipant& p: players) {
+		if (p.id == int(joinerNum) || p.clientLink == nullptr)
+			continue;
+		if (p.myState != GameParticipant::INGAME || p.desynced || p.IsAwaitingSnapshot())
+			continue;
+
+		// prefer the local client, it does not have to upload the state
+		if (p.id == int(localClientNumber))
+			return p.id;
+
+		// otherwise whoever is least behind
+		if (donorNum == -1 || p.lastFrameResponse > players[donorNum].lastFrameResponse)
+			donorNum = p.id;
+	}
+
+	return donorNum;
+}
+
+void CGameServer::RequestSnapshot(GameParticipant& joiner, int donorNum)
+{
+	joiner.snapshotDonor = donorNum;
+	joiner.snapshotReqTime = spring_gettime();
+
+	// everything broadcast from here on is after the state in the donor's stream
+	// (the request itself is not cached, so later joiners never see it)
+	joiner.snapshotCacheIdx = packetCache.size();
+
+	players[donorNum].SendData(CBaseNetProtocol::Get().SendSnapshotRequest(donorNum, joiner.id));
+
+	Message(spring::format(" -> Requesting savestate from %s for %s", players[donorNum].name.c_str(), joiner.name.c_str()));
+}
+
+void CGameServer::FinishSnapshotJoin(GameParticipant& joiner, bool haveSnapshot)
+{
+	assert(joiner.IsAwaitingSnapshot());
+
+	if (haveSnapshot) {
+		for (const std::shared_ptr<const netcode::RawPacket>& p: joiner.snapshotChunks)
+			joiner.SendData(p);
+	}
+
+	joiner.SendData(CBaseNetProtocol::Get().SendSetPlayerNum((unsigned char)joiner.id));
+
+	if (haveSnapshot) {
+		for (size_t i = joiner.snapshotCacheIdx, n = packetCache.size(); i < n; i++)
+			joiner.SendData(packetCache[i]);
+
+		Message(spring::format(" -> Sent %u byte savestate of frame %d to %s", joiner.snapshotSize, joiner.snapshotFrame, joiner.name.c_str()));
+	} else {
+		for (const std::shared_ptr<const netcode::RawPacket>& p: packetCache)
+			joiner.SendData(p);
+
+		joiner.snapshotFrame = -1;
+
+		Message(spring::format(" -> No savestate for %s, replaying the full game", joiner.name.c_str()));
+	}
+
+	joiner.ResetSnapshot();
+}
+
+void CGameServer::CheckSnapshotJoins()
+{
+	for (GameParticipant& p: players) {
+		if (!p.IsAwaitingSnapshot())
+			continue;
+
+		const GameParticipant& donor = players[p.snapshotDonor];
+
+		if (donor.clientLink != nullptr && donor.myState == GameParticipant::INGAME && (spring_gettime() - p.snapshotReqTime) < snapshotJoinTimeout)
+			continue;
+
+		FinishSnapshotJoin(p, false);
+	}
+}
+
+
 void CGameServer::GotChatMessage(const ChatMessage& msg)
 {
 	// silently drop empty chat messages
@@ -159,6 +159,9 @@ private:
 	void StartGame(bool forced);
 	void UpdateLoop();
 	void Update();
+	/// milliseconds UpdateLoop may block on the network before Update has work to do
+	int GetEventLoopWaitTime() const;
+	void ReportCPUUsage();
 	void ProcessPacket(const unsigned playerNum, std::shared_ptr<const netcode::RawPacket> packet);
 	void CheckSync();
 	void HandleConnectionAttempts();
@@ -175,6 +178,12 @@ private:
 
 	void Broadcast(std::shared_ptr<const netcode::RawPacket> packet);
 
+	/// mid-game joins from a savestate made by an in-game client (<donor>)
+	int FindSnapshotDonor(unsigned int joinerNum) const;
+	void RequestSnapshot(GameParticipant& joiner, int donorNum);
+	void FinishSnapshotJoin(GameParticipant& joiner, bool haveSnapshot);
+	void CheckSnapshotJoins();
+
 	/**
 	 * @brief skip frames
 	 *
@@ -236,6 +245,7 @@ private:
 	spring_time lastPlayerInfo = spring_notime;
 	spring_time lastUpdate = spring_notime;
 	spring_time lastBandwidthUpdate = spring_notime;
+	spring_time lastCPUReportTime = spring_notime;
 
 	float modGameTime = 0.0f;
 	float gameTime = 0.0f;
@@ -249,6 +259,9 @@ private:
 	int medianPing = 0;
 	int curSpeedCtrl = 0;
 	int loopSleepTime = 0;
+	int cpuReportInterval = 0;
+
+	std::uint64_t lastCPUReportUsecs = 0;
 
 
 	int serverFrameNum = -1;
@@ -275,10 +288,12 @@ private:
 	bool canReconnect = false;
 	bool allowSpecDraw = true;
 	bool allowSpecJoin = false;
+	bool allowSnapshotJoin = false;
 	bool whiteListAdditionalPlayers = false;
 
 	bool logInfoMessages = false;
 	bool logDebugMessages = false;
+	bool useEventLoop = false;
 
 
 	/// If the server receives a command, it will forward it to clients if it is not in this set
@@ -32,7 +32,9 @@
 #include "System/GlobalConfig.h"
 #include "System/Log/ILog.h"
 #include "System/SpringMath.h"
+#include "System/StringUtil.h"
 #include "System/TimeProfiler.h"
+#include "System/LoadSave/CregLoadSaveHandler.h"
 #include "System/LoadSave/DemoRecorder.h"
 #include "System/Net/UnpackPacket.h"
 #include "System/Sound/ISound.h"
@@ -239,8 +241,11 @@ void CGame::ClientReadNet()
 	const bool haveServerDemo = (gameServer != nullptr && gameServer->GetDemoReader() != nullptr);
 	const bool haveClientDemo = (clientNet->GetDemoRecorder() != nullptr);
 
+	// set if the server asked us for a savestate for a mid-game joiner
+	int snapshotJoinerNum = -1;
+
 	// now really process the messages
-	while (true) {
+	while (snapshotJoinerNum == -1) {
 		if (msgProcTimeLeft <= 0.0f)
 			break;
 		if (spring_gettime() > msgProcEndTime)
@@ -648,6 +653,23 @@ void CGame::ClientReadNet()
 				}
 			} break;
 
+			case NETMSG_COMMANDS: {
+				try {
+					netcode::UnpackPacket pckt(packet, 1);
+
+					uint16_t packetSize; pckt >> packetSize;
+					uint8_t playerNum; pckt >> playerNum;
+
+					if (!playerHandler.IsValidPlayer(playerNum))
+						throw netcode::UnpackPacketException("Invalid player number");
+
+					selectedUnitsHandler.NetOrders(pckt, playerNum);
+					AddTraffic(playerNum, packetCode, dataLength);
+				} catch (const netcode::UnpackPacketException& ex) {
+					LOG_L(L_ERROR, "[Game::%s][NETMSG_COMMANDS] exception \"%s\"", __func__, ex.what());
+				}
+			} break;
+
 			case NETMSG_SELECT: {
 				try {
 					netcode::UnpackPacket pckt(packet, 1);
@@ -1501,6 +1523,15 @@ void CGame::ClientReadNet()
 			case NETMSG_GAME_FRAME_PROGRESS: {
 			} break;
 
+			case NETMSG_SNAPSHOT_REQUEST: {
+				// the joiner receives everything queued behind this packet on top
+				// of the state, so stop reading here and create it right away
+				if (inbuf[1] == gu->myPlayerNum && !haveServerDemo)
+					snapshotJoinerNum = inbuf[2];
+
+				AddTraffic(-1, packetCode, dataLength);
+			} break;
+
 
 			default: {
 #ifdef SYNCDEBUG
@@ -1517,4 +1548,43 @@ void CGame::ClientReadNet()
 			} break;
 		}
 	}
+
+	if (snapshotJoinerNum != -1)
+		SendGameSnapshot(snapshotJoinerNum);
+}
+
+
+void CGame::SendGameSnapshot(int joinerNum)
+{
+	ScopedOnceTimer timer("Game::SendGameSnapshot");
+
+	// keep chunks well below the uint16_t packet-size limit
+	constexpr uint32_t maxChunkSize = 32768;
+
+	std::stringstream stateStream;
+	std::vector<std::uint8_t> stateData;
+	std::vector<std::uint8_t> chunkData;
+
+	{
+		CCregLoadSaveHandler saveHandler;
+		saveHandler.SaveInfo(gameSetup->mapName, gameSetup->modName);
+
+		if (saveHandler.SaveGameState(stateStream)) {
+			const std::string& state = stateStream.str();
+			stateData = std::move(zlib::deflate(reinterpret_cast<const std::uint8_t*>(state.data()), state.size()));
+		}
+	}
+
+	LOG("[Game::%s] sending %u byte savestate of frame %d to player %d", __func__, uint32_t(stateData.size()), gs->frameNum, joinerNum);
+
+	// an empty state tells the server to fall back to a full replay
+	if (stateData.empty()) {
+		clientNet->Send(CBaseNetProtocol::Get().SendSnapshotData(gu->myPlayerNum, joinerNum, gs->frameNum, 0, 0, chunkData));
+		return;
+	}
+
+	for (uint32_t chunkOffset = 0, totalSize = stateData.size(); chunkOffset < totalSize; chunkOffset += maxChunkSize) {
+		chunkData.assign(stateData.begin() + chunkOffset, stateData.begin() + std::min(chunkOffset + maxChunkSize, totalSize));
+		clientNet->Send(CBaseNetProtocol::Get().SendSnapshotData(gu->myPlayerNum, joinerNum, gs->frameNum, totalSize, chunkOffset, chunkData));
+	}
 }
@@ -20,14 +20,14 @@ CBaseNetProtocol& CBaseNetProtocol::Get()
 
 PacketType CBaseNetProtocol::SendKeyFrame(int32_t frameNum)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(frameNum), NETMSG_KEYFRAME);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(sizeof(uint8_t) + sizeof(frameNum), NETMSG_KEYFRAME);
 	*packet << frameNum;
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendNewFrame()
 {
-	return PacketType(new PackPacket(sizeof(uint8_t), NETMSG_NEWFRAME));
+	return (netcode::AllocPacket(sizeof(uint8_t), NETMSG_NEWFRAME));
 }
 
 
@@ -41,21 +41,21 @@ PacketType CBaseNetProtocol::SendQuit(const std::string& reason)
 	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint16_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_QUIT);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(packetSize, NETMSG_QUIT);
 	*packet << static_cast<uint16_t>(packetSize) << reason;
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendStartPlaying(uint32_t countdown)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(countdown), NETMSG_STARTPLAYING);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(sizeof(uint8_t) + sizeof(countdown), NETMSG_STARTPLAYING);
 	*packet << countdown;
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendSetPlayerNum(uint8_t playerNum)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum), NETMSG_SETPLAYERNUM);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(sizeof(uint8_t) + sizeof(playerNum), NETMSG_SETPLAYERNUM);
 	*packet << playerNum;
 	return PacketType(packet);
 }
@@ -66,14 +66,14 @@ PacketType CBaseNetProtocol::SendPlayerName(uint8_t playerNum, const std::string
 	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint8_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_PLAYERNAME);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(packetSize, NETMSG_PLAYERNAME);
 	*packet << static_cast<uint8_t>(packetSize) << playerNum << playerName;
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendRandSeed(uint32_t randSeed)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(randSeed), NETMSG_RANDSEED);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(sizeof(uint8_t) + sizeof(randSeed), NETMSG_RANDSEED);
 	*packet << randSeed;
 	return PacketType(packet);
 }
@@ -81,14 +81,14 @@ PacketType CBaseNetProtocol::SendRandSeed(uint32_t randSeed)
 // NETMSG_GAMEID = 9, char gameID[16];
 PacketType CBaseNetProtocol::SendGameID(const uint8_t* buf)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + 16, NETMSG_GAMEID);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(sizeof(uint8_t) + 16, NETMSG_GAMEID);
 	memcpy(packet->GetWritingPos(), buf, 16);
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendPathCheckSum(uint8_t playerNum, uint32_t checksum)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(uint32_t), NETMSG_PATH_CHECKSUM);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(uint32_t), NETMSG_PATH_CHECKSUM);
 	*packet << playerNum;
 	*packet << checksum;
 	return PacketType(packet);
@@ -101,7 +101,7 @@ PacketType CBaseNetProtocol::SendSelect(uint8_t playerNum, const std::vector<int
 	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint16_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_SELECT);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(packetSize, NETMSG_SELECT);
 	*packet << static_cast<uint16_t>(packetSize) << playerNum << selectedUnitIDs;
 	return PacketType(packet);
 }
@@ -109,7 +109,7 @@ PacketType CBaseNetProtocol::SendSelect(uint8_t playerNum, const std::vector<int
 
 PacketType CBaseNetProtocol::SendPause(uint8_t playerNum, uint8_t bPaused)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(bPaused), NETMSG_PAUSE);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(bPaused), NETMSG_PAUSE);
 	*packet << playerNum << bPaused;
 	return PacketType(packet);
 }
@@ -127,7 +127,7 @@ PacketType CBaseNetProtocol::SendCommand(
 	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint16_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_COMMAND);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(packetSize, NETMSG_COMMAND);
 	*packet << static_cast<uint16_t>(packetSize) << playerNum << commandID << timeout << options << numParams;
 
 	for (uint32_t i = 0; i < numParams; i++) {
@@ -137,6 +137,20 @@ PacketType CBaseNetProtocol::SendCommand(
 	return PacketType(packet);
 }
 
+PacketType CBaseNetProtocol::SendCommands(uint8_t playerNum, uint16_t numCommands, const std::vector<uint8_t>& packedCommands)
+{
+	const uint32_t payloadSize = sizeof(playerNum) + sizeof(numCommands) + packedCommands.size();
+	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint16_t);
+	const uint32_t packetSize = headerSize + payloadSize;
+
+	if (packetSize >= (1 << (sizeof(uint16_t) * 8)))
+		throw netcode::PackPacketException("[BaseNetProto::SendCommands] maximum packet-size exceeded");
+
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(packetSize, NETMSG_COMMANDS);
+	*packet << static_cast<uint16_t>(packetSize) << playerNum << numCommands << packedCommands;
+	return PacketType(packet);
+}
+
 PacketType CBaseNetProtocol::SendAICommand(
 	uint8_t playerNum,
 	uint8_t aiInstID,
@@ -162,7 +176,7 @@ PacketType CBaseNetProtocol::SendAICommand(
 	if (packetSize >= (1 << (sizeof(uint16_t) * 8)))
 		throw netcode::PackPacketException("[BaseNetProto::SendAICommand] maximum packet-size exceeded");
 
-	PackPacket* packet = new PackPacket(packetSize, commandTypeID);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(packetSize, commandTypeID);
 	*packet << static_cast<uint16_t>(packetSize) << playerNum << aiInstID << aiTeamID << unitID;
 	*packet << commandID << timeout << options << numParams;
 
@@ -192,7 +206,7 @@ PacketType CBaseNetProtocol::SendAIShare(
 	if (packetSize >= (1 << (sizeof(uint16_t) * 8)))
 		throw netcode::PackPacketException("[BaseNetProto::SendAIShare] maximum packet-size exceeded");
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_AISHARE);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(packetSize, NETMSG_AISHARE);
 	*packet << static_cast<uint16_t>(packetSize) << playerNum << aiID << sourceTeam << destTeam << metal << energy << unitIDs;
 	return PacketType(packet);
 }
@@ -200,35 +214,35 @@ PacketType CBaseNetProtocol::SendAIShare(
 
 PacketType CBaseNetProtocol::SendUserSpeed(uint8_t playerNum, float userSpeed)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(userSpeed), NETMSG_USER_SPEED);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(userSpeed), NETMSG_USER_SPEED);
 	*packet << playerNum << userSpeed;
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendInternalSpeed(float internalSpeed)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(internalSpeed), NETMSG_INTERNAL_SPEED);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(sizeof(uint8_t) + sizeof(internalSpeed), NETMSG_INTERNAL_SPEED);
 	*packet << internalSpeed;
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendCPUUsage(float cpuUsage)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(cpuUsage), NETMSG_CPU_USAGE);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(sizeof(uint8_t) + sizeof(cpuUsage), NETMSG_CPU_USAGE);
 	*packet << cpuUsage;
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendDirectControl(uint8_t playerNum)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum), NETMSG_DIRECT_CONTROL);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(sizeof(uint8_t) + sizeof(playerNum), NETMSG_DIRECT_CONTROL);
 	*packet << playerNum;
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendDirectControlUpdate(uint8_t playerNum, uint8_t status, int16_t heading, int16_t pitch)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(status) + sizeof(heading) + sizeof(pitch), NETMSG_DC_UPDATE);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(status) + sizeof(heading) + sizeof(pitch), NETMSG_DC_UPDATE);
 	*packet << playerNum << status << heading << pitch;
 	return PacketType(packet);
 }
@@ -253,7 +267,7 @@ PacketType CBaseNetProtocol::SendAttemptConnect(
 	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint16_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_ATTEMPTCONNECT);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(packetSize, NETMSG_ATTEMPTCONNECT);
 	*packet << static_cast<uint16_t>(packetSize);
 	*packet << NETWORK_VERSION;
 	*packet << name;
@@ -273,7 +287,7 @@ PacketType CBaseNetProtocol::SendRejectConnect(const std::string& reason)
 	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint16_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_REJECT_CONNECT);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(packetSize, NETMSG_REJECT_CONNECT);
 	*packet << static_cast<uint16_t>(packetSize) << reason;
 	return PacketType(packet);
 }
@@ -281,14 +295,14 @@ PacketType CBaseNetProtocol::SendRejectConnect(const std::string& reason)
 
 PacketType CBaseNetProtocol::SendShare(uint8_t playerNum, uint8_t shareTeam, uint8_t bShareUnits, float shareMetal, float shareEnergy)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(shareTeam) + sizeof(bShareUnits) + (sizeof(shareMetal) * 2), NETMSG_SHARE);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(shareTeam) + sizeof(bShareUnits) + (sizeof(shareMetal) * 2), NETMSG_SHARE);
 	*packet << playerNum << shareTeam << bShareUnits << shareMetal << shareEnergy;
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendSetShare(uint8_t playerNum, uint8_t myTeam, float metalShareFraction, float energyShareFraction)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(myTeam) + (sizeof(metalShareFraction) * 2), NETMSG_SETSHARE);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(myTeam) + (sizeof(metalShareFraction) * 2), NETMSG_SETSHARE);
 	*packet << playerNum << myTeam << metalShareFraction << energyShareFraction;
 	return PacketType(packet);
 }
@@ -296,14 +310,14 @@ PacketType CBaseNetProtocol::SendSetShare(uint8_t playerNum, uint8_t myTeam, flo
 
 PacketType CBaseNetProtocol::SendPlayerStat(uint8_t playerNum, const PlayerStatistics& currentStats)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(PlayerStatistics), NETMSG_PLAYERSTAT);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(PlayerStatistics), NETMSG_PLAYERSTAT);
 	*packet << playerNum << currentStats;
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendTeamStat(uint8_t teamNum, const TeamStatistics& currentStats)
 {
-	PackPacket* packet = new netcode::PackPacket(sizeof(uint8_t) + sizeof(teamNum) + sizeof(TeamStatistics), NETMSG_TEAMSTAT);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(sizeof(uint8_t) + sizeof(teamNum) + sizeof(TeamStatistics), NETMSG_TEAMSTAT);
 	*packet << teamNum << currentStats;
 	return PacketType(packet);
 }
@@ -316,7 +330,7 @@ PacketType CBaseNetProtocol::SendGameOver(uint8_t playerNum, const std::vector<u
 	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint8_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_GAMEOVER);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(packetSize, NETMSG_GAMEOVER);
 	*packet << static_cast<uint8_t>(packetSize) << playerNum << winningAllyTeams;
 	return PacketType(packet);
 }
@@ -330,7 +344,7 @@ PacketType CBaseNetProtocol::SendMapErase(uint8_t playerNum, int16_t x, int16_t
 	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint8_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_MAPDRAW);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(packetSize, NETMSG_MAPDRAW);
 	*packet << static_cast<uint8_t>(packetSize) << playerNum << drawType << x << z;
 	return PacketType(packet);
 }
@@ -344,7 +358,7 @@ PacketType CBaseNetProtocol::SendMapDrawPoint(uint8_t playerNum, int16_t x, int1
 	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint8_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_MAPDRAW);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(packetSize, NETMSG_MAPDRAW);
 	*packet <<
 		static_cast<uint8_t>(packetSize) <<
 		playerNum <<
@@ -364,7 +378,7 @@ PacketType CBaseNetProtocol::SendMapDrawLine(uint8_t playerNum, int16_t x1, int1
 	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint8_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_MAPDRAW);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(packetSize, NETMSG_MAPDRAW);
 	*packet <<
 		static_cast<uint8_t>(packetSize) <<
 		playerNum <<
@@ -378,7 +392,7 @@ PacketType CBaseNetProtocol::SendMapDrawLine(uint8_t playerNum, int16_t x1, int1
 
 PacketType CBaseNetProtocol::SendSyncResponse(uint8_t playerNum, int32_t frameNum, uint32_t checksum)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(frameNum) + sizeof(checksum), NETMSG_SYNCRESPONSE);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(frameNum) + sizeof(checksum), NETMSG_SYNCRESPONSE);
 	*packet << playerNum << frameNum << checksum;
 	return PacketType(packet);
 }
@@ -394,28 +408,28 @@ PacketType CBaseNetProtocol::SendSystemMessage(uint8_t playerNum, std::string me
 	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint16_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_SYSTEMMSG);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(packetSize, NETMSG_SYSTEMMSG);
 	*packet << static_cast<uint16_t>(packetSize) << playerNum << message;
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendStartPos(uint8_t playerNum, uint8_t teamNum, uint8_t readyState, float x, float y, float z)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(teamNum) + sizeof(readyState) + (3 * sizeof(x)), NETMSG_STARTPOS);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(teamNum) + sizeof(readyState) + (3 * sizeof(x)), NETMSG_STARTPOS);
 	*packet << playerNum << teamNum << readyState << x << y << z;
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendPlayerInfo(uint8_t playerNum, float cpuUsage, int32_t ping)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(cpuUsage) + sizeof(ping), NETMSG_PLAYERINFO);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(cpuUsage) + sizeof(ping), NETMSG_PLAYERINFO);
 	*packet << playerNum << cpuUsage << static_cast<uint32_t>(ping);
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendPlayerLeft(uint8_t playerNum, uint8_t bIntended)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(bIntended), NETMSG_PLAYERLEFT);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(bIntended), NETMSG_PLAYERLEFT);
 	*packet << playerNum << bIntended;
 	return PacketType(packet);
 }
@@ -430,7 +444,7 @@ PacketType CBaseNetProtocol::SendLogMsg(uint8_t playerNum, uint8_t logMsgLvl, co
 	if (packetSize >= (1 << (sizeof(uint16_t) * 8)))
 		throw netcode::PackPacketException("[BaseNetProto::SendLogMsg] maximum packet-size exceeded");
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_LOGMSG);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(packetSize, NETMSG_LOGMSG);
 	*packet << static_cast<uint16_t>(packetSize) << playerNum << logMsgLvl << strData;
 	return PacketType(packet);
 }
@@ -444,7 +458,7 @@ PacketType CBaseNetProtocol::SendLuaMsg(uint8_t playerNum, uint16_t script, uint
 	if (packetSize >= (1 << (sizeof(uint16_t) * 8)))
 		throw netcode::PackPacketException("[BaseNetProto::SendLuaMsg] maximum packet-size exceeded");
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_LUAMSG);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(packetSize, NETMSG_LUAMSG);
 	*packet << static_cast<uint16_t>(packetSize) << playerNum << script << mode << rawData;
 	return PacketType(packet);
 }
@@ -452,28 +466,28 @@ PacketType CBaseNetProtocol::SendLuaMsg(uint8_t playerNum, uint16_t script, uint
 
 PacketType CBaseNetProtocol::SendGiveAwayEverything(uint8_t playerNum, uint8_t giveToTeam, uint8_t takeFromTeam)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + 1 + sizeof(giveToTeam) + sizeof(takeFromTeam), NETMSG_TEAM);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(sizeof(uint8_t) + sizeof(playerNum) + 1 + sizeof(giveToTeam) + sizeof(takeFromTeam), NETMSG_TEAM);
 	*packet << playerNum << static_cast<uint8_t>(TEAMMSG_GIVEAWAY) << giveToTeam << takeFromTeam;
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendResign(uint8_t playerNum)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + 1 + 1 + 1, NETMSG_TEAM);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(sizeof(uint8_t) + sizeof(playerNum) + 1 + 1 + 1, NETMSG_TEAM);
 	*packet << playerNum << static_cast<uint8_t>(TEAMMSG_RESIGN) << static_cast<uint8_t>(0) << static_cast<uint8_t>(0);
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendJoinTeam(uint8_t playerNum, uint8_t wantedTeamNum)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + 1 + sizeof(wantedTeamNum) + 1, NETMSG_TEAM);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(sizeof(uint8_t) + sizeof(playerNum) + 1 + sizeof(wantedTeamNum) + 1, NETMSG_TEAM);
 	*packet << playerNum << static_cast<uint8_t>(TEAMMSG_JOIN_TEAM) << wantedTeamNum << static_cast<uint8_t>(0);
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendTeamDied(uint8_t playerNum, uint8_t whichTeam)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + 1 + sizeof(whichTeam) + 1, NETMSG_TEAM);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(sizeof(uint8_t) + sizeof(playerNum) + 1 + sizeof(whichTeam) + 1, NETMSG_TEAM);
 	*packet << playerNum << static_cast<uint8_t>(TEAMMSG_TEAM_DIED) << whichTeam << static_cast<uint8_t>(0);
 	return PacketType(packet);
 }
@@ -485,7 +499,7 @@ PacketType CBaseNetProtocol::SendAICreated(uint8_t playerNum, uint8_t whichSkirm
 	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint8_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_AI_CREATED);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(packetSize, NETMSG_AI_CREATED);
 	*packet
 		<< static_cast<uint8_t>(packetSize)
 		<< playerNum
@@ -498,14 +512,14 @@ PacketType CBaseNetProtocol::SendAICreated(uint8_t playerNum, uint8_t whichSkirm
 PacketType CBaseNetProtocol::SendAIStateChanged(uint8_t playerNum, uint8_t whichSkirmishAI, uint8_t newState)
 {
 	// do not hand optimize this math; the compiler will do that
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(whichSkirmishAI) + sizeof(newState), NETMSG_AI_STATE_CHANGED);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(whichSkirmishAI) + sizeof(newState), NETMSG_AI_STATE_CHANGED);
 	*packet << playerNum << whichSkirmishAI << newState;
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendSetAllied(uint8_t playerNum, uint8_t whichAllyTeam, uint8_t state)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(whichAllyTeam) + sizeof(state), NETMSG_ALLIANCE);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(whichAllyTeam) + sizeof(state), NETMSG_ALLIANCE);
 	*packet << playerNum << whichAllyTeam << state;
 	return PacketType(packet);
 }
@@ -517,7 +531,7 @@ PacketType CBaseNetProtocol::SendCreateNewPlayer(uint8_t playerNum, bool spectat
 	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint16_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_CREATE_NEWPLAYER);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(packetSize, NETMSG_CREATE_NEWPLAYER);
 	*packet << static_cast<uint16_t>(packetSize) << playerNum << (uint8_t)spectator << teamNum << playerName;
 	return PacketType(packet);
 
@@ -525,7 +539,7 @@ PacketType CBaseNetProtocol::SendCreateNewPlayer(uint8_t playerNum, bool spectat
 
 PacketType CBaseNetProtocol::SendCurrentFrameProgress(int32_t frameNum)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(frameNum), NETMSG_GAME_FRAME_PROGRESS);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(sizeof(uint8_t) + sizeof(frameNum), NETMSG_GAME_FRAME_PROGRESS);
 	*packet << frameNum;
 	return PacketType(packet);
 }
@@ -536,7 +550,7 @@ PacketType CBaseNetProtocol::SendPing(uint8_t playerNum, uint8_t pingTag, float
 	const uint32_t headerSize = sizeof(uint8_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_PING);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(packetSize, NETMSG_PING);
 	*packet << playerNum;
 	*packet << pingTag;
 	*packet << localTime;
@@ -550,7 +564,7 @@ PacketType CBaseNetProtocol::SendClientData(uint8_t playerNum, const std::vector
 	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint16_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_CLIENTDATA);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(packetSize, NETMSG_CLIENTDATA);
 	*packet << static_cast<uint16_t>(packetSize);
 	*packet << playerNum;
 	*packet << data;
@@ -559,11 +573,33 @@ PacketType CBaseNetProtocol::SendClientData(uint8_t playerNum, const std::vector
 }
 
 
+PacketType CBaseNetProtocol::SendSnapshotRequest(uint8_t donorPlayerNum, uint8_t joinerPlayerNum)
+{
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(sizeof(uint8_t) + sizeof(donorPlayerNum) + sizeof(joinerPlayerNum), NETMSG_SNAPSHOT_REQUEST);
+	*packet << donorPlayerNum << joinerPlayerNum;
+	return PacketType(packet);
+}
+
+PacketType CBaseNetProtocol::SendSnapshotData(uint8_t donorPlayerNum, uint8_t joinerPlayerNum, int32_t frameNum, uint32_t totalSize, uint32_t chunkOffset, const std::vector<uint8_t>& chunkData)
+{
+	const uint32_t payloadSize = sizeof(donorPlayerNum) + sizeof(joinerPlayerNum) + sizeof(frameNum) + sizeof(totalSize) + sizeof(chunkOffset) + chunkData.size();
+	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint16_t);
+	const uint32_t packetSize = headerSize + payloadSize;
+
+	if (packetSize >= (1 << (sizeof(uint16_t) * 8)))
+		throw netcode::PackPacketException("[BaseNetProto::SendSnapshotData] maximum packet-size exceeded");
+
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(packetSize, NETMSG_SNAPSHOT_DATA);
+	*packet << static_cast<uint16_t>(packetSize) << donorPlayerNum << joinerPlayerNum << frameNum << totalSize << chunkOffset << chunkData;
+	return PacketType(packet);
+}
+
+
 
 #ifdef SYNCDEBUG
 PacketType CBaseNetProtocol::SendSdCheckrequest(int32_t frameNum)
 {
-	PackPacket* packet = new PackPacket(5, NETMSG_SD_CHKREQUEST);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(5, NETMSG_SD_CHKREQUEST);
 	*packet << frameNum;
 	return PacketType(packet);
 }
@@ -574,20 +610,20 @@ PacketType CBaseNetProtocol::SendSdCheckresponse(uint8_t playerNum, uint64_t flo
 	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint16_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_SD_CHKRESPONSE);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(packetSize, NETMSG_SD_CHKRESPONSE);
 	*packet << static_cast<uint16_t>(packetSize) << playerNum << flop << checksums;
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendSdReset()
 {
-	return PacketType(new PackPacket(sizeof(uint8_t), NETMSG_SD_RESET));
+	return (netcode::AllocPacket(sizeof(uint8_t), NETMSG_SD_RESET));
 }
 
 
 PacketType CBaseNetProtocol::SendSdBlockrequest(uint16_t begin, uint16_t length, uint16_t requestSize)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(begin) + sizeof(length) + sizeof(requestSize), NETMSG_SD_BLKREQUEST);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(sizeof(uint8_t) + sizeof(begin) + sizeof(length) + sizeof(requestSize), NETMSG_SD_BLKREQUEST);
 	*packet << begin << length << requestSize;
 	return PacketType(packet);
 
@@ -599,7 +635,7 @@ PacketType CBaseNetProtocol::SendSdBlockresponse(uint8_t playerNum, std::vector<
 	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint16_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_SD_BLKRESPONSE);
+	std::shared_ptr<PackPacket> packet = netcode::AllocPacket(packetSize, NETMSG_SD_BLKRESPONSE);
 	*packet << static_cast<uint16_t>(packetSize) << playerNum << checksums;
 	return PacketType(packet);
 }
@@ -666,6 +702,9 @@ CBaseNetProtocol::CBaseNetProtocol()
 	proto->AddType(NETMSG_AI_STATE_CHANGED, 4);
 	proto->AddType(NETMSG_GAME_FRAME_PROGRESS, 5);
 	proto->AddType(NETMSG_PING, 1 + (1 + 1 + 4));
+	proto->AddType(NETMSG_SNAPSHOT_REQUEST, 3);
+	proto->AddType(NETMSG_SNAPSHOT_DATA, -2);
+	proto->AddType(NETMSG_COMMANDS, -2);
 
 #ifdef SYNCDEBUG
 	proto->AddType(NETMSG_SD_CHKREQUEST, 5);
@@ -55,6 +55,7 @@ public:
 	PacketType SendPause(uint8_t playerNum, uint8_t bPaused);
 
 	PacketType SendCommand(uint8_t playerNum, int32_t commandID, int32_t timeout, uint8_t options, uint32_t numParams, const float* params);
+	PacketType SendCommands(uint8_t playerNum, uint16_t numCommands, const std::vector<uint8_t>& packedCommands);
 	PacketType SendAICommand(uint8_t playerNum, uint8_t aiInstID, uint8_t aiTeamID, int16_t unitID, int32_t commandID, int32_t aiCommandID, int32_t timeout, uint8_t options, uint32_t numParams, const float* params);
 	PacketType SendAIShare(uint8_t playerNum, uint8_t aiID, uint8_t sourceTeam, uint8_t destTeam, float metal, float energy, const std::vector<int16_t>& unitIDs);
 
@@ -110,6 +111,9 @@ public:
 
 	PacketType SendClientData(uint8_t playerNum, const std::vector<uint8_t>& data);
 
+	PacketType SendSnapshotRequest(uint8_t donorPlayerNum, uint8_t joinerPlayerNum);
+	PacketType SendSnapshotData(uint8_t donorPlayerNum, uint8_t joinerPlayerNum, int32_t frameNum, uint32_t totalSize, uint32_t chunkOffset, const std::vector<uint8_t>& chunkData);
+
 #ifdef SYNCDEBUG
 	PacketType SendSdCheckrequest(int32_t frameNum);
 	PacketType SendSdCheckresponse(uint8_t playerNum, uint64_t flop, std::vector<uint32_t> checksums);
@@ -93,6 +93,11 @@ enum NETMSG {
 
 	NETMSG_PING = 78, // uint8_t playerNum, uint8_t pingTag, float localTime
 
+	NETMSG_SNAPSHOT_REQUEST = 79, // uint8_t donorPlayerNum, uint8_t joinerPlayerNum # sent by the server to the client that should produce a savestate for a mid-game joiner #
+	NETMSG_SNAPSHOT_DATA    = 80, // uint16_t messageSize, uint8_t donorPlayerNum, uint8_t joinerPlayerNum, int32_t frameNum, uint32_t totalSize, uint32_t chunkOffset, std::vector<uint8_t> chunkData
+
+	NETMSG_COMMANDS         = 81, // uint16_t messageSize, uint8_t playerNum, uint16_t numCommands, std::vector<uint8_t> packedCommands # delta-encoded NETMSG_COMMAND's, see CSelectedUnitsHandler #
+
 	NETMSG_LAST //max types of netmessages, internal only
 };
 
@@ -146,6 +146,13 @@ std::shared_ptr<const netcode::RawPacket> CNetProtocol::GetData(int frameNum)
 void CNetProtocol::Send(const netcode::RawPacket* pkt) { Send(std::shared_ptr<const netcode::RawPacket>(pkt)); }
 void CNetProtocol::Send(std::shared_ptr<const netcode::RawPacket> pkt)
 {
+	// packets sent by preSendFunc itself go out directly
+	if (preSendFunc && !inPreSendFunc && Threading::IsMainThread()) {
+		inPreSendFunc = true;
+		preSendFunc();
+		inPreSendFunc = false;
+	}
+
 	std::lock_guard<spring::spinlock> lock(serverConnMutex);
 	serverConnPtr->SendData(pkt);
 }
@@ -4,6 +4,7 @@
 #define NET_PROTOCOL_H
 
 #include <atomic>
+#include <functional>
 #include <string>
 
 #include "BaseNetProtocol.h" // not used in here, but in all files including this one
@@ -89,6 +90,13 @@ public:
 	/// @overload
 	void Send(const netcode::RawPacket* pkt);
 
+	/**
+	 * @brief Set a function called before every packet sent from the main thread
+	 * Lets packets that are batched by the game (unit orders) be flushed first,
+	 * so they keep their order relative to every other message of this client.
+	 */
+	void SetPreSendFunc(std::function<void()> func) { preSendFunc = std::move(func); }
+
 	/**
 	 * Updates our network while the game loads to prevent timeouts.
 	 * Runs until \a keepUpdating is false.
@@ -117,13 +125,17 @@ private:
 	spring::spinlock serverConnMutex;
 
 	uint8_t serverConnMem[1024];
-	uint8_t demoRecordMem[ 512];
+	uint8_t demoRecordMem[1024];
 
 	netcode::CConnection* serverConnPtr = nullptr;
 	CDemoRecorder* demoRecordPtr = nullptr;
 
 	std::string userName;
 	std::string userPasswd;
+
+	std::function<void()> preSendFunc;
+
+	bool inPreSendFunc = false;
 };
 
 extern CNetProtocol* clientNet;
@@ -322,6 +322,17 @@ void ShieldSegmentProjectile::Update()
 
 }
 
+void ShieldSegmentProjectile::PreDraw()
+{
+	// calls into Lua, has to happen before the (threaded) Draw
+	if (collection == nullptr)
+		return;
+	if (collection->GetColor().a == 0)
+		return;
+
+	collection->AllowDrawing();
+}
+
 void ShieldSegmentProjectile::Draw(GL::RenderDataBufferTC* va) const
 {
 	if (collection == nullptr)
@@ -332,7 +343,7 @@ void ShieldSegmentProjectile::Draw(GL::RenderDataBufferTC* va) const
 	if (color.a == 0)
 		return;
 
-	if (!collection->AllowDrawing())
+	if (!collection->AllowedDrawing())
 		return;
 
 
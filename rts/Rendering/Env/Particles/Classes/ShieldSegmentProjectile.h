@@ -34,6 +34,7 @@ public:
 	void UpdateColor();
 
 	bool AllowDrawing();
+	bool AllowedDrawing() const { return allowDrawing; }
 
 	const CPlasmaRepulser* GetShield() const { return shield; }
 	const AtlasedTexture* GetShieldTexture() const { return shieldTexture; }
@@ -80,6 +81,7 @@ public:
 		int ypart
 	);
 
+	void PreDraw() override;
 	void Draw(GL::RenderDataBufferTC* va) const override;
 	void Update() override;
 	void PreDelete() {
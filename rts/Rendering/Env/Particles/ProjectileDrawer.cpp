@@ -33,6 +33,7 @@
 #include "System/Exceptions.h"
 #include "System/Log/ILog.h"
 #include "System/StringUtil.h"
+#include "System/Threading/ThreadPool.h"
 
 
 void CProjectileDrawer::Init() {
@@ -243,6 +244,7 @@ void CProjectileDrawer::Kill() {
 	renderProjectiles.clear();
 	sortedProjectiles[0].clear();
 	sortedProjectiles[1].clear();
+	particleStagingBuffers.clear();
 
 	perlinNoiseFBO.Kill();
 	flyingPieceVAO.Delete();
@@ -434,6 +436,7 @@ void CProjectileDrawer::DrawProjectileNow(CProjectile* pro, bool drawReflection,
 	// no-op if no model
 	DrawProjectileModel(pro);
 
+	pro->PreDraw();
 	pro->SetSortDist(camera->ProjectedDistance(pro->pos));
 	sortedProjectiles[drawSorted && pro->drawSorted].push_back(pro);
 }
@@ -575,11 +578,70 @@ void CProjectileDrawer::DrawProjectilePass(Shader::IProgramObject*, bool drawRef
 
 
 	// collect the alpha-translucent particle effects in fxBuffer
-	for (CProjectile* p: sortedProjectiles[1]) {
-		p->Draw(fxBuffer);
+	DrawParticles();
+}
+
+void CProjectileDrawer::DrawParticles()
+{
+	// below this many projectiles per chunk, threading costs more than it saves
+	constexpr size_t MIN_CHUNK_PROJECTILES = 64;
+	constexpr size_t MIN_STAGING_ELEMS = 1 << 12;
+
+	const std::vector<CProjectile*>& sortedSet = sortedProjectiles[1];
+	const std::vector<CProjectile*>& unsortedSet = sortedProjectiles[0];
+
+	// sorted projectiles come first, chunks are contiguous and merged in
+	// order so the back-to-front sequence of the generated quads is kept
+	const size_t numProjectiles = sortedSet.size() + unsortedSet.size();
+	const size_t numChunks = std::min(size_t(ThreadPool::GetNumThreads()), numProjectiles / MIN_CHUNK_PROJECTILES);
+
+	const auto GetProjectile = [&](size_t i) { return ((i < sortedSet.size())? sortedSet[i]: unsortedSet[i - sortedSet.size()]); };
+
+	if (numChunks <= 1) {
+		for (size_t i = 0; i < numProjectiles; i++) {
+			GetProjectile(i)->Draw(fxBuffer);
+		}
+
+		return;
 	}
-	for (CProjectile* p: sortedProjectiles[0]) {
-		p->Draw(fxBuffer);
+
+	if (particleStagingBuffers.size() < numChunks)
+		particleStagingBuffers.resize(numChunks);
+
+	const size_t maxElems = fxBuffer->GetMaxElems();
+
+	for_mt(0, numChunks, [&](const int chunkIdx) {
+		ParticleStagingBuffer& sb = particleStagingBuffers[chunkIdx];
+
+		const size_t minIdx = (numProjectiles * (chunkIdx    )) / numChunks;
+		const size_t maxIdx = (numProjectiles * (chunkIdx + 1)) / numChunks;
+
+		if (sb.elems.empty())
+			sb.elems.resize(MIN_STAGING_ELEMS);
+
+		while (true) {
+			sb.buffer.SetupStaging(sb.elems.data(), sb.elems.size());
+
+			for (size_t i = minIdx; i < maxIdx; i++) {
+				GetProjectile(i)->Draw(&sb.buffer);
+			}
+
+			// Draw only appends single vertices, so a full buffer is the only
+			// way any could have been dropped; grow and regenerate the chunk
+			if (sb.buffer.NumElems() < sb.elems.size() || sb.elems.size() >= maxElems)
+				break;
+
+			sb.elems.resize(std::min(sb.elems.size() * 2, maxElems));
+		}
+	});
+
+	for (size_t i = 0; i < numChunks; i++) {
+		ParticleStagingBuffer& sb = particleStagingBuffers[i];
+
+		if (sb.buffer.NumElems() == 0)
+			continue;
+
+		fxBuffer->SafeAppend(sb.buffer.GetElemsMap(), sb.buffer.NumElems());
 	}
 }
 
@@ -4,12 +4,13 @@
 #define PROJECTILE_DRAWER_HDR
 
 #include <array>
+#include <vector>
 
 #include "Rendering/Env/Particles/IProjectileDrawer.h"
 #include "Rendering/GL/myGL.h"
 #include "Rendering/GL/VAO.h"
 #include "Rendering/GL/FBO.h"
-#include "Rendering/GL/RenderDataBufferFwd.hpp"
+#include "Rendering/GL/RenderDataBuffer.hpp"
 #include "Rendering/Models/3DModel.h"
 #include "Rendering/Models/ModelRenderContainer.h"
 #include "Sim/Projectiles/ProjectileFunctors.h"
@@ -72,6 +73,7 @@ private:
 	void DrawFlyingPieces(int modelType);
 
 	void DrawProjectilesSet(const std::vector<CProjectile*>& projectiles, bool drawReflection, bool drawRefraction);
+	void DrawParticles();
 	void DrawProjectilesSetShadow(const std::vector<CProjectile*>& projectiles);
 
 	static bool CanDrawProjectile(const CProjectile* pro, const CSolidObject* owner);
@@ -114,6 +116,14 @@ private:
 	/// {[0] := unsorted, [1] := distance-sorted} projectiles;
 	/// used to render particle effects in back-to-front order
 	std::vector<CProjectile*> sortedProjectiles[2];
+
+	struct ParticleStagingBuffer {
+		std::vector<VA_TYPE_TC> elems;
+		GL::RenderDataBufferTC buffer;
+	};
+
+	/// per-chunk vertices generated by worker threads, merged into fxBuffer
+	std::vector<ParticleStagingBuffer> particleStagingBuffers;
 };
 
 #endif // PROJECTILE_DRAWER_HDR
@@ -440,6 +440,8 @@ namespace GL {
 			rawBuffer = buffer;
 		}
 
+		void SetupStaging(VertexArrayType* elems, size_t numElems) {}
+
 
 		VertexArrayType* BindMapElems(bool r = false, bool w = true) { return (static_cast<VertexArrayType*>(nullptr)); }
 		 IndexArrayType* BindMapIndcs(bool r = false, bool w = true) { return (static_cast< IndexArrayType*>(nullptr)); }
@@ -486,6 +488,8 @@ namespace GL {
 		void SubmitIndexed(uint32_t primType, uint32_t dataIndx, uint32_t dataSize) const {}
 		void SubmitIndexed(uint32_t primType) {}
 
+		size_t GetMaxElems() const { return 0; }
+
 		size_t NumElems() const { return 0; }
 		size_t NumIndcs() const { return 0; }
 		size_t SumElems() const { return 0; }
@@ -531,6 +535,8 @@ namespace GL {
 			std::swap(numSubmits[0], trdb.numSubmits[0]);
 			std::swap(numSubmits[1], trdb.numSubmits[1]);
 
+			std::swap(numStagingElems, trdb.numStagingElems);
+
 			std::swap(glSyncObj, trdb.glSyncObj);
 			return *this;
 		}
@@ -563,6 +569,19 @@ namespace GL {
 			rawBuffer->TUpload<VertexArrayType, IndexArrayType, Shader::ShaderInput>(numElems, numIndcs, attribs->size(),  nullptr, nullptr, attribs->data());
 		}
 
+		// client-memory target for Append; lets worker threads generate vertices
+		// which are later copied into a mapped buffer, can not be submitted
+		void SetupStaging(VertexArrayType* elems, size_t numElems) {
+			rawBuffer = nullptr;
+			elemsMap = elems;
+
+			prvElemPos = 0;
+			curElemPos = 0;
+			sumElemPos = 0;
+
+			numStagingElems = numElems;
+		}
+
 
 		VertexArrayType* BindMapElems(bool r = false, bool w = true) { assert(!rawBuffer->IsPinned()); return (elemsMap = rawBuffer->MapElems<VertexArrayType>(true, false, r, w)); }
 		 IndexArrayType* BindMapIndcs(bool r = false, bool w = true) { assert(!rawBuffer->IsPinned()); return (indcsMap = rawBuffer->MapIndcs< IndexArrayType>(true, false, r, w)); }
@@ -629,7 +648,7 @@ namespace GL {
 		}
 
 
-		bool CheckSizeE(size_t ne, size_t pos) const { return (ne > 0 && ((pos + (ne - 1)) < rawBuffer->GetNumElems<VertexArrayType>())); }
+		bool CheckSizeE(size_t ne, size_t pos) const { return (ne > 0 && ((pos + (ne - 1)) < GetMaxElems())); }
 		bool CheckSizeI(size_t ni, size_t pos) const { return (ni > 0 && ((pos + (ni - 1)) < rawBuffer->GetNumIndcs< IndexArrayType>())); }
 
 		void AssertSizeE(size_t ne, size_t pos) const { assert(CheckSizeE(ne, pos)); }
@@ -696,6 +715,8 @@ namespace GL {
 			prvIndxPos = curIndxPos;
 		}
 
+		size_t GetMaxElems() const { return ((rawBuffer != nullptr)? rawBuffer->GetNumElems<VertexArrayType>(): numStagingElems); }
+
 		size_t NumElems() const { return (curElemPos - prvElemPos); }
 		size_t NumIndcs() const { return (curIndxPos - prvIndxPos); }
 		size_t SumElems() const { return sumElemPos; }
@@ -725,6 +746,8 @@ namespace GL {
 
 		// [0] := non-indexed, [1] := indexed
 		size_t numSubmits[2] = {0, 0};
+		// capacity of elemsMap if not backed by rawBuffer
+		size_t numStagingElems = 0;
 
 		GLsync glSyncObj = 0;
 	};
@@ -138,6 +138,7 @@ CR_REG_METADATA(CGlobalRendering, (
 	CR_IGNORED(glslMaxRecommendedVertices),
 	CR_IGNORED(glslMaxUniformBufferBindings),
 	CR_IGNORED(glslMaxUniformBufferSize),
+	CR_IGNORED(glslMaxTexBufferSize),
 	CR_IGNORED(dualScreenMode),
 	CR_IGNORED(dualScreenMiniMapOnLeft),
 
@@ -230,6 +231,7 @@ CGlobalRendering::CGlobalRendering()
 	, glslMaxRecommendedVertices(0)
 	, glslMaxUniformBufferBindings(0)
 	, glslMaxUniformBufferSize(0)
+	, glslMaxTexBufferSize(0)
 
 	, dualScreenMode(false)
 	, dualScreenMiniMapOnLeft(false)
@@ -796,6 +798,7 @@ void CGlobalRendering::QueryGLMaxVals()
 	glGetIntegerv(GL_MAX_DRAW_BUFFERS,            &glslMaxDrawBuffers);
 	glGetIntegerv(GL_MAX_ELEMENTS_INDICES,        &glslMaxRecommendedIndices);
 	glGetIntegerv(GL_MAX_ELEMENTS_VERTICES,       &glslMaxRecommendedVertices);
+	glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE,     &glslMaxTexBufferSize);
 
 	// GL_MAX_VARYING_FLOATS is the maximum number of floats, we count float4's
 	glslMaxVaryings /= 4;
@@ -881,6 +884,7 @@ void CGlobalRendering::LogGLSupportInfo() const
 	LOG("\tmax. rec. indices/vertices   : %i/%i", glslMaxRecommendedIndices, glslMaxRecommendedVertices);
 	LOG("\tmax. uniform buffer-bindings : %i", glslMaxUniformBufferBindings);
 	LOG("\tmax. uniform block-size      : %iKB", glslMaxUniformBufferSize / 1024);
+	LOG("\tmax. texture-buffer texels   : %i", glslMaxTexBufferSize);
 	LOG("\t");
 	LOG("\trun-time texture compression: %i", compressTextures);
 	LOG("\t");
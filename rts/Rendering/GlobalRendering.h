@@ -272,6 +272,7 @@ public:
 	int glslMaxRecommendedVertices;
 	int glslMaxUniformBufferBindings;
 	int glslMaxUniformBufferSize; ///< in bytes
+	int glslMaxTexBufferSize; ///< in texels
 
 	/**
 	 * @brief dual screen mode
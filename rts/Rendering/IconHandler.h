@@ -4,6 +4,7 @@
 #define ICON_HANDLER_H
 
 #include <array>
+#include <atomic>
 #include <string>
 
 #include "Icon.h"
@@ -30,7 +31,7 @@ namespace icon {
 			CIconData& operator = (CIconData&& id) {
 				std::swap(name, id.name);
 
-				std::swap(refCount, id.refCount);
+				refCount = id.refCount.exchange(refCount);
 				std::swap(texID, id.texID);
 
 				xsize = id.xsize;
@@ -79,7 +80,8 @@ namespace icon {
 		private:
 			std::string name;
 
-			int refCount = 123456;
+			// icons are referenced by UnitDefs, which can be parsed concurrently
+			std::atomic<int> refCount = {123456};
 			unsigned int texID = 0;
 			int xsize = 1;
 			int ysize = 1;
@@ -270,15 +270,20 @@ void S3DModel::FlattenPieceTree(S3DModelPiece* root) {
 
 	pieceObjects.clear();
 	pieceObjects.reserve(numPieces);
+	pieceParentIDs.clear();
+	pieceParentIDs.reserve(numPieces);
 
-	FlattenPieceTreeRec(root);
+	FlattenPieceTreeRec(root, -1);
 }
 
-void S3DModel::FlattenPieceTreeRec(S3DModelPiece* piece) {
+void S3DModel::FlattenPieceTreeRec(S3DModelPiece* piece, int parentID) {
+	const int pieceID = pieceObjects.size();
+
 	pieceObjects.push_back(piece);
+	pieceParentIDs.push_back(parentID);
 
 	for (S3DModelPiece* childPiece: piece->children) {
-		FlattenPieceTreeRec(childPiece);
+		FlattenPieceTreeRec(childPiece, pieceID);
 	}
 }
 
@@ -448,7 +453,9 @@ void LocalModel::UpdatePieceMatrices(unsigned int gsFrameNum)
 	if (gsFrameNum == pmuFrameNum)
 		return;
 
-	// could be combined with UpdateChildMatricesRec, but KISS
+	UpdateDirtyPieceMatrices();
+
+	// could be combined with UpdateDirtyPieceMatrices, but KISS
 	for (size_t i = 0, n = pieces.size(); i < n; i++) {
 		const LocalModelPiece& lmp = pieces[i];
 
@@ -460,6 +467,17 @@ void LocalModel::UpdatePieceMatrices(unsigned int gsFrameNum)
 	pmuFrameNum = gsFrameNum;
 }
 
+void LocalModel::UpdateDirtyPieceMatrices(bool forceUpdate) const
+{
+	// pieces are stored in depth-first order (see CreateLocalModelPieces)
+	// so every parent is visited before its children and a linear sweep
+	// replaces the per-piece recursion; SetDirty also marks all children
+	// of a changed piece which keeps the sweep free of extra bookkeeping
+	for (const LocalModelPiece& lmp: pieces) {
+		lmp.UpdateMatrices(forceUpdate);
+	}
+}
+
 void LocalModel::Draw() const
 {
 	glBindVertexArray(vertexArray);
@@ -527,7 +545,7 @@ void LocalModel::SetModel(const S3DModel* model, bool initialize)
 	pieces.clear();
 	pieces.reserve(model->numPieces);
 
-	CreateLocalModelPieces(model->GetRootPiece());
+	CreateLocalModelPieces(model);
 
 	assert(pieces.size() == model->numPieces);
 	matrices.clear();
@@ -539,28 +557,34 @@ void LocalModel::SetModel(const S3DModel* model, bool initialize)
 	UpdateVolumeAndMatrices(false);
 }
 
-LocalModelPiece* LocalModel::CreateLocalModelPieces(const S3DModelPiece* mpParent)
+void LocalModel::CreateLocalModelPieces(const S3DModel* model)
 {
-	LocalModelPiece* lmpChild = nullptr;
+	assert(model->pieceParentIDs.size() == model->numPieces);
 
-	// construct an LMP(mp) in-place
-	pieces.emplace_back(mpParent);
-	LocalModelPiece* lmpParent = &pieces.back();
+	// construct LMP(mp)'s in-place, in the flattened depth-first order
+	// of S3DModel::pieceObjects; <pieces> must not reallocate here
+	for (size_t n = 0; n < model->numPieces; n++) {
+		pieces.emplace_back(model->GetPiece(n));
 
-	lmpParent->SetLModelPieceIndex(pieces.size() - 1);
-	lmpParent->SetScriptPieceIndex(pieces.size() - 1);
+		LocalModelPiece* lmp = &pieces.back();
 
-	// the mapping is 1:1 for Lua scripts, but not necessarily for COB
-	// CobInstance::MapScriptToModelPieces does the remapping (if any)
-	assert(lmpParent->GetLModelPieceIndex() == lmpParent->GetScriptPieceIndex());
+		lmp->SetLModelPieceIndex(n);
+		lmp->SetScriptPieceIndex(n);
 
-	for (const S3DModelPiece* mpChild: mpParent->children) {
-		lmpChild = CreateLocalModelPieces(mpChild);
-		lmpChild->SetParent(lmpParent);
-		lmpParent->AddChild(lmpChild);
-	}
+		// the mapping is 1:1 for Lua scripts, but not necessarily for COB
+		// CobInstance::MapScriptToModelPieces does the remapping (if any)
+		assert(lmp->GetLModelPieceIndex() == lmp->GetScriptPieceIndex());
+
+		if (model->pieceParentIDs[n] < 0)
+			continue;
+
+		assert(model->pieceParentIDs[n] < int(n));
 
-	return lmpParent;
+		LocalModelPiece* lmpParent = &pieces[ model->pieceParentIDs[n] ];
+
+		lmp->SetParent(lmpParent);
+		lmpParent->AddChild(lmp);
+	}
 }
 
 
@@ -656,26 +680,25 @@ void LocalModelPiece::SetPosOrRot(const float3& src, float3& dst) {
 }
 
 
-void LocalModelPiece::UpdateChildMatricesRec(bool updateChildMatrices) const
+void LocalModelPiece::UpdateMatrices(bool updateModelSpaceMat) const
 {
+	// parent (if any) must already be up-to-date
+	assert(parent == nullptr || !parent->dirty);
+
 	if (dirty) {
 		dirty = false;
-		updateChildMatrices = true;
+		updateModelSpaceMat = true;
 
 		pieceSpaceMat = CalcPieceSpaceMatrix(pos, rot, original->scales);
 	}
 
-	if (updateChildMatrices) {
-		modelSpaceMat = pieceSpaceMat;
+	if (!updateModelSpaceMat)
+		return;
 
-		if (parent != nullptr) {
-			modelSpaceMat >>= parent->modelSpaceMat;
-		}
-	}
+	modelSpaceMat = pieceSpaceMat;
 
-	for (auto& child : children) {
-		child->UpdateChildMatricesRec(updateChildMatrices);
-	}
+	if (parent != nullptr)
+		modelSpaceMat >>= parent->modelSpaceMat;
 }
 
 void LocalModelPiece::UpdateParentMatricesRec() const
@@ -269,6 +269,7 @@ struct S3DModel
 		relMidPos = m.relMidPos;
 
 		pieceObjects = std::move(m.pieceObjects);
+		pieceParentIDs = std::move(m.pieceParentIDs);
 		pieceMatrices = std::move(m.pieceMatrices);
 		return *this;
 	}
@@ -304,7 +305,7 @@ struct S3DModel
 	// void SetPieceMatrixWeight(size_t i, float w) const { const_cast<CMatrix44f&>(pieceMatrices[i])[15] = w; }
 	void SetPieceMatrices();
 	void FlattenPieceTree(S3DModelPiece* root);
-	void FlattenPieceTreeRec(S3DModelPiece* piece);
+	void FlattenPieceTreeRec(S3DModelPiece* piece, int parentID);
 
 	// default values set by parsers; radius is also cached in WorldObject::drawRadius (used by projectiles)
 	float CalcDrawRadius() const { return ((maxs - mins).Length() * 0.5f); }
@@ -325,6 +326,9 @@ public:
 
 	// flattened tree; pieceObjects[0] is the root
 	std::vector<S3DModelPiece*> pieceObjects;
+	// index of each piece's parent in pieceObjects (-1 for the root)
+	// parents always precede their children in depth-first order
+	std::vector<int> pieceParentIDs;
 	// static bind-pose matrices
 	std::vector<CMatrix44f> pieceMatrices;
 
@@ -373,7 +377,7 @@ struct LocalModelPiece
 
 
 	// on-demand functions
-	void UpdateChildMatricesRec(bool updateChildMatrices) const;
+	void UpdateMatrices(bool updateModelSpaceMat) const;
 	void UpdateParentMatricesRec() const;
 
 	CMatrix44f CalcPieceSpaceMatrixRaw(const float3& p, const float3& r, const float3& s) const { return (original->ComposeTransform(p, r, s)); }
@@ -489,8 +493,10 @@ struct LocalModel
 	void UpdateBoundingVolume();
 	void UpdatePieceMatrices() { UpdatePieceMatrices(pmuFrameNum + 1); }
 	void UpdatePieceMatrices(unsigned int gsFrameNum);
+	// brings all dirty pieces' synced matrices up to date in one linear pass
+	void UpdateDirtyPieceMatrices(bool forceUpdate = false) const;
 	void UpdateVolumeAndMatrices(bool updateChildMatrices) {
-		pieces[0].UpdateChildMatricesRec(updateChildMatrices);
+		UpdateDirtyPieceMatrices(updateChildMatrices);
 		UpdateBoundingVolume();
 		UpdatePieceMatrices();
 	}
@@ -517,7 +523,7 @@ struct LocalModel
 
 
 private:
-	LocalModelPiece* CreateLocalModelPieces(const S3DModelPiece* mpParent);
+	void CreateLocalModelPieces(const S3DModel* model);
 
 public:
 	std::vector<LocalModelPiece> pieces;
@@ -4,6 +4,7 @@
 #include "3DModel.h"
 #include "3DModelLog.h"
 #include "AssIO.h"
+#include "ModelCache.h"
 
 #include "Lua/LuaParser.h"
 #include "Sim/Misc/CollisionVolume.h"
@@ -15,6 +16,7 @@
 #include "System/ScopedFPUSettings.h"
 #include "System/FileSystem/FileHandler.h"
 #include "System/FileSystem/FileSystem.h"
+#include "System/Sync/HsiehHash.h"
 
 #include "lib/assimp/include/assimp/config.h"
 #include "lib/assimp/include/assimp/defs.h"
@@ -182,13 +184,6 @@ S3DModel CAssParser::Load(const std::string& modelFilePath)
 		LOG_SL(LOG_SECTION_MODEL, L_INFO, "No valid model metadata in '%s' or no meta-file", metaFileName.c_str());
 
 
-	Assimp::Importer importer;
-
-	// speed-up processing by skipping things we don't need
-	importer.SetPropertyInteger(AI_CONFIG_PP_RVC_FLAGS, ASS_IMPORTER_OPTIONS);
-	importer.SetPropertyInteger(AI_CONFIG_PP_SLM_VERTEX_LIMIT,   maxVertices);
-	importer.SetPropertyInteger(AI_CONFIG_PP_SLM_TRIANGLE_LIMIT, maxIndices / 3);
-
 	if (!file.IsBuffered()) {
 		fileBuf.resize(file.FileSize(), 0);
 		file.Read(fileBuf.data(), fileBuf.size());
@@ -196,6 +191,39 @@ S3DModel CAssParser::Load(const std::string& modelFilePath)
 		fileBuf = std::move(file.GetBuffer());
 	}
 
+	// key over everything the import below depends on
+	std::uint32_t contentHash = HsiehHash(&maxVertices, sizeof(maxVertices), 0);
+	contentHash = HsiehHash(&maxIndices, sizeof(maxIndices), contentHash);
+	contentHash = HsiehHash(fileBuf.data(), fileBuf.size(), contentHash);
+
+	{
+		CFileHandler metaFile(metaFileName, SPRING_VFS_ZIP);
+		std::string metaFileData;
+
+		if (metaFile.LoadStringData(metaFileData))
+			contentHash = HsiehHash(metaFileData.data(), metaFileData.size(), contentHash);
+	}
+
+	const bool useCache = CModelCacheFile::IsEnabled();
+
+	if (useCache) {
+		S3DModel model;
+		model.type = MODELTYPE_ASS;
+
+		if (CModelCacheFile::Read<SAssPiece>(model, modelFilePath, MODELTYPE_ASS, contentHash, [this]() { return AllocPiece(); })) {
+			textureHandlerS3O.PreloadTexture(&model, modelTable.GetBool("fliptextures", true), modelTable.GetBool("invertteamcolor", true));
+			return model;
+		}
+	}
+
+
+	Assimp::Importer importer;
+
+	// speed-up processing by skipping things we don't need
+	importer.SetPropertyInteger(AI_CONFIG_PP_RVC_FLAGS, ASS_IMPORTER_OPTIONS);
+	importer.SetPropertyInteger(AI_CONFIG_PP_SLM_VERTEX_LIMIT,   maxVertices);
+	importer.SetPropertyInteger(AI_CONFIG_PP_SLM_TRIANGLE_LIMIT, maxIndices / 3);
+
 	if (modelTable.GetBool("nodenamesfromids", false)) {
 		assert(FileSystem::GetExtension(modelFilePath) == "dae");
 		PreProcessFileBuffer(fileBuf);
@@ -251,6 +279,10 @@ S3DModel CAssParser::Load(const std::string& modelFilePath)
 	LOG_SL(LOG_SECTION_MODEL, L_DEBUG, "model->mins: (%f,%f,%f)", model.mins[0], model.mins[1], model.mins[2]);
 	LOG_SL(LOG_SECTION_MODEL, L_DEBUG, "model->maxs: (%f,%f,%f)", model.maxs[0], model.maxs[1], model.maxs[2]);
 	LOG_SL(LOG_SECTION_MODEL, L_INFO, "Model %s Imported.", model.name.c_str());
+
+	if (useCache)
+		CModelCacheFile::Write(model, contentHash);
+
 	return model;
 }
 
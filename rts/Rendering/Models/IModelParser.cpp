@@ -87,7 +87,7 @@ static S3DModel CreateDummyModel(unsigned int id)
 	model.type = MODELTYPE_3DO;
 	model.numPieces = 1;
 	// give it one empty piece
-	model.AddPiece(g3DOParser.AllocPiece());
+	model.FlattenPieceTree(g3DOParser.AllocPiece());
 	model.GetRootPiece()->SetCollisionVolume(CollisionVolume('b', 'z', -UpVector, ZeroVector));
 	return model;
 }
@@ -0,0 +1,248 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "System/Platform/Win/win32.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "ModelCache.h"
+#include "3DModelLog.h"
+#include "ModelCacheFormat.h"
+#include "Sim/Misc/CollisionVolume.h"
+#include "System/Config/ConfigHandler.h"
+#include "System/FileSystem/CacheFile.h"
+#include "System/FileSystem/DataDirsAccess.h"
+#include "System/FileSystem/FileSystem.h"
+#include "System/FileSystem/FileQueryFlags.h"
+#include "System/Log/ILog.h"
+
+using ModelCacheFormat::ModelRecord;
+using ModelCacheFormat::PieceRecord;
+
+CONFIG(bool, UseModelCache).defaultValue(true).description("Store parsed S3O and Assimp models in the cache directory so later game starts can skip parsing them.");
+
+
+// bump whenever a parser changes what it produces, old entries are then rebuilt
+static constexpr std::uint32_t MODEL_CACHE_VERSION = 2;
+
+// cache-files are keyed by the parser's content-hash, data is laid out as
+// described in ModelCacheFormat.h
+static constexpr char CACHE_FILE_MAGIC[8] = {'S', 'P', 'R', 'I', 'N', 'G', 'M', 'C'};
+
+struct CacheFileInfo {
+	std::uint32_t modelType;
+	std::uint32_t numPieces;
+	std::uint32_t vertexSize;
+};
+
+
+static const std::string GetModelCacheDir() {
+	return (FileSystem::GetCacheDir() + "/models/");
+}
+
+// one file per model; an entry for an older version of its source (or of
+// anything else that went into the content-hash) is simply replaced
+static const std::string GetCacheFileName(const std::string& modelName) {
+	std::string fileName = modelName;
+
+	// keep the archive-relative path readable but flat
+	std::replace(fileName.begin(), fileName.end(), '/', '_');
+	std::replace(fileName.begin(), fileName.end(), '\\', '_');
+
+	return (GetModelCacheDir() + fileName + ".bin");
+}
+
+static void CopyVector(float* dst, const float3& src) { std::memcpy(dst, &src.x, sizeof(float) * 3); }
+static float3 CopyVector(const float* src) { return {src[0], src[1], src[2]}; }
+
+
+
+bool CModelCacheFile::IsEnabled()
+{
+	return (configHandler->GetBool("UseModelCache"));
+}
+
+
+bool CModelCacheFile::Write(const S3DModel& model, std::uint32_t contentHash)
+{
+	if (!FileSystem::CreateDirectory(GetModelCacheDir()))
+		return false;
+
+	std::vector<std::uint8_t> buffer;
+
+	{
+		ModelRecord record;
+
+		record.radius = model.radius;
+		record.height = model.height;
+
+		CopyVector(record.mins, model.mins);
+		CopyVector(record.maxs, model.maxs);
+		CopyVector(record.relMidPos, model.relMidPos);
+
+		ModelCacheFormat::WriteModel(buffer, record, model.texs[0], model.texs[1]);
+	}
+
+	for (size_t i = 0; i < model.pieceObjects.size(); i++) {
+		const S3DModelPiece* piece = model.pieceObjects[i];
+		const CollisionVolume* volume = piece->GetCollisionVolume();
+
+		const std::vector<SVertexData>& vertices = piece->GetVertexElements();
+		const std::vector<unsigned int>& indices = piece->GetVertexIndices();
+
+		PieceRecord record;
+
+		record.parentID = model.pieceParentIDs[i];
+		record.numVertices = vertices.size();
+		record.numIndices = indices.size();
+		record.nameSize = piece->name.size();
+
+		CopyVector(record.offset, piece->offset);
+		CopyVector(record.goffset, piece->goffset);
+		CopyVector(record.scales, piece->scales);
+		CopyVector(record.mins, piece->mins);
+		CopyVector(record.maxs, piece->maxs);
+		CopyVector(record.volumeScales, volume->GetScales());
+		CopyVector(record.volumeOffsets, volume->GetOffsets());
+
+		std::memcpy(record.bakedMatrix, &piece->bakedMatrix.m[0], sizeof(record.bakedMatrix));
+
+		record.volumeType = volume->GetVolumeType();
+		record.volumeAxis = volume->GetPrimaryAxis();
+		record.volumeFlags[ModelCacheFormat::VOLUME_FLAG_IGNORE_HITS  ] = volume->IgnoreHits();
+		record.volumeFlags[ModelCacheFormat::VOLUME_FLAG_CONT_HIT_TEST] = volume->UseContHitTest();
+		record.volumeFlags[ModelCacheFormat::VOLUME_FLAG_FOOTPRINT    ] = volume->DefaultToFootPrint();
+		record.volumeFlags[ModelCacheFormat::VOLUME_FLAG_PIECE_TREE   ] = volume->DefaultToPieceTree();
+
+		ModelCacheFormat::WritePiece(buffer, record, piece->name, vertices.data(), sizeof(SVertexData), indices.data());
+	}
+
+	CacheFileInfo info;
+
+	info.modelType = model.type;
+	info.numPieces = model.pieceObjects.size();
+	info.vertexSize = sizeof(SVertexData);
+
+	// replaced as a whole, other processes might have the previous version mapped
+	const std::string cacheFilePath = dataDirsAccess.LocateFile(GetCacheFileName(model.name), FileQueryFlags::WRITE);
+
+	if (!CCacheFile::Write(cacheFilePath, CACHE_FILE_MAGIC, MODEL_CACHE_VERSION, contentHash, info, buffer.data(), buffer.size()))
+		return false;
+
+	LOG_SL(LOG_SECTION_MODEL, L_INFO, "[ModelCache::%s] stored model %s (%u bytes)", __func__, model.name.c_str(), unsigned(buffer.size()));
+	return true;
+}
+
+
+bool CModelCacheFile::Open(const std::string& name, int type, std::uint32_t contentHash)
+{
+	modelName = name;
+
+	const std::string cacheFileName = GetCacheFileName(name);
+
+	if (!FileSystem::FileExists(cacheFileName))
+		return false;
+
+	CacheFileInfo info;
+
+	// a mismatching key means the source changed, the entry gets replaced
+	if (!cacheFile.Open(dataDirsAccess.LocateFile(cacheFileName), CACHE_FILE_MAGIC, MODEL_CACHE_VERSION, contentHash, info))
+		return (Close(true));
+	if (info.modelType != std::uint32_t(type) || info.vertexSize != sizeof(SVertexData))
+		return (Close(true));
+	// walk the records once so that ReadPiece can not run past the end
+	if (!ModelCacheFormat::FindPieces(cacheFile.GetData(), cacheFile.GetDataSize(), info.numPieces, sizeof(SVertexData), pieceOffsets))
+		return (Close(true));
+
+	return true;
+}
+
+bool CModelCacheFile::Close(bool remove)
+{
+	pieceOffsets.clear();
+
+	if (!remove) {
+		cacheFile.Close();
+		return false;
+	}
+
+	LOG_SL(LOG_SECTION_MODEL, L_INFO, "[ModelCache::%s] removing stale entry for model %s", __func__, modelName.c_str());
+	return (cacheFile.Remove());
+}
+
+
+void CModelCacheFile::ReadPiece(size_t idx, S3DModelPiece* piece, std::vector<SVertexData>& vertices, std::vector<unsigned int>& indices) const
+{
+	PieceRecord record;
+
+	const std::uint8_t* vertexData = nullptr;
+	const std::uint8_t* indexData = nullptr;
+
+	ModelCacheFormat::ReadPiece(cacheFile.GetData(), pieceOffsets[idx], sizeof(SVertexData), record, piece->name, vertexData, indexData);
+
+	vertices.resize(record.numVertices);
+	indices.resize(record.numIndices);
+
+	std::memcpy(vertices.data(), vertexData, vertices.size() * sizeof(SVertexData));
+	std::memcpy(indices.data(), indexData, indices.size() * sizeof(unsigned int));
+
+	piece->offset = CopyVector(record.offset);
+	piece->goffset = CopyVector(record.goffset);
+	piece->scales = CopyVector(record.scales);
+	piece->mins = CopyVector(record.mins);
+	piece->maxs = CopyVector(record.maxs);
+
+	{
+		CMatrix44f bakedMatrix;
+		std::memcpy(&bakedMatrix.m[0], record.bakedMatrix, sizeof(record.bakedMatrix));
+		piece->SetBakedMatrix(bakedMatrix);
+	}
+	{
+		CollisionVolume* volume = piece->GetCollisionVolume();
+
+		// the stored scales and type went through FixTypeAndScale already, this is idempotent
+		volume->InitShape(
+			CopyVector(record.volumeScales),
+			CopyVector(record.volumeOffsets),
+			record.volumeType,
+			record.volumeFlags[ModelCacheFormat::VOLUME_FLAG_CONT_HIT_TEST]? CollisionVolume::COLVOL_HITTEST_CONT: CollisionVolume::COLVOL_HITTEST_DISC,
+			record.volumeAxis
+		);
+
+		volume->SetIgnoreHits(record.volumeFlags[ModelCacheFormat::VOLUME_FLAG_IGNORE_HITS]);
+		volume->SetDefaultToFootPrint(record.volumeFlags[ModelCacheFormat::VOLUME_FLAG_FOOTPRINT]);
+		volume->SetDefaultToPieceTree(record.volumeFlags[ModelCacheFormat::VOLUME_FLAG_PIECE_TREE]);
+	}
+
+	// relinked by ReadModel
+	piece->parent = nullptr;
+	piece->children.clear();
+}
+
+void CModelCacheFile::ReadModel(S3DModel& model, const std::vector<S3DModelPiece*>& pieces) const
+{
+	ModelRecord record;
+	ModelCacheFormat::ReadModel(cacheFile.GetData(), record, model.texs[0], model.texs[1]);
+
+	model.name = modelName;
+	model.numPieces = pieces.size();
+	model.radius = record.radius;
+	model.height = record.height;
+	model.mins = CopyVector(record.mins);
+	model.maxs = CopyVector(record.maxs);
+	model.relMidPos = CopyVector(record.relMidPos);
+
+	for (size_t i = 1; i < pieces.size(); i++) {
+		PieceRecord pieceRecord;
+		std::memcpy(&pieceRecord, cacheFile.GetData() + pieceOffsets[i], sizeof(pieceRecord));
+
+		// children were written depth-first, appending them keeps their order
+		pieces[i]->parent = pieces[pieceRecord.parentID];
+		pieces[i]->parent->children.push_back(pieces[i]);
+	}
+
+	// rebuilds pieceObjects and pieceParentIDs in the stored order
+	model.FlattenPieceTree(pieces[0]);
+
+	LOG_SL(LOG_SECTION_MODEL, L_INFO, "[ModelCache::%s] loaded model %s (%u pieces) from cache", __func__, model.name.c_str(), model.numPieces);
+}
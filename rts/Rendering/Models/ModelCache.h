@@ -0,0 +1,74 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef MODEL_CACHE_H
+#define MODEL_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "3DModel.h"
+#include "System/FileSystem/CacheFile.h"
+
+/**
+ * Binary cache of parsed models, stored in CacheDir/models/.
+ *
+ * Entries hold the finished piece tree (transforms, extents, collision
+ * volumes, vertex- and index-arrays) in the order FlattenPieceTree yields,
+ * so a hit only has to copy arrays and relink pieces before the model can
+ * go to UploadRenderData. They are keyed by a hash over every input of the
+ * parser (file contents, metafile, import limits) which the parser itself
+ * computes; anything derived from the GL state or texture atlases (3DO)
+ * must not be cached.
+ */
+class CModelCacheFile {
+public:
+	static bool IsEnabled();
+
+	/// stores model under contentHash; failures are not fatal, the next load just parses again
+	static bool Write(const S3DModel& model, std::uint32_t contentHash);
+
+	/**
+	 * @param allocPiece returns a cleared piece from the calling parser's pool
+	 * @return true if model was filled from the cache
+	 */
+	template<typename Piece, typename AllocPieceFunc>
+	static bool Read(S3DModel& model, const std::string& name, int type, std::uint32_t contentHash, AllocPieceFunc allocPiece) {
+		CModelCacheFile cacheFile;
+
+		// checks the whole file up-front, no pieces are taken from the pool for a bad one
+		if (!cacheFile.Open(name, type, contentHash))
+			return false;
+
+		std::vector<S3DModelPiece*> pieces(cacheFile.GetNumPieces(), nullptr);
+
+		for (size_t i = 0; i < pieces.size(); i++) {
+			Piece* piece = allocPiece();
+
+			cacheFile.ReadPiece(i, piece, piece->vertices, piece->indices);
+			pieces[i] = piece;
+		}
+
+		cacheFile.ReadModel(model, pieces);
+		return true;
+	}
+
+private:
+	bool Open(const std::string& name, int type, std::uint32_t contentHash);
+	bool Close(bool remove);
+
+	void ReadPiece(size_t idx, S3DModelPiece* piece, std::vector<SVertexData>& vertices, std::vector<unsigned int>& indices) const;
+	void ReadModel(S3DModel& model, const std::vector<S3DModelPiece*>& pieces) const;
+
+	size_t GetNumPieces() const { return pieceOffsets.size(); }
+
+private:
+	CCacheFile cacheFile;
+
+	std::string modelName;
+
+	// positions of the per-piece records, found while validating
+	std::vector<size_t> pieceOffsets;
+};
+
+#endif // MODEL_CACHE_H
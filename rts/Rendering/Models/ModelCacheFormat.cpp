@@ -0,0 +1,127 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <cstring>
+
+#include "ModelCacheFormat.h"
+
+
+static size_t PadSize(size_t size) { return ((size + 3) & ~size_t(3)); }
+
+static void AppendData(std::vector<std::uint8_t>& buffer, const void* data, size_t size)
+{
+	const size_t offset = buffer.size();
+
+	buffer.resize(offset + PadSize(size), 0);
+
+	if (size > 0)
+		std::memcpy(&buffer[offset], data, size);
+}
+
+/// @return false if [offset, offset + size) does not fit into the data
+static bool SkipData(size_t& offset, size_t size, size_t dataSize)
+{
+	if (size > dataSize || offset > (dataSize - size))
+		return false;
+
+	offset += PadSize(size);
+	return true;
+}
+
+
+
+void ModelCacheFormat::WriteModel(std::vector<std::uint8_t>& buffer, ModelRecord record, const std::string& tex0, const std::string& tex1)
+{
+	record.texNameSizes[0] = tex0.size();
+	record.texNameSizes[1] = tex1.size();
+
+	AppendData(buffer, &record, sizeof(record));
+	AppendData(buffer, tex0.data(), tex0.size());
+	AppendData(buffer, tex1.data(), tex1.size());
+}
+
+void ModelCacheFormat::WritePiece(std::vector<std::uint8_t>& buffer, const PieceRecord& record, const std::string& name, const void* vertices, size_t vertexSize, const std::uint32_t* indices)
+{
+	AppendData(buffer, &record, sizeof(record));
+	AppendData(buffer, name.data(), name.size());
+	AppendData(buffer, vertices, record.numVertices * vertexSize);
+	AppendData(buffer, indices, record.numIndices * sizeof(std::uint32_t));
+}
+
+
+bool ModelCacheFormat::FindPieces(const std::uint8_t* data, size_t size, std::uint32_t numPieces, size_t vertexSize, std::vector<size_t>& pieceOffsets)
+{
+	pieceOffsets.clear();
+
+	if (numPieces == 0 || size < sizeof(ModelRecord))
+		return false;
+
+	size_t offset = 0;
+
+	ModelRecord modelRecord;
+	std::memcpy(&modelRecord, data, sizeof(modelRecord));
+
+	offset += PadSize(sizeof(modelRecord));
+
+	if (!SkipData(offset, modelRecord.texNameSizes[0], size) || !SkipData(offset, modelRecord.texNameSizes[1], size))
+		return false;
+
+	pieceOffsets.reserve(numPieces);
+
+	for (std::uint32_t i = 0; i < numPieces; i++) {
+		PieceRecord pieceRecord;
+
+		if (offset > size || (size - offset) < sizeof(pieceRecord))
+			return false;
+
+		std::memcpy(&pieceRecord, data + offset, sizeof(pieceRecord));
+		pieceOffsets.push_back(offset);
+
+		if ((i == 0) != (pieceRecord.parentID == -1) || pieceRecord.parentID >= std::int32_t(i))
+			return false;
+
+		offset += PadSize(sizeof(pieceRecord));
+
+		if (!SkipData(offset, pieceRecord.nameSize, size))
+			return false;
+		if (!SkipData(offset, size_t(pieceRecord.numVertices) * vertexSize, size))
+			return false;
+		if (!SkipData(offset, size_t(pieceRecord.numIndices) * sizeof(std::uint32_t), size))
+			return false;
+	}
+
+	// nothing may follow the last piece
+	return (offset == size);
+}
+
+
+void ModelCacheFormat::ReadModel(const std::uint8_t* data, ModelRecord& record, std::string& tex0, std::string& tex1)
+{
+	std::memcpy(&record, data, sizeof(record));
+	data += PadSize(sizeof(record));
+
+	tex0.assign(reinterpret_cast<const char*>(data), record.texNameSizes[0]);
+	data += PadSize(record.texNameSizes[0]);
+	tex1.assign(reinterpret_cast<const char*>(data), record.texNameSizes[1]);
+}
+
+void ModelCacheFormat::ReadPiece(
+	const std::uint8_t* data,
+	size_t offset,
+	size_t vertexSize,
+	PieceRecord& record,
+	std::string& name,
+	const std::uint8_t*& vertices,
+	const std::uint8_t*& indices
+) {
+	data += offset;
+
+	std::memcpy(&record, data, sizeof(record));
+	data += PadSize(sizeof(record));
+
+	name.assign(reinterpret_cast<const char*>(data), record.nameSize);
+	data += PadSize(record.nameSize);
+
+	vertices = data;
+	data += PadSize(record.numVertices * vertexSize);
+	indices = data;
+}
@@ -0,0 +1,90 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef MODEL_CACHE_FORMAT_H
+#define MODEL_CACHE_FORMAT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Byte-level layout of a model cache entry (the data section of its cache
+ * file), kept apart from S3DModel so that it does not depend on any of the
+ * model or rendering code. Layout (native endianness):
+ *
+ *   ModelRecord, texs[0] chars, texs[1] chars
+ *   numPieces * {PieceRecord, name chars, vertices[numVertices], uint32 indices[numIndices]}
+ *
+ * every variable-size section is padded to 4 bytes; vertices are opaque
+ * elements of the size passed in by the caller (sizeof(SVertexData))
+ */
+namespace ModelCacheFormat {
+	struct ModelRecord {
+		float radius;
+		float height;
+
+		float mins[3];
+		float maxs[3];
+		float relMidPos[3];
+
+		std::uint32_t texNameSizes[2];
+	};
+
+	struct PieceRecord {
+		std::int32_t parentID;
+
+		std::uint32_t numVertices;
+		std::uint32_t numIndices;
+		std::uint32_t nameSize;
+
+		float offset[3];
+		float goffset[3];
+		float scales[3];
+		float mins[3];
+		float maxs[3];
+		float bakedMatrix[16];
+
+		float volumeScales[3];
+		float volumeOffsets[3];
+
+		std::int32_t volumeType;
+		std::int32_t volumeAxis;
+
+		std::uint8_t volumeFlags[4];
+	};
+
+	enum {
+		VOLUME_FLAG_IGNORE_HITS    = 0,
+		VOLUME_FLAG_CONT_HIT_TEST  = 1,
+		VOLUME_FLAG_FOOTPRINT      = 2,
+		VOLUME_FLAG_PIECE_TREE     = 3,
+	};
+
+	/// record.texNameSizes is set from the strings
+	void WriteModel(std::vector<std::uint8_t>& buffer, ModelRecord record, const std::string& tex0, const std::string& tex1);
+	/// record.{numVertices,numIndices,nameSize} have to match the arrays
+	void WritePiece(std::vector<std::uint8_t>& buffer, const PieceRecord& record, const std::string& name, const void* vertices, size_t vertexSize, const std::uint32_t* indices);
+
+	/**
+	 * Walks all records once, which has to succeed before anything is read.
+	 * Pieces must be stored in FlattenPieceTree order (root first, parents
+	 * before their children).
+	 * @param pieceOffsets receives the position of every PieceRecord
+	 * @return false if any section would run past the end or the tree is malformed
+	 */
+	bool FindPieces(const std::uint8_t* data, size_t size, std::uint32_t numPieces, size_t vertexSize, std::vector<size_t>& pieceOffsets);
+
+	void ReadModel(const std::uint8_t* data, ModelRecord& record, std::string& tex0, std::string& tex1);
+	/// @param offset as found by FindPieces; vertices and indices point into data
+	void ReadPiece(
+		const std::uint8_t* data,
+		size_t offset,
+		size_t vertexSize,
+		PieceRecord& record,
+		std::string& name,
+		const std::uint8_t*& vertices,
+		const std::uint8_t*& indices
+	);
+}
+
+#endif // MODEL_CACHE_FORMAT_H
@@ -5,6 +5,7 @@
 
 #include "S3OParser.h"
 #include "s3o.h"
+#include "ModelCache.h"
 #include "Game/GlobalUnsynced.h"
 #include "Rendering/GlobalRendering.h"
 #include "Rendering/Textures/S3OTextureHandler.h"
@@ -15,6 +16,7 @@
 #include "System/Log/ILog.h"
 #include "System/FileSystem/FileHandler.h"
 #include "System/Platform/byteorder.h"
+#include "System/Sync/HsiehHash.h"
 
 
 
@@ -49,6 +51,20 @@ S3DModel CS3OParser::Load(const std::string& name)
 	if (fileBuf.size() < sizeof(S3OHeader))
 		throw content_error("[S3OParser] corrupted header for model-file " + name);
 
+	// LoadPiece swaps the buffer in-place, hash it first
+	const std::uint32_t contentHash = HsiehHash(fileBuf.data(), fileBuf.size(), 0);
+	const bool useCache = CModelCacheFile::IsEnabled();
+
+	if (useCache) {
+		S3DModel model;
+		model.type = MODELTYPE_S3O;
+
+		if (CModelCacheFile::Read<SS3OPiece>(model, name, MODELTYPE_S3O, contentHash, [this]() { return AllocPiece(); })) {
+			textureHandlerS3O.PreloadTexture(&model);
+			return model;
+		}
+	}
+
 	S3OHeader header;
 	memcpy(&header, fileBuf.data(), sizeof(header));
 	header.swap();
@@ -71,6 +87,9 @@ S3DModel CS3OParser::Load(const std::string& name)
 	model.height = (header.height <= 0.01f)? model.CalcDrawHeight(): header.height;
 	model.relMidPos = float3(header.midx, header.midy, header.midz);
 
+	if (useCache)
+		CModelCacheFile::Write(model, contentHash);
+
 	return model;
 }
 
@@ -20,6 +20,7 @@
 #include "System/FileSystem/FileSystem.h"
 #include "System/FileSystem/SimpleParser.h"
 #include "System/Log/ILog.h"
+#include "System/Threading/ThreadPool.h"
 
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
@@ -192,6 +193,8 @@ std::vector<TexFile> C3DOTextureHandler::LoadTexFiles()
 	tgaFiles.insert(tgaFiles.end(), bmpFiles.begin(), bmpFiles.end());
 	texFiles.reserve(tgaFiles.size() + CTAPalette::NUM_PALETTE_ENTRIES);
 
+	std::vector<std::pair<std::string, std::string>> texNames;
+
 	for (const std::string& s: tgaFiles) {
 		const std::string s2 = StringToLower(FileSystem::GetBasename(s));
 
@@ -200,14 +203,16 @@ std::vector<TexFile> C3DOTextureHandler::LoadTexFiles()
 			continue;
 
 		usedNames.insert(s2);
-
-		if (teamTexes.find(s2) == teamTexes.end()) {
-			texFiles.push_back(CreateTex(s, s2, false));
-		} else {
-			texFiles.push_back(CreateTex(s, s2, true));
-		}
+		texNames.emplace_back(s, s2);
 	}
 
+	texFiles.resize(texNames.size());
+
+	// VFS reads and pixel conversion run in parallel, only the decoder itself is serialized
+	for_mt(0, texNames.size(), [&](const int i) {
+		texFiles[i] = CreateTex(texNames[i].first, texNames[i].second, teamTexes.find(texNames[i].second) != teamTexes.end());
+	});
+
 	palette.Init(paletteFile);
 
 	for (unsigned a = 0; a < CTAPalette::NUM_PALETTE_ENTRIES; ++a) {
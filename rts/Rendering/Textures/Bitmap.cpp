@@ -402,26 +402,15 @@ void CBitmap::AllocDummy(const SColor fill)
 
 bool CBitmap::Load(const std::string& filename, uint8_t defaultAlpha)
 {
-	bool isLoaded = false;
-	bool isValid  = false;
-	bool noAlpha  =  true;
-
 	const bool loadDDS = (FileSystem::GetExtension(filename) == "dds"); // always lower-case
 	const bool flipDDS = (filename.find("unitpics") == std::string::npos); // keep buildpics as-is
 
-	const size_t curMemSize = GetMemSize();
-
-
-	channels = 4;
-	#ifndef BITMAP_NO_OPENGL
-	textype = GL_TEXTURE_2D;
-	#endif
-
 
 	#define BITMAP_USE_NV_DDS
 	#ifdef BITMAP_USE_NV_DDS
 	if (loadDDS) {
 		#ifndef BITMAP_NO_OPENGL
+		textype = GL_TEXTURE_2D;
 		compressed = true;
 		xsize = 0;
 		ysize = 0;
@@ -478,6 +467,25 @@ bool CBitmap::Load(const std::string& filename, uint8_t defaultAlpha)
 		buffer = std::move(file.GetBuffer());
 	}
 
+	return (LoadFromMemory(filename, buffer, defaultAlpha));
+}
+
+bool CBitmap::LoadFromMemory(const std::string& filename, std::vector<uint8_t>& buffer, uint8_t defaultAlpha)
+{
+	bool isLoaded = false;
+	bool isValid  = false;
+	bool noAlpha  =  true;
+
+	const bool loadDDS = (FileSystem::GetExtension(filename) == "dds");
+	const bool flipDDS = (filename.find("unitpics") == std::string::npos);
+
+	const size_t curMemSize = GetMemSize();
+
+	channels = 4;
+	compressed = false;
+	#ifndef BITMAP_NO_OPENGL
+	textype = GL_TEXTURE_2D;
+	#endif
 
 	{
 		std::lock_guard<spring::mutex> lck(texMemPool.GetMutex());
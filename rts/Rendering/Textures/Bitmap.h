@@ -37,6 +37,8 @@ public:
 
 	/// Load data from a file on the VFS
 	bool Load(const std::string& filename, uint8_t defaultAlpha = 255);
+	/// Decode the contents of a (non-DDS) file the caller already read from the VFS
+	bool LoadFromMemory(const std::string& filename, std::vector<uint8_t>& buffer, uint8_t defaultAlpha = 255);
 	/// Load data from a gray-scale file on the VFS
 	bool LoadGrayscale(const std::string& filename);
 
@@ -0,0 +1,68 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "MipChain.h"
+
+
+size_t MipChain::GetChainSize(int xsize, int ysize)
+{
+	size_t size = 0;
+
+	for (int x = xsize, y = ysize; ; x = std::max(x >> 1, 1), y = std::max(y >> 1, 1)) {
+		size += (size_t(x) * y * 4);
+
+		if (x == 1 && y == 1)
+			break;
+	}
+
+	return size;
+}
+
+
+void MipChain::DownSample(const std::uint8_t* src, int srcSizeX, int srcSizeY, std::uint8_t* dst)
+{
+	const int dstSizeX = std::max(srcSizeX >> 1, 1);
+	const int dstSizeY = std::max(srcSizeY >> 1, 1);
+
+	for (int y = 0; y < dstSizeY; y++) {
+		const int y0 = std::min(y * 2 + 0, srcSizeY - 1);
+		const int y1 = std::min(y * 2 + 1, srcSizeY - 1);
+
+		for (int x = 0; x < dstSizeX; x++) {
+			const int x0 = std::min(x * 2 + 0, srcSizeX - 1);
+			const int x1 = std::min(x * 2 + 1, srcSizeX - 1);
+
+			for (int c = 0; c < 4; c++) {
+				const int sum =
+					src[(y0 * srcSizeX + x0) * 4 + c] + src[(y0 * srcSizeX + x1) * 4 + c] +
+					src[(y1 * srcSizeX + x0) * 4 + c] + src[(y1 * srcSizeX + x1) * 4 + c];
+
+				dst[(y * dstSizeX + x) * 4 + c] = (sum + 2) >> 2;
+			}
+		}
+	}
+}
+
+
+void MipChain::Create(const std::uint8_t* src, int xsize, int ysize, std::vector<std::uint8_t>& chain)
+{
+	chain.clear();
+	chain.resize(GetChainSize(xsize, ysize));
+
+	std::memcpy(chain.data(), src, size_t(xsize) * ysize * 4);
+
+	size_t srcOffset = 0;
+	size_t dstOffset = size_t(xsize) * ysize * 4;
+
+	for (int x = xsize, y = ysize; x > 1 || y > 1; x = std::max(x >> 1, 1), y = std::max(y >> 1, 1)) {
+		DownSample(&chain[srcOffset], x, y, &chain[dstOffset]);
+
+		srcOffset = dstOffset;
+		dstOffset += (size_t(std::max(x >> 1, 1)) * std::max(y >> 1, 1) * 4);
+	}
+
+	assert(dstOffset == chain.size());
+}
@@ -0,0 +1,30 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef MIP_CHAIN_H
+#define MIP_CHAIN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * CPU-side mipmapping of RGBA8 images, without any GL dependencies so it
+ * can run on worker threads. A chain holds every level back to back, the
+ * largest first, down to and including 1x1; each dimension is halved per
+ * level and clamped to 1 (as GL does for non-square textures).
+ */
+namespace MipChain {
+	/// @return number of bytes a chain for an xsize*ysize image occupies
+	size_t GetChainSize(int xsize, int ysize);
+
+	/**
+	 * 2x2 box-filter into a (max(srcSizeX/2,1) * max(srcSizeY/2,1)) image,
+	 * the last row or column is repeated for odd sizes
+	 */
+	void DownSample(const std::uint8_t* src, int srcSizeX, int srcSizeY, std::uint8_t* dst);
+
+	/// @param src level 0, copied to the front of chain
+	void Create(const std::uint8_t* src, int xsize, int ysize, std::vector<std::uint8_t>& chain);
+}
+
+#endif // MIP_CHAIN_H
@@ -0,0 +1,140 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "System/Platform/Win/win32.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "ProcessedTexture.h"
+#include "Bitmap.h"
+#include "MipChain.h"
+#include "Rendering/GlobalRendering.h"
+#include "Rendering/GL/myGL.h"
+#include "System/Config/ConfigHandler.h"
+#include "System/FileSystem/CacheFile.h"
+#include "System/FileSystem/DataDirsAccess.h"
+#include "System/FileSystem/FileSystem.h"
+#include "System/FileSystem/FileQueryFlags.h"
+
+CONFIG(bool, UseTextureCache).defaultValue(true).description("Store decoded and mipmapped model textures in the cache directory so later game starts can upload them directly.");
+
+
+static constexpr std::uint32_t TEXTURE_CACHE_VERSION = 2;
+
+// cache-files are keyed by the hash passed to ReadCache and WriteCache,
+// their data holds the texels of every level as in CProcessedTexture::texels
+static constexpr char CACHE_FILE_MAGIC[8] = {'S', 'P', 'R', 'I', 'N', 'G', 'T', 'X'};
+
+struct CacheFileInfo {
+	std::int32_t xsize;
+	std::int32_t ysize;
+};
+
+
+static const std::string GetTextureCacheDir() {
+	return (FileSystem::GetCacheDir() + "/textures/");
+}
+
+// one file per texture, so the entry of a changed source is replaced
+// instead of piling up next to the new one
+static const std::string GetCacheFileName(const std::string& textureName) {
+	std::string fileName = textureName;
+
+	std::replace(fileName.begin(), fileName.end(), '/', '_');
+	std::replace(fileName.begin(), fileName.end(), '\\', '_');
+
+	return (GetTextureCacheDir() + fileName + ".bin");
+}
+
+
+
+bool CProcessedTexture::IsCacheEnabled()
+{
+	return (configHandler->GetBool("UseTextureCache"));
+}
+
+
+void CProcessedTexture::Create(const CBitmap& bitmap)
+{
+	assert(!bitmap.compressed);
+	assert(bitmap.channels == 4);
+
+	xsize = bitmap.xsize;
+	ysize = bitmap.ysize;
+
+	MipChain::Create(bitmap.GetRawMem(), xsize, ysize, texels);
+}
+
+
+unsigned int CProcessedTexture::CreateTexture() const
+{
+	if (texels.empty())
+		return 0;
+
+	const GLint intFormat = globalRendering->compressTextures? GL_COMPRESSED_RGBA: GL_RGBA8;
+
+	unsigned int texID = 0;
+	int numLevels = 0;
+	size_t offset = 0;
+
+	glGenTextures(1, &texID);
+	glBindTexture(GL_TEXTURE_2D, texID);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+
+	for (int x = xsize, y = ysize; ; x = std::max(x >> 1, 1), y = std::max(y >> 1, 1)) {
+		glTexImage2D(GL_TEXTURE_2D, numLevels++, intFormat, x, y, 0, GL_RGBA, GL_UNSIGNED_BYTE, &texels[offset]);
+
+		if (x == 1 && y == 1)
+			break;
+
+		offset += (size_t(x) * y * 4);
+	}
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, numLevels - 1);
+	return texID;
+}
+
+
+bool CProcessedTexture::ReadCache(const std::string& name, std::uint32_t hash)
+{
+	const std::string cacheFileName = GetCacheFileName(name);
+
+	if (!FileSystem::FileExists(cacheFileName))
+		return false;
+
+	CCacheFile cacheFile;
+	CacheFileInfo info;
+
+	// a mismatching key means the source changed, the caller rewrites the entry
+	if (!cacheFile.Open(dataDirsAccess.LocateFile(cacheFileName), CACHE_FILE_MAGIC, TEXTURE_CACHE_VERSION, hash, info))
+		return (cacheFile.Remove());
+	if (info.xsize <= 0 || info.ysize <= 0)
+		return (cacheFile.Remove());
+	if (cacheFile.GetDataSize() != MipChain::GetChainSize(info.xsize, info.ysize))
+		return (cacheFile.Remove());
+
+	xsize = info.xsize;
+	ysize = info.ysize;
+
+	texels.assign(cacheFile.GetData(), cacheFile.GetData() + cacheFile.GetDataSize());
+	return true;
+}
+
+bool CProcessedTexture::WriteCache(const std::string& name, std::uint32_t hash) const
+{
+	if (texels.empty())
+		return false;
+	if (!FileSystem::CreateDirectory(GetTextureCacheDir()))
+		return false;
+
+	const CacheFileInfo info = {xsize, ysize};
+
+	// replaced as a whole, concurrent readers never see a partial file
+	const std::string cacheFilePath = dataDirsAccess.LocateFile(GetCacheFileName(name), FileQueryFlags::WRITE);
+
+	return (CCacheFile::Write(cacheFilePath, CACHE_FILE_MAGIC, TEXTURE_CACHE_VERSION, hash, info, texels.data(), texels.size()));
+}
@@ -0,0 +1,47 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef PROCESSED_TEXTURE_H
+#define PROCESSED_TEXTURE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class CBitmap;
+
+/**
+ * RGBA8 image together with its complete mip-chain.
+ *
+ * Everything except CreateTexture may run on any thread, so decoding and
+ * mipmapping can be done by workers while the GL thread only uploads the
+ * result. Processed images can be stored in CacheDir/textures/, keyed by
+ * a hash over the source file and every transform applied to it, which
+ * lets later runs skip decoding altogether. There is one entry per texture
+ * name, a changed source replaces it.
+ */
+class CProcessedTexture {
+public:
+	static bool IsCacheEnabled();
+
+	/// @param bitmap uncompressed 4-channel image, becomes level 0
+	void Create(const CBitmap& bitmap);
+	/// uploads all levels into a new texture object, GL thread only
+	unsigned int CreateTexture() const;
+
+	bool ReadCache(const std::string& name, std::uint32_t hash);
+	bool WriteCache(const std::string& name, std::uint32_t hash) const;
+
+	bool Empty() const { return texels.empty(); }
+
+	int GetSizeX() const { return xsize; }
+	int GetSizeY() const { return ysize; }
+
+private:
+	// all levels back to back, largest first (see MipChain)
+	std::vector<std::uint8_t> texels;
+
+	int xsize = 0;
+	int ysize = 0;
+};
+
+#endif // PROCESSED_TEXTURE_H
@@ -5,6 +5,7 @@
 #include "S3OTextureHandler.h"
 
 #include "System/FileSystem/FileHandler.h"
+#include "System/FileSystem/FileSystem.h"
 #include "System/FileSystem/SimpleParser.h"
 #include "Rendering/ShadowHandler.h"
 #include "Rendering/UnitDrawer.h"
@@ -14,6 +15,7 @@
 #include "System/Exceptions.h"
 #include "System/Log/ILog.h"
 #include "System/Platform/Threading.h"
+#include "System/Sync/HsiehHash.h"
 
 #include <algorithm>
 #include <cctype>
@@ -60,24 +62,23 @@ void CS3OTextureHandler::Kill()
 	textureCache.clear();
 	textureTable.clear();
 	bitmapCache.clear();
+	loadingTextures.clear();
 }
 
 
 void CS3OTextureHandler::PreloadTexture(S3DModel* model, bool invertAxis, bool invertAlpha)
 {
-	cacheMutex.lock();
-	LoadAndCacheTexture(model, 0, invertAxis, invertAlpha, true);
-	LoadAndCacheTexture(model, 1, invertAxis,       false, true); // never invert alpha for tex2
-	cacheMutex.unlock();
+	PreloadBitmap(model, 0, invertAxis, invertAlpha);
+	PreloadBitmap(model, 1, invertAxis,       false); // never invert alpha for tex2
 }
 
 
 void CS3OTextureHandler::LoadTexture(S3DModel* model)
 {
-	cacheMutex.lock();
+	std::unique_lock<spring::mutex> lock(cacheMutex);
 
-	const unsigned int tex1ID = LoadAndCacheTexture(model, 0, false, false, false);
-	const unsigned int tex2ID = LoadAndCacheTexture(model, 1, false, false, false);
+	const unsigned int tex1ID = LoadAndCacheTexture(model, 0, lock);
+	const unsigned int tex2ID = LoadAndCacheTexture(model, 1, lock);
 
 	const auto texTableIter = textureTable.find(TEX_MAT_UID(tex1ID, tex2ID));
 
@@ -88,69 +89,162 @@ void CS3OTextureHandler::LoadTexture(S3DModel* model)
 	} else {
 		model->textureType = texTableIter->second;
 	}
+}
+
+
+void CS3OTextureHandler::PreloadBitmap(const S3DModel* model, unsigned int texNum, bool invertAxis, bool invertAlpha)
+{
+	const std::string& textureName = model->texs[texNum];
+
+	{
+		std::lock_guard<spring::mutex> lock(cacheMutex);
+
+		if (textureCache.find(textureName) != textureCache.end())
+			return;
+		if (bitmapCache.find(textureName) != bitmapCache.end())
+			return;
+
+		// someone else is already decoding it
+		if (!loadingTextures.insert(textureName).second)
+			return;
+	}
+
+	// decode outside the lock so that preloading models can overlap
+	PreloadedTex tex;
+
+	try {
+		tex = LoadBitmap(model, texNum, invertAxis, invertAlpha);
+	} catch (...) {
+		std::lock_guard<spring::mutex> lock(cacheMutex);
+
+		loadingTextures.erase(textureName);
+		cacheCond.notify_all();
+		throw;
+	}
 
-	cacheMutex.unlock();
+	std::lock_guard<spring::mutex> lock(cacheMutex);
+
+	bitmapCache.emplace(textureName, std::move(tex));
+	loadingTextures.erase(textureName);
+	cacheCond.notify_all();
 }
 
-unsigned int CS3OTextureHandler::LoadAndCacheTexture(
+CS3OTextureHandler::PreloadedTex CS3OTextureHandler::LoadBitmap(
 	const S3DModel* model,
 	unsigned int texNum,
 	bool invertAxis,
-	bool invertAlpha,
-	bool preloadCall
-) {
-	CBitmap* bitmap = nullptr;
+	bool invertAlpha
+) const {
+	const std::string& textureName = model->texs[texNum];
+	const std::string fileNames[] = {textureName, "unittextures/" + textureName};
 
-	const auto& textureName = model->texs[texNum];
-	const auto textureIt = textureCache.find(textureName);
+	PreloadedTex tex;
+	CBitmap& bitmap = tex.bitmap;
 
-	if (textureIt != textureCache.end())
-		return textureIt->second.texID;
+	const auto ProcessBitmap = [&]() {
+		if (invertAxis)
+			bitmap.ReverseYAxis();
+		if (invertAlpha)
+			bitmap.InvertAlpha();
 
-	const auto bitmapIt = bitmapCache.find(textureName);
+		if (bitmap.compressed)
+			return;
 
-	if (bitmapIt != bitmapCache.end()) {
-		// bitmap was previously preloaded but not yet loaded
-		// if !preloading, we will now turn the bitmap into a
-		// texture and cache it
-		bitmap = &(bitmapIt->second);
+		tex.processed.Create(bitmap);
+		bitmap = {};
+	};
+
+	if (FileSystem::GetExtension(textureName) == "dds") {
+		for (const std::string& fileName: fileNames) {
+			if (!bitmap.Load(fileName))
+				continue;
+
+			ProcessBitmap();
+			return tex;
+		}
 	} else {
-		// bitmap was not yet preloaded, meaning we are the
-		// first to (all non-3DO model textures are always
-		// preloaded)
-		assert(preloadCall);
+		const bool useCache = CProcessedTexture::IsCacheEnabled();
+
+		for (const std::string& fileName: fileNames) {
+			CFileHandler file(fileName);
+			std::vector<uint8_t> buffer;
+
+			if (!file.FileExists())
+				continue;
 
-		auto pair = bitmapCache.emplace(textureName, {});
-		auto iter = pair.first;
+			if (!file.IsBuffered()) {
+				buffer.resize(file.FileSize(), 0);
+				file.Read(buffer.data(), buffer.size());
+			} else {
+				buffer = std::move(file.GetBuffer());
+			}
 
-		bitmap = &(iter->second);
+			// the flags change the processed texels, so they are part of the key
+			const std::uint32_t hash = HsiehHash(buffer.data(), buffer.size(), (invertAxis * 2) + invertAlpha);
 
-		if (!bitmap->Load(textureName) && !bitmap->Load("unittextures/" + textureName)) {
-			if (texNum == 0)
-				LOG_L(L_WARNING, "[%s] could not load primary texture \"%s\" from model \"%s\"", __func__, textureName.c_str(), model->name.c_str());
+			if (useCache && tex.processed.ReadCache(fileName, hash))
+				return tex;
 
-			// file not found (or headless build), set a single pixel so model is visible
-			bitmap->AllocDummy(SColor(255 * (texNum == 0), 0, 0, 255 * (1 - invertAlpha)));
+			if (!bitmap.LoadFromMemory(fileName, buffer))
+				continue;
+
+			ProcessBitmap();
+
+			if (useCache)
+				tex.processed.WriteCache(fileName, hash);
+
+			return tex;
 		}
+	}
 
-		if (invertAxis)
-			bitmap->ReverseYAxis();
-		if (invertAlpha)
-			bitmap->InvertAlpha();
+	if (texNum == 0)
+		LOG_L(L_WARNING, "[%s] could not load primary texture \"%s\" from model \"%s\"", __func__, textureName.c_str(), model->name.c_str());
+
+	// file not found (or headless build), set a single pixel so model is visible
+	bitmap.AllocDummy(SColor(255 * (texNum == 0), 0, 0, 255 * (1 - invertAlpha)));
+
+	ProcessBitmap();
+	return tex;
+}
+
+
+unsigned int CS3OTextureHandler::LoadAndCacheTexture(const S3DModel* model, unsigned int texNum, std::unique_lock<spring::mutex>& lock)
+{
+	const std::string& textureName = model->texs[texNum];
+
+	// a preload thread might still be decoding it
+	while (loadingTextures.find(textureName) != loadingTextures.end())
+		cacheCond.wait(lock);
+
+	const auto textureIt = textureCache.find(textureName);
+
+	if (textureIt != textureCache.end())
+		return textureIt->second.texID;
+
+	if (bitmapCache.find(textureName) == bitmapCache.end()) {
+		// all non-3DO model textures are normally preloaded by their parser
+		lock.unlock();
+		PreloadBitmap(model, texNum, false, false);
+		lock.lock();
+
+		while (loadingTextures.find(textureName) != loadingTextures.end())
+			cacheCond.wait(lock);
 	}
 
-	// don't generate a texture yet, just save the bitmap for later
-	if (preloadCall)
-		return 0;
+	const PreloadedTex& tex = bitmapCache[textureName];
 
-	const unsigned int texID = bitmap->CreateMipMapTexture();
+	unsigned int texID = 0;
+	CachedS3OTex cachedTex;
 
-	textureCache[textureName] = {
-		texID,
-		static_cast<unsigned int>(bitmap->xsize),
-		static_cast<unsigned int>(bitmap->ysize)
-	};
+	if (tex.processed.Empty()) {
+		texID = tex.bitmap.CreateMipMapTexture();
+		cachedTex = {texID, static_cast<unsigned int>(tex.bitmap.xsize), static_cast<unsigned int>(tex.bitmap.ysize)};
+	} else {
+		texID = tex.processed.CreateTexture();
+		cachedTex = {texID, static_cast<unsigned int>(tex.processed.GetSizeX()), static_cast<unsigned int>(tex.processed.GetSizeY())};
+	}
 
+	textureCache[textureName] = cachedTex;
 	bitmapCache.erase(textureName);
 	return texID;
 }
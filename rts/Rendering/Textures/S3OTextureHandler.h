@@ -7,8 +7,10 @@
 #include <vector>
 
 #include "Bitmap.h"
+#include "ProcessedTexture.h"
 #include "System/Threading/SpringThreading.h"
 #include "System/UnorderedMap.hpp"
+#include "System/UnorderedSet.hpp"
 
 struct S3DModel;
 class CBitmap;
@@ -50,25 +52,33 @@ public:
 	}
 
 private:
-	unsigned int LoadAndCacheTexture(
-		const S3DModel* model,
-		unsigned int texNum,
-		bool invertAxis,
-		bool invertAlpha,
-		bool preloadCall
-	);
+	// decoded but not yet uploaded; DDS files stay in the bitmap since
+	// they are compressed already, everything else is mipmapped up-front
+	struct PreloadedTex {
+		CBitmap bitmap;
+		CProcessedTexture processed;
+	};
+
+	void PreloadBitmap(const S3DModel* model, unsigned int texNum, bool invertAxis, bool invertAlpha);
+	PreloadedTex LoadBitmap(const S3DModel* model, unsigned int texNum, bool invertAxis, bool invertAlpha) const;
+
+	unsigned int LoadAndCacheTexture(const S3DModel* model, unsigned int texNum, std::unique_lock<spring::mutex>& lock);
 	unsigned int InsertTextureMat(const S3DModel* model);
 
 private:
 	typedef spring::unsynced_map<std::string, CachedS3OTex> TextureCache;
-	typedef spring::unsynced_map<std::string, CBitmap> BitmapCache;
+	typedef spring::unsynced_map<std::string, PreloadedTex> BitmapCache;
 	typedef spring::unsynced_map<std::uint64_t, unsigned int> TextureTable;
 
 	TextureCache textureCache; // stores individual primary- and secondary-textures by name
 	TextureTable textureTable; // stores (primary, secondary) texture-pairs by unique ident
 	BitmapCache bitmapCache;
 
+	// textures some preload thread is decoding right now (without holding cacheMutex)
+	spring::unsynced_set<std::string> loadingTextures;
+
 	spring::mutex cacheMutex;
+	spring::condition_variable cacheCond;
 
 	std::vector<S3OTexMat> textures;
 };
@@ -46,6 +46,7 @@
 #include "System/EventHandler.h"
 #include "System/MemPoolTypes.h"
 #include "System/SpringMath.h"
+#include "System/Threading/ThreadPool.h"
 
 
 CONFIG(int, UnitLodDist).defaultValue(1000).headlessValue(0);
@@ -56,6 +57,10 @@ CONFIG(int, MaxDynamicModelLights)
 	.defaultValue(1)
 	.minimumValue(0);
 
+CONFIG(bool, UnitInstancedDrawing)
+	.defaultValue(true)
+	.description("Draw opaque default-material units sharing a model with one instanced call per model.");
+
 
 CUnitDrawer* unitDrawer = nullptr;
 
@@ -293,6 +298,17 @@ void CUnitDrawer::Init() {
 	drawForward = true;
 	drawDeferred = (geomBuffer->Valid());
 	wireFrameMode = false;
+	drawInstanced = configHandler->GetBool("UnitInstancedDrawing");
+
+	instanceBatches.reserve(64);
+	instanceBatchIndices.clear();
+	instanceBatchIndices.resize(MAX_MODEL_OBJECTS, -1);
+	instanceData.reserve(1024 * 16);
+
+	numInstanceBatches = 0;
+
+	if (drawInstanced)
+		glGenTextures(1, &instanceDataTexture);
 
 	unitDrawerStates[DRAWER_STATE_SSP]->Init(this);
 	cubeMapHandler.Init(); // can only fail if FBO's are invalid
@@ -354,6 +370,16 @@ void CUnitDrawer::Kill()
 	unitsByIcon.clear();
 	unitIcons.clear();
 
+	for (ModelInstanceBatch& batch: instanceBatches) {
+		batch.units.clear();
+	}
+
+	instanceData.clear();
+	instanceDataBuffer.Release();
+
+	glDeleteTextures(1, &instanceDataTexture);
+	instanceDataTexture = 0;
+
 	geomBuffer = nullptr;
 }
 
@@ -372,6 +398,19 @@ void CUnitDrawer::Update()
 			UpdateUnitDrawPos(unit);
 		}
 	}
+	{
+		// refresh unsynced piece-matrix copies of potentially visible
+		// units up-front so the draw passes do not have to; each unit
+		// only touches its own LocalModel
+		for_mt(0, unsortedUnits.size(), [&](const int i) {
+			CUnit* unit = unsortedUnits[i];
+
+			if (unit->isIcon || unit->noDraw)
+				return;
+
+			unit->localModel.UpdatePieceMatrices(gs->frameNum);
+		});
+	}
 
 	if ((useDistToGroundForIcons = (camHandler->GetCurrentController()).GetUseDistToGroundForIcons())) {
 		const float3& camPos = camera->GetPos();
@@ -445,6 +484,8 @@ void CUnitDrawer::DrawOpaqueUnits(int modelType, bool drawReflection, bool drawR
 			DrawOpaqueUnit(unit, drawReflection, drawRefraction);
 		}
 	}
+
+	DrawInstancedUnits(modelType);
 }
 
 inline void CUnitDrawer::DrawOpaqueUnit(CUnit* unit, bool drawReflection, bool drawRefraction)
@@ -460,12 +501,146 @@ inline void CUnitDrawer::DrawOpaqueUnit(CUnit* unit, bool drawReflection, bool d
 	if (LuaObjectDrawer::AddOpaqueMaterialObject(unit, LUAOBJ_UNIT))
 		return;
 
+	// defer the unit to DrawInstancedUnits
+	if (CanDrawInstancedUnit(unit)) {
+		AddInstancedUnit(unit);
+		return;
+	}
+
 	// draw the unit with the default (non-Lua) material
 	SetTeamColour(unit->team);
 	DrawUnitDefTrans(unit, false, false);
 }
 
 
+bool CUnitDrawer::CanDrawInstancedUnit(const CUnit* unit) const
+{
+	if (!drawInstanced)
+		return false;
+	// nano-frames need per-unit clip-planes and multiple passes
+	if (unit->beingBuilt && unit->unitDef->showNanoFrame)
+		return false;
+	// DrawUnit call-ins may replace or augment the model per unit
+	if (unit->luaDraw)
+		return false;
+
+	return (unit->model->id > 0 && unit->model->id < MAX_MODEL_OBJECTS);
+}
+
+void CUnitDrawer::AddInstancedUnit(const CUnit* unit)
+{
+	const S3DModel* model = unit->model;
+
+	if (instanceBatchIndices[model->id] == -1) {
+		instanceBatchIndices[model->id] = numInstanceBatches;
+
+		if (numInstanceBatches == instanceBatches.size())
+			instanceBatches.emplace_back();
+
+		instanceBatches[numInstanceBatches].model = model;
+		instanceBatches[numInstanceBatches].units.clear();
+		instanceBatches[numInstanceBatches].numInstances = 0;
+		instanceBatches[numInstanceBatches].dataOffset = 0;
+
+		numInstanceBatches += 1;
+	}
+
+	instanceBatches[ instanceBatchIndices[model->id] ].units.push_back(unit);
+}
+
+void CUnitDrawer::DrawInstancedUnits(int modelType)
+{
+	if (numInstanceBatches == 0)
+		return;
+
+	const IUnitDrawerState* state = unitDrawerStates[DRAWER_STATE_SEL];
+
+	const size_t maxDataTexels = std::max(globalRendering->glslMaxTexBufferSize, 0);
+
+	instanceData.clear();
+
+	// gather per-instance data for all batches, one upload per pass
+	// batches were created in texture-bin order, so models sharing
+	// a texture type are adjacent
+	for (size_t i = 0; i < numInstanceBatches; i++) {
+		ModelInstanceBatch& batch = instanceBatches[i];
+
+		const size_t numPieces = batch.model->numPieces;
+		const size_t numTexels = 5 + numPieces * 4;
+		const size_t curTexels = instanceData.size() / 4;
+
+		batch.dataOffset = curTexels;
+		batch.numInstances = std::min(batch.units.size(), (maxDataTexels - std::min(curTexels, maxDataTexels)) / numTexels);
+
+		for (size_t j = 0; j < batch.numInstances; j++) {
+			const CUnit* unit = batch.units[j];
+			LocalModel* lm = const_cast<LocalModel*>(&unit->localModel);
+
+			lm->UpdatePieceMatrices(gs->frameNum);
+
+			const CMatrix44f& modelMat = unit->GetTransformMatrix();
+			const float4 teamColor = IUnitDrawerState::GetTeamColor(unit->team, 1.0f);
+			const std::vector<CMatrix44f>& pieceMats = lm->GetPieceMatrices();
+
+			assert(pieceMats.size() == numPieces);
+
+			instanceData.insert(instanceData.end(), &modelMat.m[0], &modelMat.m[0] + 16);
+			instanceData.insert(instanceData.end(), &teamColor.x, &teamColor.x + 4);
+			instanceData.insert(instanceData.end(), &pieceMats[0].m[0], &pieceMats[0].m[0] + numPieces * 16);
+		}
+	}
+
+	if (!instanceData.empty()) {
+		instanceDataBuffer.Bind(GL_TEXTURE_BUFFER);
+		instanceDataBuffer.New(instanceData.size() * sizeof(float), GL_STREAM_DRAW, instanceData.data());
+		instanceDataBuffer.Unbind();
+
+		glActiveTexture(GL_TEXTURE4);
+		glBindTexture(GL_TEXTURE_BUFFER, instanceDataTexture);
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, instanceDataBuffer.GetId());
+		glActiveTexture(GL_TEXTURE0);
+	}
+
+	int boundTexType = -1;
+
+	for (size_t i = 0; i < numInstanceBatches; i++) {
+		ModelInstanceBatch& batch = instanceBatches[i];
+
+		const S3DModel* model = batch.model;
+
+		if (model->textureType != boundTexType)
+			BindModelTypeTexture(modelType, boundTexType = model->textureType);
+
+		if (batch.numInstances > 0) {
+			state->SetInstanceParams({int(5 + model->numPieces * 4), int(batch.dataOffset)});
+
+			model->BindVertexArray();
+			glDrawElementsInstanced(GL_TRIANGLES, model->vboNumIndcs, GL_UNSIGNED_INT, nullptr, batch.numInstances);
+			model->UnbindVertexArray();
+
+			state->SetInstanceParams({0, 0});
+		}
+
+		// data-buffer overflow, draw the remainder individually
+		for (size_t j = batch.numInstances, n = batch.units.size(); j < n; j++) {
+			SetTeamColour(batch.units[j]->team);
+			DrawUnitDefTrans(batch.units[j], false, false);
+		}
+
+		instanceBatchIndices[model->id] = -1;
+		batch.units.clear();
+	}
+
+	if (!instanceData.empty()) {
+		glActiveTexture(GL_TEXTURE4);
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
+		glActiveTexture(GL_TEXTURE0);
+	}
+
+	numInstanceBatches = 0;
+}
+
+
 void CUnitDrawer::DrawOpaqueAIUnits(int modelType)
 {
 	const std::vector<TempDrawUnit>& tmpOpaqueUnits = tempOpaqueUnits[modelType];
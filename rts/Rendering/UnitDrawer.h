@@ -9,6 +9,7 @@
 
 #include "Rendering/GL/LightHandler.h"
 #include "Rendering/GL/RenderDataBufferFwd.hpp"
+#include "Rendering/GL/VBO.h"
 #include "Rendering/Models/3DModel.h"
 #include "Rendering/Models/ModelRenderContainer.h"
 #include "Rendering/UnitDrawerState.hpp"
@@ -217,6 +218,10 @@ private:
 	void DrawOpaqueUnitsShadow(int modelType);
 	void DrawOpaqueUnits(int modelType, bool drawReflection, bool drawRefraction);
 
+	bool CanDrawInstancedUnit(const CUnit* unit) const;
+	void AddInstancedUnit(const CUnit* unit);
+	void DrawInstancedUnits(int modelType);
+
 	void DrawAlphaUnits(int modelType);
 	void DrawAlphaUnit(CUnit* unit, int modelType, bool drawGhostBuildingsPass);
 
@@ -295,10 +300,21 @@ public:
 	// .w := AI-temp unit alpha
 	float4 alphaValues;
 
+private:
+	struct ModelInstanceBatch {
+		const S3DModel* model;
+
+		std::vector<const CUnit*> units;
+
+		unsigned int numInstances; // can be less than units.size() if data-buffer is full
+		unsigned int dataOffset; // in texels
+	};
+
 private:
 	bool drawForward;
 	bool drawDeferred;
 	bool wireFrameMode;
+	bool drawInstanced;
 
 	bool useDistToGroundForIcons;
 
@@ -338,6 +354,18 @@ private:
 	std::array<IUnitDrawerState*, DRAWER_STATE_CNT> unitDrawerStates;
 	std::array<DrawModelFunc, 3> drawModelFuncs;
 
+	/// opaque default-material units batched per S3DModel, see DrawInstancedUnits
+	std::vector<ModelInstanceBatch> instanceBatches;
+	/// index into instanceBatches per S3DModel::id, -1 if no batch exists this pass
+	std::vector<int> instanceBatchIndices;
+	/// per-instance {model-matrix, team-color, piece-matrices} uploaded as RGBA32F texels
+	std::vector<float> instanceData;
+
+	size_t numInstanceBatches = 0;
+
+	VBO instanceDataBuffer;
+	GLuint instanceDataTexture = 0;
+
 private:
 	GL::LightHandler lightHandler;
 	GL::GeometryBuffer* geomBuffer;
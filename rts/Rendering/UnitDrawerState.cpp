@@ -151,12 +151,15 @@ bool UnitDrawerStateGLSL::Init(const CUnitDrawer* ud) {
 		modelShaders[n]->SetUniformLocation("alphaTestCtrl");     // idx 24
 		modelShaders[n]->SetUniformLocation("gammaExponent");     // idx 25
 		modelShaders[n]->SetUniformLocation("fwdDynLights");      // idx 26
+		modelShaders[n]->SetUniformLocation("instanceDataTex");   // idx 27
+		modelShaders[n]->SetUniformLocation("instanceParams");    // idx 28
 
 		modelShaders[n]->Enable();
 		modelShaders[n]->SetUniform1i(0, 0); // diffuseTex  (idx 0, texunit 0)
 		modelShaders[n]->SetUniform1i(1, 1); // shadingTex  (idx 1, texunit 1)
 		modelShaders[n]->SetUniform1i(2, 2); // shadowTex   (idx 2, texunit 2)
 		modelShaders[n]->SetUniform1i(3, 3); // reflectTex  (idx 3, texunit 3)
+		modelShaders[n]->SetUniform1i(27, 4); // instanceDataTex (idx 27, texunit 4)
 
 		modelShaders[n]->SetUniform3fv(4, sky->GetLight()->GetLightDir());
 		modelShaders[n]->SetUniform3fv(9, &fogParams.x);
@@ -179,6 +182,7 @@ bool UnitDrawerStateGLSL::Init(const CUnitDrawer* ud) {
 		modelShaders[n]->SetUniform4fv(23, shadowHandler.GetShadowParams());
 		modelShaders[n]->SetUniform4fv(24, float4{0.0f, 0.0f, 0.0f, 1.0f}); // alphaTestCtrl
 		modelShaders[n]->SetUniform1f(25, globalRendering->gammaExponent);
+		modelShaders[n]->SetUniform2i(28, 0, 0); // instanceParams
 		modelShaders[n]->Disable();
 		modelShaders[n]->Validate();
 	}
@@ -307,3 +311,7 @@ void UnitDrawerStateGLSL::SetBuildClipPlanes(const float4& upper, const float4&
 	modelShaders[MODEL_SHADER_ACTIVE]->SetUniform4fv(12, lower);
 }
 
+void UnitDrawerStateGLSL::SetInstanceParams(const int2& params) const {
+	assert(modelShaders[MODEL_SHADER_ACTIVE]->IsBound());
+	modelShaders[MODEL_SHADER_ACTIVE]->SetUniform2i(28, params.x, params.y);
+}
@@ -63,6 +63,7 @@ public:
 	virtual void SetMatrices(const CMatrix44f& modelMat, const CMatrix44f* pieceMats, size_t numPieceMats) const = 0;
 	virtual void SetWaterClipPlane(const DrawPass::e& drawPass) const = 0; // water
 	virtual void SetBuildClipPlanes(const float4&, const float4&) const = 0; // nano-frames
+	virtual void SetInstanceParams(const int2& params) const = 0; // x=stride (in texels, 0 disables), y=offset
 
 	void SetActiveShader(unsigned int shadowed, unsigned int deferred) {
 		// shadowed=1 --> shader 1 (deferred=0) or 3 (deferred=1)
@@ -122,6 +123,7 @@ public:
 	void SetMatrices(const CMatrix44f& modelMat, const CMatrix44f* pieceMats, size_t numPieceMats) const override {}
 	void SetWaterClipPlane(const DrawPass::e& drawPass) const override {}
 	void SetBuildClipPlanes(const float4&, const float4&) const override {}
+	void SetInstanceParams(const int2& params) const override {}
 };
 
 
@@ -146,6 +148,7 @@ public:
 	void SetMatrices(const CMatrix44f& modelMat, const CMatrix44f* pieceMats, size_t numPieceMats) const override {} // handled via LuaObjectDrawer::SetObjectMatrices
 	void SetWaterClipPlane(const DrawPass::e& drawPass) const override {}
 	void SetBuildClipPlanes(const float4&, const float4&) const override {}
+	void SetInstanceParams(const int2& params) const override {}
 };
 
 
@@ -174,6 +177,7 @@ public:
 	void SetMatrices(const CMatrix44f& modelMat, const CMatrix44f* pieceMats, size_t numPieceMats) const override;
 	void SetWaterClipPlane(const DrawPass::e& drawPass) const override;
 	void SetBuildClipPlanes(const float4&, const float4&) const override;
+	void SetInstanceParams(const int2& params) const override;
 };
 
 #endif
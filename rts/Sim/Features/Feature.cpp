@@ -142,7 +142,7 @@ bool CFeature::IsInLosForAllyTeam(int argAllyTeam) const
 }
 
 
-void CFeature::Initialize(const FeatureLoadParams& params)
+void CFeature::InitializeState(const FeatureLoadParams& params)
 {
 	const CSolidObject* po = params.parentObj;
 
@@ -224,8 +224,10 @@ void CFeature::Initialize(const FeatureLoadParams& params)
 
 	collisionVolume.InitDefault(float4(radius, height,  xsize * SQUARE_SIZE, zsize * SQUARE_SIZE));
 	selectionVolume.InitDefault(float4(radius, height,  xsize * SQUARE_SIZE, zsize * SQUARE_SIZE));
+}
 
-
+void CFeature::InitializeRegistration()
+{
 	// feature does not have an assigned ID yet
 	// this MUST be done before the Block() call
 	featureHandler.AddFeature(this);
@@ -70,7 +70,22 @@ public:
 	 * Pos of quad must not change after this.
 	 * This will add this to the FeatureHandler.
 	 */
-	void Initialize(const FeatureLoadParams& params);
+	void Initialize(const FeatureLoadParams& params) {
+		InitializeState(params);
+		InitializeRegistration();
+	}
+
+	/**
+	 * Sets up everything that is local to this feature; touches no
+	 * shared state and can run concurrently for different features
+	 * (as long as the def's model was already loaded).
+	 */
+	void InitializeState(const FeatureLoadParams& params);
+	/**
+	 * Assigns the ID and inserts into FeatureHandler, QuadField and
+	 * blocking-map, then runs the creation call-ins; order matters.
+	 */
+	void InitializeRegistration();
 
 	const SolidObjectDef* GetDef() const override { return ((const SolidObjectDef*) def); }
 
@@ -1,5 +1,7 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
+#include <exception>
+
 #include "FeatureDefHandler.h"
 
 #include "FeatureDef.h"
@@ -10,6 +12,7 @@
 #include "System/Exceptions.h"
 #include "System/Log/ILog.h"
 #include "System/StringUtil.h"
+#include "System/Threading/ThreadPool.h"
 
 static CFeatureDefHandler gFeatureDefHandler;
 CFeatureDefHandler* featureDefHandler = &gFeatureDefHandler;
@@ -30,12 +33,40 @@ void CFeatureDefHandler::Init(LuaParser* defsParser)
 	featureDefsVector.reserve(keys.size());
 	featureDefsVector.emplace_back();
 
+	std::vector<int> defIDs(keys.size(), 0);
+	std::vector<std::exception_ptr> parseErrors(keys.size());
+
+	// IDs are handed out up-front in key order, duplicates get none
 	for (unsigned int i = 0; i < keys.size(); i++) {
-		const std::string& nameMixedCase = keys[i];
-		const std::string& nameLowerCase = StringToLower(nameMixedCase);
-		const LuaTable& fdTable = rootTable.SubTable(nameMixedCase);
+		defIDs[i] = CreateFeatureDef(keys[i]);
+	}
+
+	const auto ParseDef = [&](const int i) {
+		if (defIDs[i] == 0)
+			return;
+
+		try {
+			ParseFeatureDef(featureDefsVector[defIDs[i]], rootTable.SubTable(keys[i]));
+		} catch (...) {
+			parseErrors[i] = std::current_exception();
+		}
+	};
+
+	if (rootTable.IsSnapshot()) {
+		for_mt(0, keys.size(), ParseDef);
+	} else {
+		for (unsigned int i = 0; i < keys.size(); i++) {
+			ParseDef(i);
+		}
+	}
+
+	for (unsigned int i = 0; i < keys.size(); i++) {
+		if (parseErrors[i] != nullptr)
+			std::rethrow_exception(parseErrors[i]);
+		if (defIDs[i] == 0)
+			continue;
 
-		AddFeatureDef(nameLowerCase, CreateFeatureDef(fdTable, nameLowerCase), false);
+		AddFeatureDef(StringToLower(keys[i]), &featureDefsVector[defIDs[i]], false);
 	}
 	for (unsigned int i = 0; i < keys.size(); i++) {
 		const std::string& nameMixedCase = keys[i];
@@ -61,7 +92,8 @@ void CFeatureDefHandler::AddFeatureDef(const std::string& name, FeatureDef* fd,
 	if (fd == nullptr)
 		return;
 
-	assert(featureDefIDs.find(name) == featureDefIDs.end());
+	// defs from FeatureDefs are registered by CreateFeatureDef
+	assert(featureDefIDs.find(name) == featureDefIDs.end() || featureDefIDs[name] == fd->id);
 
 	// generated trees, etc have no pieces
 	fd->collisionVolume.SetDefaultToPieceTree(fd->collisionVolume.DefaultToPieceTree() && !isDefaultFeature);
@@ -80,16 +112,22 @@ FeatureDef& CFeatureDefHandler::GetNewFeatureDef()
 }
 
 
-FeatureDef* CFeatureDefHandler::CreateFeatureDef(const LuaTable& fdTable, const std::string& mixedCase)
+int CFeatureDefHandler::CreateFeatureDef(const std::string& mixedCase)
 {
 	const std::string& name = StringToLower(mixedCase);
 
 	if (featureDefIDs.find(name) != featureDefIDs.end())
-		return nullptr;
+		return 0;
 
 	FeatureDef& fd = GetNewFeatureDef();
 
 	fd.name = name;
+
+	return (featureDefIDs[name] = fd.id);
+}
+
+void CFeatureDefHandler::ParseFeatureDef(FeatureDef& fd, const LuaTable& fdTable) const
+{
 	fd.description = fdTable.GetString("description", "");
 
 	fd.collidable    =  fdTable.GetBool("blocking",        true);
@@ -146,8 +184,6 @@ FeatureDef* CFeatureDefHandler::CreateFeatureDef(const LuaTable& fdTable, const
 
 	// custom parameters table
 	fdTable.SubTable("customParams").GetMap(fd.customParams);
-
-	return &fd;
 }
 
 
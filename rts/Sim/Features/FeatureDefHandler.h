@@ -48,7 +48,9 @@ private:
 
 	FeatureDef* CreateDefaultTreeFeatureDef(const std::string& name);
 	FeatureDef* CreateDefaultGeoFeatureDef(const std::string& name);
-	FeatureDef* CreateFeatureDef(const LuaTable& luaTable, const std::string& name);
+	int CreateFeatureDef(const std::string& name);
+
+	void ParseFeatureDef(FeatureDef& fd, const LuaTable& fdTable) const;
 
 	FeatureDef& GetNewFeatureDef();
 
@@ -12,6 +12,7 @@
 #include "System/creg/STL_Set.h"
 #include "System/EventHandler.h"
 #include "System/TimeProfiler.h"
+#include "System/Threading/ThreadPool.h" // for_mt
 
 /******************************************************************************/
 
@@ -64,21 +65,31 @@ void CFeatureHandler::LoadFeaturesFromMap()
 		return;
 
 	std::vector<MapFeatureInfo> mfi;
+	std::vector<FeatureLoadParams> featureParams;
+	std::vector<CFeature*> mapFeatures;
+
 	mfi.resize(numFeatures);
 	readMap->GetFeatureInfo(&mfi[0]);
 
+	featureParams.reserve(numFeatures);
+	mapFeatures.reserve(numFeatures);
+
 	for (int a = 0; a < numFeatures; ++a) {
 		const FeatureDef* def = featureDefHandler->GetFeatureDef(readMap->GetFeatureTypeName(mfi[a].featureType), true);
 
 		if (def == nullptr)
 			continue;
 
+		// models must be loaded before the state is initialized concurrently
+		if (def->drawType == DRAWTYPE_MODEL)
+			def->LoadModel();
+
 		FeatureLoadParams params = {
 			nullptr,
 			nullptr,
 			def,
 
-			float3(mfi[a].pos.x, CGround::GetHeightReal(mfi[a].pos.x, mfi[a].pos.z), mfi[a].pos.z),
+			float3(mfi[a].pos.x, 0.0f, mfi[a].pos.z), // y is set below
 			ZeroVector,
 
 			-1, // featureID
@@ -92,7 +103,28 @@ void CFeatureHandler::LoadFeaturesFromMap()
 			0, // smokeTime
 		};
 
-		LoadFeature(params);
+		featureParams.push_back(params);
+	}
+
+	// the pool is not thread-safe, allocate up front
+	featureMemPool.reserve(featureParams.size());
+	updateFeatures.reserve(updateFeatures.size() + featureParams.size());
+
+	for (size_t n = 0; n < featureParams.size(); n++) {
+		mapFeatures.push_back(featureMemPool.alloc<CFeature>());
+	}
+
+	// ground heights, transforms, models and volumes only depend on the feature itself
+	for_mt(0, featureParams.size(), [&](const int n) {
+		FeatureLoadParams& params = featureParams[n];
+
+		params.pos.y = CGround::GetHeightReal(params.pos.x, params.pos.z);
+		mapFeatures[n]->InitializeState(params);
+	});
+
+	// IDs are drawn from the synced pool, so register in map order
+	for (CFeature* feature: mapFeatures) {
+		feature->InitializeRegistration();
 	}
 }
 
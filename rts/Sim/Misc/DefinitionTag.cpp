@@ -242,13 +242,17 @@ void DefType::ReportUnknownTags(const std::string& instanceName, const LuaTable&
 }
 
 
+thread_local const LuaTable* DefType::luaTable = nullptr;
+
 void DefType::Load(void* instance, const LuaTable& luaTable)
 {
-	this->luaTable = &luaTable;
+	const LuaTable* prevLuaTable = DefType::luaTable;
+
+	DefType::luaTable = &luaTable;
 
 	for (unsigned int i = 0; i < defInitFuncCnt; i++) {
 		defInitFuncs[i](instance);
 	}
 
-	this->luaTable = nullptr;
+	DefType::luaTable = prevLuaTable;
 }
@@ -267,7 +267,9 @@ private:
 	unsigned int metaDataMemIdx = 0;
 
 	const char* name = nullptr;
-	const LuaTable* luaTable = nullptr;
+
+	// defs of the same type can be loaded by several threads at once
+	static thread_local const LuaTable* luaTable;
 
 private:
 	static std::vector<const DefType*>& GetTypes() {
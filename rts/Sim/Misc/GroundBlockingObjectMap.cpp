@@ -22,7 +22,8 @@ CR_BIND(CGroundBlockingObjectMap, )
 CR_REG_METADATA(CGroundBlockingObjectMap, (
 	CR_MEMBER(arrCells),
 	CR_MEMBER(vecCells),
-	CR_MEMBER(vecIndcs)
+	CR_MEMBER(vecIndcs),
+	CR_MEMBER(mobileObjCounts)
 ))
 
 
@@ -44,9 +45,14 @@ void CGroundBlockingObjectMap::AddGroundBlockingObject(CSolidObject* object)
 	const int xminSqr = bx, xmaxSqr = bx + sx;
 	const int zminSqr = bz, zmaxSqr = bz + sz;
 
+	const bool mobileObj = !IsStaticObject(object);
+
 	for (int zSqr = zminSqr; zSqr < zmaxSqr; zSqr++) {
 		for (int xSqr = xminSqr; xSqr < xmaxSqr; xSqr++) {
-			CellInsertUnique(zSqr * mapDims.mapx + xSqr, object);
+			const unsigned int sqr = zSqr * mapDims.mapx + xSqr;
+
+			if (CellInsertUnique(sqr, object))
+				mobileObjCounts[sqr] += mobileObj;
 		}
 	}
 
@@ -67,6 +73,8 @@ void CGroundBlockingObjectMap::AddGroundBlockingObject(CSolidObject* object, con
 	const int xminSqr = bx, xmaxSqr = bx + sx;
 	const int zminSqr = bz, zmaxSqr = bz + sz;
 
+	const bool mobileObj = !IsStaticObject(object);
+
 	for (int z = zminSqr; z < zmaxSqr; z++) {
 		for (int x = xminSqr; x < xmaxSqr; x++) {
 			// unit yardmaps always contain sx=UnitDef::xsize * sz=UnitDef::zsize
@@ -74,7 +82,10 @@ void CGroundBlockingObjectMap::AddGroundBlockingObject(CSolidObject* object, con
 			if ((object->GetGroundBlockingMaskAtPos({x * SQUARE_SIZE * 1.0f, 0.0f, z * SQUARE_SIZE * 1.0f}) & mask) == 0)
 				continue;
 
-			CellInsertUnique(z * mapDims.mapx + x, object);
+			const unsigned int sqr = z * mapDims.mapx + x;
+
+			if (CellInsertUnique(sqr, object))
+				mobileObjCounts[sqr] += mobileObj;
 		}
 	}
 
@@ -95,9 +106,14 @@ void CGroundBlockingObjectMap::RemoveGroundBlockingObject(CSolidObject* object)
 
 	object->ClearPhysicalStateBit(CSolidObject::PSTATE_BIT_BLOCKING);
 
+	const bool mobileObj = !IsStaticObject(object);
+
 	for (int z = bz; z < bz + sz; ++z) {
 		for (int x = bx; x < bx + sx; ++x) {
-			CellErase(z * mapDims.mapx + x, object);
+			const unsigned int sqr = z * mapDims.mapx + x;
+
+			if (CellErase(sqr, object))
+				mobileObjCounts[sqr] -= mobileObj;
 		}
 	}
 
@@ -3,6 +3,7 @@
 #ifndef GROUNDBLOCKINGOBJECTMAP_H
 #define GROUNDBLOCKINGOBJECTMAP_H
 
+#include <algorithm>
 #include <array>
 #include <vector>
 
@@ -99,6 +100,8 @@ public:
 
 	void Init(unsigned int numSquares) {
 		arrCells.resize(numSquares);
+		mobileObjCounts.clear();
+		mobileObjCounts.resize(numSquares, 0);
 		vecCells.reserve(32);
 		vecIndcs.reserve(32);
 
@@ -116,6 +119,8 @@ public:
 			v.clear();
 		}
 
+		std::fill(mobileObjCounts.begin(), mobileObjCounts.end(), 0);
+
 		vecIndcs.clear();
 	}
 
@@ -150,6 +155,14 @@ public:
 	bool GroundBlocked(int x, int z, const CSolidObject* ignoreObj) const;
 	bool GroundBlocked(const float3& pos, const CSolidObject* ignoreObj) const;
 
+	// static objects only enter or leave squares through Add/RemoveGroundBlockingObject
+	// (which raise TerrainChange events); whether they block can change at any time
+	static bool IsStaticObject(const CSolidObject* obj) { return (obj->immobile && obj->moveDef == nullptr); }
+
+	// number of non-static objects in a square, whose blocking-type
+	// can change at any time (e.g. when a unit stops or goes idle)
+	unsigned int GetNumMobileObjs(unsigned int mapSquare) const { return mobileObjCounts[mapSquare]; }
+
 	bool ObjectInCell(unsigned int mapSquare, const CSolidObject* obj) const {
 		if (mapSquare >= arrCells.size())
 			return false;
@@ -186,6 +199,7 @@ private:
 	std::vector<ArrCell> arrCells;
 	std::vector<VecCell> vecCells;
 	std::vector<uint32_t> vecIndcs;
+	std::vector<uint16_t> mobileObjCounts;
 };
 
 extern CGroundBlockingObjectMap groundBlockingObjectMap;
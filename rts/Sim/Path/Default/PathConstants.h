@@ -27,11 +27,21 @@ static const float MEDRES_SEARCH_DISTANCE_EXT = (MEDRES_SEARCH_DISTANCE * 0.4f)
 // how many recursive refinement attempts NextWayPoint should make
 static constexpr unsigned int MAX_PATH_REFINEMENT_DEPTH = 4;
 
-static constexpr unsigned int PATHESTIMATOR_VERSION = 100;
+static constexpr unsigned int PATHESTIMATOR_VERSION = 104;
 
 static constexpr unsigned int MEDRES_PE_BLOCKSIZE = 16;
 static constexpr unsigned int LOWRES_PE_BLOCKSIZE = 32;
 
+// flow-fields are only built once this many requests for the same
+// (goal-block, MoveDef) arrive within FLOWFIELD_REQUEST_WINDOW frames
+static constexpr unsigned int FLOWFIELD_MIN_REQUESTS = 8;
+static constexpr unsigned int MAX_FLOWFIELDS = 64;
+static constexpr int FLOWFIELD_REQUEST_WINDOW = GAME_SPEED;
+static constexpr int FLOWFIELD_CACHE_FRAMES = GAME_SPEED * 30;
+// fields only cover the blocks around their goal and the starts of the
+// requests that triggered them, extended by this many blocks on each side
+static constexpr int FLOWFIELD_BLOCK_MARGIN = 8;
+
 static constexpr unsigned int SQUARES_TO_UPDATE = 1000;
 static constexpr unsigned int MAX_SEARCHED_NODES_ON_REFINE = 2000;
 
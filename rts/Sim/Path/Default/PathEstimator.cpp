@@ -2,8 +2,6 @@
 
 #include "System/Platform/Win/win32.h"
 
-#include "minizip/zip.h"
-
 #include "PathEstimator.h"
 #include "PathFinder.h"
 #include "PathFinderDef.h"
@@ -20,8 +18,7 @@
 #include "System/Threading/ThreadPool.h" // for_mt
 #include "System/TimeProfiler.h"
 #include "System/Config/ConfigHandler.h"
-#include "System/FileSystem/Archives/IArchive.h"
-#include "System/FileSystem/ArchiveLoader.h"
+#include "System/FileSystem/CacheFile.h"
 #include "System/FileSystem/DataDirsAccess.h"
 #include "System/FileSystem/FileSystem.h"
 #include "System/FileSystem/FileQueryFlags.h"
@@ -44,7 +41,30 @@ static const std::string GetPathCacheDir() {
 }
 
 static const std::string GetCacheFileName(const std::string& fileHashCode, const std::string& peFileName, const std::string& mapFileName) {
-	return (GetPathCacheDir() + mapFileName + "." + peFileName + "-" + fileHashCode + ".zip");
+	return (GetPathCacheDir() + mapFileName + "." + peFileName + "-" + fileHashCode + ".bin");
+}
+
+
+// cache-file layout (native endianness, never compressed so it can be mapped):
+//   CCacheFile header (keyed by the PE's hash-code), CacheFileInfo
+//   short2 offsets[numPathTypes][numBlocks]
+//   float  costs[numPathTypes][numBlocks][PATH_DIRECTION_VERTICES] (same as vertexCosts)
+// the file hash covers the info too, so the stored pathChecksum can be trusted
+static constexpr char CACHE_FILE_MAGIC[8] = {'S', 'P', 'R', 'I', 'N', 'G', 'P', 'E'};
+
+struct CacheFileInfo {
+	std::uint32_t blockSize;
+	std::uint32_t numPathTypes;
+	std::uint32_t numBlocks;
+	std::uint32_t pathChecksum;
+};
+
+static size_t GetOffsetsSectionSize(size_t numPathTypes, size_t numBlocks) {
+	return (numPathTypes * numBlocks * sizeof(short2));
+}
+
+static size_t GetCostsSectionSize(size_t numPathTypes, size_t numBlocks) {
+	return (numPathTypes * numBlocks * PATH_DIRECTION_VERTICES * sizeof(float));
 }
 
 
@@ -200,6 +220,10 @@ void CPathEstimator::InitEstimator(const std::string& peFileName, const std::str
 		}
 
 
+		// calculate checksum over block-offsets and vertex-costs
+		// (stored in the cache-file, ReadFile restores it with them)
+		pathChecksum = CalcChecksum();
+
 		sprintf(calcMsg, fmtStrs[2], __func__, BLOCK_SIZE, peFileName.c_str(), fileHashCode);
 		loadscreen->SetLoadMessage(calcMsg, true);
 
@@ -209,9 +233,6 @@ void CPathEstimator::InitEstimator(const std::string& peFileName, const std::str
 		loadscreen->SetLoadMessage(calcMsg, true);
 	}
 
-	// calculate checksum over block-offsets and vertex-costs
-	pathChecksum = CalcChecksum();
-
 	// switch to runtime wanted IPathFinder (maybe PF or PE)
 	pfMemPool.free(pathFinders[0]);
 	pathFinders[0] = parentPathFinder;
@@ -948,57 +969,38 @@ bool CPathEstimator::ReadFile(const std::string& peFileName, const std::string&
 	if (!FileSystem::FileExists(cacheFileName))
 		return false;
 
-	std::unique_ptr<IArchive> upfile(archiveLoader.OpenArchive(dataDirsAccess.LocateFile(cacheFileName), "sdz"));
-
-	if (upfile == nullptr || !upfile->IsOpen()) {
-		FileSystem::Remove(cacheFileName);
-		return false;
-	}
+	const unsigned int numPathTypes = moveDefHandler.GetNumMoveDefs();
+	const unsigned int numBlocks = blockStates.GetSize();
 
 	char calcMsg[512];
 	sprintf(calcMsg, "Reading Estimate PathCosts [%d]", BLOCK_SIZE);
 	loadscreen->SetLoadMessage(calcMsg);
 
-	const unsigned fid = upfile->FindFile("pathinfo");
-	if (fid >= upfile->NumFiles()) {
-		FileSystem::Remove(cacheFileName);
-		return false;
-	}
-
-	std::vector<std::uint8_t> buffer;
+	CCacheFile cacheFile;
+	CacheFileInfo info;
 
-	if (!upfile->GetFile(fid, buffer) || buffer.size() < 4) {
-		FileSystem::Remove(cacheFileName);
-		return false;
-	}
-
-	const unsigned int filehash = *(reinterpret_cast<unsigned int*>(&buffer[0]));
-	const unsigned int blockSize = blockStates.GetSize() * sizeof(short2);
-	unsigned int pos = sizeof(unsigned);
-
-	if (filehash != fileHashCode) {
-		FileSystem::Remove(cacheFileName);
-		return false;
-	}
+	// verifies the whole file, a corrupted section could neither be
+	// recalculated later nor be caught by the stored checksum (desync)
+	if (!cacheFile.Open(dataDirsAccess.LocateFile(cacheFileName), CACHE_FILE_MAGIC, PATHESTIMATOR_VERSION, fileHashCode, info))
+		return (cacheFile.Remove());
+	if (info.blockSize != BLOCK_SIZE || info.numPathTypes != numPathTypes || info.numBlocks != numBlocks)
+		return (cacheFile.Remove());
+	if (cacheFile.GetDataSize() != (GetOffsetsSectionSize(numPathTypes, numBlocks) + GetCostsSectionSize(numPathTypes, numBlocks)))
+		return (cacheFile.Remove());
 
-	if (buffer.size() < (pos + blockSize * moveDefHandler.GetNumMoveDefs())) {
-		FileSystem::Remove(cacheFileName);
-		return false;
-	}
+	const std::uint8_t* offsetsData = cacheFile.GetData();
+	const std::uint8_t* costsData = offsetsData + GetOffsetsSectionSize(numPathTypes, numBlocks);
 
 	// read center-offset data
-	for (int pathType = 0; pathType < moveDefHandler.GetNumMoveDefs(); ++pathType) {
-		std::memcpy(&blockStates.peNodeOffsets[pathType][0], &buffer[pos], blockSize);
-		pos += blockSize;
+	for (unsigned int pathType = 0; pathType < numPathTypes; ++pathType) {
+		std::memcpy(&blockStates.peNodeOffsets[pathType][0], offsetsData + pathType * numBlocks * sizeof(short2), numBlocks * sizeof(short2));
 	}
 
 	// read vertex-cost data
-	if (buffer.size() < (pos + vertexCosts.size() * sizeof(float))) {
-		FileSystem::Remove(cacheFileName);
-		return false;
-	}
+	std::memcpy(&vertexCosts[0], costsData, vertexCosts.size() * sizeof(float));
 
-	std::memcpy(&vertexCosts[0], &buffer[pos], vertexCosts.size() * sizeof(float));
+	// the checksum was calculated over the same data when it was written
+	pathChecksum = info.pathChecksum;
 	return true;
 }
 
@@ -1017,39 +1019,33 @@ bool CPathEstimator::WriteFile(const std::string& peFileName, const std::string&
 
 	LOG("[PathEstimator::%s] hash=%s file=\"%s\" (exists=%d)", __func__, hashHexString.c_str(), cacheFileName.c_str(), FileSystem::FileExists(cacheFileName));
 
-	// open file for writing in a suitable location
-	zipFile file = zipOpen(dataDirsAccess.LocateFile(cacheFileName, FileQueryFlags::WRITE).c_str(), APPEND_STATUS_CREATE);
-
-	if (file == nullptr)
-		return false;
+	const unsigned int numPathTypes = moveDefHandler.GetNumMoveDefs();
+	const unsigned int numBlocks = blockStates.GetSize();
+	const unsigned int numCosts = numBlocks * PATH_DIRECTION_VERTICES;
 
-	zipOpenNewFileInZip(file, "pathinfo", nullptr, nullptr, 0, nullptr, 0, nullptr, Z_DEFLATED, Z_BEST_COMPRESSION);
+	const size_t offsetsSize = GetOffsetsSectionSize(numPathTypes, numBlocks);
 
-	// write hash-code (NOTE: this also affects the CRC!)
-	zipWriteInFileInZip(file, (const void*) &fileHashCode, 4);
+	std::vector<std::uint8_t> buffer(offsetsSize + GetCostsSectionSize(numPathTypes, numBlocks), 0);
 
 	// write center-offsets
-	for (int pathType = 0; pathType < moveDefHandler.GetNumMoveDefs(); ++pathType) {
-		zipWriteInFileInZip(file, (const void*) &blockStates.peNodeOffsets[pathType][0], blockStates.peNodeOffsets[pathType].size() * sizeof(short2));
+	for (unsigned int pathType = 0; pathType < numPathTypes; ++pathType) {
+		const std::vector<short2>& offsets = blockStates.peNodeOffsets[pathType];
+		std::memcpy(&buffer[pathType * numBlocks * sizeof(short2)], offsets.data(), offsets.size() * sizeof(short2));
 	}
 
 	// write vertex-costs
-	zipWriteInFileInZip(file, vertexCosts.data(), vertexCosts.size() * sizeof(float));
+	std::memcpy(&buffer[offsetsSize], vertexCosts.data(), vertexCosts.size() * sizeof(float));
 
-	zipCloseFileInZip(file);
-	zipClose(file, nullptr);
+	CacheFileInfo info;
 
+	info.blockSize = BLOCK_SIZE;
+	info.numPathTypes = numPathTypes;
+	info.numBlocks = numBlocks;
+	info.pathChecksum = pathChecksum;
 
-	// get the CRC over the written path data
-	std::unique_ptr<IArchive> upfile(archiveLoader.OpenArchive(dataDirsAccess.LocateFile(cacheFileName), "sdz"));
-
-	if (upfile == nullptr || !upfile->IsOpen()) {
-		FileSystem::Remove(cacheFileName);
-		return false;
-	}
-
-	assert(upfile->FindFile("pathinfo") < upfile->NumFiles());
-  return true;
+	// written to a temporary file first and renamed over the target, other
+	// processes might have the previous version mapped right now
+	return (CCacheFile::Write(dataDirsAccess.LocateFile(cacheFileName, FileQueryFlags::WRITE), CACHE_FILE_MAGIC, PATHESTIMATOR_VERSION, fileHashCode, info, buffer.data(), buffer.size()));
 }
 
 
@@ -9,6 +9,7 @@
 #include "PathHeatMap.hpp"
 #include "PathLog.h"
 #include "PathMemPool.h"
+#include "PathPassabilityMap.hpp"
 #include "Map/Ground.h"
 #include "Map/ReadMap.h"
 #include "Sim/MoveTypes/MoveDefHandler.h"
@@ -266,6 +267,10 @@ void CPathFinder::TestNeighborSquares(
 	const bool startSquareExpanded = (openBlocks.empty() && testedBlocks < 8);
 	const bool startSquareBlocked = (startSquareExpanded && (blockCheckFunc(moveDef, squarePos.x, squarePos.y, owner) & MMBT::BLOCK_STRUCTURE) != 0);
 
+	// cached object-bits are only valid for collider-less (e.g. PE) searches
+	const PathPassabilityMap* passMap = PathPassabilityMap::GetInstance();
+	const bool usePassMapBlocking = (owner == nullptr && passMap->IsInitialized());
+
 	// precompute structure-blocked state and speedmod for all neighbors
 	for (SquareState& sqState: ngbStates) {
 		const unsigned int dirIdx = &sqState - &ngbStates[0];
@@ -282,8 +287,23 @@ void CPathFinder::TestNeighborSquares(
 		if (blockStates.nodeMask[ngbSquareIdx] & (PATHOPT_CLOSED | PATHOPT_BLOCKED)) //FIXME
 			continue;
 
-		// IsBlockedNoSpeedModCheck; very expensive call but with a ~20% (?) chance of early-out
-		if ((sqState.blockMask = blockCheckFunc(moveDef, ngbSquareCoors.x, ngbSquareCoors.y, owner)) & MMBT::BLOCK_STRUCTURE) {
+		if (usePassMapBlocking) {
+			const std::uint8_t sqrState = passMap->GetSquareState(moveDef.pathType, ngbSquareIdx);
+
+			// only squares without any object under their footprint can skip
+			// the blocking-map; the cache knows where static objects are but
+			// not whether they currently block
+			if ((sqrState & PathPassabilityMap::SQUARE_STATIC_OBJS_BIT) != 0 || passMap->FootprintHasMobileObjs(moveDef, ngbSquareCoors.x, ngbSquareCoors.y)) {
+				sqState.blockMask = blockCheckFunc(moveDef, ngbSquareCoors.x, ngbSquareCoors.y, owner);
+			} else {
+				sqState.blockMask = MMBT::BLOCK_NONE;
+			}
+		} else {
+			// IsBlockedNoSpeedModCheck; very expensive call but with a ~20% (?) chance of early-out
+			sqState.blockMask = blockCheckFunc(moveDef, ngbSquareCoors.x, ngbSquareCoors.y, owner);
+		}
+
+		if (sqState.blockMask & MMBT::BLOCK_STRUCTURE) {
 			blockStates.nodeMask[ngbSquareIdx] |= PATHOPT_CLOSED;
 			dirtyBlocks.push_back(ngbSquareIdx);
 			continue;
@@ -300,7 +320,11 @@ void CPathFinder::TestNeighborSquares(
 			//
 			// only close node if search is directionally independent, since it
 			// might still be entered from another (better) direction otherwise
-			if ((sqState.speedMod = CMoveMath::GetPosSpeedMod(moveDef, ngbSquareCoors.x, ngbSquareCoors.y)) == 0.0f) {
+			sqState.speedMod = passMap->IsInitialized()?
+				passMap->GetSpeedMod(moveDef.pathType, ngbSquareCoors.x, ngbSquareCoors.y):
+				CMoveMath::GetPosSpeedMod(moveDef, ngbSquareCoors.x, ngbSquareCoors.y);
+
+			if (sqState.speedMod == 0.0f) {
 				blockStates.nodeMask[ngbSquareIdx] |= PATHOPT_CLOSED;
 				dirtyBlocks.push_back(ngbSquareIdx);
 			}
@@ -0,0 +1,270 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <functional>
+
+#include "PathFlowField.hpp"
+#include "PathConstants.h"
+#include "PathEstimator.h"
+#include "Sim/MoveTypes/MoveDefHandler.h"
+#include "Sim/MoveTypes/MoveMath/MoveMath.h"
+#include "System/SpringMath.h"
+
+
+void PathFlowField::Init(CPathEstimator* pe) {
+	pathEstimator = pe;
+
+	fields.clear();
+	fields.reserve(MAX_FLOWFIELDS);
+	requests.clear();
+	requests.reserve(64);
+
+	openBlocks.clear();
+	openBlocks.reserve(pe->GetNumBlocks().x * pe->GetNumBlocks().y);
+}
+
+void PathFlowField::Kill() {
+	pathEstimator = nullptr;
+
+	fields.clear();
+	requests.clear();
+	openBlocks.clear();
+	staleKeys.clear();
+}
+
+
+void PathFlowField::Update(int frameNum) {
+	// queued blocks will have their vertex costs (and offsets)
+	// recalculated, which may reroute any field computed over
+	// them; those can not be patched locally
+	for (const int2& block: pathEstimator->GetUpdatedBlocks()) {
+		if (fields.empty())
+			break;
+
+		Invalidate(block, block);
+	}
+
+	staleKeys.clear();
+
+	for (const auto& p: fields) {
+		if ((frameNum - p.second.lastUsedFrame) < FLOWFIELD_CACHE_FRAMES)
+			continue;
+
+		staleKeys.push_back(p.first);
+	}
+	for (const auto& p: requests) {
+		if ((frameNum - p.second.lastRequestFrame) < FLOWFIELD_REQUEST_WINDOW)
+			continue;
+
+		staleKeys.push_back(p.first);
+	}
+
+	// keys are unique per map, erasing a missing one is a no-op
+	for (const std::uint64_t key: staleKeys) {
+		fields.erase(key);
+		requests.erase(key);
+	}
+}
+
+
+void PathFlowField::MapChanged(unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2) {
+	const int blockSize = pathEstimator->GetBlockSize();
+
+	// same border as CPathEstimator::MapChanged
+	Invalidate({int(x1) / blockSize - 1, int(z1) / blockSize - 1}, {int(x2) / blockSize + 1, int(z2) / blockSize + 1});
+}
+
+void PathFlowField::Invalidate(const int2& minBlock, const int2& maxBlock) {
+	staleKeys.clear();
+
+	for (const auto& p: fields) {
+		if (!p.second.Overlaps(minBlock, maxBlock))
+			continue;
+
+		staleKeys.push_back(p.first);
+	}
+
+	for (const std::uint64_t key: staleKeys) {
+		fields.erase(key);
+	}
+}
+
+
+int2 PathFlowField::GetBlockPos(const float3& pos) const {
+	const int2 numBlocks = pathEstimator->GetNumBlocks();
+	const int blockSize = pathEstimator->GetBlockSize() * SQUARE_SIZE;
+
+	return {Clamp(int(pos.x / blockSize), 0, numBlocks.x - 1), Clamp(int(pos.z / blockSize), 0, numBlocks.y - 1)};
+}
+
+const PathFlowField::Field* PathFlowField::GetField(const MoveDef& moveDef, const float3& startPos, const float3& goalPos, int frameNum) {
+	const int2 strtBlock = GetBlockPos(startPos);
+	const int2 goalBlock = GetBlockPos(goalPos);
+	const std::uint64_t fieldKey = (std::uint64_t(moveDef.pathType) << 32) | pathEstimator->BlockPosToIdx(goalBlock);
+
+	const auto fit = fields.find(fieldKey);
+
+	if (fit != fields.end()) {
+		fit->second.lastUsedFrame = frameNum;
+		return &(fit->second);
+	}
+
+	{
+		RequestCounter& rc = requests[fieldKey];
+
+		// only count requests issued close together, e.g. by one group order
+		if ((frameNum - rc.lastRequestFrame) >= FLOWFIELD_REQUEST_WINDOW)
+			rc.numRequests = 0;
+		if (rc.numRequests == 0)
+			rc.minStartBlock = rc.maxStartBlock = strtBlock;
+
+		rc.lastRequestFrame = frameNum;
+		rc.minStartBlock = {std::min(rc.minStartBlock.x, strtBlock.x), std::min(rc.minStartBlock.y, strtBlock.y)};
+		rc.maxStartBlock = {std::max(rc.maxStartBlock.x, strtBlock.x), std::max(rc.maxStartBlock.y, strtBlock.y)};
+
+		if ((rc.numRequests += 1) < FLOWFIELD_MIN_REQUESTS)
+			return nullptr;
+		if (fields.size() >= MAX_FLOWFIELDS)
+			return nullptr;
+	}
+
+	const RequestCounter rc = requests[fieldKey];
+	const int2 numBlocks = pathEstimator->GetNumBlocks();
+
+	const int2 minBlock = {
+		std::max(std::min(rc.minStartBlock.x, goalBlock.x) - FLOWFIELD_BLOCK_MARGIN, 0),
+		std::max(std::min(rc.minStartBlock.y, goalBlock.y) - FLOWFIELD_BLOCK_MARGIN, 0),
+	};
+	const int2 maxBlock = {
+		std::min(std::max(rc.maxStartBlock.x, goalBlock.x) + FLOWFIELD_BLOCK_MARGIN, numBlocks.x - 1),
+		std::min(std::max(rc.maxStartBlock.y, goalBlock.y) + FLOWFIELD_BLOCK_MARGIN, numBlocks.y - 1),
+	};
+
+	// a field computed now would be dropped by the next Update
+	for (const int2& block: pathEstimator->GetUpdatedBlocks()) {
+		if (block.x >= minBlock.x && block.x <= maxBlock.x && block.y >= minBlock.y && block.y <= maxBlock.y)
+			return nullptr;
+	}
+
+	requests.erase(fieldKey);
+
+	Field& field = fields[fieldKey];
+	field.goalBlock = goalBlock;
+	field.minBlock = minBlock;
+	field.maxBlock = maxBlock;
+	field.pathType = moveDef.pathType;
+	field.lastUsedFrame = frameNum;
+
+	CalcField(field, moveDef);
+	return &field;
+}
+
+
+void PathFlowField::CalcField(Field& field, const MoveDef& moveDef) {
+	const int2 numBlocks = pathEstimator->GetNumBlocks();
+
+	const PathNodeStateBuffer& blockStates = pathEstimator->GetNodeStateBuffer();
+	const std::vector<short2>& nodeOffsets = blockStates.peNodeOffsets[moveDef.pathType];
+	const std::vector<float>& vertexCosts = pathEstimator->GetVertexCosts();
+
+	const unsigned int vertexBaseIdx = moveDef.pathType * numBlocks.x * numBlocks.y * PATH_DIRECTION_VERTICES;
+	const unsigned int goalBlockIdx = pathEstimator->BlockPosToIdx(field.goalBlock);
+
+	field.costs.clear();
+	field.costs.resize(numBlocks.x * numBlocks.y, PATHCOST_INFINITY);
+	field.dirs.clear();
+	field.dirs.resize(numBlocks.x * numBlocks.y, PATH_DIRECTIONS);
+	field.costs[goalBlockIdx] = 0.0f;
+
+	// plain Dijkstra outward from the goal, bounded by the field's
+	// blocks; ties are broken on the block index so the field is
+	// identical on every client
+	const auto heapCmp = std::greater< std::pair<float, unsigned int> >();
+
+	openBlocks.clear();
+	openBlocks.emplace_back(0.0f, goalBlockIdx);
+
+	while (!openBlocks.empty()) {
+		std::pop_heap(openBlocks.begin(), openBlocks.end(), heapCmp);
+
+		const std::pair<float, unsigned int> openBlock = openBlocks.back();
+		openBlocks.pop_back();
+
+		if (openBlock.first > field.costs[openBlock.second])
+			continue;
+
+		const int2 openBlockPos = pathEstimator->BlockIdxToPos(openBlock.second);
+		const short2 openBlockSquare = nodeOffsets[openBlock.second];
+
+		// units flowing into this block pay its extra-cost, as in PE::TestBlock
+		// (clamped since Dijkstra can not handle negative edge weights)
+		const float extraCost = std::max(0.0f, blockStates.GetNodeExtraCost(openBlockSquare.x, openBlockSquare.y, true));
+
+		for (unsigned int pathDir = 0; pathDir < PATH_DIRECTIONS; pathDir++) {
+			const int2 ngbBlockPos = openBlockPos + PE_DIRECTION_VECTORS[pathDir];
+
+			if (ngbBlockPos.x < field.minBlock.x || ngbBlockPos.x > field.maxBlock.x)
+				continue;
+			if (ngbBlockPos.y < field.minBlock.y || ngbBlockPos.y > field.maxBlock.y)
+				continue;
+
+			// vertex costs are bi-directional, so the edge leaving the
+			// open block also prices the move from neighbor back into it
+			const unsigned int vertexCostIdx =
+				vertexBaseIdx +
+				openBlock.second * PATH_DIRECTION_VERTICES +
+				GetBlockVertexOffset(pathDir, numBlocks.x);
+			const float vertexCost = vertexCosts[vertexCostIdx];
+
+			if (vertexCost >= PATHCOST_INFINITY)
+				continue;
+
+			const unsigned int ngbBlockIdx = pathEstimator->BlockPosToIdx(ngbBlockPos);
+			const float ngbBlockCost = openBlock.first + vertexCost + extraCost;
+
+			if (ngbBlockCost >= field.costs[ngbBlockIdx])
+				continue;
+
+			field.costs[ngbBlockIdx] = ngbBlockCost;
+			field.dirs[ngbBlockIdx] = (pathDir + PATH_DIRECTION_VERTICES) % PATH_DIRECTIONS;
+
+			openBlocks.emplace_back(ngbBlockCost, ngbBlockIdx);
+			std::push_heap(openBlocks.begin(), openBlocks.end(), heapCmp);
+		}
+	}
+}
+
+
+bool PathFlowField::GetPath(const Field& field, const MoveDef& moveDef, const float3& startPos, IPath::Path& path) const {
+	const std::vector<short2>& nodeOffsets = pathEstimator->GetNodeStateBuffer().peNodeOffsets[moveDef.pathType];
+
+	const unsigned int strtBlockIdx = pathEstimator->BlockPosToIdx(GetBlockPos(startPos));
+	const unsigned int goalBlockIdx = pathEstimator->BlockPosToIdx(field.goalBlock);
+
+	if (field.costs[strtBlockIdx] >= PATHCOST_INFINITY)
+		return false;
+
+	path.path.clear();
+	path.squares.clear();
+
+	// directions form a tree rooted at the goal-block, so this terminates
+	for (unsigned int blockIdx = strtBlockIdx; ; ) {
+		const short2 square = nodeOffsets[blockIdx];
+
+		path.path.emplace_back(square.x * SQUARE_SIZE, CMoveMath::yLevel(moveDef, square.x, square.y), square.y * SQUARE_SIZE);
+
+		if (blockIdx == goalBlockIdx)
+			break;
+
+		assert(field.dirs[blockIdx] < PATH_DIRECTIONS);
+		blockIdx = pathEstimator->BlockPosToIdx(pathEstimator->BlockIdxToPos(blockIdx) + PE_DIRECTION_VECTORS[field.dirs[blockIdx]]);
+	}
+
+	// estimator paths run from goal (front) to start (back)
+	std::reverse(path.path.begin(), path.path.end());
+
+	path.pathGoal = path.path[0];
+	path.pathCost = field.costs[strtBlockIdx];
+	return true;
+}
+
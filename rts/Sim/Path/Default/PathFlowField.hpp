@@ -0,0 +1,105 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef PATH_FLOWFIELD_HDR
+#define PATH_FLOWFIELD_HDR
+
+#include <cinttypes>
+#include <utility>
+#include <vector>
+
+#include "IPath.h"
+#include "System/type2.h"
+#include "System/float3.h"
+#include "System/UnorderedMap.hpp"
+
+struct MoveDef;
+class CPathEstimator;
+
+// shared per-(goal, MoveDef) integration and direction fields over
+// the block-grid of an estimator; lets large groups moving to the
+// same spot walk one precomputed field instead of each running A*
+class PathFlowField {
+public:
+	struct Field {
+		// integrated cost from each block to the goal-block
+		std::vector<float> costs;
+		// PATHDIR_* index of the next block towards the goal,
+		// PATH_DIRECTIONS for the goal and unreachable blocks
+		std::vector<std::uint8_t> dirs;
+
+		int2 goalBlock;
+		// blocks the field was computed over (inclusive); it only
+		// depends on the costs of these and is infinite elsewhere
+		int2 minBlock;
+		int2 maxBlock;
+
+		unsigned int pathType = -1u;
+		int lastUsedFrame = 0;
+
+		bool Overlaps(const int2& mins, const int2& maxs) const {
+			return (mins.x <= maxBlock.x && maxs.x >= minBlock.x && mins.y <= maxBlock.y && maxs.y >= minBlock.y);
+		}
+	};
+
+	void Init(CPathEstimator* pe);
+	void Kill();
+
+	/**
+	 * called every frame; evicts fields that were not sampled
+	 * for a while and drops those over blocks whose PE costs
+	 * are queued to change
+	 */
+	void Update(int frameNum);
+	/// drops the fields over any of the blocks affected by a change to squares [x1, x2] x [z1, z2]
+	void MapChanged(unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2);
+	/// drops the fields over any block in [minBlock, maxBlock]
+	void Invalidate(const int2& minBlock, const int2& maxBlock);
+
+	/**
+	 * Returns the field towards the block containing goalPos,
+	 * or nullptr if too few requests for it were made within
+	 * FLOWFIELD_REQUEST_WINDOW frames to be worth computing.
+	 * The field covers the start-blocks of those requests, so
+	 * it might not contain startPos for later ones.
+	 */
+	const Field* GetField(const MoveDef& moveDef, const float3& startPos, const float3& goalPos, int frameNum);
+
+	/**
+	 * Follows a field's directions from the block containing
+	 * startPos to its goal-block; path is stored in estimator
+	 * order (goal first, start last). Returns false if startPos
+	 * can not reach the goal.
+	 */
+	bool GetPath(const Field& field, const MoveDef& moveDef, const float3& startPos, IPath::Path& path) const;
+
+	unsigned int GetNumFields() const { return (fields.size()); }
+
+private:
+	struct RequestCounter {
+		int lastRequestFrame = 0;
+		unsigned int numRequests = 0;
+
+		// bounds of the start-blocks of the counted requests
+		int2 minStartBlock;
+		int2 maxStartBlock;
+	};
+
+	int2 GetBlockPos(const float3& pos) const;
+
+	void CalcField(Field& field, const MoveDef& moveDef);
+
+private:
+	friend class PathFlowFieldTests;
+
+	CPathEstimator* pathEstimator = nullptr;
+
+	spring::unordered_map<std::uint64_t, Field> fields;
+	spring::unordered_map<std::uint64_t, RequestCounter> requests;
+
+	// scratch; (cost, blockIdx) min-heap for CalcField and eviction keys for Update
+	std::vector< std::pair<float, unsigned int> > openBlocks;
+	std::vector<std::uint64_t> staleKeys;
+};
+
+#endif
+
@@ -4,11 +4,14 @@
 #include "PathConstants.h"
 #include "PathFinder.h"
 #include "PathEstimator.h"
+#include "PathFlowField.hpp"
 #include "PathFlowMap.hpp"
 #include "PathHeatMap.hpp"
 #include "PathLog.h"
 #include "PathMemPool.h"
+#include "PathPassabilityMap.hpp"
 #include "Map/MapInfo.h"
+#include "Sim/Misc/GlobalSynced.h"
 #include "Sim/Misc/ModInfo.h"
 #include "Sim/Objects/SolidObject.h"
 #include "Sim/MoveTypes/MoveDefHandler.h"
@@ -19,6 +22,7 @@
 static CPathFinder    gMaxResPF;
 static CPathEstimator gMedResPE;
 static CPathEstimator gLowResPE;
+static PathFlowField  gFlowField;
 
 
 CPathManager::CPathManager()
@@ -26,6 +30,7 @@ CPathManager::CPathManager()
 , medResPE(nullptr)
 , lowResPE(nullptr)
 , pathFlowMap(nullptr)
+, pathFlowField(nullptr)
 , pathHeatMap(nullptr)
 , nextPathID(0)
 {
@@ -46,6 +51,7 @@ CPathManager::~CPathManager()
 {
 	// Finalize is not called in case of forced exit
 	if (maxResPF != nullptr) {
+		pathFlowField->Kill();
 		lowResPE->Kill();
 		medResPE->Kill();
 		maxResPF->Kill();
@@ -53,8 +59,11 @@ CPathManager::~CPathManager()
 		maxResPF = nullptr;
 		medResPE = nullptr;
 		lowResPE = nullptr;
+
+		pathFlowField = nullptr;
 	}
 
+	PathPassabilityMap::FreeInstance(PathPassabilityMap::GetInstance());
 	PathHeatMap::FreeInstance(pathHeatMap);
 	PathFlowMap::FreeInstance(pathFlowMap);
 	IPathFinder::KillStatic();
@@ -81,10 +90,17 @@ std::int64_t CPathManager::Finalize() {
 		medResPE = &gMedResPE;
 		lowResPE = &gLowResPE;
 
+		// must be ready before the PE's compute their vertex costs
+		PathPassabilityMap::GetInstance()->Init();
+
 		// maxResPF only runs on the main thread, so can be unsafe
 		maxResPF->Init(false);
 		medResPE->Init(maxResPF, MEDRES_PE_BLOCKSIZE, "pe" , mapInfo->map.name);
 		lowResPE->Init(medResPE, LOWRES_PE_BLOCKSIZE, "pe2", mapInfo->map.name);
+
+		// flow-fields are built over the med-res block grid
+		pathFlowField = &gFlowField;
+		pathFlowField->Init(medResPE);
 	}
 
 	const spring_time dt = spring_gettime() - t0;
@@ -414,6 +430,66 @@ unsigned int CPathManager::RequestPath(
 }
 
 
+/*
+Serve a request from the flow-field towards goalPos if enough units share
+that goal, otherwise (or if startPos can not reach it) fall back to A*.
+The field walk stands in for the med-res search; max-res refinement and
+NextWayPoint then treat the path like any other.
+*/
+unsigned int CPathManager::RequestFlowPath(
+	CSolidObject* caller,
+	const MoveDef* moveDef,
+	float3 startPos,
+	float3 goalPos,
+	float goalRadius,
+	bool synced
+) {
+	if (!IsFinalized())
+		return 0;
+
+	// short paths gain nothing from a shared field, and unsynced
+	// requests must not touch the (synced) field cache
+	if (!synced || startPos.SqDistance2D(goalPos) <= Square(MEDRES_SEARCH_DISTANCE * SQUARE_SIZE))
+		return (RequestPath(caller, moveDef, startPos, goalPos, goalRadius, synced));
+
+	SCOPED_TIMER("Misc::Path::RequestFlowPath");
+	startPos.ClampInBounds();
+	goalPos.ClampInBounds();
+
+	assert(moveDef == moveDefHandler.GetMoveDefByPathType(moveDef->pathType));
+
+	const PathFlowField::Field* flowField = pathFlowField->GetField(*moveDef, startPos, goalPos, gs->frameNum);
+
+	if (flowField == nullptr)
+		return (RequestPath(caller, moveDef, startPos, goalPos, goalRadius, synced));
+
+	goalRadius = std::max<float>(goalRadius, PATH_NODE_SPACING * SQUARE_SIZE);
+
+	MultiPath newPath = MultiPath(moveDef, startPos, goalPos, goalRadius);
+	newPath.finalGoal = goalPos;
+	newPath.caller = caller;
+	newPath.peDef.synced = synced;
+
+	if (!pathFlowField->GetPath(*flowField, *moveDef, startPos, newPath.medResPath))
+		return (RequestPath(caller, moveDef, startPos, goalPos, goalRadius, synced));
+
+	if (caller != nullptr)
+		caller->UnBlock();
+
+	MedRes2MaxRes(newPath, startPos, caller, synced);
+	FinalizePath(&newPath, startPos, goalPos, false);
+
+	newPath.searchResult = IPath::Ok;
+
+	const unsigned int pathID = Store(newPath);
+
+	if (caller != nullptr)
+		caller->Block();
+
+	return pathID;
+}
+
+
 // converts part of a med-res path into a max-res path
 void CPathManager::MedRes2MaxRes(MultiPath& multiPath, const float3& startPos, const CSolidObject* owner, bool synced) const
 {
@@ -600,11 +676,14 @@ float3 CPathManager::NextWayPoint(
 
 
 // Tells estimators about changes in or on the map.
-void CPathManager::TerrainChange(unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2, unsigned int /*type*/) {
+void CPathManager::TerrainChange(unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2, unsigned int type) {
 	if (!IsFinalized())
 		return;
 
+	PathPassabilityMap::GetInstance()->TerrainChange(x1, z1, x2, z2, type);
+
 	medResPE->MapChanged(x1, z1, x2, z2);
+	pathFlowField->MapChanged(x1, z1, x2, z2);
 
 	// low-res PE will be informed via (medRes)PE::Update
 	if (true && medResPE->nextPathEstimator != nullptr)
@@ -623,6 +702,10 @@ void CPathManager::Update()
 	pathFlowMap->Update();
 	pathHeatMap->Update();
 
+	// must precede the PE update: any queued blocks get their costs
+	// changed by it, which invalidates fields computed before that
+	pathFlowField->Update(gs->frameNum);
+
 	medResPE->Update();
 	lowResPE->Update();
 }
@@ -14,6 +14,7 @@ class CSolidObject;
 class CPathFinder;
 class CPathEstimator;
 class PathFlowMap;
+class PathFlowField;
 class PathHeatMap;
 class CPathFinderDef;
 struct MoveDef;
@@ -115,6 +116,15 @@ public:
 		bool synced
 	) override;
 
+	unsigned int RequestFlowPath(
+		CSolidObject* caller,
+		const MoveDef* moveDef,
+		float3 startPos,
+		float3 goalPos,
+		float goalRadius,
+		bool synced
+	) override;
+
 	/**
 	 * Returns waypoints of the max-resolution path segments.
 	 * @param pathID
@@ -151,6 +161,7 @@ public:
 	const CPathEstimator* GetLowResPE() const { return lowResPE; }
 
 	const PathFlowMap* GetPathFlowMap() const { return pathFlowMap; }
+	const PathFlowField* GetPathFlowField() const { return pathFlowField; }
 	const PathHeatMap* GetPathHeatMap() const { return pathHeatMap; }
 
 	const spring::unordered_map<unsigned int, MultiPath>& GetPathMap() const { return pathMap; }
@@ -192,6 +203,7 @@ private:
 	CPathEstimator* lowResPE;
 
 	PathFlowMap* pathFlowMap;
+	PathFlowField* pathFlowField;
 	PathHeatMap* pathHeatMap;
 
 	spring::unordered_map<unsigned int, MultiPath> pathMap;
@@ -0,0 +1,150 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+
+#include "PathPassabilityMap.hpp"
+#include "Map/ReadMap.h"
+#include "Sim/Misc/GroundBlockingObjectMap.h"
+#include "Sim/MoveTypes/MoveDefHandler.h"
+#include "Sim/MoveTypes/MoveMath/MoveMath.h"
+#include "System/SpringMath.h"
+#include "System/Threading/ThreadPool.h"
+
+// must match the footprint sampling in CMoveMath::IsBlockedNoSpeedModCheck
+static constexpr int FOOTPRINT_XSTEP = 2;
+static constexpr int FOOTPRINT_ZSTEP = 2;
+
+// not extern'ed, so static
+static PathPassabilityMap gPathPassabilityMap;
+
+
+PathPassabilityMap* PathPassabilityMap::GetInstance() {
+	return &gPathPassabilityMap;
+}
+
+void PathPassabilityMap::FreeInstance(PathPassabilityMap* ppm) {
+	assert(ppm == &gPathPassabilityMap);
+	ppm->Kill();
+}
+
+
+
+void PathPassabilityMap::Init() {
+	const unsigned int numMoveDefs = moveDefHandler.GetNumMoveDefs();
+
+	squareStates.resize(numMoveDefs);
+	speedMods.resize(numMoveDefs);
+	speedModStride = mapDims.hmapx;
+
+	for_mt(0, numMoveDefs, [&](const int i) {
+		const MoveDef* md = moveDefHandler.GetMoveDefByPathType(i);
+
+		squareStates[i].clear();
+		squareStates[i].resize(mapDims.mapSquares, 0);
+		speedMods[i].clear();
+		speedMods[i].resize(mapDims.hmapx * mapDims.hmapy, 0.0f);
+
+		UpdateSpeedMods(*md, 0, 0, mapDims.mapx - 1, mapDims.mapy - 1);
+		UpdateStaticObjBits(*md, 0, 0, mapDims.mapx - 1, mapDims.mapy - 1);
+	});
+}
+
+void PathPassabilityMap::Kill() {
+	squareStates.clear();
+	speedMods.clear();
+}
+
+
+void PathPassabilityMap::TerrainChange(unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2, unsigned int type) {
+	if (!IsInitialized())
+		return;
+
+	for (unsigned int i = 0, n = moveDefHandler.GetNumMoveDefs(); i < n; i++) {
+		const MoveDef* md = moveDefHandler.GetMoveDefByPathType(i);
+
+		switch (type) {
+			case TERRAINCHANGE_OBJECT_INSERTED:
+			case TERRAINCHANGE_OBJECT_INSERTED_YM:
+			case TERRAINCHANGE_OBJECT_DELETED: {
+				// every square whose footprint overlaps the changed area
+				UpdateStaticObjBits(*md, int(x1) - md->xsizeh, int(z1) - md->zsizeh, int(x2) + md->xsizeh, int(z2) + md->zsizeh);
+			} break;
+			default: {
+				// slopes depend on neighboring heights
+				UpdateSpeedMods(*md, int(x1) - 2, int(z1) - 2, int(x2) + 2, int(z2) + 2);
+			} break;
+		}
+	}
+}
+
+
+bool PathPassabilityMap::FootprintHasMobileObjs(const MoveDef& moveDef, int xSquare, int zSquare) const {
+	const int xmin = std::max(xSquare - moveDef.xsizeh,                0);
+	const int zmin = std::max(zSquare - moveDef.zsizeh,                0);
+	const int xmax = std::min(xSquare + moveDef.xsizeh, mapDims.mapx - 1);
+	const int zmax = std::min(zSquare + moveDef.zsizeh, mapDims.mapy - 1);
+
+	for (int z = zmin; z <= zmax; z += FOOTPRINT_ZSTEP) {
+		for (int x = xmin; x <= xmax; x += FOOTPRINT_XSTEP) {
+			if (groundBlockingObjectMap.GetNumMobileObjs(z * mapDims.mapx + x) != 0)
+				return true;
+		}
+	}
+
+	return false;
+}
+
+
+void PathPassabilityMap::UpdateSpeedMods(const MoveDef& moveDef, int x1, int z1, int x2, int z2) {
+	std::vector<float>& mods = speedMods[moveDef.pathType];
+
+	// one value per heightmap square, each covers 2x2 map squares
+	x1 = Clamp(x1, 0, mapDims.mapx - 1) >> 1;
+	z1 = Clamp(z1, 0, mapDims.mapy - 1) >> 1;
+	x2 = Clamp(x2, 0, mapDims.mapx - 1) >> 1;
+	z2 = Clamp(z2, 0, mapDims.mapy - 1) >> 1;
+
+	for (int z = z1; z <= z2; z++) {
+		for (int x = x1; x <= x2; x++) {
+			mods[z * mapDims.hmapx + x] = CMoveMath::GetPosSpeedMod(moveDef, x << 1, z << 1);
+		}
+	}
+}
+
+void PathPassabilityMap::UpdateStaticObjBits(const MoveDef& moveDef, int x1, int z1, int x2, int z2) {
+	std::vector<std::uint8_t>& states = squareStates[moveDef.pathType];
+
+	x1 = Clamp(x1, 0, mapDims.mapx - 1);
+	z1 = Clamp(z1, 0, mapDims.mapy - 1);
+	x2 = Clamp(x2, 0, mapDims.mapx - 1);
+	z2 = Clamp(z2, 0, mapDims.mapy - 1);
+
+	const auto FootprintHasStaticObjs = [&](int xSquare, int zSquare) {
+		const int xmin = std::max(xSquare - moveDef.xsizeh,                0);
+		const int zmin = std::max(zSquare - moveDef.zsizeh,                0);
+		const int xmax = std::min(xSquare + moveDef.xsizeh, mapDims.mapx - 1);
+		const int zmax = std::min(zSquare + moveDef.zsizeh, mapDims.mapy - 1);
+
+		for (int z = zmin; z <= zmax; z += FOOTPRINT_ZSTEP) {
+			for (int x = xmin; x <= xmax; x += FOOTPRINT_XSTEP) {
+				const unsigned int sqr = z * mapDims.mapx + x;
+
+				// every object in a cell that is not counted as mobile is static
+				if (groundBlockingObjectMap.GetCellUnsafeConst(sqr).size() != groundBlockingObjectMap.GetNumMobileObjs(sqr))
+					return true;
+			}
+		}
+
+		return false;
+	};
+
+	for (int z = z1; z <= z2; z++) {
+		for (int x = x1; x <= x2; x++) {
+			std::uint8_t& state = states[z * mapDims.mapx + x];
+
+			state &= ~SQUARE_STATIC_OBJS_BIT;
+			state |= (SQUARE_STATIC_OBJS_BIT * FootprintHasStaticObjs(x, z));
+		}
+	}
+}
+
@@ -0,0 +1,63 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef PATH_PASSABILITYMAP_HDR
+#define PATH_PASSABILITYMAP_HDR
+
+#include <cinttypes>
+#include <vector>
+
+struct MoveDef;
+
+// per-MoveDef cache of the collider-independent parts of a square's
+// state, so the PF does not have to query the blocking-map and height/
+// slope/type-maps for every expanded square:
+//
+//   whether any static object (see CGroundBlockingObjectMap::IsStaticObject)
+//   overlaps the square's footprint; whether one actually blocks depends on
+//   object state (collidable-bits, crushability, height) that can change
+//   without a TerrainChange, so those squares still need the exact check
+//
+//   the positional speed-mod of every heightmap square (as returned by
+//   CMoveMath::GetPosSpeedMod, which is constant over 2x2 map squares)
+//
+// squares whose footprint overlaps any mobile object must likewise be
+// tested against the blocking-map (dynamic overlay)
+class PathPassabilityMap {
+public:
+	static constexpr std::uint8_t SQUARE_STATIC_OBJS_BIT = 0x01;
+
+	static PathPassabilityMap* GetInstance();
+	static void FreeInstance(PathPassabilityMap*);
+
+	void Init();
+	void Kill();
+
+	// called for every TerrainChange event (by CPathManager)
+	void TerrainChange(unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2, unsigned int type);
+
+	std::uint8_t GetSquareState(unsigned int pathType, unsigned int sqrIdx) const { return squareStates[pathType][sqrIdx]; }
+
+	float GetSpeedMod(unsigned int pathType, unsigned int xSquare, unsigned int zSquare) const {
+		return speedMods[pathType][(xSquare >> 1) + (zSquare >> 1) * speedModStride];
+	}
+
+	bool FootprintHasMobileObjs(const MoveDef& moveDef, int xSquare, int zSquare) const;
+
+	bool IsInitialized() const { return (!squareStates.empty()); }
+
+private:
+	void UpdateSpeedMods(const MoveDef& moveDef, int x1, int z1, int x2, int z2);
+	void UpdateStaticObjBits(const MoveDef& moveDef, int x1, int z1, int x2, int z2);
+
+private:
+	// [pathType][z * mapx + x]
+	std::vector< std::vector<std::uint8_t> > squareStates;
+	// [pathType][(z >> 1) * hmapx + (x >> 1)]
+	std::vector< std::vector<float> > speedMods;
+
+	// mapDims.hmapx
+	unsigned int speedModStride = 0;
+};
+
+#endif
+
@@ -144,6 +144,23 @@ public:
 		return 0;
 	}
 
+	/**
+	 * Same contract as RequestPath, but lets the manager serve the request
+	 * from a flow-field shared by every request towards the same goal (and
+	 * with the same MoveDef), e.g. when a large group is ordered to one spot.
+	 * Managers without flow-field support treat this as a regular request.
+	 */
+	virtual unsigned int RequestFlowPath(
+		CSolidObject* caller,
+		const MoveDef* moveDef,
+		float3 startPos,
+		float3 goalPos,
+		float goalRadius,
+		bool synced
+	) {
+		return (RequestPath(caller, moveDef, startPos, goalPos, goalRadius, synced));
+	}
+
 	/**
 	 * Whenever there are any changes in the terrain
 	 * (examples: explosions, new buildings, etc.)
@@ -20,43 +20,6 @@ unsigned int QTPFS::QTNode::MAX_DEPTH;
 
 
 
-void QTPFS::INode::SetPathCost(unsigned int type, float cost) {
-	#ifndef QTPFS_ENABLE_MICRO_OPTIMIZATION_HACKS
-	switch (type) {
-		case NODE_PATH_COST_F: { fCost = cost; return; } break;
-		case NODE_PATH_COST_G: { gCost = cost; return; } break;
-		case NODE_PATH_COST_H: { hCost = cost; return; } break;
-	}
-
-	assert(false);
-	#else
-	assert(&gCost == &fCost + 1);
-	assert(&hCost == &gCost + 1);
-	assert(type <= NODE_PATH_COST_H);
-
-	*(&fCost + type) = cost;
-	#endif
-}
-
-float QTPFS::INode::GetPathCost(unsigned int type) const {
-	#ifndef QTPFS_ENABLE_MICRO_OPTIMIZATION_HACKS
-	switch (type) {
-		case NODE_PATH_COST_F: { return fCost; } break;
-		case NODE_PATH_COST_G: { return gCost; } break;
-		case NODE_PATH_COST_H: { return hCost; } break;
-	}
-
-	assert(false);
-	return 0.0f;
-	#else
-	assert(&gCost == &fCost + 1);
-	assert(&hCost == &gCost + 1);
-	assert(type <= NODE_PATH_COST_H);
-
-	return *(&fCost + type);
-	#endif
-}
-
 float QTPFS::INode::GetDistance(const INode* n, unsigned int type) const {
 	const float dx = float(xmid() * SQUARE_SIZE) - float(n->xmid() * SQUARE_SIZE);
 	const float dz = float(zmid() * SQUARE_SIZE) - float(n->zmid() * SQUARE_SIZE);
@@ -198,9 +161,7 @@ void QTPFS::QTNode::Init(
 	assert(MIN_SIZE_Z > 0);
 
 	nodeNumber = nn;
-	heapIndex = -1u;
 
-	searchState  =   0;
 	currMagicNum =   0;
 	prevMagicNum = -1u;
 
@@ -215,29 +176,23 @@ void QTPFS::QTNode::Init(
 	assert(xsize() != 0);
 	assert(zsize() != 0);
 
-	fCost = 0.0f;
-	gCost = 0.0f;
-	hCost = 0.0f;
-
 	speedModSum =  0.0f;
 	speedModAvg =  0.0f;
 	moveCostAvg = -1.0f;
 
-	prevNode = nullptr;
-
-	neighbors.clear();
-	netpoints.clear();
+	// any previous range was released by Split or Merge
+	ngbsOffset = -1u;
+	ngbsClass = 0;
+	numNgbs = 0;
 }
 
 
 
 std::uint64_t QTPFS::QTNode::GetMemFootPrint(const NodeLayer& nl) const {
+	// neighbor-caches are accounted for by NodeLayer
 	std::uint64_t memFootPrint = sizeof(QTNode);
 
-	if (IsLeaf()) {
-		memFootPrint += (neighbors.size() * sizeof(decltype(neighbors)::value_type));
-		memFootPrint += (netpoints.size() * sizeof(decltype(netpoints)::value_type));
-	} else {
+	if (!IsLeaf()) {
 		for (unsigned int i = 0; i < QTNODE_CHILD_COUNT; i++) {
 			memFootPrint += (nl.GetPoolNode(childBaseIndex + i)->GetMemFootPrint(nl));
 		}
@@ -251,11 +206,11 @@ std::uint64_t QTPFS::QTNode::GetCheckSum(const NodeLayer& nl) const {
 
 	{
 		const unsigned char* minByte = reinterpret_cast<const unsigned char*>(&nodeNumber);
-		const unsigned char* maxByte = reinterpret_cast<const unsigned char*>(&hCost) + sizeof(hCost);
+		const unsigned char* maxByte = reinterpret_cast<const unsigned char*>(&nodeNumber) + sizeof(nodeNumber);
 
 		assert(minByte < maxByte);
 
-		// INode bytes (unpadded)
+		// INode bytes (unpadded); nodeIndex depends on pool allocation order
 		for (const unsigned char* byte = minByte; byte != maxByte; byte++) {
 			sum ^= ((((byte + 1) - minByte) << 8) * (*byte));
 		}
@@ -330,8 +285,7 @@ bool QTPFS::QTNode::Split(NodeLayer& nl, unsigned int depth, bool forced) {
 
 	childBaseIndex = childIndices[0];
 
-	neighbors.clear();
-	netpoints.clear();
+	ClearNeighborCache(nl);
 
 	nl.SetNumLeafNodes(nl.GetNumLeafNodes() + (4 - 1));
 	assert(!IsLeaf());
@@ -342,12 +296,10 @@ bool QTPFS::QTNode::Merge(NodeLayer& nl) {
 	if (IsLeaf())
 		return false;
 
-	neighbors.clear();
-	// netpoints.clear();
-
 	// get rid of our children completely
 	for (unsigned int i = 0; i < QTNODE_CHILD_COUNT; i++) {
 		nl.GetPoolNode(childBaseIndex + i)->Merge(nl);
+		nl.GetPoolNode(childBaseIndex + i)->ClearNeighborCache(nl);
 	}
 
 	// NOTE: return indices in reverse order (BL, BR, TR, TL) of allocation by Split
@@ -640,73 +592,85 @@ unsigned int QTPFS::QTNode::GetMaxNumNeighbors() const {
 
 
 
-void QTPFS::QTNode::Serialize(std::fstream& fStream, NodeLayer& nodeLayer, unsigned int* streamSize, unsigned int depth, bool readMode) {
-	// overwritten when de-serializing
-	unsigned int numChildren = QTNODE_CHILD_COUNT * (1 - int(IsLeaf()));
+void QTPFS::QTNode::Serialize(const NodeLayer& nl, std::vector<NodeTreeRecord>& records) const {
+	// explicit stack, children are pushed in reverse s.t. they are visited in NODE_IDX order
+	std::vector<const QTNode*> nodes(1, this);
 
-	(*streamSize) += (3 * sizeof(unsigned int));
-	(*streamSize) += (3 * sizeof(float));
+	while (!nodes.empty()) {
+		const QTNode* node = nodes.back();
 
-	if (readMode) {
-		fStream.read(reinterpret_cast<char*>(&nodeNumber), sizeof(unsigned int));
-		fStream.read(reinterpret_cast<char*>(&numChildren), sizeof(unsigned int));
-		fStream.read(reinterpret_cast<char*>(&childBaseIndex), sizeof(unsigned int));
+		nodes.pop_back();
+		records.push_back({node->nodeNumber, QTNODE_CHILD_COUNT * (1 - int(node->IsLeaf())), node->speedModSum, node->speedModAvg, node->moveCostAvg});
 
-		fStream.read(reinterpret_cast<char*>(&speedModAvg), sizeof(float));
-		fStream.read(reinterpret_cast<char*>(&speedModSum), sizeof(float));
-		fStream.read(reinterpret_cast<char*>(&moveCostAvg), sizeof(float));
+		if (node->IsLeaf())
+			continue;
 
-		if (numChildren > 0) {
-			// re-create child nodes
-			assert(IsLeaf());
-			Split(nodeLayer, depth, true);
-		} else {
-			// node was a leaf in an earlier life, register it
-			nodeLayer.RegisterNode(this);
+		for (unsigned int i = QTNODE_CHILD_COUNT; i > 0; i--) {
+			nodes.push_back(static_cast<const QTNode*>(nl.GetPoolNode(node->childBaseIndex + i - 1)));
 		}
-	} else {
-		fStream.write(reinterpret_cast<const char*>(&nodeNumber), sizeof(unsigned int));
-		fStream.write(reinterpret_cast<const char*>(&numChildren), sizeof(unsigned int));
-		fStream.write(reinterpret_cast<const char*>(&childBaseIndex), sizeof(unsigned int));
-
-		fStream.write(reinterpret_cast<const char*>(&speedModAvg), sizeof(float));
-		fStream.write(reinterpret_cast<const char*>(&speedModSum), sizeof(float));
-		fStream.write(reinterpret_cast<const char*>(&moveCostAvg), sizeof(float));
-	}
-
-	for (unsigned int i = 0; i < numChildren; i++) {
-		nodeLayer.GetPoolNode(childBaseIndex + i)->Serialize(fStream, nodeLayer, streamSize, depth + 1, readMode);
 	}
 }
 
-unsigned int QTPFS::QTNode::GetNeighbors(const std::vector<INode*>& nodes, std::vector<INode*>& ngbs) {
-	#ifdef QTPFS_CONSERVATIVE_NEIGHBOR_CACHE_UPDATES
-	UpdateNeighborCache(nodes);
-	#endif
+bool QTPFS::QTNode::Deserialize(NodeLayer& nl, const NodeTreeRecord* records, size_t numRecords) {
+	assert(IsLeaf());
+
+	std::vector<QTNode*> nodes(1, this);
+
+	size_t recordIdx = 0;
 
-	if (!neighbors.empty()) {
-		ngbs.clear();
-		ngbs.resize(neighbors.size());
+	while (!nodes.empty()) {
+		QTNode* node = nodes.back();
 
-		std::copy(neighbors.begin(), neighbors.end(), ngbs.begin());
+		nodes.pop_back();
+
+		if (recordIdx >= numRecords)
+			return false;
+
+		const NodeTreeRecord& record = records[recordIdx++];
+
+		// node-numbers are implied by the position in the tree
+		if (record.nodeNumber != node->nodeNumber)
+			return false;
+
+		node->speedModSum = record.speedModSum;
+		node->speedModAvg = record.speedModAvg;
+		node->moveCostAvg = record.moveCostAvg;
+
+		if (record.numChildren == 0) {
+			// node was a leaf in an earlier life, register it
+			nl.RegisterNode(node);
+			continue;
+		}
+
+		// re-create child nodes; allocated in the same order as by the recursive tesselation
+		if (record.numChildren != QTNODE_CHILD_COUNT || !node->Split(nl, 0, true))
+			return false;
+
+		for (unsigned int i = QTNODE_CHILD_COUNT; i > 0; i--) {
+			nodes.push_back(static_cast<QTNode*>(nl.GetPoolNode(node->childBaseIndex + i - 1)));
+		}
 	}
 
-	return (neighbors.size());
+	return (recordIdx == numRecords);
 }
 
-const std::vector<QTPFS::INode*>& QTPFS::QTNode::GetNeighbors(const std::vector<INode*>& nodes) {
+unsigned int QTPFS::QTNode::GetNeighbors(NodeLayer& nl) {
 	#ifdef QTPFS_CONSERVATIVE_NEIGHBOR_CACHE_UPDATES
-	UpdateNeighborCache(nodes);
+	UpdateNeighborCache(nl);
 	#endif
-	return neighbors;
+	return numNgbs;
+}
+
+void QTPFS::QTNode::ClearNeighborCache(NodeLayer& nl) {
+	nl.FreeNeighbors(ngbsOffset, ngbsClass);
+	numNgbs = 0;
 }
 
 // this is *either* called from ::GetNeighbors when the conservative
 // update-scheme is enabled, *or* from PM::ExecQueuedNodeLayerUpdates
 // (never both)
-bool QTPFS::QTNode::UpdateNeighborCache(const std::vector<INode*>& nodes) {
+bool QTPFS::QTNode::UpdateNeighborCache(NodeLayer& nl) {
 	assert(IsLeaf());
-	assert(!nodes.empty());
 
 	if (prevMagicNum != currMagicNum) {
 		prevMagicNum = currMagicNum;
@@ -714,32 +678,35 @@ bool QTPFS::QTNode::UpdateNeighborCache(const std::vector<INode*>& nodes) {
 		unsigned int ngbRels = 0;
 		unsigned int maxNgbs = GetMaxNumNeighbors();
 
-		// regenerate our neighbor cache
-		if (maxNgbs > 0) {
-			neighbors.clear();
-			neighbors.reserve(maxNgbs + 4);
+		// gathered here first, then copied into our range of the layer's arrays
+		std::vector<unsigned int>& neighbors = nl.GetNeighborsBuffer();
+		std::vector<float2>& netpoints = nl.GetNetpointsBuffer();
+
+		neighbors.clear();
+		netpoints.clear();
+
+		const auto AddNeighbor = [&](const INode* ngb) {
+			neighbors.push_back(ngb->GetNodeIndex());
 
-			netpoints.clear();
-			netpoints.reserve(1 + maxNgbs * QTPFS_MAX_NETPOINTS_PER_NODE_EDGE + 4);
 			// NOTE: caching ETP's breaks QTPFS_ORTHOPROJECTED_EDGE_TRANSITIONS
-			// NOTE: [0] is a reserved index and must always be valid
-			netpoints.emplace_back();
+			for (unsigned int i = 0; i < QTPFS_MAX_NETPOINTS_PER_NODE_EDGE; i++) {
+				netpoints.push_back(INode::GetNeighborEdgeTransitionPoint(ngb, {}, QTPFS_NETPOINT_EDGE_SPACING_SCALE * (i + 1)));
+			}
+		};
 
-			INode* ngb = nullptr;
+		// regenerate our neighbor cache
+		if (maxNgbs > 0) {
+			const INode* ngb = nullptr;
 
 			if (xmin() > 0) {
 				const unsigned int hmx = xmin() - 1;
 
 				// walk along EDGE_L (west) neighbors
 				for (unsigned int hmz = zmin(); hmz < zmax(); ) {
-					ngb = nodes[hmz * mapDims.mapx + hmx];
+					ngb = nl.GetNode(hmx, hmz);
 					hmz = ngb->zmax();
 
-					neighbors.push_back(ngb);
-
-					for (unsigned int i = 0; i < QTPFS_MAX_NETPOINTS_PER_NODE_EDGE; i++) {
-						netpoints.push_back(INode::GetNeighborEdgeTransitionPoint(ngb, {}, QTPFS_NETPOINT_EDGE_SPACING_SCALE * (i + 1)));
-					}
+					AddNeighbor(ngb);
 				}
 
 				ngbRels |= REL_NGB_EDGE_L;
@@ -749,14 +716,10 @@ bool QTPFS::QTNode::UpdateNeighborCache(const std::vector<INode*>& nodes) {
 
 				// walk along EDGE_R (east) neighbors
 				for (unsigned int hmz = zmin(); hmz < zmax(); ) {
-					ngb = nodes[hmz * mapDims.mapx + hmx];
+					ngb = nl.GetNode(hmx, hmz);
 					hmz = ngb->zmax();
 
-					neighbors.push_back(ngb);
-
-					for (unsigned int i = 0; i < QTPFS_MAX_NETPOINTS_PER_NODE_EDGE; i++) {
-						netpoints.push_back(INode::GetNeighborEdgeTransitionPoint(ngb, {}, QTPFS_NETPOINT_EDGE_SPACING_SCALE * (i + 1)));
-					}
+					AddNeighbor(ngb);
 				}
 
 				ngbRels |= REL_NGB_EDGE_R;
@@ -767,14 +730,10 @@ bool QTPFS::QTNode::UpdateNeighborCache(const std::vector<INode*>& nodes) {
 
 				// walk along EDGE_T (north) neighbors
 				for (unsigned int hmx = xmin(); hmx < xmax(); ) {
-					ngb = nodes[hmz * mapDims.mapx + hmx];
+					ngb = nl.GetNode(hmx, hmz);
 					hmx = ngb->xmax();
 
-					neighbors.push_back(ngb);
-
-					for (unsigned int i = 0; i < QTPFS_MAX_NETPOINTS_PER_NODE_EDGE; i++) {
-						netpoints.push_back(INode::GetNeighborEdgeTransitionPoint(ngb, {}, QTPFS_NETPOINT_EDGE_SPACING_SCALE * (i + 1)));
-					}
+					AddNeighbor(ngb);
 				}
 
 				ngbRels |= REL_NGB_EDGE_T;
@@ -784,14 +743,10 @@ bool QTPFS::QTNode::UpdateNeighborCache(const std::vector<INode*>& nodes) {
 
 				// walk along EDGE_B (south) neighbors
 				for (unsigned int hmx = xmin(); hmx < xmax(); ) {
-					ngb = nodes[hmz * mapDims.mapx + hmx];
+					ngb = nl.GetNode(hmx, hmz);
 					hmx = ngb->xmax();
 
-					neighbors.push_back(ngb);
-
-					for (unsigned int i = 0; i < QTPFS_MAX_NETPOINTS_PER_NODE_EDGE; i++) {
-						netpoints.push_back(INode::GetNeighborEdgeTransitionPoint(ngb, {}, QTPFS_NETPOINT_EDGE_SPACING_SCALE * (i + 1)));
-					}
+					AddNeighbor(ngb);
 				}
 
 				ngbRels |= REL_NGB_EDGE_B;
@@ -801,34 +756,26 @@ bool QTPFS::QTNode::UpdateNeighborCache(const std::vector<INode*>& nodes) {
 			// top- and bottom-left corners
 			if ((ngbRels & REL_NGB_EDGE_L) != 0) {
 				if ((ngbRels & REL_NGB_EDGE_T) != 0) {
-					const INode* ngbL = nodes[(zmin() + 0) * mapDims.mapx + (xmin() - 1)];
-					const INode* ngbT = nodes[(zmin() - 1) * mapDims.mapx + (xmin() + 0)];
-						  INode* ngbC = nodes[(zmin() - 1) * mapDims.mapx + (xmin() - 1)];
+					const INode* ngbL = nl.GetNode(xmin() - 1, zmin() + 0);
+					const INode* ngbT = nl.GetNode(xmin() + 0, zmin() - 1);
+					const INode* ngbC = nl.GetNode(xmin() - 1, zmin() - 1);
 
 					// VERT_TL ngb must be distinct from EDGE_L and EDGE_T ngbs
 					if (ngbC != ngbL && ngbC != ngbT) {
 						if (ngbL->AllSquaresAccessible() && ngbT->AllSquaresAccessible()) {
-							neighbors.push_back(ngbC);
-
-							for (unsigned int i = 0; i < QTPFS_MAX_NETPOINTS_PER_NODE_EDGE; i++) {
-								netpoints.push_back(INode::GetNeighborEdgeTransitionPoint(ngbC, {}, QTPFS_NETPOINT_EDGE_SPACING_SCALE * (i + 1)));
-							}
+							AddNeighbor(ngbC);
 						}
 					}
 				}
 				if ((ngbRels & REL_NGB_EDGE_B) != 0) {
-					const INode* ngbL = nodes[(zmax() - 1) * mapDims.mapx + (xmin() - 1)];
-					const INode* ngbB = nodes[(zmax() + 0) * mapDims.mapx + (xmin() + 0)];
-						  INode* ngbC = nodes[(zmax() + 0) * mapDims.mapx + (xmin() - 1)];
+					const INode* ngbL = nl.GetNode(xmin() - 1, zmax() - 1);
+					const INode* ngbB = nl.GetNode(xmin() + 0, zmax() + 0);
+					const INode* ngbC = nl.GetNode(xmin() - 1, zmax() + 0);
 
 					// VERT_BL ngb must be distinct from EDGE_L and EDGE_B ngbs
 					if (ngbC != ngbL && ngbC != ngbB) {
 						if (ngbL->AllSquaresAccessible() && ngbB->AllSquaresAccessible()) {
-							neighbors.push_back(ngbC);
-
-							for (unsigned int i = 0; i < QTPFS_MAX_NETPOINTS_PER_NODE_EDGE; i++) {
-								netpoints.push_back(INode::GetNeighborEdgeTransitionPoint(ngbC, {}, QTPFS_NETPOINT_EDGE_SPACING_SCALE * (i + 1)));
-							}
+							AddNeighbor(ngbC);
 						}
 					}
 				}
@@ -837,34 +784,26 @@ bool QTPFS::QTNode::UpdateNeighborCache(const std::vector<INode*>& nodes) {
 			// top- and bottom-right corners
 			if ((ngbRels & REL_NGB_EDGE_R) != 0) {
 				if ((ngbRels & REL_NGB_EDGE_T) != 0) {
-					const INode* ngbR = nodes[(zmin() + 0) * mapDims.mapx + (xmax() + 0)];
-					const INode* ngbT = nodes[(zmin() - 1) * mapDims.mapx + (xmax() - 1)];
-						  INode* ngbC = nodes[(zmin() - 1) * mapDims.mapx + (xmax() + 0)];
+					const INode* ngbR = nl.GetNode(xmax() + 0, zmin() + 0);
+					const INode* ngbT = nl.GetNode(xmax() - 1, zmin() - 1);
+					const INode* ngbC = nl.GetNode(xmax() + 0, zmin() - 1);
 
 					// VERT_TR ngb must be distinct from EDGE_R and EDGE_T ngbs
 					if (ngbC != ngbR && ngbC != ngbT) {
 						if (ngbR->AllSquaresAccessible() && ngbT->AllSquaresAccessible()) {
-							neighbors.push_back(ngbC);
-
-							for (unsigned int i = 0; i < QTPFS_MAX_NETPOINTS_PER_NODE_EDGE; i++) {
-								netpoints.push_back(INode::GetNeighborEdgeTransitionPoint(ngbC, {}, QTPFS_NETPOINT_EDGE_SPACING_SCALE * (i + 1)));
-							}
+							AddNeighbor(ngbC);
 						}
 					}
 				}
 				if ((ngbRels & REL_NGB_EDGE_B) != 0) {
-					const INode* ngbR = nodes[(zmax() - 1) * mapDims.mapx + (xmax() + 0)];
-					const INode* ngbB = nodes[(zmax() + 0) * mapDims.mapx + (xmax() - 1)];
-						  INode* ngbC = nodes[(zmax() + 0) * mapDims.mapx + (xmax() + 0)];
+					const INode* ngbR = nl.GetNode(xmax() + 0, zmax() - 1);
+					const INode* ngbB = nl.GetNode(xmax() - 1, zmax() + 0);
+					const INode* ngbC = nl.GetNode(xmax() + 0, zmax() + 0);
 
 					// VERT_BR ngb must be distinct from EDGE_R and EDGE_B ngbs
 					if (ngbC != ngbR && ngbC != ngbB) {
 						if (ngbR->AllSquaresAccessible() && ngbB->AllSquaresAccessible()) {
-							neighbors.push_back(ngbC);
-
-							for (unsigned int i = 0; i < QTPFS_MAX_NETPOINTS_PER_NODE_EDGE; i++) {
-								netpoints.push_back(INode::GetNeighborEdgeTransitionPoint(ngbC, {}, QTPFS_NETPOINT_EDGE_SPACING_SCALE * (i + 1)));
-							}
+							AddNeighbor(ngbC);
 						}
 					}
 				}
@@ -872,6 +811,8 @@ bool QTPFS::QTNode::UpdateNeighborCache(const std::vector<INode*>& nodes) {
 			#endif
 		}
 
+		numNgbs = neighbors.size();
+		nl.StoreNeighbors(ngbsOffset, ngbsClass, neighbors, netpoints);
 		return true;
 	}
 
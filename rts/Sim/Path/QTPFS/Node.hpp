@@ -5,7 +5,6 @@
 
 #include <array>
 #include <vector>
-#include <fstream>
 #include <cinttypes>
 
 #include "PathEnums.hpp"
@@ -22,28 +21,30 @@
 
 namespace QTPFS {
 	struct NodeLayer;
+
+	// flat (pre-order) representation of a tree node, see QTNode::{Serialize,Deserialize}
+	struct NodeTreeRecord {
+		std::uint32_t nodeNumber;
+		std::uint32_t numChildren;
+
+		float speedModSum;
+		float speedModAvg;
+		float moveCostAvg;
+	};
+
 	struct INode {
 	public:
 		void SetNodeNumber(unsigned int n) { nodeNumber = n; }
-		void SetHeapIndex(unsigned int n) { heapIndex = n; }
+		void SetNodeIndex(unsigned int n) { nodeIndex = n; }
 		unsigned int GetNodeNumber() const { return nodeNumber; }
-		unsigned int GetHeapIndex() const { return heapIndex; }
-		float GetHeapPriority() const { return GetPathCost(NODE_PATH_COST_F); }
-
-		bool operator <  (const INode* n) const { return (fCost <  n->fCost); }
-		bool operator >  (const INode* n) const { return (fCost >  n->fCost); }
-		bool operator == (const INode* n) const { return (fCost == n->fCost); }
-		bool operator <= (const INode* n) const { return (fCost <= n->fCost); }
-		bool operator >= (const INode* n) const { return (fCost >= n->fCost); }
+		unsigned int GetNodeIndex() const { return nodeIndex; }
 
 		#ifdef QTPFS_VIRTUAL_NODE_FUNCTIONS
-		virtual void Serialize(std::fstream&, NodeLayer&, unsigned int*, unsigned int, bool) = 0;
-		virtual unsigned int GetNeighbors(const std::vector<INode*>&, std::vector<INode*>&) = 0;
-		virtual const std::vector<INode*>& GetNeighbors(const std::vector<INode*>& v) = 0;
-		virtual bool UpdateNeighborCache(const std::vector<INode*>& nodes) = 0;
-
-		virtual void SetNeighborEdgeTransitionPoint(unsigned int ngbIdx, const float2& point) = 0;
-		virtual const float2& GetNeighborEdgeTransitionPoint(unsigned int ngbIdx) const = 0;
+		virtual void Serialize(const NodeLayer&, std::vector<NodeTreeRecord>&) const = 0;
+		virtual bool Deserialize(NodeLayer&, const NodeTreeRecord*, size_t) = 0;
+		virtual unsigned int GetNeighbors(NodeLayer& nl) = 0;
+		virtual unsigned int GetNeighborsOffset() const = 0;
+		virtual bool UpdateNeighborCache(NodeLayer& nl) = 0;
 		#endif
 
 		unsigned int GetNeighborRelation(const INode* ngb) const;
@@ -69,34 +70,16 @@ namespace QTPFS {
 		virtual void SetMoveCost(float cost) = 0;
 		virtual float GetMoveCost() const = 0;
 
-		virtual void SetSearchState(unsigned int) = 0;
-		virtual unsigned int GetSearchState() const = 0;
-
 		virtual void SetMagicNumber(unsigned int) = 0;
 		virtual unsigned int GetMagicNumber() const = 0;
 		#endif
 
-		void SetPathCosts(float g, float h) { fCost = g + h; gCost = g; hCost = h; }
-		void SetPathCost(unsigned int type, float cost);
-		const float* GetPathCosts() const { return &fCost; }
-		float GetPathCost(unsigned int type) const;
-
-		void SetPrevNode(INode* n) { prevNode = n; }
-		INode* GetPrevNode() { return prevNode; }
-
 	protected:
-		// NOTE:
-		//     storing the heap-index is an *UGLY* break of abstraction,
-		//     but the only way to keep the cost of resorting acceptable
 		unsigned int nodeNumber = -1u;
-		unsigned int heapIndex = -1u;
-
-		float fCost = 0.0f;
-		float gCost = 0.0f;
-		float hCost = 0.0f;
-
-		// points back to previous node in path
-		INode* prevNode = nullptr;
+		// dense per-layer index (assigned by NodeLayer) into the
+		// per-thread search state, which is kept out of the tree
+		// s.t. multiple searches can run on one layer at a time
+		unsigned int nodeIndex = -1u;
 
 	#ifdef QTPFS_VIRTUAL_NODE_FUNCTIONS
 	};
@@ -135,7 +118,10 @@ namespace QTPFS {
 
 		void PreTesselate(NodeLayer& nl, const SRectangle& r, SRectangle& ur, unsigned int depth);
 		void Tesselate(NodeLayer& nl, const SRectangle& r, unsigned int depth);
-		void Serialize(std::fstream& fStream, NodeLayer& nodeLayer, unsigned int* streamSize, unsigned int depth, bool readMode);
+		// appends the records of this node and its subtree
+		void Serialize(const NodeLayer& nl, std::vector<NodeTreeRecord>& records) const;
+		// re-creates the subtree of a leaf from its records; false if they do not describe one
+		bool Deserialize(NodeLayer& nl, const NodeTreeRecord* records, size_t numRecords);
 
 		bool IsLeaf() const { return (childBaseIndex == -1u); }
 		bool CanSplit(unsigned int depth, bool forced) const;
@@ -144,12 +130,13 @@ namespace QTPFS {
 		bool Merge(NodeLayer& nl);
 
 		unsigned int GetMaxNumNeighbors() const;
-		unsigned int GetNeighbors(const std::vector<INode*>&, std::vector<INode*>&);
-		const std::vector<INode*>& GetNeighbors(const std::vector<INode*>&);
-		bool UpdateNeighborCache(const std::vector<INode*>& nodes);
-
-		void SetNeighborEdgeTransitionPoint(unsigned int ngbIdx, const float2& point) { netpoints[ngbIdx] = point; }
-		const float2& GetNeighborEdgeTransitionPoint(unsigned int ngbIdx) const { return netpoints[ngbIdx]; }
+		// returns the number of neighbors; their node-indices and edge transition-points
+		// (QTPFS_MAX_NETPOINTS_PER_NODE_EDGE per neighbor) are stored in the layer's flat
+		// arrays, see NodeLayer::GetNodeNeighbors and NodeLayer::GetNodeNetpoints
+		unsigned int GetNeighbors(NodeLayer& nl);
+		unsigned int GetNeighborsOffset() const { return ngbsOffset; }
+		bool UpdateNeighborCache(NodeLayer& nl);
+		void ClearNeighborCache(NodeLayer& nl);
 
 		unsigned int xmin() const { return (_xminxmax  & 0xFFFF); }
 		unsigned int zmin() const { return (_zminzmax  & 0xFFFF); }
@@ -166,11 +153,9 @@ namespace QTPFS {
 		bool AllSquaresImpassable() const { return (moveCostAvg == QTPFS_POSITIVE_INFINITY); }
 
 		void SetMoveCost(float cost) { moveCostAvg = cost; }
-		void SetSearchState(unsigned int state) { searchState = state; }
 		void SetMagicNumber(unsigned int number) { currMagicNum = number; }
 
 		float GetMoveCost() const { return moveCostAvg; }
-		unsigned int GetSearchState() const { return searchState; }
 		unsigned int GetMagicNumber() const { return currMagicNum; }
 		unsigned int GetChildBaseIndex() const { return childBaseIndex; }
 
@@ -199,14 +184,15 @@ namespace QTPFS {
 		float speedModAvg =  0.0f;
 		float moveCostAvg = -1.0f;
 
-		unsigned int searchState = 0;
 		unsigned int currMagicNum = 0;
 		unsigned int prevMagicNum = -1u;
 
 		unsigned int childBaseIndex = -1u;
 
-		std::vector<INode*> neighbors;
-		std::vector<float2> netpoints;
+		// range in NodeLayer::{nodeNeighbors,nodeNetpoints}, owned by leaves
+		unsigned int ngbsOffset = -1u;
+		unsigned int ngbsClass = 0;
+		unsigned int numNgbs = 0;
 	};
 }
 
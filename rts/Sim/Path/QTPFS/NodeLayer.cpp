@@ -27,22 +27,81 @@ void QTPFS::NodeLayer::InitStatic() {
 void QTPFS::NodeLayer::RegisterNode(INode* n) {
 	for (unsigned int hmz = n->zmin(); hmz < n->zmax(); hmz++) {
 		for (unsigned int hmx = n->xmin(); hmx < n->xmax(); hmx++) {
-			nodeGrid[hmz * xsize + hmx] = n;
+			nodeGrid[hmz * xsize + hmx] = n->GetNodeIndex();
 		}
 	}
 }
 
+void QTPFS::NodeLayer::StoreNeighbors(
+	unsigned int& offset,
+	unsigned int& sizeClass,
+	const std::vector<unsigned int>& neighbors,
+	const std::vector<float2>& netpoints
+) {
+	assert(netpoints.size() == (neighbors.size() * QTPFS_MAX_NETPOINTS_PER_NODE_EDGE));
+
+	unsigned int reqClass = 0;
+
+	while ((4u << reqClass) < neighbors.size())
+		reqClass++;
+
+	assert(reqClass < NUM_NEIGHBOR_SIZE_CLASSES);
+
+	// keep the current range if it still has the right size
+	if (neighbors.empty() || reqClass != sizeClass)
+		FreeNeighbors(offset, sizeClass);
+
+	if (neighbors.empty())
+		return;
+
+	if (offset == -1u) {
+		std::vector<unsigned int>& freeRanges = freeNeighborRanges[sizeClass = reqClass];
+
+		if (freeRanges.empty()) {
+			offset = nodeNeighbors.size();
+
+			nodeNeighbors.resize(offset + (4u << sizeClass), -1u);
+			nodeNetpoints.resize(nodeNeighbors.size() * QTPFS_MAX_NETPOINTS_PER_NODE_EDGE);
+		} else {
+			offset = freeRanges.back();
+			freeRanges.pop_back();
+		}
+	}
+
+	std::copy(neighbors.begin(), neighbors.end(), nodeNeighbors.begin() + offset);
+	std::copy(netpoints.begin(), netpoints.end(), nodeNetpoints.begin() + offset * QTPFS_MAX_NETPOINTS_PER_NODE_EDGE);
+}
+
+void QTPFS::NodeLayer::FreeNeighbors(unsigned int& offset, unsigned int sizeClass) {
+	if (offset == -1u)
+		return;
+
+	freeNeighborRanges[sizeClass].push_back(offset);
+	offset = -1u;
+}
+
 void QTPFS::NodeLayer::Init(unsigned int layerNum) {
 	assert((QTPFS::NodeLayer::NUM_SPEEDMOD_BINS + 1) <= MaxSpeedBinTypeValue());
 
-	// pre-count the root
-	numLeafNodes = 1;
 	layerNumber = layerNum;
 
 	xsize = mapDims.mapx;
 	zsize = mapDims.mapy;
 
-	nodeGrid.resize(xsize * zsize, nullptr);
+	nodeGrid.resize(xsize * zsize, -1u);
+
+	ClearNodes();
+
+	curSpeedMods.resize(xsize * zsize,  0);
+	oldSpeedMods.resize(xsize * zsize,  0);
+	oldSpeedBins.resize(xsize * zsize, -1);
+	curSpeedBins.resize(xsize * zsize, -1);
+}
+
+void QTPFS::NodeLayer::ClearNodes() {
+	// pre-count the root
+	numLeafNodes = 1;
+	maxNodeIndex = 0;
 
 	{
 		// chunks are reserved OTF
@@ -53,15 +112,24 @@ void QTPFS::NodeLayer::Init(unsigned int layerNum) {
 		std::reverse(nodeIndcs.begin(), nodeIndcs.end());
 	}
 
-	curSpeedMods.resize(xsize * zsize,  0);
-	oldSpeedMods.resize(xsize * zsize,  0);
-	oldSpeedBins.resize(xsize * zsize, -1);
-	curSpeedBins.resize(xsize * zsize, -1);
+	nodeNeighbors.clear();
+	nodeNetpoints.clear();
+
+	for (std::vector<unsigned int>& freeRanges: freeNeighborRanges) {
+		freeRanges.clear();
+	}
 }
 
 void QTPFS::NodeLayer::Clear() {
 	nodeGrid.clear();
 
+	nodeNeighbors.clear();
+	nodeNetpoints.clear();
+
+	for (std::vector<unsigned int>& freeRanges: freeNeighborRanges) {
+		freeRanges.clear();
+	}
+
 	curSpeedMods.clear();
 	oldSpeedMods.clear();
 	oldSpeedBins.clear();
@@ -256,14 +324,14 @@ void QTPFS::NodeLayer::ExecNodeNeighborCacheUpdate(unsigned int currFrameNum, un
 			unsigned int zspan = zsize;
 
 			for (int x = xmin; x < xmax; ) {
-				n = nodeGrid[z * xsize + x];
+				n = GetNode(x, z);
 				x = n->xmax();
 
 				zspan = std::min(zspan, n->zmax() - z);
 				zspan = std::max(zspan, 1u);
 
 				n->SetMagicNumber(currMagicNum);
-				n->GetNeighbors(nodeGrid);
+				n->GetNeighbors(*this);
 			}
 
 			z += zspan;
@@ -278,14 +346,14 @@ void QTPFS::NodeLayer::ExecNodeNeighborCacheUpdate(unsigned int currFrameNum, un
 			unsigned int zspan = zsize;
 
 			for (int x = xmin; x < xmax; ) {
-				n = nodeGrid[z * xsize + x];
+				n = GetNode(x, z);
 				x = n->xmax();
 
 				zspan = std::min(zspan, n->zmax() - z);
 				zspan = std::max(zspan, 1u);
 
 				n->SetMagicNumber(currMagicNum);
-				n->GetNeighbors(nodeGrid);
+				n->GetNeighbors(*this);
 			}
 
 			z += zspan;
@@ -300,14 +368,14 @@ void QTPFS::NodeLayer::ExecNodeNeighborCacheUpdate(unsigned int currFrameNum, un
 			unsigned int zspan = zsize;
 
 			for (int x = xmin; x < xmax; ) {
-				n = nodeGrid[z * xsize + x];
+				n = GetNode(x, z);
 				x = n->xmax();
 
 				zspan = std::min(zspan, n->zmax() - z);
 				zspan = std::max(zspan, 1u);
 
 				n->SetMagicNumber(currMagicNum);
-				n->GetNeighbors(nodeGrid);
+				n->GetNeighbors(*this);
 			}
 
 			z += zspan;
@@ -322,14 +390,14 @@ void QTPFS::NodeLayer::ExecNodeNeighborCacheUpdate(unsigned int currFrameNum, un
 			unsigned int zspan = zsize;
 
 			for (int x = xmin; x < xmax; ) {
-				n = nodeGrid[z * xsize + x];
+				n = GetNode(x, z);
 				x = n->xmax();
 
 				zspan = std::min(zspan, n->zmax() - z);
 				zspan = std::max(zspan, 1u);
 
 				n->SetMagicNumber(currMagicNum);
-				n->GetNeighbors(nodeGrid);
+				n->GetNeighbors(*this);
 			}
 
 			z += zspan;
@@ -353,7 +421,7 @@ void QTPFS::NodeLayer::ExecNodeNeighborCacheUpdates(const SRectangle& ur, unsign
 		unsigned int zspan = zsize;
 
 		for (int x = xmin; x < xmax; ) {
-			n = nodeGrid[z * xsize + x];
+			n = GetNode(x, z);
 			x = n->xmax();
 
 			// calculate largest safe z-increment along this row
@@ -364,7 +432,7 @@ void QTPFS::NodeLayer::ExecNodeNeighborCacheUpdates(const SRectangle& ur, unsign
 			//   during initialization, currMagicNum == 0 which nodes start with already 
 			//   (does not matter because prevMagicNum == -1, so updates are not no-ops)
 			n->SetMagicNumber(currMagicNum);
-			n->UpdateNeighborCache(nodeGrid);
+			n->UpdateNeighborCache(*this);
 		}
 
 		z += zspan;
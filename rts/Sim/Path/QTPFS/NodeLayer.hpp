@@ -3,6 +3,7 @@
 #ifndef QTPFS_NODELAYER_HDR
 #define QTPFS_NODELAYER_HDR
 
+#include <algorithm>
 #include <limits>
 #include <vector>
 #include <deque>
@@ -45,6 +46,8 @@ namespace QTPFS {
 
 		void Init(unsigned int layerNum);
 		void Clear();
+		// returns every pool node and neighbor-range to the layer
+		void ClearNodes();
 
 		#ifdef QTPFS_STAGGERED_LAYER_UPDATES
 		void QueueUpdate(const SRectangle& r, const MoveDef* md);
@@ -66,16 +69,37 @@ namespace QTPFS {
 		void ExecNodeNeighborCacheUpdates(const SRectangle& ur, unsigned int currMagicNum);
 
 		float GetNodeRatio() const { return (numLeafNodes / std::max(1.0f, float(xsize * zsize))); }
-		const INode* GetNode(unsigned int x, unsigned int z) const { return nodeGrid[z * xsize + x]; }
-		      INode* GetNode(unsigned int x, unsigned int z)       { return nodeGrid[z * xsize + x]; }
-		const INode* GetNode(unsigned int i) const { return nodeGrid[i]; }
-		      INode* GetNode(unsigned int i)       { return nodeGrid[i]; }
+		const INode* GetNode(unsigned int x, unsigned int z) const { return GetNodeByIndex(nodeGrid[z * xsize + x]); }
+		      INode* GetNode(unsigned int x, unsigned int z)       { return GetNodeByIndex(nodeGrid[z * xsize + x]); }
+		const INode* GetNode(unsigned int i) const { return GetNodeByIndex(nodeGrid[i]); }
+		      INode* GetNode(unsigned int i)       { return GetNodeByIndex(nodeGrid[i]); }
 
 		const INode* GetPoolNode(unsigned int i) const { return &poolNodes[i / POOL_CHUNK_SIZE][i % POOL_CHUNK_SIZE]; }
 		      INode* GetPoolNode(unsigned int i)       { return &poolNodes[i / POOL_CHUNK_SIZE][i % POOL_CHUNK_SIZE]; }
 
+		// resolves an INode::GetNodeIndex value
+		const INode* GetNodeByIndex(unsigned int i) const { return ((i == 0)? &rootNode: GetPoolNode(i - 1)); }
+		      INode* GetNodeByIndex(unsigned int i)       { return ((i == 0)? &rootNode: GetPoolNode(i - 1)); }
+
+		// node-indices and edge transition-points of a leaf's neighbors, <offset> is
+		// QTNode::GetNeighborsOffset (only valid if the node has any neighbors)
+		const unsigned int* GetNodeNeighbors(unsigned int offset) const { return &nodeNeighbors[offset]; }
+		const float2* GetNodeNetpoints(unsigned int offset) const { return &nodeNetpoints[offset * QTPFS_MAX_NETPOINTS_PER_NODE_EDGE]; }
+
+		std::vector<unsigned int>& GetNeighborsBuffer() { return neighborsBuffer; }
+		std::vector<float2>& GetNetpointsBuffer() { return netpointsBuffer; }
+
+		void StoreNeighbors(
+			unsigned int& offset,
+			unsigned int& sizeClass,
+			const std::vector<unsigned int>& neighbors,
+			const std::vector<float2>& netpoints
+		);
+		void FreeNeighbors(unsigned int& offset, unsigned int sizeClass);
+
 		INode* AllocRootNode(const INode* parent, unsigned int nn,  unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2) {
 			rootNode.Init(parent, nn, x1, z1, x2, z2);
+			rootNode.SetNodeIndex(0);
 			return &rootNode;
 		}
 
@@ -89,21 +113,25 @@ namespace QTPFS {
 				poolNodes[idx / POOL_CHUNK_SIZE].resize(POOL_CHUNK_SIZE);
 
 			poolNodes[idx / POOL_CHUNK_SIZE][idx % POOL_CHUNK_SIZE].Init(parent, nn, x1, z1, x2, z2);
+			poolNodes[idx / POOL_CHUNK_SIZE][idx % POOL_CHUNK_SIZE].SetNodeIndex(idx + 1);
 			nodeIndcs.pop_back();
 
+			maxNodeIndex = std::max(maxNodeIndex, idx + 1);
+
 			return idx;
 		}
 
 		void FreePoolNode(unsigned int nodeIndex) { nodeIndcs.push_back(nodeIndex); }
 
+		// upper bound on INode::GetNodeIndex (root is 0, pool nodes are idx + 1)
+		unsigned int GetNumNodeIndices() const { return (maxNodeIndex + 1); }
+
 
 		const std::vector<SpeedBinType>& GetOldSpeedBins() const { return oldSpeedBins; }
 		const std::vector<SpeedBinType>& GetCurSpeedBins() const { return curSpeedBins; }
 		const std::vector<SpeedModType>& GetOldSpeedMods() const { return oldSpeedMods; }
 		const std::vector<SpeedModType>& GetCurSpeedMods() const { return curSpeedMods; }
 
-		std::vector<INode*>& GetNodes() { return nodeGrid; }
-
 		void RegisterNode(INode* n);
 
 		void SetNumLeafNodes(unsigned int n) { numLeafNodes = n; }
@@ -121,6 +149,8 @@ namespace QTPFS {
 			memFootPrint += (curSpeedBins.size() * sizeof(SpeedBinType));
 			memFootPrint += (oldSpeedBins.size() * sizeof(SpeedBinType));
 			memFootPrint += (nodeGrid.size() * sizeof(decltype(nodeGrid)::value_type));
+			memFootPrint += (nodeNeighbors.size() * sizeof(decltype(nodeNeighbors)::value_type));
+			memFootPrint += (nodeNetpoints.size() * sizeof(decltype(nodeNetpoints)::value_type));
 			// memFootPrint += (poolNodes.size() * sizeof(decltype(poolNodes)::value_type));
 			for (size_t i = 0, n = NUM_POOL_CHUNKS; i < n; i++) {
 				memFootPrint += (poolNodes[i].size() * sizeof(QTNode));
@@ -130,7 +160,20 @@ namespace QTPFS {
 		}
 
 	private:
-		std::vector<INode*> nodeGrid;
+		static constexpr unsigned int NUM_NEIGHBOR_SIZE_CLASSES = 16;
+
+		// leaf node-index per square
+		std::vector<unsigned int> nodeGrid;
+
+		// neighbor-caches of all leaves, in ranges of (4 << sizeClass)
+		// entries that are recycled through per-class free-lists s.t.
+		// re-tesselation only relinks the nodes it touched
+		std::vector<unsigned int> nodeNeighbors;
+		std::vector<float2> nodeNetpoints;
+		std::vector<unsigned int> freeNeighborRanges[NUM_NEIGHBOR_SIZE_CLASSES];
+
+		std::vector<unsigned int> neighborsBuffer;
+		std::vector<float2> netpointsBuffer;
 
 		std::vector<QTNode> poolNodes[16];
 		std::vector<unsigned int> nodeIndcs;
@@ -161,6 +204,7 @@ namespace QTPFS {
 
 		unsigned int layerNumber = 0;
 		unsigned int numLeafNodes = 0;
+		unsigned int maxNodeIndex = 0;
 		unsigned int updateCounter = 0;
 
 		unsigned int xsize = 0;
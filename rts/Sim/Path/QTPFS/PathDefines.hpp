@@ -27,8 +27,7 @@
 #define QTPFS_MAX_NETPOINTS_PER_NODE_EDGE 3
 #define QTPFS_NETPOINT_EDGE_SPACING_SCALE (1.0f / (QTPFS_MAX_NETPOINTS_PER_NODE_EDGE + 1))
 
-#define QTPFS_CACHE_VERSION 16
-#define QTPFS_CACHE_XACCESS
+#define QTPFS_CACHE_VERSION 17
 
 #define QTPFS_POSITIVE_INFINITY (std::numeric_limits<float>::infinity())
 #define QTPFS_CLOSED_NODE_COST (1 << 24)
@@ -1,5 +1,6 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
+#include <algorithm>
 #include <chrono>
 #include <cinttypes>
 #include <functional>
@@ -20,12 +21,16 @@
 #include "Sim/Objects/SolidObject.h"
 #include "System/Config/ConfigHandler.h"
 #include "System/FileSystem/ArchiveScanner.h"
+#include "System/FileSystem/CacheFile.h"
+#include "System/FileSystem/DataDirsAccess.h"
+#include "System/FileSystem/FileQueryFlags.h"
 #include "System/FileSystem/FileSystem.h"
 #include "System/Log/ILog.h"
 #include "System/Platform/Threading.h"
 #include "System/Rectangle.h"
 #include "System/TimeProfiler.h"
 #include "System/StringUtil.h"
+#include "System/Sync/HsiehHash.h"
 
 #ifdef GetTempPath
 #undef GetTempPath
@@ -36,6 +41,22 @@
 #define MAP_RECTANGLE SRectangle(0, 0,  mapDims.mapx, mapDims.mapy)
 
 
+static constexpr char TREE_CACHE_FILE_MAGIC[8] = {'Q', 'T', 'P', 'F', 'S', 'N', 'T', '\0'};
+
+// node-tree cache-files hold <numNodes> NodeTreeRecord's in pre-order, which
+// are read straight out of the mapped file (the data section is aligned); the
+// key is the hash over the layer's speed-mods and -bins the tree was built from
+struct NodeTreeCacheInfo {
+	std::uint32_t numNodes;
+	std::uint32_t xsize;
+	std::uint32_t zsize;
+	std::uint32_t padding;
+	std::uint64_t treeCheckSum; // QTNode::GetCheckSum of the finished tree
+};
+
+static_assert(alignof(QTPFS::NodeTreeRecord) <= CCacheFile::DATA_ALIGNMENT, "");
+
+
 namespace QTPFS {
 	struct PMLoadScreen {
 	public:
@@ -148,7 +169,7 @@ QTPFS::PathManager::~PathManager() {
 	numCurrExecutedSearches.clear();
 	numPrevExecutedSearches.clear();
 
-	PathSearch::FreeGlobalQueue();
+	PathSearch::FreeThreadData();
 
 	#ifdef QTPFS_ENABLE_THREADED_UPDATE
 	// at this point the thread is waiting, so notify it
@@ -185,8 +206,6 @@ void QTPFS::PathManager::InitStatic() {
 }
 
 void QTPFS::PathManager::Load() {
-	// NOTE: offset *must* start at a non-zero value
-	searchStateOffset = NODE_STATE_OFFSET;
 	numTerrainChanges = 0;
 	numPathRequests   = 0;
 	maxNumLeafNodes   = 0;
@@ -209,18 +228,26 @@ void QTPFS::PathManager::Load() {
 		sha512::dump_digest(mapCheckSum, mapCheckSumHex);
 		sha512::dump_digest(modCheckSum, modCheckSumHex);
 
-		const std::string& cacheDirName = GetCacheDirName({mapCheckSumHex.data()}, {modCheckSumHex.data()});
+		cacheDirName = GetCacheDirName({mapCheckSumHex.data()}, {modCheckSumHex.data()});
 
 		{
 			layersInited = false;
-			haveCacheDir = FileSystem::DirExists(cacheDirName);
+			cachedTrees.clear();
+			cachedTrees.resize(nodeLayers.size(), 0);
 
+			FileSystem::CreateDirectory(cacheDirName);
 			InitNodeLayersThreaded(MAP_RECTANGLE);
-			Serialize(cacheDirName);
 
 			layersInited = true;
 		}
 
+		{
+			const unsigned int numCachedTrees = std::count(cachedTrees.begin(), cachedTrees.end(), 1);
+			const std::string cacheStr = "restored " + IntToString(numCachedTrees) + " of " + IntToString(nodeTrees.size()) + " node-trees from cache";
+
+			pmLoadScreen.AddMessage("[" + std::string(__func__) + "] " + cacheStr);
+		}
+
 		// NOTE:
 		//   should be sufficient in theory, because if either
 		//   the map or the mod changes then the checksum does
@@ -234,20 +261,13 @@ void QTPFS::PathManager::Load() {
 			((modCheckSum[0] << 24) | (modCheckSum[1] << 16) | (modCheckSum[2] << 8) | (modCheckSum[3] << 0));
 
 		for (unsigned int layerNum = 0; layerNum < nodeLayers.size(); layerNum++) {
-			#ifndef QTPFS_CONSERVATIVE_NEIGHBOR_CACHE_UPDATES
-			if (haveCacheDir) {
-				// if cache-dir exists, must set node relations after de-serializing its trees
-				nodeLayers[layerNum].ExecNodeNeighborCacheUpdates(MAP_RECTANGLE, numTerrainChanges);
-			}
-			#endif
-
 			pfsCheckSum ^= nodeTrees[layerNum]->GetCheckSum(nodeLayers[layerNum]);
 			maxNumLeafNodes = std::max(nodeLayers[layerNum].GetNumLeafNodes(), maxNumLeafNodes);
 		}
 
 		{ SyncedUint tmp(pfsCheckSum); }
 
-		PathSearch::InitGlobalQueue(maxNumLeafNodes);
+		PathSearch::InitThreadData(maxNumLeafNodes);
 	}
 
 	{
@@ -291,11 +311,11 @@ void QTPFS::PathManager::InitNodeLayersThreaded(const SRectangle& rect) {
 	streflop::streflop_init<streflop::Simple>();
 
 	char loadMsg[512] = {'\0'};
-	const char* fmtString = "[PathManager::%s] using %u threads for %u node-layers (%s)";
+	const char* fmtString = "[PathManager::%s] using %u threads for %u node-layers";
 
 	#ifdef QTPFS_OPENMP_ENABLED
 	{
-		sprintf(loadMsg, fmtString, __func__, ThreadPool::GetNumThreads(), nodeLayers.size(), (haveCacheDir? "cached": "uncached"));
+		sprintf(loadMsg, fmtString, __func__, ThreadPool::GetNumThreads(), nodeLayers.size());
 		pmLoadScreen.AddMessage(loadMsg);
 
 		#ifndef NDEBUG
@@ -309,12 +329,9 @@ void QTPFS::PathManager::InitNodeLayersThreaded(const SRectangle& rect) {
 			pmLoadScreen.AddMessage(loadMsg);
 			#endif
 
-			// construct each tree from scratch IFF no cache-dir exists
-			// (if it does, we only need to initialize speed{Mods, Bins}
-			// since Serialize will fill in the branches)
-			// NOTE:
-			//     silently assumes trees either ALL exist or ALL do not
-			//     (if >= 1 are missing for some player in MP, we desync)
+			// construct each tree from scratch IFF its cache-file is
+			// missing or stale (otherwise we only need to initialize
+			// speed{Mods, Bins} and ReadNodeTree fills in the branches)
 			InitNodeLayer(layerNum, rect);
 			UpdateNodeLayer(layerNum, rect);
 
@@ -330,7 +347,7 @@ void QTPFS::PathManager::InitNodeLayersThreaded(const SRectangle& rect) {
 	}
 	#else
 	{
-		sprintf(loadMsg, fmtString, __func__, GetNumThreads(), nodeLayers.size(), (haveCacheDir? "cached": "uncached"));
+		sprintf(loadMsg, fmtString, __func__, GetNumThreads(), nodeLayers.size());
 		pmLoadScreen.AddMessage(loadMsg);
 
 		SpawnSpringThreads(&PathManager::InitNodeLayersThread, rect);
@@ -454,8 +471,10 @@ void QTPFS::PathManager::UpdateNodeLayer(unsigned int layerNum, const SRectangle
 	ur.x2 = mr.x2;
 	ur.z2 = mr.z2;
 
-	const bool wantTesselation = (layersInited || !haveCacheDir);
 	const bool needTesselation = nodeLayers[layerNum].Update(mr, md);
+	// at load-time the tree is restored from its cache-file if that
+	// was tesselated from the same speed-bins; must come after Update
+	const bool wantTesselation = (layersInited || !ReadNodeTree(layerNum));
 
 	if (needTesselation && wantTesselation) {
 		nodeTrees[layerNum]->PreTesselate(nodeLayers[layerNum], mr, ur, 0);
@@ -465,6 +484,11 @@ void QTPFS::PathManager::UpdateNodeLayer(unsigned int layerNum, const SRectangle
 		nodeLayers[layerNum].ExecNodeNeighborCacheUpdates(ur, numTerrainChanges);
 		#endif
 	}
+
+	if (layersInited || !wantTesselation)
+		return;
+
+	WriteNodeTree(layerNum);
 }
 
 
@@ -547,88 +571,91 @@ std::string QTPFS::PathManager::GetCacheDirName(const std::string& mapCheckSumHe
 	return dir;
 }
 
-void QTPFS::PathManager::Serialize(const std::string& cacheFileDir) {
-	std::vector<std::string> fileNames(nodeTrees.size(), "");
-	std::vector<std::fstream*> fileStreams(nodeTrees.size(), nullptr);
-	std::vector<unsigned int> fileSizes(nodeTrees.size(), 0);
+std::string QTPFS::PathManager::GetCacheFileName(unsigned int layerNum) const {
+	const MoveDef* md = moveDefHandler.GetMoveDefByPathType(layerNum);
+	return (cacheDirName + "tree" + IntToString(layerNum, "%02x") + "-" + md->name + ".bin");
+}
 
-	if (!haveCacheDir) {
-		FileSystem::CreateDirectory(cacheFileDir);
-		assert(FileSystem::DirExists(cacheFileDir));
-	}
+std::uint32_t QTPFS::PathManager::GetLayerBinsHash(unsigned int layerNum) const {
+	const NodeLayer& nl = nodeLayers[layerNum];
 
-	#ifndef NDEBUG
-	char loadMsg[512] = {'\0'};
-	const char* fmtString = "[PathManager::%s] serializing node-tree %u (%s)";
-	#endif
+	const std::vector<NodeLayer::SpeedBinType>& speedBins = nl.GetCurSpeedBins();
+	const std::vector<NodeLayer::SpeedModType>& speedMods = nl.GetCurSpeedMods();
 
-	// TODO: compress the tree cache-files?
-	for (unsigned int i = 0; i < nodeTrees.size(); i++) {
-		const MoveDef* md = moveDefHandler.GetMoveDefByPathType(i);
-
-		fileNames[i] = cacheFileDir + "tree" + IntToString(i, "%02x") + "-" + md->name;
-		fileStreams[i] = new std::fstream();
-
-		if (haveCacheDir) {
-			#ifdef QTPFS_CACHE_XACCESS
-			{
-				// FIXME: lock fileNames[i] instead of doing this
-				// fstreams can not be easily locked however, see
-				// http://stackoverflow.com/questions/839856/
-				while (!FileSystem::FileExists(fileNames[i] + "-tmp")) {
-					spring::this_thread::sleep_for(std::chrono::milliseconds(100));
-				}
-				while (FileSystem::GetFileSize(fileNames[i] + "-tmp") != sizeof(unsigned int)) {
-					spring::this_thread::sleep_for(std::chrono::milliseconds(100));
-				}
-
-				fileStreams[i]->open((fileNames[i] + "-tmp").c_str(), std::ios::in | std::ios::binary);
-				fileStreams[i]->read(reinterpret_cast<char*>(&fileSizes[i]), sizeof(unsigned int));
-				fileStreams[i]->close();
-
-				while (!FileSystem::FileExists(fileNames[i])) {
-					spring::this_thread::sleep_for(std::chrono::milliseconds(100));
-				}
-				while (FileSystem::GetFileSize(fileNames[i]) != fileSizes[i]) {
-					spring::this_thread::sleep_for(std::chrono::milliseconds(100));
-				}
-			}
+	std::uint32_t hash = 0;
+	hash = HsiehHash(speedBins.data(), speedBins.size() * sizeof(NodeLayer::SpeedBinType), hash);
+	hash = HsiehHash(speedMods.data(), speedMods.size() * sizeof(NodeLayer::SpeedModType), hash);
+	return hash;
+}
 
-			#else
-			assert(FileSystem::FileExists(fileNames[i]));
-			#endif
+// called from the layer's init-thread right after its speed-mods were binned;
+// the map (and thus also the mod) checksums are already part of cacheDirName
+// but Lua can change terrain before we initialize, hence the bins-hash
+bool QTPFS::PathManager::ReadNodeTree(unsigned int layerNum) {
+	const std::string cacheFileName = GetCacheFileName(layerNum);
 
-			// read fileNames[i] into nodeTrees[i]
-			fileStreams[i]->open(fileNames[i].c_str(), std::ios::in | std::ios::binary);
-			assert(fileStreams[i]->good());
-			assert(nodeTrees[i]->IsLeaf());
-		} else {
-			// write nodeTrees[i] into fileNames[i]
-			fileStreams[i]->open(fileNames[i].c_str(), std::ios::out | std::ios::binary);
-		}
+	if (!FileSystem::FileExists(cacheFileName))
+		return false;
 
-		#ifndef NDEBUG
-		sprintf(loadMsg, fmtString, __func__, i, md->name.c_str());
-		pmLoadScreen.AddMessage(loadMsg);
-		#endif
+	CCacheFile cacheFile;
+	NodeTreeCacheInfo info;
 
-		nodeTrees[i]->Serialize(*fileStreams[i], nodeLayers[i], &fileSizes[i], 0, haveCacheDir);
+	NodeLayer& nl = nodeLayers[layerNum];
+
+	// a file other processes might still be reading is never removed, see WriteNodeTree
+	if (!cacheFile.Open(dataDirsAccess.LocateFile(cacheFileName), TREE_CACHE_FILE_MAGIC, QTPFS_CACHE_VERSION, GetLayerBinsHash(layerNum), info))
+		return false;
+	if (info.xsize != std::uint32_t(mapDims.mapx) || info.zsize != std::uint32_t(mapDims.mapy))
+		return false;
+	if (cacheFile.GetDataSize() != (info.numNodes * sizeof(NodeTreeRecord)))
+		return false;
 
-		fileStreams[i]->flush();
-		fileStreams[i]->close();
+	// the data section is aligned within the page-aligned mapping, records can be used in place
+	const NodeTreeRecord* records = reinterpret_cast<const NodeTreeRecord*>(cacheFile.GetData());
 
-		#ifdef QTPFS_CACHE_XACCESS
-		if (!haveCacheDir) {
-			// signal any other (concurrently loading) Spring processes; needed for validation-tests
-			fileStreams[i]->open((fileNames[i] + "-tmp").c_str(), std::ios::out | std::ios::binary);
-			fileStreams[i]->write(reinterpret_cast<const char*>(&fileSizes[i]), sizeof(unsigned int));
-			fileStreams[i]->flush();
-			fileStreams[i]->close();
-		}
+	if (nodeTrees[layerNum]->Deserialize(nl, records, info.numNodes)) {
+		#ifndef QTPFS_CONSERVATIVE_NEIGHBOR_CACHE_UPDATES
+		// set node relations after de-serializing, as tesselation would
+		nl.ExecNodeNeighborCacheUpdates(MAP_RECTANGLE, numTerrainChanges);
 		#endif
 
-		delete fileStreams[i];
+		// trees are part of pfsCheckSum, so a restored tree must be
+		// identical to what tesselation would have produced for it
+		if (nodeTrees[layerNum]->GetCheckSum(nl) == info.treeCheckSum) {
+			cachedTrees[layerNum] = 1;
+			return true;
+		}
 	}
+
+	// discard whatever was restored, re-initializing keeps the bins
+	InitNodeLayer(layerNum, MAP_RECTANGLE);
+
+	LOG_L(L_WARNING, "[QTPFS::PathManager::%s] discarded invalid cache-file \"%s\"", __func__, cacheFileName.c_str());
+	return false;
+}
+
+bool QTPFS::PathManager::WriteNodeTree(unsigned int layerNum) const {
+	const NodeLayer& nl = nodeLayers[layerNum];
+	const QTNode* tree = nodeTrees[layerNum];
+
+	std::vector<NodeTreeRecord> records;
+	records.reserve(nl.GetNumLeafNodes() + (nl.GetNumLeafNodes() - 1) / (QTNODE_CHILD_COUNT - 1));
+
+	tree->Serialize(nl, records);
+
+	NodeTreeCacheInfo info;
+
+	info.numNodes = records.size();
+	info.xsize = mapDims.mapx;
+	info.zsize = mapDims.mapy;
+	info.padding = 0;
+	info.treeCheckSum = tree->GetCheckSum(nl);
+
+	// the file is replaced as a whole, concurrently loading processes either
+	// map the previous or this version (or tesselate, producing the same tree)
+	const std::string cacheFilePath = dataDirsAccess.LocateFile(GetCacheFileName(layerNum), FileQueryFlags::WRITE);
+
+	return (CCacheFile::Write(cacheFilePath, TREE_CACHE_FILE_MAGIC, QTPFS_CACHE_VERSION, GetLayerBinsHash(layerNum), info, records.data(), records.size() * sizeof(NodeTreeRecord)));
 }
 
 
@@ -752,62 +779,73 @@ void QTPFS::PathManager::ExecuteQueuedSearches(unsigned int pathType) {
 	PathCache& pathCache = pathCaches[pathType];
 
 	std::vector<IPathSearch*>& searches = pathSearches[pathType];
-	std::vector<IPathSearch*>::iterator searchesIt = searches.begin();
-
-	if (!searches.empty()) {
-		// execute pending searches collected via
-		// RequestPath and QueueDeadPathSearches
-		while (searchesIt != searches.end()) {
-			if (ExecuteSearch(searches, searchesIt, nodeLayer, pathCache, pathType)) {
-				searchStateOffset += NODE_STATE_OFFSET;
-			}
-		}
+
+	// execute pending searches collected via RequestPath and
+	// QueueDeadPathSearches, in rounds of independent batches
+	// (searches held back from a batch can share its results)
+	while (!searches.empty()) {
+		if (!QueueSearchBatch(searches, nodeLayer, pathCache, pathType))
+			break;
+
+		ExecuteSearchBatch(pathCache);
 	}
 }
 
-bool QTPFS::PathManager::ExecuteSearch(
+bool QTPFS::PathManager::QueueSearchBatch(
 	PathSearchVect& searches,
-	PathSearchVectIt& searchesIt,
 	NodeLayer& nodeLayer,
 	PathCache& pathCache,
 	unsigned int pathType
 ) {
-	IPathSearch* search = *searchesIt;
-	IPath* path = pathCache.GetTempPath(search->GetID());
-
-	assert(search != nullptr);
-	assert(path != nullptr);
-
 	const auto DeleteSearch = [](IPathSearch* s, PathSearchVect& v, PathSearchVectIt& it) {
 		// ordering of still-queued searches is not relevant
 		*it = v.back();
 		v.pop_back();
 		delete s;
 	};
+	const auto TakeSearch = [](PathSearchVect& v, PathSearchVectIt& it) {
+		*it = v.back();
+		v.pop_back();
+	};
 
-	// temp-path might have been removed already via
-	// DeletePath before we got a chance to process it
-	if (path->GetID() == 0) {
-		DeleteSearch(search, searches, searchesIt);
-		return false;
-	}
+	searchBatch.clear();
+	searchBatchHashes.clear();
 
-	assert(search->GetID() != 0);
-	assert(path->GetID() == search->GetID());
+	for (PathSearchVectIt searchesIt = searches.begin(); searchesIt != searches.end(); ) {
+		IPathSearch* search = *searchesIt;
+		IPath* path = pathCache.GetTempPath(search->GetID());
 
-	search->Initialize(&nodeLayer, &pathCache, path->GetSourcePoint(), path->GetTargetPoint(), MAP_RECTANGLE);
-	path->SetHash(search->GetHash(mapDims.mapx * mapDims.mapy, pathType));
+		assert(search != nullptr);
+		assert(path != nullptr);
+
+		// temp-path might have been removed already via
+		// DeletePath before we got a chance to process it
+		if (path->GetID() == 0) {
+			DeleteSearch(search, searches, searchesIt);
+			continue;
+		}
+
+		assert(search->GetID() != 0);
+		assert(path->GetID() == search->GetID());
+
+		search->Initialize(&nodeLayer, &pathCache, path->GetSourcePoint(), path->GetTargetPoint(), MAP_RECTANGLE);
+		path->SetHash(search->GetHash(mapDims.mapx * mapDims.mapy, pathType));
 
-	{
 		#ifdef QTPFS_SEARCH_SHARED_PATHS
 		SharedPathMap::const_iterator sharedPathsIt = sharedPaths.find(path->GetHash());
 
 		if (sharedPathsIt != sharedPaths.end()) {
 			if (search->SharedFinalize(sharedPathsIt->second, path)) {
 				DeleteSearch(search, searches, searchesIt);
-				return false;
+				continue;
 			}
 		}
+
+		// wait for the batched search with the same hash, its path might be shareable
+		if (searchBatchHashes.find(path->GetHash()) != searchBatchHashes.end()) {
+			++searchesIt;
+			continue;
+		}
 		#endif
 
 		#ifdef QTPFS_LIMIT_TEAM_SEARCHES
@@ -815,30 +853,64 @@ bool QTPFS::PathManager::ExecuteSearch(
 		const unsigned int numPrevSearches = numPrevExecutedSearches[search->GetTeam()];
 
 		if ((numCurrSearches - numPrevSearches) >= MAX_TEAM_SEARCHES) {
-			++searchesIt; return false;
+			++searchesIt;
+			continue;
 		}
 
 		numCurrExecutedSearches[search->GetTeam()] += 1;
 		#endif
+
+		searchBatch.push_back({search, path, false});
+		searchBatchHashes.insert(path->GetHash());
+
+		TakeSearch(searches, searchesIt);
 	}
 
-	// removes path from temp-paths, adds it to live-paths
-	if (search->Execute(searchStateOffset, numTerrainChanges)) {
-		search->Finalize(path);
+	return (!searchBatch.empty());
+}
 
-		#ifdef QTPFS_SEARCH_SHARED_PATHS
-		sharedPaths[path->GetHash()] = path;
-		#endif
+void QTPFS::PathManager::ExecuteSearchBatch(PathCache& pathCache) {
+	const auto ExecuteSearch = [&](unsigned int i) {
+		SearchBatchItem& item = searchBatch[i];
 
-		#ifdef QTPFS_TRACE_PATH_SEARCHES
-		pathTraces[path->GetID()] = search->GetExecutionTrace();
-		#endif
-	} else {
-		DeletePath(path->GetID());
+		// searches only read the node-tree, their state is per-thread
+		if ((item.found = item.search->Execute(numTerrainChanges)))
+			item.search->Finalize(item.path);
+	};
+
+	#ifndef QTPFS_CONSERVATIVE_NEIGHBOR_CACHE_UPDATES
+	for_mt(0, searchBatch.size(), ExecuteSearch);
+	#else
+	// neighbor-caches are updated lazily by the searches themselves
+	for (unsigned int i = 0; i < searchBatch.size(); i++) {
+		ExecuteSearch(i);
+	}
+	#endif
+
+	// results are committed in queue-order, regardless of which thread finished first
+	for (SearchBatchItem& item: searchBatch) {
+		IPathSearch* search = item.search;
+		IPath* path = item.path;
+
+		if (item.found) {
+			// removes path from temp-paths, adds it to live-paths
+			pathCache.AddLivePath(path);
+
+			#ifdef QTPFS_SEARCH_SHARED_PATHS
+			sharedPaths[path->GetHash()] = path;
+			#endif
+
+			#ifdef QTPFS_TRACE_PATH_SEARCHES
+			pathTraces[path->GetID()] = search->GetExecutionTrace();
+			#endif
+		} else {
+			DeletePath(path->GetID());
+		}
+
+		delete search;
 	}
 
-	DeleteSearch(search, searches, searchesIt);
-	return true;
+	searchBatch.clear();
 }
 
 void QTPFS::PathManager::QueueDeadPathSearches(unsigned int pathType) {
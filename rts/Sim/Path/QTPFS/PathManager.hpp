@@ -10,6 +10,7 @@
 #include "PathCache.hpp"
 #include "PathSearch.hpp"
 #include "System/UnorderedMap.hpp"
+#include "System/UnorderedSet.hpp"
 
 struct MoveDef;
 struct SRectangle;
@@ -134,19 +135,23 @@ namespace QTPFS {
 			const bool synced
 		);
 
-		bool ExecuteSearch(
+		bool QueueSearchBatch(
 			PathSearchVect& searches,
-			PathSearchVectIt& searchesIt,
 			NodeLayer& nodeLayer,
 			PathCache& pathCache,
 			unsigned int pathType
 		);
+		void ExecuteSearchBatch(PathCache& pathCache);
 
 		bool IsFinalized() const { return (!nodeTrees.empty()); }
 
 
 		std::string GetCacheDirName(const std::string& mapCheckSumHexStr, const std::string& modCheckSumHexStr) const;
-		void Serialize(const std::string& cacheFileDir);
+		std::string GetCacheFileName(unsigned int layerNum) const;
+		std::uint32_t GetLayerBinsHash(unsigned int layerNum) const;
+
+		bool ReadNodeTree(unsigned int layerNum);
+		bool WriteNodeTree(unsigned int layerNum) const;
 
 		static std::vector<NodeLayer> nodeLayers;
 		static std::vector<QTNode*> nodeTrees;
@@ -159,13 +164,22 @@ namespace QTPFS {
 		// maps "hashes" of executed searches to the found paths
 		spring::unordered_map<std::uint64_t, IPath*> sharedPaths;
 
+		struct SearchBatchItem {
+			IPathSearch* search;
+			IPath* path;
+			bool found;
+		};
+
+		// searches taken from the queue to be executed concurrently
+		std::vector<SearchBatchItem> searchBatch;
+		spring::unordered_set<std::uint64_t> searchBatchHashes;
+
 		std::vector<unsigned int> numCurrExecutedSearches;
 		std::vector<unsigned int> numPrevExecutedSearches;
 
 		static unsigned int LAYERS_PER_UPDATE;
 		static unsigned int MAX_TEAM_SEARCHES;
 
-		unsigned int searchStateOffset;
 		unsigned int numTerrainChanges;
 		unsigned int numPathRequests;
 		unsigned int maxNumLeafNodes;
@@ -173,7 +187,10 @@ namespace QTPFS {
 		std::uint32_t pfsCheckSum;
 
 		bool layersInited;
-		bool haveCacheDir;
+
+		std::string cacheDirName;
+		// per layer, 1 if its tree was restored from cacheDirName
+		std::vector<std::uint8_t> cachedTrees;
 
 		#ifdef QTPFS_ENABLE_THREADED_UPDATE
 		spring::thread updateThread;
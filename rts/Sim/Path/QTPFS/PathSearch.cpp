@@ -1,5 +1,6 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
+#include <array>
 #include <cassert>
 #include <limits>
 
@@ -14,11 +15,29 @@
 #endif
 
 #include "System/float3.h"
+#include "System/Threading/ThreadPool.h"
 
-QTPFS::binary_heap<QTPFS::INode*> QTPFS::PathSearch::openNodes;
+static std::array<QTPFS::SearchThreadData, ThreadPool::MAX_THREADS> searchThreadData;
 
 
 
+void QTPFS::PathSearch::InitThreadData(unsigned int numLeafNodes) {
+	// searchNodes are sized on demand, per layer
+	for (SearchThreadData& data: searchThreadData) {
+		data.openNodes.reserve(std::max(1u, numLeafNodes));
+		data.searchState = NODE_STATE_OFFSET;
+	}
+}
+
+void QTPFS::PathSearch::FreeThreadData() {
+	for (SearchThreadData& data: searchThreadData) {
+		data.openNodes.clear();
+		data.searchNodes.clear();
+		data.searchNodes.shrink_to_fit();
+	}
+}
+
+
 void QTPFS::PathSearch::Initialize(
 	NodeLayer* layer,
 	PathCache* cache,
@@ -42,11 +61,10 @@ void QTPFS::PathSearch::Initialize(
 	minNode = srcNode;
 }
 
-bool QTPFS::PathSearch::Execute(
-	unsigned int searchStateOffset,
-	unsigned int searchMagicNumber
-) {
-	searchState = searchStateOffset; // starts at NODE_STATE_OFFSET
+bool QTPFS::PathSearch::Execute(unsigned int searchMagicNumber) {
+	threadData = &searchThreadData[ThreadPool::GetThreadNum()];
+
+	searchState = (threadData->searchState += NODE_STATE_OFFSET);
 	searchMagic = searchMagicNumber; // starts at numTerrainChanges
 
 	haveFullPath = (srcNode == tgtNode);
@@ -56,6 +74,10 @@ bool QTPFS::PathSearch::Execute(
 	if (haveFullPath)
 		return true;
 
+	// entries added here start out with a searchState (0) older than any search
+	if (threadData->searchNodes.size() < nodeLayer->GetNumNodeIndices())
+		threadData->searchNodes.resize(nodeLayer->GetNumNodeIndices());
+
 	#ifdef QTPFS_TRACE_PATH_SEARCHES
 	searchExec = new PathSearchTrace::Execution(gs->frameNum);
 	#endif
@@ -71,18 +93,15 @@ bool QTPFS::PathSearch::Execute(
 		case PATH_SEARCH_DIJKSTRA: { hCostMult = 0.0f;                                  } break;
 	}
 
-	// allow the search to start from an impassable node (because single
-	// nodes can represent many terrain squares, some of which can still
-	// be passable and allow a unit to move within a node)
-	// NOTE: we need to make sure such paths do not have infinite cost!
-	if (srcNode->GetMoveCost() == QTPFS_POSITIVE_INFINITY)
-		srcNode->SetMoveCost(0.0f);
+	// allow the search to start from an impassable node, but make sure
+	// such paths do not have infinite cost (see GetMoveCost)
+	srcMoveCost = (srcNode->GetMoveCost() != QTPFS_POSITIVE_INFINITY)? srcNode->GetMoveCost(): 0.0f;
 
 	ResetState(srcNode);
 	UpdateNode(srcNode, nullptr, 0);
 
-	while (!openNodes.empty()) {
-		IterateNodes(nodeLayer->GetNodes());
+	while (!threadData->openNodes.empty()) {
+		IterateNodes();
 
 		#ifdef QTPFS_TRACE_PATH_SEARCHES
 		searchExec->AddIteration(searchIter);
@@ -93,13 +112,9 @@ bool QTPFS::PathSearch::Execute(
 		havePartPath = (minNode != srcNode);
 
 		if (haveFullPath)
-			openNodes.reset();
+			threadData->openNodes.reset();
 	}
 
-	if (srcNode->GetMoveCost() == 0.0f)
-		srcNode->SetMoveCost(QTPFS_POSITIVE_INFINITY);
-
-
 	#ifdef QTPFS_SUPPORT_PARTIAL_SEARCHES
 	// adjust the target-point if we only got a partial result
 	// NOTE:
@@ -136,8 +151,8 @@ void QTPFS::PathSearch::ResetState(INode* node) {
 		hCosts[i] = 0.0f;
 	}
 
-	openNodes.reset();
-	openNodes.push(node);
+	threadData->openNodes.reset();
+	threadData->openNodes.push(&GetSearchNode(node));
 }
 
 void QTPFS::PathSearch::UpdateNode(INode* nextNode, INode* prevNode, unsigned int netPointIdx) {
@@ -146,23 +161,28 @@ void QTPFS::PathSearch::UpdateNode(INode* nextNode, INode* prevNode, unsigned in
 	//   but this is *impossible* to achieve on a non-regular
 	//   grid on which any node only has an average move-cost
 	//   associated with it --> paths will be "nearly optimal"
-	nextNode->SetPrevNode(prevNode);
-	nextNode->SetPathCosts(gCosts[netPointIdx], hCosts[netPointIdx]);
-	nextNode->SetSearchState(searchState | NODE_STATE_OPEN);
-	nextNode->SetNeighborEdgeTransitionPoint(0, netPoints[netPointIdx]);
+	SearchNode& nextSearchNode = GetSearchNode(nextNode);
+
+	nextSearchNode.node = nextNode;
+	nextSearchNode.prevNode = prevNode;
+	nextSearchNode.netPoint = netPoints[netPointIdx];
+	nextSearchNode.searchState = searchState | NODE_STATE_OPEN;
+	nextSearchNode.SetPathCosts(gCosts[netPointIdx], hCosts[netPointIdx]);
 }
 
-void QTPFS::PathSearch::IterateNodes(const std::vector<INode*>& allNodes) {
-	curNode = openNodes.top();
-	curNode->SetSearchState(searchState | NODE_STATE_CLOSED);
+void QTPFS::PathSearch::IterateNodes() {
+	SearchNode* curSearchNode = threadData->openNodes.top();
+
+	curNode = curSearchNode->node;
+	curSearchNode->searchState = searchState | NODE_STATE_CLOSED;
 	#ifdef QTPFS_CONSERVATIVE_NEIGHBOR_CACHE_UPDATES
 	// in the non-conservative case, this is done from
 	// NodeLayer::ExecNodeNeighborCacheUpdates instead
 	curNode->SetMagicNumber(searchMagic);
 	#endif
 
-	openNodes.pop();
-	openNodes.check_heap_property(0);
+	threadData->openNodes.pop();
+	threadData->openNodes.check_heap_property(0);
 
 	#ifdef QTPFS_TRACE_PATH_SEARCHES
 	searchIter.SetPoppedNodeIdx(curNode->zmin() * mapDims.mapx + curNode->xmin());
@@ -170,7 +190,7 @@ void QTPFS::PathSearch::IterateNodes(const std::vector<INode*>& allNodes) {
 
 	if (curNode == tgtNode)
 		return;
-	if (curNode->AllSquaresImpassable())
+	if (IsImpassable(curNode))
 		return;
 
 	if (curNode->xmid() < searchRect.x1) return;
@@ -180,19 +200,27 @@ void QTPFS::PathSearch::IterateNodes(const std::vector<INode*>& allNodes) {
 
 	#ifdef QTPFS_SUPPORT_PARTIAL_SEARCHES
 	// remember the node with lowest h-cost in case the search fails to reach tgtNode
-	if (curNode->GetPathCost(NODE_PATH_COST_H) < minNode->GetPathCost(NODE_PATH_COST_H))
+	if (curSearchNode->GetPathCost(NODE_PATH_COST_H) < GetSearchNode(minNode).GetPathCost(NODE_PATH_COST_H))
 		minNode = curNode;
 	#endif
 
-	IterateNodeNeighbors(curNode->GetNeighbors(allNodes));
+	IterateNodeNeighbors(curNode->GetNeighbors(*nodeLayer));
 }
 
-void QTPFS::PathSearch::IterateNodeNeighbors(const std::vector<INode*>& nxtNodes) {
+void QTPFS::PathSearch::IterateNodeNeighbors(unsigned int numNgbs) {
+	if (numNgbs == 0)
+		return;
+
+	const SearchNode& curSearchNode = GetSearchNode(curNode);
+
+	const unsigned int* ngbIndices = nodeLayer->GetNodeNeighbors(curNode->GetNeighborsOffset());
+	const float2* ngbNetpoints = nodeLayer->GetNodeNetpoints(curNode->GetNeighborsOffset());
+
 	// if curNode equals srcNode, this is just the original srcPoint
-	const float2& curPoint2 = curNode->GetNeighborEdgeTransitionPoint(0);
+	const float2& curPoint2 = curSearchNode.netPoint;
 	const float3  curPoint  = {curPoint2.x, 0.0f, curPoint2.y};
 
-	for (unsigned int i = 0; i < nxtNodes.size(); i++) {
+	for (unsigned int i = 0; i < numNgbs; i++) {
 		// NOTE:
 		//   this uses the actual distance that edges of the final path will cover,
 		//   from <curPoint> (initialized to sourcePoint) to a position on the edge
@@ -210,13 +238,15 @@ void QTPFS::PathSearch::IterateNodeNeighbors(const std::vector<INode*>& nxtNodes
 		//   in the first case we would explore many more nodes than necessary (CPU
 		//   nightmare), while in the second we would get low-quality paths (player
 		//   nightmare)
-		nxtNode = nxtNodes[i];
+		nxtNode = nodeLayer->GetNodeByIndex(ngbIndices[i]);
 
-		if (nxtNode->AllSquaresImpassable())
+		if (IsImpassable(nxtNode))
 			continue;
 
-		const bool isCurrent = (nxtNode->GetSearchState() >= searchState);
-		const bool isClosed = ((nxtNode->GetSearchState() & 1) == NODE_STATE_CLOSED);
+		SearchNode& nxtSearchNode = GetSearchNode(nxtNode);
+
+		const bool isCurrent = (nxtSearchNode.searchState >= searchState);
+		const bool isClosed = ((nxtSearchNode.searchState & 1) == NODE_STATE_CLOSED);
 		const bool isTarget = (nxtNode == tgtNode);
 
 		unsigned int netPointIdx = 0;
@@ -228,16 +258,16 @@ void QTPFS::PathSearch::IterateNodeNeighbors(const std::vector<INode*>& nxtNodes
 			// to be fancy (note that this is not always the best
 			// option, it causes local and global sub-optimalities
 			// which SmoothPath can only partially address)
-			netPoints[0] = curNode->GetNeighborEdgeTransitionPoint(1 + i);
+			netPoints[0] = ngbNetpoints[i];
 
 			// cannot use squared-distances because that will bias paths
 			// towards smaller nodes (eg. 1^2 + 1^2 + 1^2 + 1^2 != 4^2)
 			gDists[0] = curPoint.distance({netPoints[0].x, 0.0f, netPoints[0].y});
 			hDists[0] = tgtPoint.distance({netPoints[0].x, 0.0f, netPoints[0].y});
 			gCosts[0] =
-				curNode->GetPathCost(NODE_PATH_COST_G) +
-				curNode->GetMoveCost() * gDists[0] +
-				nxtNode->GetMoveCost() * hDists[0] * int(isTarget);
+				curSearchNode.GetPathCost(NODE_PATH_COST_G) +
+				GetMoveCost(curNode) * gDists[0] +
+				GetMoveCost(nxtNode) * hDists[0] * int(isTarget);
 			hCosts[0] = hDists[0] * hCostMult * int(!isTarget);
 		}
 		#else
@@ -248,14 +278,14 @@ void QTPFS::PathSearch::IterateNodeNeighbors(const std::vector<INode*>& nxtNodes
 		// not handle; more points means a greater degree
 		// of non-cardinality (but gets expensive quickly)
 		for (unsigned int j = 0; j < QTPFS_MAX_NETPOINTS_PER_NODE_EDGE; j++) {
-			netPoints[j] = curNode->GetNeighborEdgeTransitionPoint(1 + i * QTPFS_MAX_NETPOINTS_PER_NODE_EDGE + j);
+			netPoints[j] = ngbNetpoints[i * QTPFS_MAX_NETPOINTS_PER_NODE_EDGE + j];
 
 			gDists[j] = curPoint.distance({netPoints[j].x, 0.0f, netPoints[j].y});
 			hDists[j] = tgtPoint.distance({netPoints[j].x, 0.0f, netPoints[j].y});
 			gCosts[j] =
-				curNode->GetPathCost(NODE_PATH_COST_G) +
-				curNode->GetMoveCost() * gDists[j] +
-				nxtNode->GetMoveCost() * hDists[j] * int(isTarget);
+				curSearchNode.GetPathCost(NODE_PATH_COST_G) +
+				GetMoveCost(curNode) * gDists[j] +
+				GetMoveCost(nxtNode) * hDists[j] * int(isTarget);
 			hCosts[j] = hDists[j] * hCostMult * int(!isTarget);
 
 			if ((gCosts[j] + hCosts[j]) < (gCosts[netPointIdx] + hCosts[netPointIdx])) {
@@ -267,8 +297,8 @@ void QTPFS::PathSearch::IterateNodeNeighbors(const std::vector<INode*>& nxtNodes
 		if (!isCurrent) {
 			UpdateNode(nxtNode, curNode, netPointIdx);
 
-			openNodes.push(nxtNode);
-			openNodes.check_heap_property(0);
+			threadData->openNodes.push(&nxtSearchNode);
+			threadData->openNodes.check_heap_property(0);
 
 			#ifdef QTPFS_TRACE_PATH_SEARCHES
 			searchIter.AddPushedNodeIdx(nxtNode->zmin() * mapDims.mapx + nxtNode->xmin());
@@ -276,10 +306,10 @@ void QTPFS::PathSearch::IterateNodeNeighbors(const std::vector<INode*>& nxtNodes
 
 			continue;
 		}
-		if (gCosts[netPointIdx] >= nxtNode->GetPathCost(NODE_PATH_COST_G))
+		if (gCosts[netPointIdx] >= nxtSearchNode.GetPathCost(NODE_PATH_COST_G))
 			continue;
 		if (isClosed)
-			openNodes.push(nxtNode);
+			threadData->openNodes.push(&nxtSearchNode);
 
 		UpdateNode(nxtNode, curNode, netPointIdx);
 
@@ -287,8 +317,8 @@ void QTPFS::PathSearch::IterateNodeNeighbors(const std::vector<INode*>& nxtNodes
 		// (changing the f-cost of an OPEN node messes up the
 		// queue's internal consistency; a pushed node remains
 		// OPEN until it gets popped)
-		openNodes.resort(nxtNode);
-		openNodes.check_heap_property(0);
+		threadData->openNodes.resort(&nxtSearchNode);
+		threadData->openNodes.check_heap_property(0);
 	}
 }
 
@@ -301,8 +331,10 @@ void QTPFS::PathSearch::Finalize(IPath* path) {
 
 	path->SetBoundingBox();
 
-	// path remains in live-cache until DeletePath is called
-	pathCache->AddLivePath(path);
+	// NOTE:
+	//   this can run concurrently with other searches, the caller
+	//   moves path into the live-cache (where it remains until
+	//   DeletePath is called) once all searches are done
 }
 
 void QTPFS::PathSearch::TracePath(IPath* path) {
@@ -311,12 +343,12 @@ void QTPFS::PathSearch::TracePath(IPath* path) {
 
 	if (srcNode != tgtNode) {
 		INode* tmpNode = tgtNode;
-		INode* prvNode = tmpNode->GetPrevNode();
+		INode* prvNode = GetSearchNode(tmpNode).prevNode;
 
 		float3 prvPoint = tgtPoint;
 
 		while ((prvNode != nullptr) && (tmpNode != srcNode)) {
-			const float2& tmpPoint2 = tmpNode->GetNeighborEdgeTransitionPoint(0);
+			const float2& tmpPoint2 = GetSearchNode(tmpNode).netPoint;
 			const float3  tmpPoint  = {tmpPoint2.x, 0.0f, tmpPoint2.y};
 
 			assert(!math::isinf(tmpPoint.x) && !math::isinf(tmpPoint.z));
@@ -335,12 +367,12 @@ void QTPFS::PathSearch::TracePath(IPath* path) {
 			// make sure the back-pointers can never become dangling
 			// (if smoothing IS enabled, we delay this until we reach
 			// SmoothPath() because we still need them there)
-			tmpNode->SetPrevNode(nullptr);
+			GetSearchNode(tmpNode).prevNode = nullptr;
 			#endif
 
 			prvPoint = tmpPoint;
 			tmpNode = prvNode;
-			prvNode = tmpNode->GetPrevNode();
+			prvNode = GetSearchNode(tmpNode).prevNode;
 		}
 	}
 
@@ -366,7 +398,7 @@ void QTPFS::PathSearch::SmoothPath(IPath* path) const {
 	if (path->NumPoints() == 2)
 		return;
 
-	assert(srcNode->GetPrevNode() == NULL);
+	assert(GetSearchNode(srcNode).prevNode == NULL);
 
 	for (unsigned int k = 0; k < QTPFS_MAX_SMOOTHING_ITERATIONS; k++) {
 		if (!SmoothPathIter(path)) {
@@ -380,10 +412,10 @@ void QTPFS::PathSearch::SmoothPath(IPath* path) const {
 
 	while (n1 != srcNode) {
 		n0 = n1;
-		n1 = n0->GetPrevNode();
+		n1 = GetSearchNode(n0).prevNode;
 
 		// reset back-pointers
-		n0->SetPrevNode(NULL);
+		GetSearchNode(n0).prevNode = NULL;
 	}
 }
 
@@ -400,7 +432,7 @@ bool QTPFS::PathSearch::SmoothPathIter(IPath* path) const {
 
 	while (n1 != srcNode) {
 		n0 = n1;
-		n1 = n0->GetPrevNode();
+		n1 = GetSearchNode(n0).prevNode;
 		ni -= 1;
 
 		assert(n1->GetNeighborRelation(n0) != 0);
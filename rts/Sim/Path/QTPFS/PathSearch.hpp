@@ -6,6 +6,7 @@
 #include <vector>
 
 #include "PathDefines.hpp"
+#include "PathEnums.hpp"
 #include "Node.hpp"
 #include "NodeHeap.hpp"
 
@@ -65,12 +66,56 @@ namespace QTPFS {
 	}
 
 
+	// per-search state of a node; lives in per-thread arrays (indexed
+	// by INode::GetNodeIndex) rather than in the node-tree, s.t. the
+	// tree stays read-only during searches and independent searches
+	// can be executed concurrently
+	struct SearchNode {
+	public:
+		bool operator <  (const SearchNode* n) const { return (pathCosts[NODE_PATH_COST_F] <  n->pathCosts[NODE_PATH_COST_F]); }
+		bool operator >  (const SearchNode* n) const { return (pathCosts[NODE_PATH_COST_F] >  n->pathCosts[NODE_PATH_COST_F]); }
+		bool operator == (const SearchNode* n) const { return (pathCosts[NODE_PATH_COST_F] == n->pathCosts[NODE_PATH_COST_F]); }
+		bool operator <= (const SearchNode* n) const { return (pathCosts[NODE_PATH_COST_F] <= n->pathCosts[NODE_PATH_COST_F]); }
+		bool operator >= (const SearchNode* n) const { return (pathCosts[NODE_PATH_COST_F] >= n->pathCosts[NODE_PATH_COST_F]); }
+
+		void SetHeapIndex(unsigned int n) { heapIndex = n; }
+		unsigned int GetHeapIndex() const { return heapIndex; }
+		float GetHeapPriority() const { return pathCosts[NODE_PATH_COST_F]; }
+
+		void SetPathCosts(float g, float h) { pathCosts[NODE_PATH_COST_F] = g + h; pathCosts[NODE_PATH_COST_G] = g; pathCosts[NODE_PATH_COST_H] = h; }
+		float GetPathCost(unsigned int type) const { return pathCosts[type]; }
+
+	public:
+		INode* node = nullptr;
+		// points back to previous node in path
+		INode* prevNode = nullptr;
+		// position on the edge via which this node was entered
+		float2 netPoint;
+
+		float pathCosts[3] = {0.0f, 0.0f, 0.0f};
+
+		// NOTE:
+		//     storing the heap-index is an *UGLY* break of abstraction,
+		//     but the only way to keep the cost of resorting acceptable
+		unsigned int heapIndex = -1u;
+		unsigned int searchState = 0;
+	};
+
+	struct SearchThreadData {
+		// allocated once, re-used by all searches on this thread without clear()'s
+		// this relies on SearchNode::operator< to sort by increasing f-cost
+		binary_heap<SearchNode*> openNodes;
+		std::vector<SearchNode> searchNodes;
+
+		// advanced by NODE_STATE_OFFSET per search; identifies stale searchNodes
+		unsigned int searchState = 0;
+	};
+
+
 	// NOTE:
-	//     we could support "time-sliced" execution, but we would have
-	//     to isolate each query from modifying another's INode members
-	//     (*Cost, nodeState, etc.) --> memory-intensive
-	//     also, terrain changes could invalidate partial paths without
-	//     buffering the *entire* heightmap each frame --> not efficient
+	//     we could support "time-sliced" execution, but terrain changes
+	//     could invalidate partial paths without buffering the *entire*
+	//     heightmap each frame --> not efficient
 	// NOTE:
 	//     with time-sliced execution, {src,tgt,cur,nxt}Node can become
 	//     dangling
@@ -91,10 +136,10 @@ namespace QTPFS {
 			const float3& targetPoint,
 			const SRectangle& searchArea
 		) = 0;
-		virtual bool Execute(
-			unsigned int searchStateOffset = 0,
-			unsigned int searchMagicNumber = 0
-		) = 0;
+		// Execute and Finalize may run on a worker thread, but
+		// must both run on the same one without other searches
+		// executing on it in between
+		virtual bool Execute(unsigned int searchMagicNumber = 0) = 0;
 		virtual void Finalize(IPath* path) = 0;
 		virtual bool SharedFinalize(const IPath* srcPath, IPath* dstPath) { return false; }
 		virtual PathSearchTrace::Execution* GetExecutionTrace() { return NULL; }
@@ -111,7 +156,7 @@ namespace QTPFS {
 		unsigned int searchTeam;   // which team queued this search
 
 		unsigned int searchType;   // indicates if Dijkstra (h==0) or A* (h!=0) search is employed
-		unsigned int searchState;  // offset that identifies nodes as part of current search
+		unsigned int searchState;  // identifies nodes as part of current search (per thread)
 		unsigned int searchMagic;  // used to signal nodes they should update their neighbor-set
 	};
 
@@ -122,6 +167,7 @@ namespace QTPFS {
 			: IPathSearch(pathSearchType)
 			, nodeLayer(NULL)
 			, pathCache(NULL)
+			, threadData(NULL)
 			, searchExec(NULL)
 			, srcNode(NULL)
 			, tgtNode(NULL)
@@ -129,10 +175,11 @@ namespace QTPFS {
 			, nxtNode(NULL)
 			, minNode(NULL)
 			, hCostMult(0.0f)
+			, srcMoveCost(0.0f)
 			, haveFullPath(false)
 			, havePartPath(false)
 			{}
-		~PathSearch() { openNodes.reset(); }
+		~PathSearch() {}
 
 		void Initialize(
 			NodeLayer* layer,
@@ -141,37 +188,42 @@ namespace QTPFS {
 			const float3& targetPoint,
 			const SRectangle& searchArea
 		) override;
-		bool Execute(
-			unsigned int searchStateOffset = 0,
-			unsigned int searchMagicNumber = 0
-		) override;
+		bool Execute(unsigned int searchMagicNumber = 0) override;
 		void Finalize(IPath* path) override;
 		bool SharedFinalize(const IPath* srcPath, IPath* dstPath) override;
 		PathSearchTrace::Execution* GetExecutionTrace() override { return searchExec; }
 
 		const std::uint64_t GetHash(std::uint64_t N, std::uint32_t k) const override;
 
-		static void InitGlobalQueue(unsigned int n) { openNodes.reserve(n); }
-		static void FreeGlobalQueue() { openNodes.clear(); }
+		static void InitThreadData(unsigned int numLeafNodes);
+		static void FreeThreadData();
 
 	private:
+		SearchNode& GetSearchNode(const INode* n) const { return threadData->searchNodes[n->GetNodeIndex()]; }
+
+		// searches may start from an impassable node (because single
+		// nodes can represent many terrain squares, some of which can
+		// still be passable and allow a unit to move within a node),
+		// srcNode is treated as having zero cost in that case
+		float GetMoveCost(const INode* n) const { return ((n == srcNode)? srcMoveCost: n->GetMoveCost()); }
+		bool IsImpassable(const INode* n) const { return (n != srcNode && n->AllSquaresImpassable()); }
+
 		void ResetState(INode* node);
 		void UpdateNode(INode* nextNode, INode* prevNode, unsigned int netPointIdx);
 
-		void IterateNodes(const std::vector<INode*>& allNodes);
-		void IterateNodeNeighbors(const std::vector<INode*>& nxtNodes);
+		void IterateNodes();
+		void IterateNodeNeighbors(unsigned int numNgbs);
 
 		void TracePath(IPath* path);
 		void SmoothPath(IPath* path) const;
 		bool SmoothPathIter(IPath* path) const;
 
-		// global queue: allocated once, re-used by all searches without clear()'s
-		// this relies on INode::operator< to sort the INode*'s by increasing f-cost
-		static binary_heap<INode*> openNodes;
-
 		NodeLayer* nodeLayer;
 		PathCache* pathCache;
 
+		// data of the thread executing this search, set by Execute
+		SearchThreadData* threadData;
+
 		// not used unless QTPFS_TRACE_PATH_SEARCHES is defined
 		PathSearchTrace::Execution* searchExec;
 		PathSearchTrace::Iteration searchIter;
@@ -193,6 +245,7 @@ namespace QTPFS {
 		float hCosts[QTPFS_MAX_NETPOINTS_PER_NODE_EDGE];
 
 		float hCostMult;
+		float srcMoveCost;
 
 		bool haveFullPath;
 		bool havePartPath;
@@ -0,0 +1,286 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <cassert>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "ExpGenSpawnTemplate.h"
+#include "ExpGenSpawnableMemberInfo.h"
+#include "Game/GlobalUnsynced.h" // guRNG
+#include "System/Exceptions.h"
+#include "System/float3.h"
+#include "System/SafeUtil.h"
+#include "System/SpringMath.h"
+#include "System/StringUtil.h"
+#include "System/Log/ILog.h"
+
+
+// operators whose result only depends on val and their argument
+static bool IsConstantOp(std::uint8_t op)
+{
+	switch (op) {
+		case CExpGenSpawnTemplate::OP_ADD:
+		case CExpGenSpawnTemplate::OP_SAWTOOTH:
+		case CExpGenSpawnTemplate::OP_DISCRETE:
+		case CExpGenSpawnTemplate::OP_SINE:
+		case CExpGenSpawnTemplate::OP_POW: {
+			return true;
+		} break;
+		default: {
+		} break;
+	}
+
+	return false;
+}
+
+static float EvalConstantOp(std::uint8_t op, float arg, float val)
+{
+	switch (op) {
+		case CExpGenSpawnTemplate::OP_ADD     : { return (val + arg); } break;
+		// this translates to modulo except it works with floats
+		case CExpGenSpawnTemplate::OP_SAWTOOTH: { return (val - arg * math::floor(val / arg)); } break;
+		case CExpGenSpawnTemplate::OP_DISCRETE: { return (arg * math::floor(spring::SafeDivide(val, arg))); } break;
+		case CExpGenSpawnTemplate::OP_SINE    : { return (arg * math::sin(val)); } break;
+		case CExpGenSpawnTemplate::OP_POW     : { return (math::pow(val, arg)); } break;
+		default: {
+			assert(false);
+		} break;
+	}
+
+	return val;
+}
+
+
+
+void CExpGenSpawnTemplate::Clear()
+{
+	instrs.clear();
+	usesBuffer = false;
+}
+
+void CExpGenSpawnTemplate::AddInstr(std::uint8_t op, std::uint8_t size, std::uint16_t offset)
+{
+	Instr instr;
+	instr.op = op;
+	instr.size = size;
+	instr.offset = offset;
+	instr.arg.p = nullptr;
+	instrs.push_back(instr);
+}
+
+void CExpGenSpawnTemplate::AddInstr(std::uint8_t op, float arg)
+{
+	AddInstr(op, 0, 0);
+	instrs.back().arg.f = arg;
+}
+
+void CExpGenSpawnTemplate::AddInstr(std::uint8_t op, std::int32_t arg)
+{
+	AddInstr(op, 0, 0);
+	instrs.back().arg.i = arg;
+}
+
+
+void CExpGenSpawnTemplate::AddProperty(const std::string& script, const SExpGenSpawnableMemberInfo& memberInfo)
+{
+	const std::string content = script.substr(0, script.find(';', 0));
+
+	const bool isFloat = (memberInfo.type == SExpGenSpawnableMemberInfo::TYPE_FLOAT);
+
+	if (content == "dir") {
+		// dir keyword; type has to be float3
+		if (!isFloat || memberInfo.length < 3)
+			throw content_error("[CEGST::AddProperty] incorrect use of \"dir\" (" + script + ")");
+
+		AddInstr(OP_DIR, 0, memberInfo.offset);
+		return;
+	}
+
+	// arrays (float3 or float4)
+	if (memberInfo.length > 1) {
+		std::string::size_type start = 0;
+		SExpGenSpawnableMemberInfo subInfo = memberInfo;
+		subInfo.length = 1;
+
+		for (unsigned int i = 0; i < memberInfo.length && start < script.length(); ++i) {
+			const std::string::size_type subEnd = script.find(',', start + 1);
+
+			AddProperty(script.substr(start, subEnd - start), subInfo);
+
+			start = subEnd + 1;
+			subInfo.offset += subInfo.size;
+		}
+
+		return;
+	}
+
+	// textures, colormaps, etc.
+	if (memberInfo.type == SExpGenSpawnableMemberInfo::TYPE_PTR) {
+		// Memory is managed by whomever this callback belongs to
+		AddInstr(OP_STOREP, 0, memberInfo.offset);
+		instrs.back().arg.p = memberInfo.ptrCallback(content);
+		return;
+	}
+
+	AddScalarProperty(script, memberInfo);
+}
+
+void CExpGenSpawnTemplate::AddScalarProperty(const std::string& script, const SExpGenSpawnableMemberInfo& memberInfo)
+{
+	const bool isFloat = (memberInfo.type == SExpGenSpawnableMemberInfo::TYPE_FLOAT);
+	const bool isInt   = (memberInfo.type == SExpGenSpawnableMemberInfo::TYPE_INT  );
+
+	// Floats or Ints
+	assert(isFloat || isInt);
+
+	if (isFloat) {
+		switch (memberInfo.size) {
+			case 4: {} break;
+			default: { throw content_error("[CEGST::AddProperty] incompatible float size \"" + IntToString(memberInfo.size) + "\" (" + script + ")"); } break;
+		}
+	} else {
+		switch (memberInfo.size) {
+			case 1: case 2: case 4: {} break;
+			default: { throw content_error("[CEGST::AddProperty] incompatible integer size \"" + IntToString(memberInfo.size) + "\" (" + script + ")"); } break;
+		}
+	}
+
+	const size_t firstInstr = instrs.size();
+
+	// parse the code
+	for (size_t p = 0, len = script.length(); p < len; ) {
+		std::uint8_t opcode = 0;
+		char c = script[p++];
+
+		// consume whitespace
+		if (c == ' ')
+			continue;
+
+		bool useInt = false;
+
+		     if (c == 'i')   opcode = OP_INDEX;
+		else if (c == 'r')   opcode = OP_RAND;
+		else if (c == 'd')   opcode = OP_DAMAGE;
+		else if (c == 'm')   opcode = OP_SAWTOOTH;
+		else if (c == 'k')   opcode = OP_DISCRETE;
+		else if (c == 's')   opcode = OP_SINE;
+		else if (c == 'p')   opcode = OP_POW;
+		else if (c == 'y') { opcode = OP_YANK;     useInt = true; }
+		else if (c == 'x') { opcode = OP_MULTIPLY; useInt = true; }
+		else if (c == 'a') { opcode = OP_ADDBUFF;  useInt = true; }
+		else if (c == 'q') { opcode = OP_POWBUFF;  useInt = true; }
+		else if (isdigit(c) || c == '.' || c == '-') { opcode = OP_ADD; p--; }
+		else {
+			LOG_L(L_WARNING, "[CEGST::%s] unknown op-code \"%c\" in \"%s\" at index " _STPF_ "", __func__, c, script.c_str(), p);
+			continue;
+		}
+
+		// be sure to exit cleanly if there are no more operators or operands
+		if (p >= script.size())
+			continue;
+
+		char* endp = nullptr;
+
+		if (!useInt) {
+			const float v = (float)strtod(&script[p], &endp);
+
+			p += (endp - &script[p]);
+
+			AddInstr(opcode, v);
+		} else {
+			const std::int32_t v = Clamp(int(strtol(&script[p], &endp, 10)), 0, BUFFER_SIZE - 1);
+
+			p += (endp - &script[p]);
+
+			AddInstr(opcode, v);
+			usesBuffer = true;
+		}
+	}
+
+	// val is always zero when a property starts, so a sequence of operators
+	// that neither reads nor writes anything but val can be evaluated here
+	bool isConstant = true;
+
+	for (size_t n = firstInstr; n < instrs.size() && isConstant; n++) {
+		isConstant &= IsConstantOp(instrs[n].op);
+	}
+
+	if (isConstant && firstInstr < instrs.size()) {
+		float val = 0.0f;
+
+		for (size_t n = firstInstr; n < instrs.size(); n++) {
+			val = EvalConstantOp(instrs[n].op, instrs[n].arg.f, val);
+		}
+
+		instrs.resize(firstInstr);
+
+		if (val != 0.0f || std::signbit(val))
+			AddInstr(OP_CONST, val);
+	}
+
+	// store the final value
+	AddInstr(isFloat ? OP_STOREF : OP_STOREI, memberInfo.size, memberInfo.offset);
+}
+
+
+
+void CExpGenSpawnTemplate::Execute(char* instance, float damage, int spawnIndex, const float3& dir) const
+{
+	float val = 0.0f;
+	float buffer[BUFFER_SIZE];
+
+	if (usesBuffer)
+		std::memset(&buffer[0], 0, sizeof(buffer));
+
+	for (const Instr& instr: instrs) {
+		switch (instr.op) {
+			case OP_STOREI: {
+				switch (instr.size) {
+					case 1: { *(std::int8_t*)  (instance + instr.offset) = (int) val; } break;
+					case 2: { *(std::int16_t*) (instance + instr.offset) = (int) val; } break;
+					case 4: { *(std::int32_t*) (instance + instr.offset) = (int) val; } break;
+					default: { /*no op*/ } break;
+				}
+				val = 0.0f;
+			} break;
+			case OP_STOREF: {
+				*(float*) (instance + instr.offset) = val;
+				val = 0.0f;
+			} break;
+
+			case OP_CONST : { val = instr.arg.f; } break;
+			case OP_ADD   : { val += instr.arg.f; } break;
+			case OP_RAND  : { val += guRNG.NextFloat() * instr.arg.f; } break;
+			case OP_DAMAGE: { val += damage * instr.arg.f; } break;
+			case OP_INDEX : { val += spawnIndex * instr.arg.f; } break;
+
+			case OP_STOREP: {
+				*(void**) (instance + instr.offset) = instr.arg.p;
+			} break;
+			case OP_DIR: {
+				*reinterpret_cast<float3*>(instance + instr.offset) = dir;
+			} break;
+
+			case OP_SAWTOOTH:
+			case OP_DISCRETE:
+			case OP_SINE:
+			case OP_POW: {
+				val = EvalConstantOp(instr.op, instr.arg.f, val);
+			} break;
+
+			case OP_YANK: {
+				buffer[instr.arg.i] = val;
+				val = 0.0f;
+			} break;
+			case OP_MULTIPLY: { val *= buffer[instr.arg.i]; } break;
+			case OP_ADDBUFF : { val += buffer[instr.arg.i]; } break;
+			case OP_POWBUFF : { val = math::pow(val, buffer[instr.arg.i]); } break;
+
+			default: {
+				assert(false);
+			} break;
+		}
+	}
+}
@@ -0,0 +1,82 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef EXP_GEN_SPAWN_TEMPLATE_H
+#define EXP_GEN_SPAWN_TEMPLATE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class float3;
+struct SExpGenSpawnableMemberInfo;
+
+/**
+ * Compiled form of the "properties" table of a single CEG spawn.
+ *
+ * Every property string is translated once (when the CEG is loaded) into a
+ * sequence of fixed-size instructions addressing the spawnable's members by
+ * their offset; Execute then only has to walk this list for each instance.
+ * Property components which do not depend on the damage, spawn-index, the
+ * RNG or the yank-buffer are evaluated at load time and stored as constants.
+ */
+class CExpGenSpawnTemplate
+{
+public:
+	enum {
+		OP_STOREI   =  1, // int
+		OP_STOREF   =  2, // float
+		OP_CONST    =  3, // replaces val by a value folded at load time
+		OP_ADD      =  4,
+		OP_RAND     =  5,
+		OP_DAMAGE   =  6,
+		OP_INDEX    =  7,
+		OP_STOREP   =  9, // store a void* (texture, colormap, ...)
+		OP_DIR      = 10, // store the float3 direction
+		OP_SAWTOOTH = 11, // Performs a modulo to create a sawtooth wave
+		OP_DISCRETE = 12, // Floors the value to a multiple of its parameter
+		OP_SINE     = 13, // Uses val as the phase of a sine wave
+		OP_YANK     = 14, // Moves the input value into a buffer, returns zero
+		OP_MULTIPLY = 15, // Multiplies with buffer value
+		OP_ADDBUFF  = 16, // Adds buffer value
+		OP_POW      = 17, // Power with code as exponent
+		OP_POWBUFF  = 18, // Power with buffer as exponent
+	};
+
+	// the parser clamps buffer indices to [0, 16]
+	static constexpr int BUFFER_SIZE = 17;
+
+	struct Instr {
+		std::uint8_t op;
+		std::uint8_t size;
+		std::uint16_t offset;
+
+		union {
+			float f;
+			std::int32_t i;
+			void* p;
+		} arg;
+	};
+
+public:
+	/// @throws content_error on invalid member types or uses of "dir"
+	void AddProperty(const std::string& script, const SExpGenSpawnableMemberInfo& memberInfo);
+	void Clear();
+
+	void Execute(char* instance, float damage, int spawnIndex, const float3& dir) const;
+
+	size_t GetNumInstrs() const { return instrs.size(); }
+	bool UsesBuffer() const { return usesBuffer; }
+
+private:
+	void AddScalarProperty(const std::string& script, const SExpGenSpawnableMemberInfo& memberInfo);
+	void AddInstr(std::uint8_t op, std::uint8_t size, std::uint16_t offset);
+	void AddInstr(std::uint8_t op, float arg);
+	void AddInstr(std::uint8_t op, std::int32_t arg);
+
+private:
+	std::vector<Instr> instrs;
+
+	bool usesBuffer = false;
+};
+
+#endif // EXP_GEN_SPAWN_TEMPLATE_H
@@ -106,15 +106,20 @@ int CExpGenSpawnable::GetSpawnableID(const std::string& spawnableName)
 
 CExpGenSpawnable* CExpGenSpawnable::CreateSpawnable(int spawnableID)
 {
-	int i = 0;
-#define CHECK_SPAWNABLE(spawnable)               \
-	if (spawnableID == i)                        \
-		return (projMemPool.alloc<spawnable>()); \
-	++i;
+	typedef CExpGenSpawnable* (*SpawnFunc)();
 
-	CHECK_ALL_SPAWNABLES()
+	// indexed by spawnable-ID; saves walking the whole list for every spawn
+	static const SpawnFunc spawnFuncs[] = {
+#define CHECK_SPAWNABLE(spawnable) \
+		[]() -> CExpGenSpawnable* { return (projMemPool.alloc<spawnable>()); },
+
+		CHECK_ALL_SPAWNABLES()
 
 #undef CHECK_SPAWNABLE
+	};
+
+	if (static_cast<unsigned int>(spawnableID) >= (sizeof(spawnFuncs) / sizeof(spawnFuncs[0])))
+		return nullptr;
 
-	return nullptr;
+	return (spawnFuncs[spawnableID]());
 }
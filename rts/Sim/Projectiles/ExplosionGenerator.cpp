@@ -280,7 +280,7 @@ unsigned int CExplosionGeneratorHandler::LoadGeneratorID(const char* tag, const
 // creates either a standard or a custom explosion generator instance
 // NOTE:
 //   can be called recursively for custom instances (LoadGenerator ->
-//   Load -> ParseExplosionCode -> LoadGenerator -> ...), generators
+//   Load -> AddProperty -> LoadGenerator -> ...), generators
 //   must NOT be overwritten
 IExplosionGenerator* CExplosionGeneratorHandler::LoadGenerator(const char* tag, const char* pre)
 {
@@ -577,268 +577,6 @@ bool CStdExplosionGenerator::Explosion(
 
 
 
-void CCustomExplosionGenerator::ExecuteExplosionCode(const char* code, float damage, char* instance, int spawnIndex, const float3& dir)
-{
-	float val = 0.0f;
-	float buffer[16];
-	void* ptr = nullptr;
-
-	std::memset(&buffer[0], 0, sizeof(buffer));
-
-	for (;;) {
-		switch (*(code++)) {
-			case OP_END: {
-				return;
-			}
-			case OP_STOREI: {
-				std::uint8_t  size   = *(std::uint8_t*)  code; code++;
-				std::uint16_t offset = *(std::uint16_t*) code; code += 2;
-				switch (size) {
-					case 1: { *(std::int8_t*)  (instance + offset) = (int) val; } break;
-					case 2: { *(std::int16_t*) (instance + offset) = (int) val; } break;
-					case 4: { *(std::int32_t*) (instance + offset) = (int) val; } break;
-					case 8: { *(std::int64_t*) (instance + offset) = (int) val; } break;
-					default: { /*no op*/ } break;
-				}
-				val = 0.0f;
-				break;
-			}
-			case OP_STOREF: {
-				std::uint8_t  size   = *(std::uint8_t*)  code; code++;
-				std::uint16_t offset = *(std::uint16_t*) code; code += 2;
-				switch (size) {
-					case 4: { *(float*)  (instance + offset) = val; } break;
-					case 8: { *(double*) (instance + offset) = val; } break;
-					default: { /*no op*/ } break;
-				}
-				val = 0.0f;
-				break;
-			}
-			case OP_ADD: {
-				val += *(float*) code;
-				code += 4;
-				break;
-			}
-			case OP_RAND: {
-				val += guRNG.NextFloat() * (*(float*) code);
-				code += 4;
-				break;
-			}
-			case OP_DAMAGE: {
-				val += damage * (*(float*) code);
-				code += 4;
-				break;
-			}
-			case OP_INDEX: {
-				val += spawnIndex * (*(float*) code);
-				code += 4;
-				break;
-			}
-
-			case OP_LOADP: {
-				ptr = *(void**) code;
-				code += sizeof(void*);
-				break;
-			}
-			case OP_STOREP: {
-				std::uint16_t offset = *(std::uint16_t*) code;
-				code += 2;
-				*(void**) (instance + offset) = ptr;
-				ptr = nullptr;
-				break;
-			}
-
-			case OP_DIR: {
-				std::uint16_t offset = *(std::uint16_t*) code;
-				code += 2;
-				*reinterpret_cast<float3*>(instance + offset) = dir;
-				break;
-			}
-			case OP_SAWTOOTH: {
-				// this translates to modulo except it works with floats
-				val -= (*(float*) code) * math::floor(val / (*(float*) code));
-				code += 4;
-				break;
-			}
-			case OP_DISCRETE: {
-				val = (*(float*) code) * math::floor(spring::SafeDivide(val, (*(float*) code)));
-				code += 4;
-				break;
-			}
-			case OP_SINE: {
-				val = (*(float*) code) * math::sin(val);
-				code += 4;
-				break;
-			}
-			case OP_YANK: {
-				buffer[(*(int*) code)] = val;
-				val = 0;
-				code += 4;
-				break;
-			}
-			case OP_MULTIPLY: {
-				val *= buffer[(*(int*) code)];
-				code += 4;
-				break;
-			}
-			case OP_ADDBUFF: {
-				val += buffer[(*(int*) code)];
-				code += 4;
-				break;
-			}
-			case OP_POW: {
-				val = math::pow(val, (*(float*) code));
-				code += 4;
-				break;
-			}
-			case OP_POWBUFF: {
-				val = math::pow(val, buffer[(*(int*) code)]);
-				code += 4;
-				break;
-			}
-			default: {
-				assert(false);
-				break;
-			}
-		}
-	}
-}
-
-
-
-void CCustomExplosionGenerator::ParseExplosionCode(
-	CCustomExplosionGenerator::ProjectileSpawnInfo* psi,
-	const string& script,
-	SExpGenSpawnableMemberInfo& memberInfo,
-	string& code
-) {
-	const std::string content = script.substr(0, script.find(';', 0));
-
-	const bool isFloat = (memberInfo.type == SExpGenSpawnableMemberInfo::TYPE_FLOAT);
-	const bool isInt   = (memberInfo.type == SExpGenSpawnableMemberInfo::TYPE_INT  );
-
-	if (content == "dir") {
-		// dir keyword; type has to be float3
-		if (!isFloat || memberInfo.length < 3)
-			throw content_error("[CCEG::ParseExplosionCode] incorrect use of \"dir\" (" + script + ")");
-
-		const std::uint16_t ofs = memberInfo.offset;
-
-		code.append(1, OP_DIR);
-		code.append((char*) &ofs, (char*) &ofs + sizeof(ofs));
-		return;
-	}
-
-	// arrays (float3 or float4)
-	if (memberInfo.length > 1) {
-		string::size_type start = 0;
-		SExpGenSpawnableMemberInfo subInfo = memberInfo;
-		subInfo.length = 1;
-
-		for (unsigned int i = 0; i < memberInfo.length && start < script.length(); ++i) {
-			const string::size_type subEnd = script.find(',', start + 1);
-
-			ParseExplosionCode(psi, script.substr(start, subEnd - start), subInfo, code);
-
-			start = subEnd + 1;
-			subInfo.offset += subInfo.size;
-		}
-
-		return;
-	}
-
-	// textures, colormaps, etc.
-	if (memberInfo.type == SExpGenSpawnableMemberInfo::TYPE_PTR) {
-		// Memory is managed by whomever this callback belongs to
-		void* ptr = memberInfo.ptrCallback(content);
-
-		code.append(1, OP_LOADP);
-		code.append((char*)(&ptr), ((char*)(&ptr)) + sizeof(void*));
-
-		const std::uint16_t ofs = memberInfo.offset;
-
-		code.append(1, OP_STOREP);
-		code.append((char*)&ofs, (char*)&ofs + sizeof(ofs));
-		return;
-	}
-
-
-	// Floats or Ints
-	assert(isFloat || isInt);
-
-	if (isFloat) {
-		switch (memberInfo.size) {
-			case 4: {} break;
-			default: { throw content_error("[CCEG::ParseExplosionCode] incompatible float size \"" + IntToString(memberInfo.size) + "\" (" + script + ")"); } break;
-		}
-	} else {
-		switch (memberInfo.size) {
-			case 1: case 2: case 4: {} break;
-			default: { throw content_error("[CCEG::ParseExplosionCode] incompatible integer size \"" + IntToString(memberInfo.size) + "\" (" + script + ")"); } break;
-		}
-	}
-
-	// parse the code
-	for (size_t p = 0, len = script.length(); p < len; ) {
-		char opcode = OP_END;
-		char c = script[p++];
-
-		// consume whitespace
-		if (c == ' ')
-			continue;
-
-		bool useInt = false;
-
-		     if (c == 'i')   opcode = OP_INDEX;
-		else if (c == 'r')   opcode = OP_RAND;
-		else if (c == 'd')   opcode = OP_DAMAGE;
-		else if (c == 'm')   opcode = OP_SAWTOOTH;
-		else if (c == 'k')   opcode = OP_DISCRETE;
-		else if (c == 's')   opcode = OP_SINE;
-		else if (c == 'p')   opcode = OP_POW;
-		else if (c == 'y') { opcode = OP_YANK;     useInt = true; }
-		else if (c == 'x') { opcode = OP_MULTIPLY; useInt = true; }
-		else if (c == 'a') { opcode = OP_ADDBUFF;  useInt = true; }
-		else if (c == 'q') { opcode = OP_POWBUFF;  useInt = true; }
-		else if (isdigit(c) || c == '.' || c == '-') { opcode = OP_ADD; p--; }
-		else {
-			LOG_L(L_WARNING, "[CCEG::%s] unknown op-code \"%c\" in \"%s\" at index " _STPF_ "", __func__, c, script.c_str(), p);
-			continue;
-		}
-
-		// be sure to exit cleanly if there are no more operators or operands
-		if (p >= script.size())
-			continue;
-
-		char* endp = nullptr;
-
-		if (!useInt) {
-			const float v = (float)strtod(&script[p], &endp);
-
-			p += (endp - &script[p]);
-
-			code.append(1, opcode);
-			code.append((char*) &v, ((char*) &v) + sizeof(v));
-		} else {
-			const int v = Clamp(int(strtol(&script[p], &endp, 10)), 0, 16);
-
-			p += (endp - &script[p]);
-
-			code.append(1, opcode);
-			code.append((char*) &v, ((char*) &v) + sizeof(v));
-		}
-	}
-
-	// store the final value
-	const std::uint16_t ofs = memberInfo.offset;
-
-	code.push_back(isFloat ? OP_STOREF : OP_STOREI);
-	code.push_back(memberInfo.size);
-	code.append((char*)&ofs, (char*)&ofs + sizeof(ofs));
-}
-
-
-
 bool CCustomExplosionGenerator::Load(CExplosionGeneratorHandler* handler, const char* tag)
 {
 	const LuaTable* root = handler->GetExplosionTableRoot();
@@ -880,7 +618,6 @@ bool CCustomExplosionGenerator::Load(CExplosionGeneratorHandler* handler, const
 		psi.flags = GetFlagsFromTable(spawnTable);
 		psi.count = std::max(0, spawnTable.GetInt("count", 1));
 
-		std::string code;
 		spring::unordered_map<string, string> props;
 
 		spawnTable.SubTable("properties").GetMap(props);
@@ -889,16 +626,12 @@ bool CCustomExplosionGenerator::Load(CExplosionGeneratorHandler* handler, const
 			SExpGenSpawnableMemberInfo memberInfo = {0, 0, 0, STRING_HASH(std::move(StringToLower(propIt.first))), SExpGenSpawnableMemberInfo::TYPE_INT, nullptr};
 
 			if (CExpGenSpawnable::GetSpawnableMemberInfo(className, memberInfo)) {
-				ParseExplosionCode(&psi, propIt.second, memberInfo, code);
+				psi.spawnTemplate.AddProperty(propIt.second, memberInfo);
 			} else {
 				LOG_L(L_WARNING, "[CCEG::%s] unknown field %s::%s in spawn-table \"%s\" for CEG \"%s\"", __func__, tag, propIt.first.c_str(), spawnName.c_str(), className.c_str());
 			}
 		}
 
-		code += (char)OP_END;
-		psi.code.resize(code.size());
-		copy(code.begin(), code.end(), psi.code.begin());
-
 		expGenParams.projectiles.push_back(psi);
 	}
 
@@ -964,7 +697,7 @@ bool CCustomExplosionGenerator::Explosion(
 
 		for (unsigned int c = 0; c < psi.count; c++) {
 			CExpGenSpawnable* projectile = CExpGenSpawnable::CreateSpawnable(psi.spawnableID);
-			ExecuteExplosionCode(&psi.code[0], damage, (char*) projectile, c, dir);
+			psi.spawnTemplate.Execute(reinterpret_cast<char*>(projectile), damage, c, dir);
 			projectile->Init(owner, pos);
 		}
 	}
@@ -43,6 +43,9 @@ public:
 	virtual void Update();
 	virtual void Init(const CUnit* owner, const float3& offset) override;
 
+	// called on the render thread before Draw, which can run concurrently
+	// with other projectiles' Draw calls and must only append vertices
+	virtual void PreDraw() {}
 	virtual void Draw(GL::RenderDataBufferTC* va) const {}
 	virtual void DrawOnMinimap(GL::RenderDataBufferC* va);
 
@@ -13,6 +13,7 @@
 #include "Sim/Units/UnitHandler.h"
 #include "System/ContainerUtil.h"
 #include "System/SafeUtil.h"
+#include "System/Threading/ThreadPool.h"
 
 static CCobEngine gCobEngine;
 static CCobFileHandler gCobFileHandler;
@@ -29,7 +30,8 @@ CR_REG_METADATA(CUnitScriptEngine, (
 	CR_MEMBER(animating),
 
 	// always null when saving
-	CR_IGNORED(currentScript)
+	CR_IGNORED(currentScript),
+	CR_IGNORED(animated)
 ))
 
 
@@ -118,10 +120,14 @@ void CUnitScriptEngine::Tick(int deltaTime)
 {
 	cobEngine->Tick(deltaTime);
 
+	animated.clear();
+
 	// tick all (COB or LUS) script instances that have registered themselves as animating
 	for (size_t i = 0; i < animating.size(); ) {
 		currentScript = animating[i];
 
+		animated.push_back(currentScript->GetUnit());
+
 		if (!currentScript->Tick(deltaTime)) {
 			animating[i] = animating.back();
 			animating.pop_back();
@@ -132,5 +138,12 @@ void CUnitScriptEngine::Tick(int deltaTime)
 	}
 
 	currentScript = nullptr;
+
+	// every unit owns its pieces, so this is order-independent and the
+	// results are identical to the lazy per-piece updates done by synced
+	// piece-position queries (which now mostly find clean matrices)
+	for_mt(0, animated.size(), [&](const int i) {
+		animated[i]->localModel.UpdateDirtyPieceMatrices();
+	});
 }
 
@@ -25,8 +25,14 @@ public:
 
 	void Tick(int deltaTime);
 
-	void Init() { animating.reserve(256); }
-	void Kill() { animating.clear(); }
+	void Init() {
+		animating.reserve(256);
+		animated.reserve(256);
+	}
+	void Kill() {
+		animating.clear();
+		animated.clear();
+	}
 
 	static void InitStatic();
 	static void KillStatic();
@@ -35,6 +41,9 @@ private:
 	CUnitScript* currentScript = nullptr;
 
 	std::vector<CUnitScript*> animating;
+	// units whose scripts were ticked this frame; their dirty piece
+	// matrices are refreshed in parallel at the end of Tick
+	std::vector<CUnit*> animated;
 };
 
 extern CUnitScriptEngine* unitScriptEngine;
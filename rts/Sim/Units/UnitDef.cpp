@@ -39,11 +39,9 @@ UnitDefWeapon::UnitDefWeapon(const WeaponDef* weaponDef, const LuaTable& weaponT
 	//     (arcs are always symmetric around mainDir)
 	this->maxMainDirAngleDif = math::cos((weaponTable.GetFloat("maxAngleDif", 360.0f) * 0.5f) * math::DEG_TO_RAD);
 
-	const string& btcString = weaponTable.GetString("badTargetCategory", "");
-	const string& otcString = weaponTable.GetString("onlyTargetCategory", "");
-
-	this->badTargetCat =                                   CCategoryHandler::Instance()->GetCategories(btcString);
-	this->onlyTargetCat = (otcString.empty())? 0xffffffff: CCategoryHandler::Instance()->GetCategories(otcString);
+	// {bad,only}TargetCategory are set by UnitDef::ResolveCategories
+	this->badTargetCat = 0;
+	this->onlyTargetCat = 0xffffffff;
 
 	this->mainDir = weaponTable.GetFloat3("mainDir", FwdVector);
 	this->mainDir.SafeNormalize();
@@ -484,9 +482,7 @@ UnitDef::UnitDef(const LuaTable& udTable, const std::string& unitName, int id)
 	maxThisUnit = std::min(maxThisUnit, gameSetup->GetRestrictedUnitLimit(name, MAX_UNITS));
 
 	categoryString = udTable.GetString("category", "");
-
-	category = CCategoryHandler::Instance()->GetCategories(udTable.GetString("category", ""));
-	noChaseCategory = CCategoryHandler::Instance()->GetCategories(udTable.GetString("noChaseCategory", ""));
+	noChaseCategoryString = udTable.GetString("noChaseCategory", "");
 
 	iconType = icon::iconHandler.GetIcon(udTable.GetString("iconType", "default"));
 
@@ -694,6 +690,8 @@ void UnitDef::ParseWeaponsTable(const LuaTable& weaponsTable)
 
 		weapons[k++] = {wd, wTable};
 
+		weaponCategoryNames.push_back({k - 1, wTable.GetString("badTargetCategory", ""), wTable.GetString("onlyTargetCategory", "")});
+
 		maxWeaponRange = std::max(maxWeaponRange, wd->range);
 
 		if (wd->interceptor && wd->coverageRange > maxCoverage)
@@ -715,6 +713,23 @@ void UnitDef::ParseWeaponsTable(const LuaTable& weaponsTable)
 
 
 
+void UnitDef::ResolveCategories()
+{
+	CCategoryHandler* categoryHandler = CCategoryHandler::Instance();
+
+	category = categoryHandler->GetCategories(categoryString);
+	noChaseCategory = categoryHandler->GetCategories(noChaseCategoryString);
+
+	for (const WeaponCategoryNames& names: weaponCategoryNames) {
+		UnitDefWeapon& udw = weapons[names.weaponIndex];
+
+		udw.badTargetCat =                                       categoryHandler->GetCategories(names.badTargetCat);
+		udw.onlyTargetCat = (names.onlyTargetCat.empty())? 0xffffffff: categoryHandler->GetCategories(names.onlyTargetCat);
+	}
+}
+
+
+
 void UnitDef::CreateYardMap(std::string&& yardMapStr)
 {
 	// if a unit is immobile but does *not* have a yardmap
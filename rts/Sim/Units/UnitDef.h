@@ -52,6 +52,9 @@ public:
 	UnitDef();
 
 	void SetNoCost(bool noCost);
+	// category bits are handed out in order of first use; must be called
+	// for each def in ID order and from a single thread, see UnitDefHandler
+	void ResolveCategories();
 
 	bool IsTransportUnit()     const { return (transportCapacity > 0 && transportMass > 0.0f); }
 	bool IsImmobileUnit()      const { return (pathType == -1U && !canfly && speed <= 0.0f); }
@@ -378,6 +381,16 @@ private:
 	void ParseWeaponsTable(const LuaTable& weaponsTable);
 	void CreateYardMap(std::string&& yardMapStr);
 
+	struct WeaponCategoryNames {
+		int weaponIndex;
+
+		std::string badTargetCat;
+		std::string onlyTargetCat;
+	};
+
+	std::string noChaseCategoryString;
+	std::vector<WeaponCategoryNames> weaponCategoryNames;
+
 	float realMetalCost;
 	float realEnergyCost;
 	float realMetalUpkeep;
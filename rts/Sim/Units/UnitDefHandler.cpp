@@ -2,6 +2,7 @@
 
 #include <stdio.h>
 #include <algorithm>
+#include <exception>
 #include <iostream>
 #include <locale>
 #include <cctype>
@@ -13,6 +14,7 @@
 #include "System/Log/ILog.h"
 #include "System/StringUtil.h"
 #include "System/Sound/ISound.h"
+#include "System/Threading/ThreadPool.h"
 
 
 static CUnitDefHandler gUnitDefHandler;
@@ -38,16 +40,43 @@ void CUnitDefHandler::Init(LuaParser* defsParser)
 	std::vector<std::string> unitDefNames;
 	rootTable.GetKeys(unitDefNames);
 
+	std::vector<UnitDef> parsedDefs(unitDefNames.size());
+	std::vector<std::exception_ptr> parseErrors(unitDefNames.size());
+
 	unitDefIDs.reserve(unitDefNames.size() + 1);
 	unitDefsVector.reserve(unitDefNames.size() + 1);
 	unitDefsVector.emplace_back();
 
+	const auto ParseUnitDef = [&](const int a) {
+		// parse the unitdef data (but don't load buildpics, etc...)
+		// the ID is assigned later since failed defs do not consume one
+		try {
+			parsedDefs[a] = UnitDef(rootTable.SubTable(unitDefNames[a]), StringToLower(unitDefNames[a]), 0);
+		} catch (...) {
+			parseErrors[a] = std::current_exception();
+		}
+	};
+
+	if (rootTable.IsSnapshot()) {
+		for_mt(0, unitDefNames.size(), ParseUnitDef);
+	} else {
+		for (unsigned int a = 0; a < unitDefNames.size(); ++a) {
+			ParseUnitDef(a);
+		}
+	}
+
 	for (unsigned int a = 0; a < unitDefNames.size(); ++a) {
 		const string& unitName = unitDefNames[a];
-		const LuaTable& udTable = rootTable.SubTable(unitName);
 
-		// parse the unitdef data (but don't load buildpics, etc...)
-		PushNewUnitDef(StringToLower(unitName), udTable);
+		try {
+			if (parseErrors[a] != nullptr)
+				std::rethrow_exception(parseErrors[a]);
+		} catch (const content_error& err) {
+			LOG_L(L_ERROR, "%s", err.what());
+			continue;
+		}
+
+		PushNewUnitDef(StringToLower(unitName), rootTable.SubTable(unitName), std::move(parsedDefs[a]));
 	}
 
 	CleanBuildOptions();
@@ -56,7 +85,7 @@ void CUnitDefHandler::Init(LuaParser* defsParser)
 
 
 
-int CUnitDefHandler::PushNewUnitDef(const std::string& unitName, const LuaTable& udTable)
+int CUnitDefHandler::PushNewUnitDef(const std::string& unitName, const LuaTable& udTable, UnitDef&& unitDef)
 {
 	if (std::find_if(unitName.begin(), unitName.end(), isblank) != unitName.end())
 		LOG_L(L_WARNING, "[%s] UnitDef name \"%s\" contains white-spaces", __func__, unitName.c_str());
@@ -64,8 +93,11 @@ int CUnitDefHandler::PushNewUnitDef(const std::string& unitName, const LuaTable&
 	const int defID = unitDefsVector.size();
 
 	try {
-		unitDefsVector.emplace_back(udTable, unitName, defID);
+		unitDefsVector.emplace_back(std::move(unitDef));
 		UnitDef& newDef = unitDefsVector.back();
+		newDef.id = defID;
+		// everything below depends on the order of definition
+		newDef.ResolveCategories();
 		UnitDefLoadSounds(&newDef, udTable);
 
 		// map unitName to newDef.decoyName
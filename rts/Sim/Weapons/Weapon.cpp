@@ -106,6 +106,12 @@ CR_REG_METADATA(CWeapon, (
 ))
 
 
+// AutoTarget scratch-space, shared by all weapons (sim-thread only)
+static std::vector<TraceRay::SConeQuery> targetConeQueries;
+static std::vector<int> targetConeQueryIndices;
+static std::vector<uint8_t> targetConeBlocked;
+
+
 
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
@@ -631,33 +637,78 @@ bool CWeapon::AutoTarget()
 	//   GenerateWeaponTargets sorts by INCREASING order of priority, so lower equals better
 	//   <targetPairs> is normally sorted such that all bad TargetCategory units live at the
 	//   end, but Lua can mess with the ordering arbitrarily
-	for (size_t i = 0, n = CGameHelper::GenerateWeaponTargets(this, avoidUnit, targetPairs); i < n; i++, assert(n == targetPairs.size())) {
-		CUnit* unit = targetPairs[i].second;
+	//
+	//   candidates are tried in windows of doubling size; the friendly-fire cone tests of a
+	//   window's TryTarget calls are collected and evaluated together, then the candidates
+	//   are visited in the same order (with the same rules) as a one-by-one loop would
+	const size_t numTargets = CGameHelper::GenerateWeaponTargets(this, avoidUnit, targetPairs);
 
-		// save the "best" bad target in case we have no other
-		// good targets (of higher priority) left in <targets>
-		const bool isBadTarget = (unit->category & badTargetCategory);
+	for (size_t i0 = 0, i1 = 0; i0 < numTargets && goodTargetUnit == nullptr; i0 = i1) {
+		i1 = std::min(numTargets, i0 + std::max(i0, size_t(4)));
 
-		if (isBadTarget && (badTargetUnit != nullptr))
-			continue;
+		targetConeQueries.clear();
+		targetConeQueryIndices.clear();
 
-		// set isAutoTarget s.t. TestRange result is ignored
-		// (which enables pre-aiming at targets out of range)
-		if (!TryTarget(SWeaponTarget(unit, false, autoTargetRangeBoost > 0.0f)))
-			continue;
+		TraceRay::BeginConeQueryBatch(&targetConeQueries);
 
-		if (unit->IsNeutral() && (owner->fireState < FIRESTATE_FIREATNEUTRAL))
-			continue;
+		for (size_t i = i0; i < i1; i++) {
+			const CUnit* unit = targetPairs[i].second;
+			const size_t numQueries = targetConeQueries.size();
 
-		if (isBadTarget) {
-			badTargetUnit = unit;
-			continue;
+			// bad targets are only needed if none has passed yet, which is not known
+			// until the batch is evaluated; the call is cheap without the cone test
+			if ((unit->category & badTargetCategory) && (badTargetUnit != nullptr)) {
+				targetConeQueryIndices.push_back(-2);
+				continue;
+			}
+
+			// set isAutoTarget s.t. TestRange result is ignored
+			// (which enables pre-aiming at targets out of range)
+			if (!TryTarget(SWeaponTarget(unit, false, autoTargetRangeBoost > 0.0f))) {
+				targetConeQueryIndices.push_back(-2);
+				continue;
+			}
+
+			// HaveFreeLineOfFire performs at most one cone test, as its last step
+			assert(targetConeQueries.size() <= (numQueries + 1));
+			targetConeQueryIndices.push_back((targetConeQueries.size() > numQueries)? int(numQueries): -1);
 		}
 
-		goodTargetUnit = unit;
-		break;
+		TraceRay::EndConeQueryBatch();
+		TraceRay::TestConeQueries(targetConeQueries, targetConeBlocked);
+
+		for (size_t i = i0; i < i1; i++) {
+			CUnit* unit = targetPairs[i].second;
+
+			// save the "best" bad target in case we have no other
+			// good targets (of higher priority) left in <targets>
+			const bool isBadTarget = (unit->category & badTargetCategory);
+
+			if (isBadTarget && (badTargetUnit != nullptr))
+				continue;
+
+			const int queryIdx = targetConeQueryIndices[i - i0];
+
+			if (queryIdx == -2)
+				continue;
+			if (queryIdx >= 0 && targetConeBlocked[queryIdx] != 0)
+				continue;
+
+			if (unit->IsNeutral() && (owner->fireState < FIRESTATE_FIREATNEUTRAL))
+				continue;
+
+			if (isBadTarget) {
+				badTargetUnit = unit;
+				continue;
+			}
+
+			goodTargetUnit = unit;
+			break;
+		}
 	}
 
+	assert(numTargets == targetPairs.size());
+
 	if (goodTargetUnit == nullptr)
 		goodTargetUnit = badTargetUnit;
 
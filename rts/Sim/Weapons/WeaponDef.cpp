@@ -370,9 +370,8 @@ WeaponDef::WeaponDef(const LuaTable& wdTable, const std::string& name_, int id_)
 			damages.paralyzeDamageTime = 0;
 
 
-		static std::vector<std::pair<std::string, float>> dmgs;
+		std::vector<std::pair<std::string, float>> dmgs;
 
-		dmgs.clear();
 		dmgs.reserve(32);
 		dmgTable.GetPairs(dmgs);
 
@@ -494,8 +493,6 @@ WeaponDef::WeaponDef(const LuaTable& wdTable, const std::string& name_, int id_)
 		interceptedByShieldType = wdTable.GetInt("interceptedByShieldType", defInterceptType);
 	}
 
-	ParseWeaponSounds(wdTable);
-
 	// custom parameters table
 	wdTable.SubTable("customParams").GetMap(customParams);
 
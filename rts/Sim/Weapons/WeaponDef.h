@@ -262,8 +262,10 @@ public:
 	};
 	Visuals visuals;
 
-private:
+	// called by WeaponDefHandler after construction, in ID order
 	void ParseWeaponSounds(const LuaTable& wdTable);
+
+private:
 	void LoadSound(const LuaTable& wdTable, const std::string& soundKey, GuiSoundSet& soundSet);
 };
 
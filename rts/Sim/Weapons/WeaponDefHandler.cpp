@@ -3,6 +3,7 @@
 
 #include <algorithm>
 #include <cctype>
+#include <exception>
 #include <iostream>
 #include <stdexcept>
 
@@ -11,6 +12,7 @@
 #include "Sim/Misc/DamageArrayHandler.h"
 #include "System/Exceptions.h"
 #include "System/StringUtil.h"
+#include "System/Threading/ThreadPool.h"
 
 
 static CWeaponDefHandler gWeaponDefHandler;
@@ -27,14 +29,36 @@ void CWeaponDefHandler::Init(LuaParser* defsParser)
 	std::vector<std::string> weaponNames;
 	rootTable.GetKeys(weaponNames);
 
-	weaponDefsVector.reserve(weaponNames.size());
+	std::vector<std::exception_ptr> parseErrors(weaponNames.size());
+
+	weaponDefsVector.resize(weaponNames.size());
 	weaponDefIDs.reserve(weaponNames.size());
 
+	const auto ParseWeaponDef = [&](const int wid) {
+		try {
+			weaponDefsVector[wid] = WeaponDef(rootTable.SubTable(weaponNames[wid]), weaponNames[wid], wid);
+		} catch (...) {
+			parseErrors[wid] = std::current_exception();
+		}
+	};
+
+	// IDs follow the sorted names, so parsing order does not matter
+	// as long as the tables can be read concurrently
+	if (rootTable.IsSnapshot()) {
+		for_mt(0, weaponNames.size(), ParseWeaponDef);
+	} else {
+		for (int wid = 0; wid < weaponNames.size(); wid++) {
+			ParseWeaponDef(wid);
+		}
+	}
+
 	for (int wid = 0; wid < weaponNames.size(); wid++) {
-		const std::string& name = weaponNames[wid];
-		const LuaTable wdTable = rootTable.SubTable(name);
-		weaponDefsVector.emplace_back(wdTable, name, wid);
-		weaponDefIDs[name] = wid;
+		if (parseErrors[wid] != nullptr)
+			std::rethrow_exception(parseErrors[wid]);
+
+		// sound-set data is appended to a shared list in ID order
+		weaponDefsVector[wid].ParseWeaponSounds(rootTable.SubTable(weaponNames[wid]));
+		weaponDefIDs[weaponNames[wid]] = wid;
 	}
 }
 
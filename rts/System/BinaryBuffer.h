@@ -0,0 +1,79 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef BINARY_BUFFER_H
+#define BINARY_BUFFER_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Minimal (de)serialization of trivially copyable values and strings into
+ * a byte-buffer, in native endianness and without any padding. Strings are
+ * stored as uint32 length followed by their characters. Used for the binary
+ * cache-files, which are only ever read back by the same build.
+ */
+struct BinaryWriter {
+public:
+	BinaryWriter(std::vector<std::uint8_t>& _buffer): buffer(_buffer) {}
+
+	template<typename T> void Write(const T& value) {
+		static_assert(std::is_trivially_copyable<T>::value, "");
+
+		const std::uint8_t* bytes = reinterpret_cast<const std::uint8_t*>(&value);
+		buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+	}
+
+	void WriteString(const std::string& str) {
+		Write(std::uint32_t(str.size()));
+		buffer.insert(buffer.end(), str.begin(), str.end());
+	}
+
+private:
+	std::vector<std::uint8_t>& buffer;
+};
+
+
+/**
+ * Counterpart of BinaryWriter; every read is bounds-checked and returns
+ * false (leaving value unspecified) rather than running past the end, so
+ * truncated or corrupted buffers can be rejected.
+ */
+struct BinaryReader {
+public:
+	BinaryReader(const std::uint8_t* _data, size_t _size): data(_data), size(_size) {}
+
+	template<typename T> bool Read(T& value) {
+		static_assert(std::is_trivially_copyable<T>::value, "");
+
+		if ((size - offset) < sizeof(T))
+			return false;
+
+		std::memcpy(&value, data + offset, sizeof(T));
+		offset += sizeof(T);
+		return true;
+	}
+
+	bool ReadString(std::string& str) {
+		std::uint32_t len = 0;
+
+		if (!Read(len) || (size - offset) < len)
+			return false;
+
+		str.assign(reinterpret_cast<const char*>(data + offset), len);
+		offset += len;
+		return true;
+	}
+
+	bool AtEnd() const { return (offset == size); }
+
+private:
+	const std::uint8_t* data;
+
+	size_t size;
+	size_t offset = 0;
+};
+
+#endif // BINARY_BUFFER_H
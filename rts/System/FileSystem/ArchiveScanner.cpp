@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <array>
 #include <cstdio>
+#include <cstring>
 #include <memory>
 
 #include <sys/types.h>
@@ -16,9 +17,11 @@
 #include "Archives/DirArchive.h"
 #include "FileFilter.h"
 #include "DataDirsAccess.h"
+#include "CacheFile.h"
 #include "FileSystem.h"
 #include "FileQueryFlags.h"
 #include "Lua/LuaParser.h"
+#include "System/BinaryBuffer.h"
 #include "System/ContainerUtil.h"
 #include "System/StringUtil.h"
 #include "System/Exceptions.h"
@@ -53,6 +56,14 @@ LOG_REGISTER_SECTION_GLOBAL(LOG_SECTION_ARCHIVESCANNER)
 
 constexpr static int INTERNAL_VER = 16;
 
+static constexpr char CACHE_FILE_MAGIC[8] = {'S', 'P', 'R', 'I', 'N', 'G', 'A', 'C'};
+
+// the "cache" dir is created in DataDirLocater
+static std::string GetCacheFilePath(const char* ext)
+{
+	return (FileSystem::EnsurePathSepAtEnd(FileSystem::GetCacheDir()) + IntToString(INTERNAL_VER, "ArchiveCache%i.") + ext);
+}
+
 
 /*
  * Engine known (and used?) tags in [map|mod]info.lua
@@ -387,8 +398,7 @@ static std::atomic<uint32_t> numScannedArchives{0};
 CArchiveScanner::CArchiveScanner()
 {
 	Clear();
-	// the "cache" dir is created in DataDirLocater
-	ReadCacheData(cachefile = FileSystem::EnsurePathSepAtEnd(FileSystem::GetCacheDir()) + IntToString(INTERNAL_VER, "ArchiveCache%i.lua"));
+	ReadCacheData(cachefile = GetCacheFilePath("bin"));
 	ScanAllDirs();
 }
 
@@ -407,6 +417,19 @@ uint32_t CArchiveScanner::GetNumScannedArchives()
 	return (numScannedArchives.load());
 }
 
+std::vector<std::string> CArchiveScanner::GetBaseContentArchives()
+{
+	std::vector<std::string> archives;
+	archives.reserve(baseContentArchives.size());
+
+	for (const auto& p: baseContentArchives) {
+		archives.push_back(p.first);
+	}
+
+	std::sort(archives.begin(), archives.end());
+	return archives;
+}
+
 
 void CArchiveScanner::Clear()
 {
@@ -432,7 +455,7 @@ void CArchiveScanner::Reload()
 
 	// ctor
 	Clear();
-	ReadCacheData(cachefile = FileSystem::EnsurePathSepAtEnd(FileSystem::GetCacheDir()) + IntToString(INTERNAL_VER, "ArchiveCache%i.lua"));
+	ReadCacheData(cachefile = GetCacheFilePath("bin"));
 	ScanAllDirs();
 }
 
@@ -498,12 +521,52 @@ void CArchiveScanner::ScanDirs(const std::vector<std::string>& scanDirs)
 		}
 	}*/
 
-	// Create archiveInfos etc. if not in cache already
+	// Create archiveInfos etc. if not in cache already; the cache is checked
+	// serially in scan order, only the archives that need to be (re)opened
+	// are then processed in parallel
+	std::vector<std::string> scanArchives;
+	std::vector<unsigned> scanModTimes;
+	std::vector<ScannedArchive> scanResults;
+
 	for (const std::string& archive: foundArchives) {
-		ScanArchive(archive, false);
-	#if !defined(DEDICATED) && !defined(UNITSYNC)
+		unsigned modifiedTime = 0;
+
+		if (CheckCachedData(archive, modifiedTime, false))
+			continue;
+
+		scanArchives.push_back(archive);
+		scanModTimes.push_back(modifiedTime);
+	}
+
+	scanResults.resize(scanArchives.size());
+
+	// one archive per thread and batch; the watchdog is kicked by the calling
+	// (main) thread in between, workers must not touch its timers
+	const int batchSize = ThreadPool::GetNumThreads();
+
+	for (int batchStart = 0, numArchives = scanArchives.size(); batchStart < numArchives; batchStart += batchSize) {
+		for_mt(batchStart, std::min(batchStart + batchSize, numArchives), [&](const int i) {
+			ScanArchiveData(scanArchives[i], scanModTimes[i], false, scanResults[i]);
+		});
+
+		#if !defined(DEDICATED) && !defined(UNITSYNC)
 		Watchdog::ClearTimer(WDT_MAIN);
-	#endif
+		#endif
+	}
+
+	for (size_t i = 0; i < scanResults.size(); i++) {
+		const std::string& lcfn = StringToLower(FileSystem::GetFilename(scanArchives[i]));
+
+		// same name as an archive added earlier in this scan; let CheckCachedData
+		// deal with the duplicate exactly as if the archives were scanned in turn
+		if (archiveInfosIndex.find(lcfn) != archiveInfosIndex.end()) {
+			unsigned modifiedTime = 0;
+
+			if (CheckCachedData(scanArchives[i], modifiedTime, false))
+				continue;
+		}
+
+		AddScannedArchive(scanResults[i]);
 	}
 
 	// Now we'll have to parse the replaces-stuff found in the mods
@@ -661,6 +724,14 @@ void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 
 	const ScanScope scanScope(&isInScan);
 
+	ScannedArchive result;
+	ScanArchiveData(fullName, modifiedTime, doChecksum, result);
+	AddScannedArchive(result);
+}
+
+
+void CArchiveScanner::ScanArchiveData(const std::string& fullName, unsigned modifiedTime, bool doChecksum, ScannedArchive& result)
+{
 	const std::string& fname = FileSystem::GetFilename(fullName);
 	const std::string& fpath = FileSystem::GetDirectory(fullName);
 	const std::string& lcfn  = StringToLower(fname);
@@ -671,13 +742,15 @@ void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 		LOG_L(L_WARNING, "[AS::%s] unable to open archive \"%s\"", __func__, fullName.c_str());
 
 		// record it as broken, so we don't need to look inside everytime
-		BrokenArchive& ba = GetAddBrokenArchive(lcfn);
+		BrokenArchive& ba = result.brokenArchive;
 		ba.name = lcfn;
 		ba.path = fpath;
 		ba.modified = modifiedTime;
 		ba.updated = true;
 		ba.problem = "Unable to open archive";
 
+		result.isBroken = true;
+
 		// does not count as a scan
 		// numScannedArchives += 1;
 		return;
@@ -692,7 +765,7 @@ void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 	const bool hasMapInfo = ar->FileExists("mapinfo.lua");
 
 
-	ArchiveInfo ai;
+	ArchiveInfo& ai = result.archiveInfo;
 	ArchiveData& ad = ai.archiveData;
 
 	// execute the respective .lua, otherwise assume this archive is a map
@@ -715,13 +788,15 @@ void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 		LOG_L(L_WARNING, "[AS::%s] failed to scan \"%s\" (%s)", __func__, fullName.c_str(), error.c_str());
 
 		// mark archive as broken, so we don't need to look inside everytime
-		BrokenArchive& ba = GetAddBrokenArchive(lcfn);
+		BrokenArchive& ba = result.brokenArchive;
 		ba.name = lcfn;
 		ba.path = fpath;
 		ba.modified = modifiedTime;
 		ba.updated = true;
 		ba.problem = error;
 
+		result.isBroken = true;
+
 		// does count as a scan
 		numScannedArchives += 1;
 		return;
@@ -767,12 +842,21 @@ void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 	ai.updated = true;
 	ai.hashed = doChecksum && GetArchiveChecksum(fullName, ai);
 
-	archiveInfosIndex.insert(lcfn, archiveInfos.size());
-	archiveInfos.emplace_back(std::move(ai));
-
 	numScannedArchives += 1;
 }
 
+void CArchiveScanner::AddScannedArchive(ScannedArchive& result)
+{
+	if (result.isBroken) {
+		BrokenArchive& ba = GetAddBrokenArchive(result.brokenArchive.name);
+		ba = std::move(result.brokenArchive);
+		return;
+	}
+
+	archiveInfosIndex.insert(StringToLower(result.archiveInfo.origName), archiveInfos.size());
+	archiveInfos.emplace_back(std::move(result.archiveInfo));
+}
+
 
 bool CArchiveScanner::CheckCachedData(const std::string& fullName, unsigned& modified, bool doChecksum)
 {
@@ -979,15 +1063,164 @@ bool CArchiveScanner::GetArchiveChecksum(const std::string& archiveName, Archive
 void CArchiveScanner::ReadCacheData(const std::string& filename)
 {
 	std::lock_guard<decltype(scannerMutex)> lck(scannerMutex);
+
+	if (ReadCacheBinary(filename))
+		return;
+
+	// binary cache missing or unusable; migrate from the lua one if present
+	ReadCacheLua(GetCacheFilePath("lua"));
+}
+
+
+// layout (native endianness): CCacheFile header, then all archives and all
+// broken archives as written by WriteCacheData
+bool CArchiveScanner::ReadCacheBinary(const std::string& filename)
+{
+	if (!FileSystem::FileExists(filename))
+		return false;
+
+	CCacheFile cacheFile;
+
+	if (!cacheFile.Open(filename, CACHE_FILE_MAGIC, INTERNAL_VER, 0)) {
+		LOG_L(L_WARNING, "[AS::%s] ArchiveCache %s is outdated or corrupt", __func__, filename.c_str());
+		return false;
+	}
+
+	const size_t dataSize = cacheFile.GetDataSize();
+
+	BinaryReader reader(cacheFile.GetData(), dataSize);
+
+	std::vector<ArchiveInfo> cachedArchiveInfos;
+	std::vector<BrokenArchive> cachedBrokenArchives;
+
+	std::uint32_t numArchives = 0;
+	std::uint32_t numBrokenArchives = 0;
+
+	if (!reader.Read(numArchives) || numArchives > dataSize)
+		return false;
+
+	cachedArchiveInfos.resize(numArchives);
+
+	for (ArchiveInfo& ai: cachedArchiveInfos) {
+		ArchiveData& ad = ai.archiveData;
+		ArchiveInfo tmp; // used to compare against all-zero hash
+
+		std::uint32_t numInfoItems = 0;
+		std::uint32_t numDependencies = 0;
+
+		if (!reader.ReadString(ai.origName) || !reader.ReadString(ai.path) || !reader.ReadString(ai.archiveDataPath))
+			return false;
+		if (!reader.Read(ai.modified) || !reader.Read(ai.modifiedArchiveData) || !reader.Read(ai.checksum))
+			return false;
+		if (!reader.Read(numInfoItems) || numInfoItems > dataSize)
+			return false;
+
+		for (std::uint32_t n = 0; n < numInfoItems; n++) {
+			std::string key;
+			std::uint8_t valueType = 0;
+
+			if (!reader.ReadString(key) || !reader.Read(valueType))
+				return false;
+			if (key.empty() || ArchiveData::IsReservedKey(key))
+				return false;
+
+			switch (valueType) {
+				case INFO_VALUE_TYPE_STRING: {
+					std::string value;
+
+					if (!reader.ReadString(value))
+						return false;
+
+					ad.SetInfoItemValueString(key, value);
+				} break;
+				case INFO_VALUE_TYPE_INTEGER: {
+					std::int32_t value = 0;
+
+					if (!reader.Read(value))
+						return false;
+
+					ad.SetInfoItemValueInteger(key, value);
+				} break;
+				case INFO_VALUE_TYPE_FLOAT: {
+					float value = 0.0f;
+
+					if (!reader.Read(value))
+						return false;
+
+					ad.SetInfoItemValueFloat(key, value);
+				} break;
+				case INFO_VALUE_TYPE_BOOL: {
+					std::uint8_t value = 0;
+
+					if (!reader.Read(value))
+						return false;
+
+					ad.SetInfoItemValueBool(key, value != 0);
+				} break;
+				default: {
+					return false;
+				} break;
+			}
+		}
+
+		if (!reader.Read(numDependencies) || numDependencies > dataSize)
+			return false;
+
+		ad.GetDependencies().resize(numDependencies);
+
+		for (std::string& dep: ad.GetDependencies()) {
+			if (!reader.ReadString(dep))
+				return false;
+		}
+
+		ai.updated = false;
+		ai.hashed = (memcmp(ai.checksum, tmp.checksum, sha512::SHA_LEN) != 0);
+
+		if (ad.IsMap()) {
+			AddDependency(ad.GetDependencies(), GetMapHelperContentName());
+		} else if (ad.IsGame()) {
+			AddDependency(ad.GetDependencies(), GetSpringBaseContentName());
+		}
+	}
+
+	if (!reader.Read(numBrokenArchives) || numBrokenArchives > dataSize)
+		return false;
+
+	cachedBrokenArchives.resize(numBrokenArchives);
+
+	for (BrokenArchive& ba: cachedBrokenArchives) {
+		if (!reader.ReadString(ba.name) || !reader.ReadString(ba.path) || !reader.Read(ba.modified) || !reader.ReadString(ba.problem))
+			return false;
+
+		ba.updated = false;
+	}
+
+	if (!reader.AtEnd())
+		return false;
+
+	// only commit a completely valid cache
+	for (ArchiveInfo& ai: cachedArchiveInfos) {
+		GetAddArchiveInfo(StringToLower(ai.origName)) = std::move(ai);
+	}
+	for (BrokenArchive& ba: cachedBrokenArchives) {
+		GetAddBrokenArchive(ba.name) = std::move(ba);
+	}
+
+	isDirty = false;
+	return true;
+}
+
+bool CArchiveScanner::ReadCacheLua(const std::string& filename)
+{
 	if (!FileSystem::FileExists(filename)) {
 		LOG_L(L_INFO, "[AS::%s] ArchiveCache %s doesn't exist", __func__, filename.c_str());
-		return;
+		return false;
 	}
 
 	LuaParser p(filename, SPRING_VFS_RAW, SPRING_VFS_BASE);
 	if (!p.Execute()) {
 		LOG_L(L_ERROR, "[AS::%s] failed to parse ArchiveCache: %s", __func__, p.GetErrorLog().c_str());
-		return;
+		return false;
 	}
 
 	const LuaTable& archiveCacheTbl = p.GetRoot();
@@ -997,7 +1230,7 @@ void CArchiveScanner::ReadCacheData(const std::string& filename)
 	// Do not load old version caches
 	const int ver = archiveCacheTbl.GetInt("internalver", (INTERNAL_VER + 1));
 	if (ver != INTERNAL_VER)
-		return;
+		return false;
 
 	for (int i = 1; archivesTbl.KeyExists(i); ++i) {
 		const LuaTable& curArchiveTbl = archivesTbl.SubTable(i);
@@ -1054,18 +1287,7 @@ void CArchiveScanner::ReadCacheData(const std::string& filename)
 	}
 
 	isDirty = false;
-}
-
-static inline void SafeStr(FILE* out, const char* prefix, const std::string& str)
-{
-	if (str.empty())
-		return;
-
-	if ((str.find_first_of("\\\"") != std::string::npos) || (str.find_first_of('\n') != std::string::npos )) {
-		fprintf(out, "%s[[%s]],\n", prefix, str.c_str());
-	} else {
-		fprintf(out, "%s\"%s\",\n", prefix, str.c_str());
-	}
+	return true;
 }
 
 void FilterDep(std::vector<std::string>& deps, const std::string& exclude)
@@ -1080,12 +1302,6 @@ void CArchiveScanner::WriteCacheData(const std::string& filename)
 	if (!isDirty)
 		return;
 
-	FILE* out = fopen(filename.c_str(), "wt");
-	if (out == nullptr) {
-		LOG_L(L_ERROR, "[AS::%s] failed to write to \"%s\"!", __func__, filename.c_str());
-		return;
-	}
-
 	// First delete all outdated information
 	{
 		std::stable_sort(archiveInfos.begin(), archiveInfos.end(), [](const ArchiveInfo& a, const ArchiveInfo& b) { return (a.origName < b.origName); });
@@ -1109,81 +1325,80 @@ void CArchiveScanner::WriteCacheData(const std::string& filename)
 		}
 	}
 
+	std::vector<std::uint8_t> buffer;
+	BinaryWriter writer(buffer);
 
-	fprintf(out, "local archiveCache = {\n\n");
-	fprintf(out, "\tinternalver = %i,\n\n", INTERNAL_VER);
-	fprintf(out, "\tarchives = {  -- count = %u\n", unsigned(archiveInfos.size()));
+	buffer.reserve(archiveInfos.size() * 512);
 
-	for (const ArchiveInfo& arcInfo: archiveInfos) {
-		sha512::raw_digest rawDigest;
-		sha512::hex_digest hexDigest;
-
-		std::memcpy(rawDigest.data(), arcInfo.checksum, sha512::SHA_LEN);
-		sha512::dump_digest(rawDigest, hexDigest);
-
-		fprintf(out, "\t\t{\n");
-		SafeStr(out, "\t\t\tname = ",              arcInfo.origName);
-		SafeStr(out, "\t\t\tpath = ",              arcInfo.path);
-		fprintf(out, "\t\t\tmodified = \"%u\",\n", arcInfo.modified);
-		fprintf(out, "\t\t\tchecksum = \"%s\",\n", hexDigest.data());
-		SafeStr(out, "\t\t\treplaced = ",          arcInfo.replaced);
-
-		if (!arcInfo.archiveDataPath.empty()) {
-			SafeStr(out, "\t\t\tarchiveDataPath = ",              arcInfo.archiveDataPath);
-			fprintf(out, "\t\t\tmodifiedArchiveData = \"%u\",\n", arcInfo.modifiedArchiveData);
-		}
+	writer.Write(std::uint32_t(archiveInfos.size()));
 
-		// mod info?
+	// same content as the lua cache had; replaced-markers are recomputed by
+	// every scan and (empty) archive-data is not stored for nameless archives
+	for (const ArchiveInfo& arcInfo: archiveInfos) {
 		const ArchiveData& archData = arcInfo.archiveData;
-		if (!archData.GetName().empty()) {
-			fprintf(out, "\t\t\tarchivedata = {\n");
-
-			for (const auto& ii: archData.GetInfo()) {
-				if (ii.second.valueType == INFO_VALUE_TYPE_STRING) {
-					SafeStr(out, std::string("\t\t\t\t" + ii.first + " = ").c_str(), ii.second.valueTypeString);
-				} else {
-					fprintf(out, "\t\t\t\t%s = %s,\n", ii.first.c_str(), ii.second.GetValueAsString(false).c_str());
-				}
+		const bool haveData = !archData.GetName().empty();
+
+		writer.WriteString(arcInfo.origName);
+		writer.WriteString(arcInfo.path);
+		writer.WriteString(arcInfo.archiveDataPath);
+		writer.Write(arcInfo.modified);
+		writer.Write(arcInfo.modifiedArchiveData);
+		writer.Write(arcInfo.checksum);
+
+		writer.Write(std::uint32_t(haveData? archData.GetInfo().size(): 0));
+
+		for (const auto& ii: archData.GetInfo()) {
+			if (!haveData)
+				break;
+
+			writer.WriteString(ii.first);
+			writer.Write(std::uint8_t(ii.second.valueType));
+
+			switch (ii.second.valueType) {
+				case INFO_VALUE_TYPE_STRING : { writer.WriteString(ii.second.valueTypeString); } break;
+				case INFO_VALUE_TYPE_INTEGER: { writer.Write(std::int32_t(ii.second.value.typeInteger)); } break;
+				case INFO_VALUE_TYPE_FLOAT  : { writer.Write(ii.second.value.typeFloat); } break;
+				case INFO_VALUE_TYPE_BOOL   : { writer.Write(std::uint8_t(ii.second.value.typeBool)); } break;
+				default: {
+					assert(false);
+				} break;
 			}
+		}
+
+		std::vector<std::string> deps;
+
+		if (haveData) {
+			deps = archData.GetDependencies();
 
-			std::vector<std::string> deps = archData.GetDependencies();
 			if (archData.IsMap()) {
 				FilterDep(deps, GetMapHelperContentName());
 			} else if (archData.IsGame()) {
 				FilterDep(deps, GetSpringBaseContentName());
 			}
-
-			if (!deps.empty()) {
-				fprintf(out, "\t\t\t\tdepend = {\n");
-				for (const auto& dep: deps) {
-					SafeStr(out, "\t\t\t\t\t", dep);
-				}
-				fprintf(out, "\t\t\t\t},\n");
-			}
-			fprintf(out, "\t\t\t},\n");
 		}
 
-		fprintf(out, "\t\t},\n");
+		writer.Write(std::uint32_t(deps.size()));
+
+		for (const std::string& dep: deps) {
+			writer.WriteString(dep);
+		}
 	}
 
-	fprintf(out, "\t},\n\n"); // close 'archives'
-	fprintf(out, "\tbrokenArchives = {  -- count = %u\n", unsigned(brokenArchives.size()));
+	writer.Write(std::uint32_t(brokenArchives.size()));
 
 	for (const BrokenArchive& ba: brokenArchives) {
-		fprintf(out, "\t\t{\n");
-		SafeStr(out, "\t\t\tname = ", ba.name);
-		SafeStr(out, "\t\t\tpath = ", ba.path);
-		fprintf(out, "\t\t\tmodified = \"%u\",\n", ba.modified);
-		SafeStr(out, "\t\t\tproblem = ", ba.problem);
-		fprintf(out, "\t\t},\n");
+		writer.WriteString(ba.name);
+		writer.WriteString(ba.path);
+		writer.Write(ba.modified);
+		writer.WriteString(ba.problem);
 	}
 
-	fprintf(out, "\t},\n"); // close 'brokenArchives'
-	fprintf(out, "}\n\n"); // close 'archiveCache'
-	fprintf(out, "return archiveCache\n");
-
-	if (fclose(out) == EOF)
+	// replaced atomically, a concurrently starting engine or unitsync either
+	// reads the previous or the new cache but never a partially written one
+	if (!CCacheFile::Write(filename, CACHE_FILE_MAGIC, INTERNAL_VER, 0, buffer)) {
 		LOG_L(L_ERROR, "[AS::%s] failed to write to \"%s\"!", __func__, filename.c_str());
+		return;
+	}
 
 	isDirty = false;
 }
@@ -120,6 +120,8 @@ public:
 	static const char* GetMapHelperContentName() { return "Map Helper v1"; }
 	static const char* GetSpringBaseContentName() { return "Spring content v1"; }
 	static uint32_t GetNumScannedArchives();
+	/// file names of the archives every game can read from, sorted
+	static std::vector<std::string> GetBaseContentArchives();
 
 	std::vector<std::string> GetMaps() const;
 	std::vector<ArchiveData> GetPrimaryMods() const;
@@ -184,6 +186,12 @@ private:
 		uint32_t modified = 0;
 		bool updated = false;
 	};
+	struct ScannedArchive {
+		ArchiveInfo archiveInfo;
+		BrokenArchive brokenArchive;
+
+		bool isBroken = false;
+	};
 
 private:
 	ArchiveInfo& GetAddArchiveInfo(const std::string& lcfn);
@@ -192,6 +200,13 @@ private:
 	void ScanDirs(const std::vector<std::string>& dirs);
 	void ScanDir(const std::string& curPath, std::deque<std::string>& foundArchives);
 
+	/**
+	 * open and inspect an archive that is not (validly) cached; only touches
+	 * the result so multiple archives can be processed in parallel
+	 */
+	void ScanArchiveData(const std::string& fullName, unsigned modifiedTime, bool doChecksum, ScannedArchive& result);
+	void AddScannedArchive(ScannedArchive& result);
+
 	/// scan mapinfo / modinfo lua files
 	bool ScanArchiveLua(IArchive* ar, const std::string& fileName, ArchiveInfo& ai, std::string& err);
 
@@ -202,9 +217,13 @@ private:
 	std::string SearchMapFile(const IArchive* ar, std::string& error);
 
 
+	/// reads the binary cache, or the older lua one if that does not exist
 	void ReadCacheData(const std::string& filename);
 	void WriteCacheData(const std::string& filename);
 
+	bool ReadCacheBinary(const std::string& filename);
+	bool ReadCacheLua(const std::string& filename);
+
 	IFileFilter* CreateIgnoreFilter(IArchive* ar);
 
 	/**
@@ -0,0 +1,155 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "System/Platform/Win/win32.h"
+
+#include <atomic>
+#include <cstddef>
+#include <fstream>
+
+#include "CacheFile.h"
+#include "FileSystem.h"
+#include "System/StringUtil.h"
+#include "System/Sync/HsiehHash.h"
+
+#ifndef _WIN32
+	#include <unistd.h>
+#endif
+
+
+static std::string GetTempFileName(const std::string& filePath)
+{
+	// unique across concurrent writers in this and in other processes
+	static std::atomic<unsigned int> tempFileCounter = {0};
+
+	#ifdef _WIN32
+	const unsigned int processID = GetCurrentProcessId();
+	#else
+	const unsigned int processID = getpid();
+	#endif
+
+	return (filePath + IntToString(processID, ".%u") + IntToString(tempFileCounter++, "-%u.tmp"));
+}
+
+
+bool CCacheFile::WriteFileAtomically(const std::string& filePath, const std::vector< std::pair<const void*, size_t> >& chunks)
+{
+	const std::string tempFilePath = GetTempFileName(filePath);
+
+	{
+		std::ofstream file(tempFilePath, std::ios::out | std::ios::binary);
+
+		if (!file.is_open())
+			return false;
+
+		for (const auto& chunk: chunks) {
+			if (file.write(reinterpret_cast<const char*>(chunk.first), chunk.second))
+				continue;
+
+			file.close();
+			FileSystem::Remove(tempFilePath);
+			return false;
+		}
+
+		file.close();
+
+		if (file.fail()) {
+			FileSystem::Remove(tempFilePath);
+			return false;
+		}
+	}
+
+	if (!FileSystem::Rename(tempFilePath, filePath)) {
+		FileSystem::Remove(tempFilePath);
+		return false;
+	}
+
+	return true;
+}
+
+
+std::uint32_t CCacheFile::CalcHash(const Header& header, const void* info, const void* data)
+{
+	std::uint32_t hash = 0;
+
+	hash = HsiehHash(&header, offsetof(Header, hash), hash);
+	hash = HsiehHash(info, header.infoSize, hash);
+	hash = HsiehHash(data, header.dataSize, hash);
+	return hash;
+}
+
+bool CCacheFile::Write(
+	const std::string& filePath,
+	const char* magic,
+	std::uint32_t version,
+	std::uint32_t key,
+	const void* info,
+	size_t infoSize,
+	const void* data,
+	size_t dataSize
+) {
+	Header fileHeader;
+
+	std::memcpy(fileHeader.magic, magic, sizeof(fileHeader.magic));
+
+	fileHeader.version = version;
+	fileHeader.key = key;
+	fileHeader.infoSize = infoSize;
+	fileHeader.dataSize = dataSize;
+	fileHeader.hash = CalcHash(fileHeader, info, data);
+
+	const char padding[DATA_ALIGNMENT] = {0};
+
+	return (WriteFileAtomically(filePath, {
+		{&fileHeader, sizeof(fileHeader)},
+		{info, infoSize},
+		{padding, GetDataOffset(infoSize) - sizeof(fileHeader) - infoSize},
+		{data, dataSize},
+	}));
+}
+
+
+bool CCacheFile::Open(const std::string& filePath, const char* magic, std::uint32_t version, std::uint32_t key, size_t infoSize)
+{
+	Close();
+
+	if (!FileSystem::FileExists(filePath))
+		return false;
+
+	fileName = filePath;
+
+	if (!mappedFile.Open(filePath))
+		return false;
+	if (mappedFile.GetSize() < sizeof(header))
+		return false;
+
+	std::memcpy(&header, mappedFile.GetData(), sizeof(header));
+
+	if (std::memcmp(header.magic, magic, sizeof(header.magic)) != 0)
+		return false;
+	if (header.version != version || header.key != key || header.infoSize != infoSize)
+		return false;
+	if (mappedFile.GetSize() != (GetDataOffset(infoSize) + header.dataSize))
+		return false;
+
+	return (CalcHash(header, GetInfo(), GetData()) == header.hash);
+}
+
+void CCacheFile::Close()
+{
+	mappedFile.Close();
+
+	header = {};
+	fileName.clear();
+}
+
+bool CCacheFile::Remove()
+{
+	const std::string filePath = std::move(fileName);
+
+	Close();
+
+	if (!filePath.empty())
+		FileSystem::Remove(filePath);
+
+	return false;
+}
@@ -0,0 +1,113 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef CACHE_FILE_H
+#define CACHE_FILE_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "MappedFile.h"
+
+/**
+ * Binary cache-file as used by the archive-, defs-, model-, texture- and
+ * path-caches. Layout (native endianness):
+ *
+ *   Header
+ *   info   (fixed-size record defined by the format, may be empty)
+ *   data   (starts at the next DATA_ALIGNMENT boundary)
+ *
+ * Header::hash covers the header itself, the info and the data, so nothing
+ * read from a file that passed Open can be stale or corrupted. Files are
+ * only ever replaced as a whole (see WriteFileAtomically), other processes
+ * that have the previous version opened or mapped keep reading it intact.
+ */
+class CCacheFile {
+public:
+	struct Header {
+		char magic[8];
+
+		std::uint32_t version;
+		std::uint32_t key;      // hash over every input the cached data depends on
+		std::uint32_t infoSize;
+		std::uint32_t dataSize;
+		std::uint32_t hash;     // must stay last, see CalcHash
+	};
+
+	static constexpr size_t DATA_ALIGNMENT = 16;
+
+	static size_t GetDataOffset(size_t infoSize) {
+		return ((sizeof(Header) + infoSize + DATA_ALIGNMENT - 1) & ~(DATA_ALIGNMENT - 1));
+	}
+
+public:
+	/**
+	 * Writes all chunks to a uniquely named temporary file in the directory
+	 * of filePath which is then renamed over it; the temporary is removed if
+	 * anything fails, filePath itself is never touched in that case.
+	 * @param filePath real path, e.g. from DataDirsAccess::LocateFile(WRITE)
+	 */
+	static bool WriteFileAtomically(const std::string& filePath, const std::vector< std::pair<const void*, size_t> >& chunks);
+
+	static bool Write(
+		const std::string& filePath,
+		const char* magic,
+		std::uint32_t version,
+		std::uint32_t key,
+		const void* info,
+		size_t infoSize,
+		const void* data,
+		size_t dataSize
+	);
+
+	template<typename Info>
+	static bool Write(const std::string& filePath, const char* magic, std::uint32_t version, std::uint32_t key, const Info& info, const void* data, size_t dataSize) {
+		return (Write(filePath, magic, version, key, &info, sizeof(Info), data, dataSize));
+	}
+
+	static bool Write(const std::string& filePath, const char* magic, std::uint32_t version, std::uint32_t key, const std::vector<std::uint8_t>& data) {
+		return (Write(filePath, magic, version, key, nullptr, 0, data.data(), data.size()));
+	}
+
+public:
+	/**
+	 * Maps filePath and verifies its header, sizes and hash.
+	 * @return false if the file does not exist or is unusable; in the latter
+	 *   case Remove can be used to get rid of it
+	 */
+	bool Open(const std::string& filePath, const char* magic, std::uint32_t version, std::uint32_t key, size_t infoSize = 0);
+
+	template<typename Info>
+	bool Open(const std::string& filePath, const char* magic, std::uint32_t version, std::uint32_t key, Info& info) {
+		if (!Open(filePath, magic, version, key, sizeof(Info)))
+			return false;
+
+		std::memcpy(&info, GetInfo(), sizeof(Info));
+		return true;
+	}
+
+	void Close();
+	/// closes and deletes the file passed to Open (if it existed); always returns false
+	bool Remove();
+
+	bool IsOpen() const { return mappedFile.IsOpen(); }
+
+	const std::uint8_t* GetInfo() const { return (mappedFile.GetData() + sizeof(Header)); }
+	const std::uint8_t* GetData() const { return (mappedFile.GetData() + GetDataOffset(header.infoSize)); }
+
+	size_t GetDataSize() const { return header.dataSize; }
+
+private:
+	static std::uint32_t CalcHash(const Header& header, const void* info, const void* data);
+
+private:
+	CMappedFile mappedFile;
+	Header header = {};
+
+	// empty unless the file existed
+	std::string fileName;
+};
+
+#endif // CACHE_FILE_H
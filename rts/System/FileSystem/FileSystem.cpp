@@ -280,6 +280,14 @@ bool FileSystem::Remove(std::string file)
 	return FileSystem::DeleteFile(FileSystem::GetNormalizedPath(file));
 }
 
+bool FileSystem::Rename(std::string src, std::string dst)
+{
+	if (!CheckFile(src) || !CheckFile(dst))
+		return false;
+
+	return FileSystem::RenameFile(FileSystem::GetNormalizedPath(src), FileSystem::GetNormalizedPath(dst));
+}
+
 const std::string& FileSystem::GetCacheBaseDir()
 {
 	static const std::string cacheBaseDir = "cache";
@@ -32,6 +32,15 @@ public:
 	 */
 	static bool Remove(std::string file);
 
+	/**
+	 * @brief rename a file, replacing the target if it exists
+	 *
+	 * Readers that still have the old target open (or mapped) keep seeing
+	 * its contents on POSIX systems; on Windows the rename fails instead.
+	 * Operates on the current working directory.
+	 */
+	static bool Rename(std::string src, std::string dst);
+
 	/**
 	 * @brief Compares if 2 paths point to the same file/directory
 	 *
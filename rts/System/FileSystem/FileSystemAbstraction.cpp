@@ -283,6 +283,24 @@ bool FileSystemAbstraction::DeleteFile(const std::string& file)
 	return true;
 }
 
+bool FileSystemAbstraction::RenameFile(const std::string& src, const std::string& dst)
+{
+#ifdef _WIN32
+	// fails (and leaves dst alone) while another process has dst open
+	if (!MoveFileExA(src.c_str(), dst.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+		LOG_L(L_WARNING, "[FSA::%s] error %lu renaming file '%s' to '%s'", __func__, GetLastError(), src.c_str(), dst.c_str());
+		return false;
+	}
+#else
+	if (rename(src.c_str(), dst.c_str()) != 0) {
+		LOG_L(L_WARNING, "[FSA::%s] error '%s' renaming file '%s' to '%s'", __func__, strerror(errno), src.c_str(), dst.c_str());
+		return false;
+	}
+#endif
+
+	return true;
+}
+
 
 bool FileSystemAbstraction::FileExists(const std::string& file)
 {
@@ -27,6 +27,8 @@ public:
 	// almost direct wrappers to system calls
 	static bool MkDir(const std::string& dir);
 	static bool DeleteFile(const std::string& file);
+	/// replaces dst if it exists; atomic where the platform allows it
+	static bool RenameFile(const std::string& src, const std::string& dst);
 	/// Returns true if the file exists, and is not a directory
 	static bool FileExists(const std::string& file);
 	static bool DirExists(const std::string& dir);
@@ -0,0 +1,137 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+	#include "System/Platform/Win/win32.h"
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+
+CMappedFile& CMappedFile::operator = (CMappedFile&& f)
+{
+	if (this == &f)
+		return *this;
+
+	Close();
+
+	std::swap(fileData, f.fileData);
+	std::swap(fileSize, f.fileSize);
+
+	#ifdef _WIN32
+	std::swap(fileHandle, f.fileHandle);
+	std::swap(mappingHandle, f.mappingHandle);
+	#endif
+
+	return *this;
+}
+
+
+bool CMappedFile::Open(const std::string& filePath)
+{
+	Close();
+
+	#ifdef _WIN32
+	HANDLE hFile = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+	if (hFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+
+	if (!GetFileSizeEx(hFile, &size) || size.QuadPart == 0) {
+		CloseHandle(hFile);
+		return false;
+	}
+
+	HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+	if (hMapping == nullptr) {
+		CloseHandle(hFile);
+		return false;
+	}
+
+	const void* data = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+
+	if (data == nullptr) {
+		CloseHandle(hMapping);
+		CloseHandle(hFile);
+		return false;
+	}
+
+	fileHandle = hFile;
+	mappingHandle = hMapping;
+	fileData = reinterpret_cast<const std::uint8_t*>(data);
+	fileSize = size.QuadPart;
+
+	#else
+	const int fd = open(filePath.c_str(), O_RDONLY);
+
+	if (fd == -1)
+		return false;
+
+	struct stat sb;
+
+	if (fstat(fd, &sb) == -1 || sb.st_size == 0) {
+		close(fd);
+		return false;
+	}
+
+	void* data = mmap(nullptr, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	// the mapping keeps its own reference to the file
+	close(fd);
+
+	if (data == MAP_FAILED)
+		return false;
+
+	fileData = reinterpret_cast<const std::uint8_t*>(data);
+	fileSize = sb.st_size;
+	#endif
+
+	return true;
+}
+
+void CMappedFile::Close()
+{
+	if (fileData == nullptr)
+		return;
+
+	#ifdef _WIN32
+	UnmapViewOfFile(fileData);
+	CloseHandle(mappingHandle);
+	CloseHandle(fileHandle);
+
+	fileHandle = nullptr;
+	mappingHandle = nullptr;
+	#else
+	munmap(const_cast<std::uint8_t*>(fileData), fileSize);
+	#endif
+
+	fileData = nullptr;
+	fileSize = 0;
+}
+
+
+void CMappedFile::Prefetch(size_t offset, size_t size) const
+{
+	if (fileData == nullptr || offset >= fileSize)
+		return;
+
+	#ifndef _WIN32
+	// madvise wants a page-aligned start address
+	const size_t pageSize = sysconf(_SC_PAGESIZE);
+	const size_t pageOffset = offset & ~(pageSize - 1);
+
+	size = std::min(size, fileSize - offset) + (offset - pageOffset);
+
+	madvise(const_cast<std::uint8_t*>(fileData) + pageOffset, size, MADV_WILLNEED);
+	#endif
+}
+
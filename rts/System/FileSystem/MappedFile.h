@@ -0,0 +1,50 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cinttypes>
+#include <string>
+#include <utility>
+
+/**
+ * Read-only memory mapping of a whole file on the real filesystem
+ * (not the VFS). Pages are faulted in by the OS on first access, so
+ * opening even a large file is cheap and only touched parts of it
+ * are ever read from disk.
+ */
+class CMappedFile {
+public:
+	CMappedFile() = default;
+	CMappedFile(const std::string& filePath) { Open(filePath); }
+	CMappedFile(const CMappedFile&) = delete;
+	CMappedFile(CMappedFile&& f) { *this = std::move(f); }
+	~CMappedFile() { Close(); }
+
+	CMappedFile& operator = (const CMappedFile&) = delete;
+	CMappedFile& operator = (CMappedFile&& f);
+
+	/// @param filePath absolute path, e.g. from DataDirsAccess::LocateFile
+	bool Open(const std::string& filePath);
+	void Close();
+
+	/// hints the OS to start reading [offset, offset + size) in the background
+	void Prefetch(size_t offset, size_t size) const;
+
+	bool IsOpen() const { return (fileData != nullptr); }
+
+	const std::uint8_t* GetData() const { return fileData; }
+	size_t GetSize() const { return fileSize; }
+
+private:
+	const std::uint8_t* fileData = nullptr;
+	size_t fileSize = 0;
+
+	#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+	#endif
+};
+
+#endif // MAPPED_FILE_H
+
@@ -196,12 +196,36 @@ static void LoadLuaState(CSplitLuaHandle* handle, creg::CInputStreamSerializer&
 
 void CCregLoadSaveHandler::SaveGame(const std::string& path)
 {
-#ifdef USING_CREG
 	LOG("[LSH::%s] saving game to \"%s\"", __func__, path.c_str());
 
-	try {
-		std::stringstream oss;
+	std::stringstream oss;
+
+	if (!SaveGameState(oss))
+		return;
+
+	gzFile file = gzopen(dataDirsAccess.LocateFile(path, FileQueryFlags::WRITE).c_str(), "wb5");
+
+	if (file == nullptr) {
+		LOG_L(L_ERROR, "[LSH::%s] could not open save-file", __func__);
+		return;
+	}
+
+	std::string data = std::move(oss.str());
+	std::function<void(gzFile, std::string&&)> func = [](gzFile file, std::string&& data) {
+		gzwrite(file, data.c_str(), data.size());
+		gzflush(file, Z_FINISH);
+		gzclose(file);
+	};
+
+	// gzFile is just a plain typedef (struct gzFile_s {}* gzFile), can be copied
+	// need to keep a reference to the future around or its destructor will block
+	ThreadPool::AddExtJob(std::move(std::async(std::launch::async, std::move(func), file, std::move(data))));
+}
 
+bool CCregLoadSaveHandler::SaveGameState(std::stringstream& oss)
+{
+#ifdef USING_CREG
+	try {
 		// write our own header. SavePackage() will add its own
 		WriteString(oss, SpringVersion::GetSync());
 		WriteString(oss, gameSetup->setupText);
@@ -240,27 +264,7 @@ void CCregLoadSaveHandler::SaveGame(const std::string& path)
 			PrintSize("AIs", ((int)oss.tellp()) - aiStart);
 		}
 
-		{
-			gzFile file = gzopen(dataDirsAccess.LocateFile(path, FileQueryFlags::WRITE).c_str(), "wb5");
-
-			if (file == nullptr) {
-				LOG_L(L_ERROR, "[LSH::%s] could not open save-file", __func__);
-				return;
-			}
-
-			std::string data = std::move(oss.str());
-			std::function<void(gzFile, std::string&&)> func = [](gzFile file, std::string&& data) {
-				gzwrite(file, data.c_str(), data.size());
-				gzflush(file, Z_FINISH);
-				gzclose(file);
-			};
-
-			// gzFile is just a plain typedef (struct gzFile_s {}* gzFile), can be copied
-			// need to keep a reference to the future around or its destructor will block
-			ThreadPool::AddExtJob(std::move(std::async(std::launch::async, std::move(func), file, std::move(data))));
-		}
-
-		//FIXME add lua state
+		return true;
 	} catch (const content_error& ex) {
 		LOG_L(L_ERROR, "[LSH::%s] content error \"%s\"", __func__, ex.what());
 	} catch (const std::exception& ex) {
@@ -275,6 +279,8 @@ void CCregLoadSaveHandler::SaveGame(const std::string& path)
 #else //USING_CREG
 	LOG_L(L_ERROR, "[LSH::%s] creg is disabled", __func__);
 #endif //USING_CREG
+
+	return false;
 }
 
 /// loads the data (map&mod-name,setup-script) needed by PreGame
@@ -283,28 +289,45 @@ bool CCregLoadSaveHandler::LoadGameStartInfo(const std::string& path)
 	CGZFileHandler saveFile(dataDirsAccess.LocateFile(FindSaveFile(path)), SPRING_VFS_RAW_FIRST);
 
 	std::stringbuf* sbuf = iss.rdbuf();
-	std::string saveVersion;
-	std::string syncVersion = SpringVersion::GetSync();
 
 	char buf[4096];
 	int len;
 	while ((len = saveFile.Read(buf, sizeof(buf))) > 0)
 		sbuf->sputn(buf, len);
 
+	const bool validVersion = ReadGameStartInfo(path);
+
+	CGameSetup::LoadSavedScript(path, scriptText);
+	return validVersion;
+}
+
+/// loads the header of a state sent by the server, setup-script is already known from gamedata
+bool CCregLoadSaveHandler::LoadGameStateInfo(const std::string& stateData)
+{
+	iss.str(stateData);
+	isSnapshot = true;
+
+	return (ReadGameStartInfo("<snapshot>"));
+}
+
+bool CCregLoadSaveHandler::ReadGameStartInfo(const std::string& name)
+{
+	std::string saveVersion;
+	std::string syncVersion = SpringVersion::GetSync();
+
 	ReadString(iss, saveVersion);
 
 	// check saved engine version against current build
 	// in general these will *not* be binary-compatible
 	// (so prefer to terminate loading from PreGame)
 	if (saveVersion != syncVersion)
-		LOG_L(L_WARNING, "[LSH::%s][release=%d] file \"%s\" saved by engine version \"%s\" incompatible with \"%s\"", __func__, SpringVersion::IsRelease(), path.c_str(), saveVersion.c_str(), syncVersion.c_str());
+		LOG_L(L_WARNING, "[LSH::%s][release=%d] file \"%s\" saved by engine version \"%s\" incompatible with \"%s\"", __func__, SpringVersion::IsRelease(), name.c_str(), saveVersion.c_str(), syncVersion.c_str());
 
 	// read our own header
 	ReadString(iss, scriptText);
 	ReadString(iss, modName);
 	ReadString(iss, mapName);
 
-	CGameSetup::LoadSavedScript(path, scriptText);
 	return (saveVersion == syncVersion);
 }
 
@@ -313,6 +336,10 @@ void CCregLoadSaveHandler::LoadGame()
 {
 #ifdef USING_CREG
 	ENTER_SYNCED_CODE();
+
+	// gu is part of the state, but a snapshot was made by another player
+	const int myPlayerNum = gu->myPlayerNum;
+
 	{
 		creg::CInputStreamSerializer inputStream;
 
@@ -336,6 +363,12 @@ void CCregLoadSaveHandler::LoadGame()
 			std::streamsize aiSize;
 			inputStream.SerializeInt(&aiSize, sizeof(aiSize));
 
+			// the donor's AIs are not ours; any we host start from scratch
+			if (isSnapshot) {
+				iss.ignore(aiSize);
+				continue;
+			}
+
 			std::vector<char> buffer(aiSize);
 			std::stringstream aiData;
 			iss.read(buffer.data(), buffer.size());
@@ -348,6 +381,13 @@ void CCregLoadSaveHandler::LoadGame()
 	// cleanup
 	iss.str("");
 
+	if (isSnapshot) {
+		// joined mid-game, keep the pause-state of the running game
+		gu->SetMyPlayer(myPlayerNum);
+		LEAVE_SYNCED_CODE();
+		return;
+	}
+
 	gs->paused = false;
 	if (gameServer != nullptr) {
 		gameServer->isPaused = false;
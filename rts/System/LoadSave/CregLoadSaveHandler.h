@@ -17,8 +17,23 @@ public:
 	void LoadGame() override;
 	void SaveGame(const std::string& path) override;
 
+	/// serializes the current game-state into <oss> (what SaveGame writes)
+	bool SaveGameState(std::stringstream& oss);
+
+	/**
+	 * counterpart of LoadGameStartInfo for a state received from another
+	 * client (mid-game join); the local player keeps its own identity and
+	 * the game is not unpaused when the state is loaded
+	 */
+	bool LoadGameStateInfo(const std::string& stateData);
+
+protected:
+	bool ReadGameStartInfo(const std::string& name);
+
 protected:
 	std::stringstream iss;
+
+	bool isSnapshot = false;
 };
 
 #endif // CREG_LOAD_SAVE_HANDLER_H
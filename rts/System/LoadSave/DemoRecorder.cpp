@@ -2,8 +2,11 @@
 
 #include <cassert>
 #include <cerrno>
+#include <cstdio>
 #include <cstring>
+#include <deque>
 #include <memory>
+#include <zlib.h>
 
 #include "DemoRecorder.h"
 #include "Game/GameVersion.h"
@@ -15,7 +18,7 @@
 #include "System/FileSystem/FileQueryFlags.h"
 #include "System/FileSystem/FileHandler.h"
 #include "System/Log/ILog.h"
-#include "System/Threading/ThreadPool.h"
+#include "System/Threading/SpringThreading.h"
 
 #ifdef CreateDirectory
 #undef CreateDirectory
@@ -26,40 +29,161 @@
 #endif
 
 
-// server and client memory-streams
-static std::string demoStreams[2];
-static spring::mutex demoMutex;
+// chunks are handed to the writer once they reach this size or age
+static constexpr size_t DEMO_CHUNK_SIZE = 1024 * 1024;
+static constexpr float DEMO_CHUNK_PERIOD = 30.0f;
 
+// writer blocks the recorder if it falls this many chunks behind
+static constexpr size_t MAX_QUEUED_CHUNKS = 8;
 
-CDemoRecorder::CDemoRecorder(const std::string& mapName, const std::string& modName, bool serverDemo): isServerDemo(serverDemo)
+
+static void DeflateGzipMember(const std::string& src, int level, std::vector<std::uint8_t>& dst)
 {
-	std::lock_guard<spring::mutex> lock(demoMutex);
+	z_stream zs;
+	memset(&zs, 0, sizeof(zs));
+
+	// +16 selects a gzip wrapper; a single Z_FINISH call always suffices with deflateBound
+	deflateInit2(&zs, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+	dst.resize(deflateBound(&zs, src.size()));
+
+	zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(src.data()));
+	zs.avail_in = src.size();
+	zs.next_out = dst.data();
+	zs.avail_out = dst.size();
+
+	const int ret = deflate(&zs, Z_FINISH);
+	assert(ret == Z_STREAM_END);
+
+	dst.resize(zs.total_out);
+	deflateEnd(&zs);
+}
+
+
+/**
+ * Compresses and writes demo data on its own thread. The file is a series
+ * of gzip members (which gzread decompresses as one stream): the first
+ * holds only the DemoFileHeader and is stored uncompressed, s.t. it keeps
+ * its size and can be rewritten in place; each following member is one
+ * chunk of the demo and is flushed to disk as soon as it is compressed.
+ */
+class CDemoStreamWriter
+{
+public:
+	CDemoStreamWriter(FILE* f): file(f) {
+		thread = spring::thread(&CDemoStreamWriter::Run, this);
+	}
+	~CDemoStreamWriter() {
+		{
+			std::lock_guard<spring::mutex> lock(mutex);
+			quit = true;
+		}
+
+		cond.notify_all();
+		thread.join();
+		fclose(file);
+	}
+
+	void Push(std::string&& data, bool header) {
+		{
+			std::unique_lock<spring::mutex> lock(mutex);
+
+			cond.wait(lock, [&]() { return (jobs.size() < MAX_QUEUED_CHUNKS); });
+			jobs.emplace_back(std::move(data), header);
+		}
+
+		cond.notify_all();
+	}
+
+private:
+	void Run() {
+		std::vector<std::uint8_t> member;
+		std::pair<std::string, bool> job;
+
+		while (true) {
+			{
+				std::unique_lock<spring::mutex> lock(mutex);
+
+				cond.wait(lock, [&]() { return (quit || !jobs.empty()); });
+
+				// only exit once everything queued has been written
+				if (jobs.empty())
+					return;
+
+				job = std::move(jobs.front());
+				jobs.pop_front();
+			}
+
+			cond.notify_all();
+
+			if (job.second) {
+				DeflateGzipMember(job.first, Z_NO_COMPRESSION, member);
+
+				assert(headerSize == 0 || headerSize == member.size());
+				headerSize = member.size();
+
+				fseek(file, 0, SEEK_SET);
+				fwrite(member.data(), member.size(), 1, file);
+				fseek(file, 0, SEEK_END);
+			} else {
+				DeflateGzipMember(job.first, Z_BEST_COMPRESSION, member);
+				fwrite(member.data(), member.size(), 1, file);
+			}
+
+			fflush(file);
+		}
+	}
+
+private:
+	FILE* file = nullptr;
+
+	spring::thread thread;
+	spring::mutex mutex;
+	spring::condition_variable_any cond;
 
+	// {data, isHeader}
+	std::deque<std::pair<std::string, bool>> jobs;
+
+	size_t headerSize = 0;
+	bool quit = false;
+};
+
+
+
+CDemoRecorder::CDemoRecorder() { memset(&fileHeader, 0, sizeof(fileHeader)); }
+CDemoRecorder::CDemoRecorder(CDemoRecorder&& r) { *this = std::move(r); }
+
+CDemoRecorder::CDemoRecorder(const std::string& mapName, const std::string& modName, bool serverDemo): isServerDemo(serverDemo)
+{
 	SetStream();
 	SetName(mapName, modName);
 	SetFileHeader();
-	WriteFileHeader(false);
 
-	file = gzopen(demoName.c_str(), "wb9");
+	FILE* file = demoName.empty()? nullptr: fopen(demoName.c_str(), "wb");
+
+	if (file == nullptr)
+		return;
+
+	writer.reset(new CDemoStreamWriter(file));
+	WriteFileHeader(false);
 }
 
 CDemoRecorder::~CDemoRecorder()
 {
-	if (file == nullptr)
+	if (writer == nullptr)
 		return;
 
 	WriteWinnerList();
 	WritePlayerStats();
 	WriteTeamStats();
-	WriteFileHeader(true);
 	WriteDemoFile();
 }
 
 
 void CDemoRecorder::SetStream()
 {
-	demoStreams[isServerDemo].clear();
-	demoStreams[isServerDemo].reserve(8 * 1024 * 1024);
+	demoChunk.clear();
+	demoChunk.reserve(DEMO_CHUNK_SIZE + 4096);
+	demoChunkTime = 0.0f;
 }
 
 void CDemoRecorder::SetFileHeader()
@@ -76,31 +200,28 @@ void CDemoRecorder::SetFileHeader()
 	fileHeader.winningAllyTeamsSize = 0;
 }
 
+void CDemoRecorder::WriteDemoChunk()
+{
+	if (demoChunk.empty())
+		return;
+
+	std::string chunk;
+	chunk.reserve(DEMO_CHUNK_SIZE + 4096);
+	chunk.swap(demoChunk);
+
+	writer->Push(std::move(chunk), false);
+}
+
 void CDemoRecorder::WriteDemoFile()
 {
-	// zlib FAQ claims the lib is thread-safe, "however any library routines that zlib uses and
-	// any application-provided memory allocation routines must also be thread-safe. zlib's gz*
-	// functions use stdio library routines, and most of zlib's functions use the library memory
-	// allocation routines by default" (so code below should be OK)
-	// gz* should usually be finished before ctor runs again when reloading, but take no chances
-	std::string& data = demoStreams[isServerDemo];
-	std::function<void(gzFile, std::string&)> func = [](gzFile file, std::string& data) {
-		std::lock_guard<spring::mutex> lock(demoMutex);
-
-		gzwrite(file, data.c_str(), data.size());
-		gzflush(file, Z_FINISH);
-		gzclose(file);
-	};
-
-	LOG("[DemoRecorder::%s] writing %s-demo \"%s\" (" _STPF_ " bytes)", __func__, (isServerDemo? "server": "client"), demoName.c_str(), data.size());
-
-	#ifndef _WIN32
-	// NOTE: can not use ThreadPool for this directly here, workers are already gone
-	// FIXME: does not currently (august 2017) compile on Windows mingw buildbots
-	ThreadPool::AddExtJob(spring::thread(std::move(func), file, std::ref(data)));
-	#else
-	ThreadPool::AddExtJob(std::move(std::async(std::launch::async, std::move(func), file, std::ref(data))));
-	#endif
+	LOG("[DemoRecorder::%s] writing %s-demo \"%s\" (%d bytes)", __func__, (isServerDemo? "server": "client"), demoName.c_str(), fileHeader.demoStreamSize);
+
+	// stats go into the last chunk, then the header gets its final sizes;
+	// only a little data is left at this point so waiting on it is cheap
+	WriteDemoChunk();
+	WriteFileHeader(true);
+
+	writer.reset();
 }
 
 void CDemoRecorder::WriteSetupText(const std::string& text)
@@ -111,7 +232,10 @@ void CDemoRecorder::WriteSetupText(const std::string& text)
 	}
 
 	fileHeader.scriptSize = length;
-	demoStreams[isServerDemo].append(text.c_str(), length);
+	demoChunk.append(text.c_str(), length);
+
+	// the script precedes the stream, readers need its size even if the demo is never finished
+	WriteFileHeader(false);
 }
 
 void CDemoRecorder::SaveToDemo(const unsigned char* buf, const unsigned length, const float modGameTime)
@@ -121,9 +245,18 @@ void CDemoRecorder::SaveToDemo(const unsigned char* buf, const unsigned length,
 	chunkHeader.modGameTime = modGameTime;
 	chunkHeader.length = length;
 	chunkHeader.swab();
-	demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&chunkHeader), sizeof(chunkHeader));
-	demoStreams[isServerDemo].append(reinterpret_cast<const char*>(buf), length);
+	demoChunk.append(reinterpret_cast<const char*>(&chunkHeader), sizeof(chunkHeader));
+	demoChunk.append(reinterpret_cast<const char*>(buf), length);
 	fileHeader.demoStreamSize += (length + sizeof(chunkHeader));
+
+	if (writer == nullptr)
+		return;
+
+	if (demoChunk.size() < DEMO_CHUNK_SIZE && (modGameTime - demoChunkTime) < DEMO_CHUNK_PERIOD)
+		return;
+
+	WriteDemoChunk();
+	demoChunkTime = modGameTime;
 }
 
 void CDemoRecorder::SetName(const std::string& mapName, const std::string& modName)
@@ -216,9 +349,9 @@ void CDemoRecorder::SetWinningAllyTeams(const std::vector<unsigned char>& winnin
 }
 
 /** @brief Write DemoFileHeader
-Write the DemoFileHeader at the start of the file and restores the original
-position in the file afterwards. */
-unsigned int CDemoRecorder::WriteFileHeader(bool updateStreamLength)
+(Re)writes the DemoFileHeader at the start of the file; demoStreamSize stays
+zero until the end, which tells readers to read an interrupted demo until EOF. */
+void CDemoRecorder::WriteFileHeader(bool updateStreamLength)
 {
 	DemoFileHeader tmpHeader;
 	memcpy(&tmpHeader, &fileHeader, sizeof(fileHeader));
@@ -229,28 +362,24 @@ unsigned int CDemoRecorder::WriteFileHeader(bool updateStreamLength)
 	// to little endian
 	tmpHeader.swab();
 
-	if (demoStreams[isServerDemo].empty()) {
-		demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&tmpHeader), sizeof(tmpHeader));
-	} else {
-		assert(demoStreams[isServerDemo].size() >= sizeof(tmpHeader));
-		memcpy(&demoStreams[isServerDemo][0], reinterpret_cast<const char*>(&tmpHeader), sizeof(tmpHeader)); // no non-const .data() until C++17
-	}
+	if (writer == nullptr)
+		return;
 
-	return (demoStreams[isServerDemo].size());
+	writer->Push(std::string(reinterpret_cast<const char*>(&tmpHeader), sizeof(tmpHeader)), true);
 }
 
 /** @brief Write the CPlayer::Statistics at the current position in the file. */
 void CDemoRecorder::WritePlayerStats()
 {
-	const size_t pos = demoStreams[isServerDemo].size();
+	const size_t pos = demoChunk.size();
 
 	for (PlayerStatistics& stats: playerStats) {
 		stats.swab();
-		demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&stats), sizeof(PlayerStatistics));
+		demoChunk.append(reinterpret_cast<const char*>(&stats), sizeof(PlayerStatistics));
 	}
 
 	fileHeader.numPlayers = playerStats.size();
-	fileHeader.playerStatSize = int(demoStreams[isServerDemo].size() - pos);
+	fileHeader.playerStatSize = int(demoChunk.size() - pos);
 
 	playerStats.clear();
 }
@@ -263,38 +392,38 @@ void CDemoRecorder::WriteWinnerList()
 	if (fileHeader.numTeams == 0)
 		return;
 
-	const size_t pos = demoStreams[isServerDemo].size();
+	const size_t pos = demoChunk.size();
 
 	// Write the array of winningAllyTeams.
 	for (size_t i = 0; i < winningAllyTeams.size(); i++) { // NOLINT{modernize-loop-convert}
-		demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&winningAllyTeams[i]), sizeof(unsigned char));
+		demoChunk.append(reinterpret_cast<const char*>(&winningAllyTeams[i]), sizeof(unsigned char));
 	}
 
 	winningAllyTeams.clear();
 
-	fileHeader.winningAllyTeamsSize = int(demoStreams[isServerDemo].size() - pos);
+	fileHeader.winningAllyTeamsSize = int(demoChunk.size() - pos);
 }
 
 /** @brief Write the TeamStatistics at the current position in the file. */
 void CDemoRecorder::WriteTeamStats()
 {
-	const size_t pos = demoStreams[isServerDemo].size();
+	const size_t pos = demoChunk.size();
 
 	// Write array of dwords indicating number of TeamStatistics per team.
 	for (std::vector<TeamStatistics>& history: teamStats) {
 		unsigned int c = swabDWord(history.size());
-		demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&c), sizeof(unsigned int));
+		demoChunk.append(reinterpret_cast<const char*>(&c), sizeof(unsigned int));
 	}
 
 	// Write big array of TeamStatistics.
 	for (std::vector<TeamStatistics>& history: teamStats) {
 		for (TeamStatistics& stats: history) {
 			stats.swab();
-			demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&stats), sizeof(TeamStatistics));
+			demoChunk.append(reinterpret_cast<const char*>(&stats), sizeof(TeamStatistics));
 		}
 	}
 
-	fileHeader.teamStatSize = int(demoStreams[isServerDemo].size() - pos);
+	fileHeader.teamStatSize = int(demoChunk.size() - pos);
 
 	teamStats.clear();
 }
@@ -3,26 +3,31 @@
 #ifndef DEMO_RECORDER
 #define DEMO_RECORDER
 
+#include <memory>
 #include <vector>
 #include <sstream>
-#include <zlib.h>
 
 #include "Demo.h"
 #include "Game/Players/PlayerStatistics.h"
 #include "Sim/Misc/TeamStatistics.h"
 
+class CDemoStreamWriter;
 
 /**
  * @brief Used to record demos
+ *
+ * The demo stream is buffered in chunks which are compressed and appended
+ * to the file on a background thread as they fill up (or become too old),
+ * so memory use is bounded and an interrupted recording remains readable.
  */
 class CDemoRecorder : public CDemo
 {
 public:
-	CDemoRecorder() { memset(&fileHeader, 0, sizeof(fileHeader)); }
+	CDemoRecorder();
 	CDemoRecorder(const std::string& mapName, const std::string& modName, bool serverDemo);
 
 	CDemoRecorder(const CDemoRecorder&) = delete;
-	CDemoRecorder(CDemoRecorder&& r) { *this = std::move(r); }
+	CDemoRecorder(CDemoRecorder&& r);
 
 	~CDemoRecorder();
 
@@ -32,9 +37,11 @@ public:
 		memcpy(&fileHeader, &r.fileHeader, sizeof(fileHeader));
 		memset(&r.fileHeader, 0, sizeof(fileHeader));
 
-		std::swap(file, r.file);
+		std::swap(writer, r.writer);
 
 		std::swap(demoName, r.demoName);
+		std::swap(demoChunk, r.demoChunk);
+		std::swap(demoChunkTime, r.demoChunkTime);
 		std::swap(playerStats, r.playerStats);
 		std::swap(teamStats, r.teamStats);
 		std::swap(winningAllyTeams, r.winningAllyTeams);
@@ -44,7 +51,7 @@ public:
 	}
 
 
-	bool IsValid() const { return (file != nullptr); }
+	bool IsValid() const { return (writer != nullptr); }
 
 	void WriteSetupText(const std::string& text);
 	void SaveToDemo(const unsigned char* buf, const unsigned length, const float modGameTime);
@@ -63,15 +70,21 @@ public:
 	void SetWinningAllyTeams(const std::vector<unsigned char>& winningAllyTeams);
 
 private:
-	unsigned int WriteFileHeader(bool updateStreamLength);
+	void WriteFileHeader(bool updateStreamLength);
 	void SetFileHeader();
 	void WritePlayerStats();
 	void WriteTeamStats();
 	void WriteWinnerList();
+	void WriteDemoChunk();
 	void WriteDemoFile();
 
 private:
-	gzFile file = nullptr;
+	std::unique_ptr<CDemoStreamWriter> writer;
+
+	// uncompressed data not yet handed to the writer
+	std::string demoChunk;
+	// game-time at which the current chunk was started
+	float demoChunkTime = 0.0f;
 
 	std::vector<PlayerStatistics> playerStats;
 	std::vector< std::vector<TeamStatistics> > teamStats;
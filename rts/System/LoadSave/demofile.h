@@ -49,6 +49,9 @@
  *
  * If Spring did not cleanup properly (crashed), the demoStreamSize is 0 and it
  * can be assumed the demo stream continues until the end of the file.
+ *
+ * The file is gzip-compressed as a sequence of members (see CDemoRecorder),
+ * any gzip reader that handles concatenated members sees the layout above.
  */
 struct DemoFileHeader
 {
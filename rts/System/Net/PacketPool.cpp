@@ -0,0 +1,109 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "PacketPool.h"
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cinttypes>
+#include <mutex>
+#include <new>
+
+#include "System/Threading/SpringThreading.h"
+
+namespace netcode
+{
+namespace PacketPool
+{
+
+static constexpr size_t SLAB_SIZE = 64 * 1024;
+static constexpr size_t NUM_SIZE_CLASSES = 10;
+
+static_assert((MIN_BLOCK_SIZE << (NUM_SIZE_CLASSES - 1)) == MAX_BLOCK_SIZE, "");
+static_assert((SLAB_SIZE % MAX_BLOCK_SIZE) == 0, "");
+
+
+struct FreeBlock {
+	FreeBlock* next;
+};
+
+struct SizeClass {
+	spring::spinlock mutex;
+	FreeBlock* freeList = nullptr;
+};
+
+// slabs are never released (not even at exit) so packets which
+// outlive the pool's statics can still be returned to it safely
+static std::array<SizeClass, NUM_SIZE_CLASSES> sizeClasses;
+static std::atomic<size_t> numHeapAllocs = {0};
+
+
+static size_t GetSizeClass(size_t size)
+{
+	size_t sizeClass = 0;
+
+	while ((MIN_BLOCK_SIZE << sizeClass) < size)
+		sizeClass++;
+
+	return sizeClass;
+}
+
+
+void* Alloc(size_t size)
+{
+	if (size > MAX_BLOCK_SIZE) {
+		numHeapAllocs.fetch_add(1, std::memory_order_relaxed);
+		return (::operator new(size));
+	}
+
+	const size_t sizeClassIdx = GetSizeClass(size);
+	const size_t blockSize = MIN_BLOCK_SIZE << sizeClassIdx;
+
+	SizeClass& sizeClass = sizeClasses[sizeClassIdx];
+
+	std::lock_guard<spring::spinlock> lock(sizeClass.mutex);
+
+	if (sizeClass.freeList == nullptr) {
+		std::uint8_t* slab = static_cast<std::uint8_t*>(::operator new(SLAB_SIZE));
+
+		// thread blocks in reverse so they are handed out in address order
+		for (size_t ofs = SLAB_SIZE; ofs >= blockSize; ofs -= blockSize) {
+			FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + ofs - blockSize);
+
+			block->next = sizeClass.freeList;
+			sizeClass.freeList = block;
+		}
+
+		numHeapAllocs.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	FreeBlock* block = sizeClass.freeList;
+	sizeClass.freeList = block->next;
+	return block;
+}
+
+void Free(void* mem, size_t size)
+{
+	if (mem == nullptr)
+		return;
+
+	if (size > MAX_BLOCK_SIZE) {
+		::operator delete(mem);
+		return;
+	}
+
+	SizeClass& sizeClass = sizeClasses[GetSizeClass(size)];
+	FreeBlock* block = static_cast<FreeBlock*>(mem);
+
+	std::lock_guard<spring::spinlock> lock(sizeClass.mutex);
+
+	block->next = sizeClass.freeList;
+	sizeClass.freeList = block;
+}
+
+
+size_t GetNumHeapAllocs() { return (numHeapAllocs.load(std::memory_order_relaxed)); }
+
+} // namespace PacketPool
+} // namespace netcode
+
@@ -0,0 +1,59 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef PACKET_POOL_H
+#define PACKET_POOL_H
+
+#include <cstddef>
+
+namespace netcode
+{
+
+/**
+ * @brief process-wide size-class allocator for packet memory
+ *
+ * Blocks are carved out of slabs which are never given back to the
+ * system; freed blocks go onto the free-list of their size-class and
+ * are handed out again, so once the pool has grown to cover the peak
+ * number of packets (and chunks) in flight, creating and destroying
+ * them causes no further heap allocations. Requests larger than
+ * MAX_BLOCK_SIZE are passed straight to operator new.
+ *
+ * Thread-safe; every size-class has its own lock.
+ */
+namespace PacketPool
+{
+	static constexpr size_t MIN_BLOCK_SIZE = 16;
+	static constexpr size_t MAX_BLOCK_SIZE = 8192;
+
+	void* Alloc(size_t size);
+	void Free(void* mem, size_t size);
+
+	/// number of times the pool had to go to the heap (new slabs and oversized blocks)
+	size_t GetNumHeapAllocs();
+}
+
+
+/**
+ * @brief allocator for std::allocate_shared and containers
+ *
+ * Used to place RawPacket's and Chunk's together with their shared_ptr
+ * reference-counts in a single pooled block, and for the per-connection
+ * packet queues.
+ */
+template<typename T> struct PacketPoolAllocator {
+	typedef T value_type;
+
+	PacketPoolAllocator() = default;
+	template<typename U> PacketPoolAllocator(const PacketPoolAllocator<U>&) {}
+
+	T* allocate(size_t n) { return (static_cast<T*>(PacketPool::Alloc(n * sizeof(T)))); }
+	void deallocate(T* p, size_t n) { PacketPool::Free(p, n * sizeof(T)); }
+
+	template<typename U> bool operator == (const PacketPoolAllocator<U>&) const { return true; }
+	template<typename U> bool operator != (const PacketPoolAllocator<U>&) const { return false; }
+};
+
+} // namespace netcode
+
+#endif // PACKET_POOL_H
+
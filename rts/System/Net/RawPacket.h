@@ -6,11 +6,13 @@
 #include <cassert>
 #include <cstdint>
 #include <cstring>
+#include <memory>
 #include <utility>
 
 #include <string>
 #include <vector>
 
+#include "PacketPool.h"
 #include "System/SafeVector.h"
 
 namespace netcode
@@ -39,7 +41,7 @@ public:
 		if (length == 0)
 			return;
 
-		data = new uint8_t[length];
+		data = static_cast<uint8_t*>(PacketPool::Alloc(length));
 	}
 
 	RawPacket(const uint32_t length, uint8_t msgID): RawPacket(length) {
@@ -116,7 +118,7 @@ public:
 		if (length == 0)
 			return;
 
-		delete[] data;
+		PacketPool::Free(data, length);
 		data = nullptr;
 
 		length = 0;
@@ -130,6 +132,17 @@ public:
 	uint32_t length = 0;
 };
 
+
+/**
+ * @brief create a shared packet
+ * The RawPacket and its reference-count share one pooled block (and its data
+ * comes from the pool as well), so unlike shared_ptr<RawPacket>(new RawPacket)
+ * this does not touch the heap once the pool is warm.
+ */
+template<typename... A> std::shared_ptr<RawPacket> AllocPacket(A&&... a) {
+	return (std::allocate_shared<RawPacket>(PacketPoolAllocator<RawPacket>(), std::forward<A>(a)...));
+}
+
 } // namespace netcode
 
 #endif // RAW_PACKET_H
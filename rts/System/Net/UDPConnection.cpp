@@ -3,6 +3,7 @@
 #include "UDPConnection.h"
 
 #include <cinttypes>
+#include <cstring>
 
 
 #include "Socket.h"
@@ -27,6 +28,9 @@ using namespace asio;
 static constexpr unsigned udpMaxPacketSize = 4096;
 static constexpr int maxChunkSize = 254;
 static constexpr int chunksPerSec = 30;
+// asio hands at most this many buffers per call to the OS (detail::max_iov_len)
+// and silently drops the rest, so larger sequences have to be flattened first
+static constexpr size_t maxGatherBuffers = 64;
 
 
 
@@ -96,8 +100,8 @@ public:
 		pos += sizeof(t);
 	}
 
-	void Unpack(std::vector<std::uint8_t>& t, unsigned unpackLength) {
-		std::copy(data + pos, data + pos + unpackLength, std::back_inserter(t));
+	void Unpack(std::uint8_t* t, unsigned unpackLength) {
+		std::memcpy(t, data + pos, unpackLength);
 		pos += unpackLength;
 	}
 
@@ -119,14 +123,14 @@ public:
 	}
 
 	template<typename T>
-	void Pack(T& t) {
+	void Pack(const T& t) {
 		const size_t pos = data.size();
 		data.resize(pos + sizeof(T));
-		*reinterpret_cast<T*>(&data[pos]) = t;
+		std::memcpy(&data[pos], &t, sizeof(T));
 	}
 
-	void Pack(std::vector<std::uint8_t>& _data) {
-		std::copy(_data.begin(), _data.end(), std::back_inserter(data));
+	void Pack(const std::uint8_t* _data, size_t size) {
+		data.insert(data.end(), _data, _data + size);
 	}
 
 private:
@@ -140,8 +144,8 @@ void Chunk::UpdateChecksum(CRC& crc) const {
 	crc << chunkNumber;
 	crc << (unsigned int)chunkSize;
 
-	if (!data.empty()) {
-		crc.Update(&data[0], data.size());
+	if (chunkSize > 0) {
+		crc.Update(&data[0], chunkSize);
 	}
 }
 
@@ -171,15 +175,15 @@ Packet::Packet(const unsigned char* data, unsigned length)
 	chunks.reserve(buf.Remaining() / Chunk::headerSize);
 
 	while (buf.Remaining() > Chunk::headerSize) {
-		ChunkPtr temp(new Chunk);
+		ChunkPtr temp = AllocChunk();
 		buf.Unpack(temp->chunkNumber);
 		buf.Unpack(temp->chunkSize);
 
 		// defective, ignore
-		if (buf.Remaining() < temp->chunkSize)
+		if (buf.Remaining() < temp->chunkSize || temp->chunkSize > Chunk::maxSize)
 			break;
 
-		buf.Unpack(temp->data, temp->chunkSize);
+		buf.Unpack(temp->data.data(), temp->chunkSize);
 		chunks.push_back(temp);
 	}
 }
@@ -210,21 +214,47 @@ std::uint8_t Packet::GetChecksum() const
 	return (std::uint8_t)crc.GetDigest();
 }
 
-void Packet::Serialize(std::vector<std::uint8_t>& data)
+void Packet::Serialize(std::vector<std::uint8_t>& data, std::vector<asio::const_buffer>& buffers) const
 {
+	const bool gather = ((1 + chunks.size() * 2) <= maxGatherBuffers);
+
 	data.clear();
 	data.reserve(GetSize());
+	buffers.clear();
 
 	Packer buf(data);
 	buf.Pack(lastContinuous);
 	buf.Pack(nakType);
 	buf.Pack(checksum);
-	buf.Pack(naks);
+	buf.Pack(naks.data(), naks.size());
+
+	if (!gather) {
+		for (const ChunkPtr& c: chunks) {
+			buf.Pack(c->chunkNumber);
+			buf.Pack(c->chunkSize);
+			buf.Pack(c->data.data(), c->chunkSize);
+		}
+
+		buffers.emplace_back(data.data(), data.size());
+		return;
+	}
+
+	// chunk headers go behind the packet header; data is never reallocated
+	// below (capacity was reserved above), so buffers can point into it
+	for (const ChunkPtr& c: chunks) {
+		buf.Pack(c->chunkNumber);
+		buf.Pack(c->chunkSize);
+	}
 
-	for (auto ci = chunks.begin(); ci != chunks.end(); ++ci) {
-		buf.Pack((*ci)->chunkNumber);
-		buf.Pack((*ci)->chunkSize);
-		buf.Pack((*ci)->data);
+	size_t headerPos = headerSize + naks.size();
+
+	buffers.emplace_back(data.data(), headerPos);
+
+	for (const ChunkPtr& c: chunks) {
+		buffers.emplace_back(data.data() + headerPos, Chunk::headerSize);
+		buffers.emplace_back(c->data.data(), c->chunkSize);
+
+		headerPos += Chunk::headerSize;
 	}
 }
 
@@ -277,6 +307,7 @@ void UDPConnection::Init()
 	#endif
 
 	lastInOrder = -1;
+	outgoingDataOffset = 0;
 	waitingPackets.clear();
 	waitingPackets.reserve(256);
 	incomingChunkNums.clear();
@@ -316,6 +347,8 @@ void UDPConnection::Init()
 
 	#ifndef UNIT_TEST
 	logMessages = configHandler->GetBool("UDPConnectionLogDebugMessages");
+	#else
+	logMessages = false;
 	#endif
 
 	netLossFactor = globalConfig.networkLossFactor;
@@ -330,12 +363,13 @@ void UDPConnection::ReconnectTo(CConnection& conn) {
 }
 
 void UDPConnection::CopyConnection(UDPConnection &conn) {
-	conn.InitConnection(addr, mySocket);
+	conn.InitConnection(addr, mySocket, sendBatch);
 }
 
-void UDPConnection::InitConnection(ip::udp::endpoint address, std::shared_ptr<ip::udp::socket> socket) {
+void UDPConnection::InitConnection(ip::udp::endpoint address, std::shared_ptr<ip::udp::socket> socket, std::shared_ptr<UDPSendBatch> batch) {
 	addr = address;
 	mySocket = socket;
+	sendBatch = batch;
 }
 
 UDPConnection::~UDPConnection()
@@ -344,6 +378,10 @@ UDPConnection::~UDPConnection()
 	waitingPackets.clear();
 
 	Flush(true);
+
+	// the listener might not be around to send our last packets
+	if (sendBatch != nullptr && !sendBatch->Empty())
+		sendBatch->Flush(*mySocket);
 }
 
 void UDPConnection::SendData(std::shared_ptr<const RawPacket> pkt)
@@ -600,7 +638,7 @@ void UDPConnection::ProcessRawPacket(Packet& incoming)
 			continue;
 		}
 
-		waitingPackets.emplace_back(c->chunkNumber, std::move(RawPacket(&c->data[0], c->data.size())));
+		waitingPackets.emplace_back(c->chunkNumber, std::move(RawPacket(&c->data[0], c->chunkSize)));
 		incomingChunkNums.insert(c->chunkNumber);
 	}
 
@@ -644,7 +682,7 @@ void UDPConnection::ProcessRawPacket(Packet& incoming)
 
 			// this returns false for zero/invalid pktLength
 			if (ProtocolDef::GetInstance()->IsValidLength(pktLength, msgLength)) {
-				msgQueue.emplace_back(new RawPacket(bufp, pktLength));
+				msgQueue.emplace_back(AllocPacket(bufp, pktLength));
 				std::shared_ptr<const RawPacket>& msgPacket = msgQueue.back();
 
 				#ifdef ENABLE_DEBUG_STATS
@@ -720,15 +758,18 @@ void UDPConnection::Flush(const bool forced)
 		// Manually fragment packets to respect configured UDP_MTU.
 		// This is an attempt to fix the bug where players drop out
 		// of the game if someone in the game gives a large order.
-		bool partialPacket = false;
+		// A packet split over several chunks stays at the front of
+		// the queue until all of it has been copied.
 		bool sendMore = true;
 
 		do {
+			const bool partialPacket = (outgoingDataOffset != 0);
+
 			sendMore  = (outgoing.GetAverage(true) <= globalConfig.linkOutgoingBandwidth);
 			sendMore |= ((globalConfig.linkOutgoingBandwidth <= 0) || partialPacket || forced);
 
 			if (!outgoingData.empty() && sendMore) {
-				std::shared_ptr<const RawPacket>& packet = *(outgoingData.begin());
+				const std::shared_ptr<const RawPacket>& packet = outgoingData.front();
 
 				if (!partialPacket && !ProtocolDef::GetInstance()->IsValidPacket(packet->data, packet->length)) {
 					LOG_L(L_ERROR,
@@ -737,22 +778,20 @@ void UDPConnection::Flush(const bool forced)
 					);
 					outgoingData.pop_front();
 				} else {
-					const unsigned numBytes = std::min((unsigned)maxChunkSize - pos, packet->length);
+					const unsigned numBytes = std::min((unsigned)maxChunkSize - pos, packet->length - outgoingDataOffset);
 
-					assert(packet->length > 0);
-					memcpy(buffer + pos, packet->data, numBytes);
+					assert(packet->length > outgoingDataOffset);
+					memcpy(buffer + pos, packet->data + outgoingDataOffset, numBytes);
 
 					pos += numBytes;
 					sentOverhead += Packet::headerSize;
 
 					outgoing.DataSent(numBytes, true);
 
-					if ((partialPacket = (numBytes != packet->length))) {
-						// partially transfered
-						packet.reset(new RawPacket(packet->data + numBytes, packet->length - numBytes));
-					} else {
-						// full packet copied
+					// full packet copied?
+					if ((outgoingDataOffset += numBytes) == packet->length) {
 						outgoingData.pop_front();
+						outgoingDataOffset = 0;
 					}
 				}
 			}
@@ -835,10 +874,10 @@ void UDPConnection::SetMTU(unsigned mtu2)
 void UDPConnection::CreateChunk(const unsigned char* data, const unsigned length, const int packetNum)
 {
 	assert((length > 0) && (length < 255));
-	ChunkPtr buf(new Chunk);
+	ChunkPtr buf = AllocChunk();
 	buf->chunkNumber = packetNum;
 	buf->chunkSize = length;
-	std::copy(data, data + length, std::back_inserter(buf->data));
+	std::memcpy(buf->data.data(), data, length);
 	newChunks.push_back(buf);
 	lastChunkCreatedTime = spring_gettime();
 }
@@ -1048,22 +1087,28 @@ void UDPConnection::SendIfNecessary(bool flushed)
 
 void UDPConnection::SendPacket(Packet& pkt)
 {
-	pkt.Serialize(sendBuffer);
+	pkt.Serialize(sendBuffer, sendBuffers);
+
+	const size_t packetSize = asio::buffer_size(sendBuffers);
 
-	outgoing.DataSent(sendBuffer.size());
+	outgoing.DataSent(packetSize);
 	lastPacketSendTime = spring_gettime();
 
 	ip::udp::socket::message_flags flags = 0;
 	asio::error_code err;
 
 	EMULATE_LATENCY( !EMULATE_PACKET_LOSS( LOSS_COUNTER ) ) {
-		mySocket->send_to(buffer(sendBuffer), addr, flags, err);
+		if (sendBatch != nullptr) {
+			sendBatch->Add(addr, sendBuffers);
+		} else {
+			mySocket->send_to(sendBuffers, addr, flags, err);
+		}
 	}
 
 	if (CheckErrorCode(err))
 		return;
 
-	dataSent += sendBuffer.size();
+	dataSent += packetSize;
 	sentPackets += 1;
 }
 
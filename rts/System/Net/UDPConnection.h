@@ -4,10 +4,14 @@
 #define _UDP_CONNECTION_H
 
 #include <asio/ip/udp.hpp>
+#include <array>
 #include <memory>
 #include <deque>
+#include <vector>
 
 #include "Connection.h"
+#include "PacketPool.h"
+#include "UDPSendBatch.h"
 #include "System/Misc/SpringTime.h"
 #include "System/UnorderedSet.hpp"
 
@@ -29,16 +33,23 @@ namespace netcode {
 class Chunk
 {
 public:
-	unsigned GetSize() const { return (data.size() + headerSize); }
+	unsigned GetSize() const { return (chunkSize + headerSize); }
 	void UpdateChecksum(CRC& crc) const;
 	static constexpr unsigned maxSize = 254;
 	static constexpr unsigned headerSize = 5;
 	std::int32_t chunkNumber;
 	std::uint8_t chunkSize;
-	std::vector<std::uint8_t> data;
+	/// first chunkSize bytes are valid
+	std::array<std::uint8_t, maxSize> data;
 };
 typedef std::shared_ptr<Chunk> ChunkPtr;
 
+/// chunks and their reference-counts are allocated together from the PacketPool
+inline ChunkPtr AllocChunk() { return (std::allocate_shared<Chunk>(PacketPoolAllocator<Chunk>())); }
+
+template<typename T> using PooledVector = std::vector<T, PacketPoolAllocator<T>>;
+template<typename T> using PooledDeque = std::deque<T, PacketPoolAllocator<T>>;
+
 
 class Packet
 {
@@ -54,7 +65,12 @@ public:
 
 	std::uint8_t GetChecksum() const;
 
-	void Serialize(std::vector<std::uint8_t>& data);
+	/**
+	 * Packs all headers into data and fills buffers with the sequence to send;
+	 * chunk payloads are referenced in place rather than copied unless there
+	 * are more chunks than the socket can gather in one call.
+	 */
+	void Serialize(std::vector<std::uint8_t>& data, std::vector<asio::const_buffer>& buffers) const;
 
 	std::int32_t lastContinuous;
 	/// if < 0, we lost -x packets since lastContinuous
@@ -62,8 +78,8 @@ public:
 	std::int8_t nakType;
 	std::uint8_t checksum;
 
-	std::vector<std::uint8_t> naks;
-	std::vector<ChunkPtr> chunks;
+	PooledVector<std::uint8_t> naks;
+	PooledVector<ChunkPtr> chunks;
 };
 
 
@@ -134,9 +150,16 @@ public:
 
 	const asio::ip::udp::endpoint& GetEndpoint() const { return addr; }
 
+	/// true if there are packets or chunks which Flush has not sent yet
+	bool HasUnsentData() const { return (!outgoingData.empty() || !newChunks.empty()); }
+
+	/// if set, outgoing packets are added to batch instead of being sent right away
+	void SetSendBatch(std::shared_ptr<UDPSendBatch> batch) { sendBatch = std::move(batch); }
+
 private:
 	void InitConnection(asio::ip::udp::endpoint address,
-			std::shared_ptr<asio::ip::udp::socket> socket);
+			std::shared_ptr<asio::ip::udp::socket> socket,
+			std::shared_ptr<UDPSendBatch> batch);
 
 	void CopyConnection(UDPConnection& conn);
 
@@ -184,25 +207,28 @@ private:
 	int reconnectTime;
 
 	/// outgoing stuff (pure data without header) waiting to be sent
-	std::deque< std::shared_ptr<const RawPacket> > outgoingData;
+	PooledDeque< std::shared_ptr<const RawPacket> > outgoingData;
+	/// number of bytes of the front of outgoingData that were already chunked
+	unsigned int outgoingDataOffset;
 	/// packets we have received but not yet read
 	std::vector< std::pair<int, RawPacket> > waitingPackets;
 	spring::unordered_set<int> incomingChunkNums;
 
 
 	/// Newly created and not yet sent
-	std::deque<ChunkPtr> newChunks;
+	PooledDeque<ChunkPtr> newChunks;
 	/// packets the other side did not ack'ed until now
-	std::deque<ChunkPtr> unackedChunks;
+	PooledDeque<ChunkPtr> unackedChunks;
 
 	/// Packets the other side missed
 	std::vector< std::pair<std::int32_t, ChunkPtr> > resendRequested;
 	spring::unordered_set<std::int32_t> erasedResendChunks;
 
 	/// complete packets we received but did not yet consume
-	std::deque< std::shared_ptr<const RawPacket> > msgQueue;
+	PooledDeque< std::shared_ptr<const RawPacket> > msgQueue;
 
 	std::vector<std::uint8_t> sendBuffer;
+	std::vector<asio::const_buffer> sendBuffers;
 	std::vector<std::uint8_t> recvBuffer;
 	std::vector<std::uint8_t> waitBuffer;
 
@@ -221,6 +247,8 @@ private:
 
 	/// Our socket
 	std::shared_ptr<asio::ip::udp::socket> mySocket;
+	/// shared with all other connections on mySocket, if any
+	std::shared_ptr<UDPSendBatch> sendBatch;
 
 	RawPacket fragmentBuffer;
 
@@ -9,12 +9,27 @@
 
 #include <memory>
 #include <asio.hpp>
+#include <array>
+#include <cerrno>
 #include <cinttypes>
+#include <cstring>
 #include <queue>
 
+#ifdef __linux__
+	#include <poll.h>
+	#include <sys/epoll.h>
+	#include <sys/socket.h>
+	#include <unistd.h>
+#elif defined(_WIN32)
+	#include <winsock2.h>
+#else
+	#include <poll.h>
+#endif
+
 
 #include "ProtocolDef.h"
 #include "UDPConnection.h"
+#include "UDPSendBatch.h"
 #include "Socket.h"
 #include "System/Log/ILog.h"
 #include "System/Platform/errorhandler.h"
@@ -25,6 +40,12 @@ namespace netcode
 {
 using namespace asio;
 
+#ifdef __linux__
+// datagrams read per recvmmsg call, and space for each (UDPConnection never sends more than 4K)
+static constexpr size_t RECV_BATCH_SIZE = 32;
+static constexpr size_t RECV_DATAGRAM_SIZE = 4096;
+#endif
+
 UDPListener::UDPListener(int port, const std::string& ip): acceptNewConnections(false)
 {
 	// resets socket on any exception
@@ -36,10 +57,29 @@ UDPListener::UDPListener(int port, const std::string& ip): acceptNewConnections(
 	socket->non_blocking(true);
 	SetAcceptingConnections(true);
 
+	#ifdef __linux__
+	if ((epollFD = epoll_create1(EPOLL_CLOEXEC)) != -1) {
+		epoll_event event = {};
+		event.events = EPOLLIN;
+
+		if (epoll_ctl(epollFD, EPOLL_CTL_ADD, socket->native_handle(), &event) == -1) {
+			close(epollFD);
+			epollFD = -1;
+		}
+	}
+
+	recvBuffer.resize(RECV_BATCH_SIZE * RECV_DATAGRAM_SIZE);
+	#endif
+
 	LOG("[%s] successfully bound socket on port %i", __func__, socket->local_endpoint().port());
 }
 
 UDPListener::~UDPListener() {
+	#ifdef __linux__
+	if (epollFD != -1)
+		close(epollFD);
+	#endif
+
 	for (const auto& p: dropMap) {
 		LOG("[%s] dropped %lu packets from unknown IP %s", __func__, (unsigned long) p.second, (p.first).c_str());
 	}
@@ -110,6 +150,73 @@ std::string UDPListener::TryBindSocket(int port, std::shared_ptr<asio::ip::udp::
 void UDPListener::Update() {
 	netservice.poll();
 
+	ReceiveDatagrams();
+
+	for (auto i = connMap.cbegin(); i != connMap.cend(); ) {
+		if (i->second.expired()) {
+			LOG_L(L_DEBUG, "[UDPListener::%s] connection closed: [%s]:%i", __func__, i->first.address().to_string().c_str(), i->first.port());
+			i = connMap.erase(i);
+			continue;
+		}
+
+		i->second.lock()->Update();
+		++i;
+	}
+
+	FlushSendBatch();
+}
+
+void UDPListener::ReceiveDatagrams() {
+	#ifdef __linux__
+	std::array<mmsghdr, RECV_BATCH_SIZE> msgs;
+	std::array<iovec, RECV_BATCH_SIZE> iovs;
+	std::array<sockaddr_storage, RECV_BATCH_SIZE> addrs;
+
+	while (true) {
+		for (size_t i = 0; i < RECV_BATCH_SIZE; i++) {
+			iovs[i].iov_base = &recvBuffer[i * RECV_DATAGRAM_SIZE];
+			iovs[i].iov_len = RECV_DATAGRAM_SIZE;
+
+			std::memset(&msgs[i], 0, sizeof(msgs[i]));
+			msgs[i].msg_hdr.msg_name = &addrs[i];
+			msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+			msgs[i].msg_hdr.msg_iov = &iovs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		const int numRecv = recvmmsg(socket->native_handle(), msgs.data(), RECV_BATCH_SIZE, MSG_DONTWAIT, nullptr);
+
+		if (numRecv <= 0) {
+			if (numRecv < 0 && errno == EINTR)
+				continue;
+			if (numRecv < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+				LOG_L(L_ERROR, "[UDPListener::%s] recvmmsg failed (%s)", __func__, strerror(errno));
+
+			break;
+		}
+
+		for (int i = 0; i < numRecv; i++) {
+			// larger than anything a UDPConnection would send
+			if ((msgs[i].msg_hdr.msg_flags & MSG_TRUNC) != 0)
+				continue;
+
+			ip::udp::endpoint udpEndPoint;
+
+			if (msgs[i].msg_hdr.msg_namelen > udpEndPoint.capacity())
+				continue;
+
+			std::memcpy(udpEndPoint.data(), &addrs[i], msgs[i].msg_hdr.msg_namelen);
+			udpEndPoint.resize(msgs[i].msg_hdr.msg_namelen);
+
+			ProcessDatagram(&recvBuffer[i * RECV_DATAGRAM_SIZE], msgs[i].msg_len, udpEndPoint);
+		}
+
+		if (static_cast<size_t>(numRecv) < RECV_BATCH_SIZE)
+			break;
+	}
+
+	#else
+
 	size_t bytesAvailable = 0;
 
 	while ((bytesAvailable = socket->available()) > 0) {
@@ -122,73 +229,128 @@ void UDPListener::Update() {
 
 		const size_t bytesReceived = socket->receive_from(asio::buffer(recvBuffer), udpEndPoint, msgFlags, err);
 
-		const auto ci = connMap.find(udpEndPoint);
-
-		// known connection but expired
-		if (ci != connMap.end() && ci->second.expired())
-			continue;
-
 		if (CheckErrorCode(err))
 			break;
 
-		if (bytesReceived < Packet::headerSize)
-			continue;
+		ProcessDatagram(&recvBuffer[0], bytesReceived, udpEndPoint);
+	}
+	#endif
+}
 
-		Packet data(&recvBuffer[0], bytesReceived);
+void UDPListener::ProcessDatagram(const std::uint8_t* buffer, size_t bytesReceived, const ip::udp::endpoint& udpEndPoint) {
+	const auto ci = connMap.find(udpEndPoint);
 
-		if (ci != connMap.end()) {
-			ci->second.lock()->ProcessRawPacket(data);
-			continue;
-		}
+	// known connection but expired
+	if (ci != connMap.end() && ci->second.expired())
+		return;
 
+	if (bytesReceived < Packet::headerSize)
+		return;
 
-		// unknown connection but still have the packet, maybe a new client wants to connect from sender's address
-		if (acceptNewConnections && data.lastContinuous == -1 && data.nakType == 0)	{
-			if (!data.chunks.empty() && (*data.chunks.begin())->chunkNumber == 0) {
-				std::shared_ptr<UDPConnection> incoming(new UDPConnection(socket, udpEndPoint));
-				waiting.push(incoming);
-				connMap[udpEndPoint] = incoming;
-				incoming->ProcessRawPacket(data);
-			}
+	Packet data(buffer, bytesReceived);
 
-			continue;
+	if (ci != connMap.end()) {
+		ci->second.lock()->ProcessRawPacket(data);
+		return;
+	}
+
+
+	// unknown connection but still have the packet, maybe a new client wants to connect from sender's address
+	if (acceptNewConnections && data.lastContinuous == -1 && data.nakType == 0)	{
+		if (!data.chunks.empty() && (*data.chunks.begin())->chunkNumber == 0) {
+			std::shared_ptr<UDPConnection> incoming(new UDPConnection(socket, udpEndPoint));
+			incoming->SetSendBatch(sendBatch);
+			waiting.push(incoming);
+			connMap[udpEndPoint] = incoming;
+			incoming->ProcessRawPacket(data);
 		}
 
+		return;
+	}
 
-		const asio::ip::address& senderAddr = udpEndPoint.address();
-		const std::string& senderIP = senderAddr.to_string();
 
-		if (dropMap.find(senderIP) == dropMap.end()) {
-			LOG_L(L_DEBUG, "[UDPListener::%s] dropping packet from unknown IP: [%s]:%i", __func__, senderIP.c_str(), udpEndPoint.port());
-			dropMap[senderIP] = 0;
-		} else {
-			dropMap[senderIP] += 1;
-		}
+	const asio::ip::address& senderAddr = udpEndPoint.address();
+	const std::string& senderIP = senderAddr.to_string();
 
-	#ifdef DEBUG
-		std::string conns;
-		for (auto it = connMap.cbegin(); it != connMap.cend(); ++it) {
-			conns += spring::format(" [%s]:%i;", it->first.address().to_string().c_str(),it->first.port());
-		}
-		LOG_L(L_DEBUG, "[UDPListener::%s] open connections: %s", __func__, conns.c_str());
-	#endif
+	if (dropMap.find(senderIP) == dropMap.end()) {
+		LOG_L(L_DEBUG, "[UDPListener::%s] dropping packet from unknown IP: [%s]:%i", __func__, senderIP.c_str(), udpEndPoint.port());
+		dropMap[senderIP] = 0;
+	} else {
+		dropMap[senderIP] += 1;
 	}
 
-	for (auto i = connMap.cbegin(); i != connMap.cend(); ) {
-		if (i->second.expired()) {
-			LOG_L(L_DEBUG, "[UDPListener::%s] connection closed: [%s]:%i", __func__, i->first.address().to_string().c_str(), i->first.port());
-			i = connMap.erase(i);
+#ifdef DEBUG
+	std::string conns;
+	for (auto it = connMap.cbegin(); it != connMap.cend(); ++it) {
+		conns += spring::format(" [%s]:%i;", it->first.address().to_string().c_str(),it->first.port());
+	}
+	LOG_L(L_DEBUG, "[UDPListener::%s] open connections: %s", __func__, conns.c_str());
+#endif
+}
+
+
+bool UDPListener::WaitForData(int timeout) {
+	#if defined(__linux__)
+	if (epollFD != -1) {
+		epoll_event event;
+		return (epoll_wait(epollFD, &event, 1, timeout) > 0);
+	}
+
+	// no epoll instance; fall back to the generic (timed) wait
+	pollfd pfd = {socket->native_handle(), POLLIN, 0};
+	return (poll(&pfd, 1, timeout) > 0);
+	#elif defined(_WIN32)
+	WSAPOLLFD pfd = {socket->native_handle(), POLLRDNORM, 0};
+	return (WSAPoll(&pfd, 1, timeout) > 0);
+	#else
+	pollfd pfd = {socket->native_handle(), POLLIN, 0};
+	return (poll(&pfd, 1, timeout) > 0);
+	#endif
+}
+
+
+void UDPListener::SetBatchedSends(bool enable) {
+	if (enable == (sendBatch != nullptr))
+		return;
+
+	FlushSendBatch();
+
+	if (enable)
+		sendBatch = std::make_shared<UDPSendBatch>();
+	else
+		sendBatch.reset();
+
+	for (const auto& p: connMap) {
+		if (p.second.expired())
 			continue;
-		}
-		i->second.lock()->Update();
-		++i;
+
+		p.second.lock()->SetSendBatch(sendBatch);
 	}
 }
 
+bool UDPListener::HasUnsentData() const {
+	for (const auto& p: connMap) {
+		const std::shared_ptr<UDPConnection> conn = p.second.lock();
+
+		if (conn != nullptr && conn->HasUnsentData())
+			return true;
+	}
+
+	return false;
+}
+
+void UDPListener::FlushSendBatch() {
+	if (sendBatch == nullptr || sendBatch->Empty())
+		return;
+
+	sendBatch->Flush(*socket);
+}
+
 
 std::shared_ptr<UDPConnection> UDPListener::SpawnConnection(const std::string& ip, const unsigned port)
 {
 	std::shared_ptr<UDPConnection> newConn(new UDPConnection(socket, ip::udp::endpoint(WrapIP(ip), port)));
+	newConn->SetSendBatch(sendBatch);
 	connMap[newConn->GetEndpoint()] = newConn;
 	return newConn;
 }
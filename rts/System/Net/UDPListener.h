@@ -13,6 +13,7 @@
 namespace netcode
 {
 class UDPConnection;
+class UDPSendBatch;
 
 /**
  * @brief Class for handling Connections on an UDPSocket
@@ -55,6 +56,24 @@ public:
 	 */
 	void Update();
 
+	/**
+	 * @brief block until the socket has data to read
+	 * @param timeout milliseconds to wait at most
+	 * @return false if the timeout expired first
+	 */
+	bool WaitForData(int timeout);
+
+	/**
+	 * If enabled, packets of all connections on our socket are
+	 * collected and only sent (in as few syscalls as possible)
+	 * at the end of Update or by FlushSendBatch.
+	 */
+	void SetBatchedSends(bool enable);
+	void FlushSendBatch();
+
+	/// true if any connection has data waiting for its next send
+	bool HasUnsentData() const;
+
 	/**
 	 * Set if we are accepting new connections
 	 * or drop all data from unconnected addresses.
@@ -75,6 +94,10 @@ public:
 	void RejectConnection() { waiting.pop(); }
 	void UpdateConnections(); // Updates connections when the endpoint has been reconnected
 
+private:
+	void ReceiveDatagrams();
+	void ProcessDatagram(const std::uint8_t* data, size_t size, const asio::ip::udp::endpoint& udpEndPoint);
+
 private:
 	/**
 	 * @brief Do we accept packets from unknown sources?
@@ -87,6 +110,13 @@ private:
 
 	std::vector<std::uint8_t> recvBuffer;
 
+	/// non-null iff sends are batched
+	std::shared_ptr<UDPSendBatch> sendBatch;
+
+	#ifdef __linux__
+	int epollFD = -1;
+	#endif
+
 	/// all connections
 	std::map< asio::ip::udp::endpoint, std::weak_ptr<UDPConnection> > connMap;
 	std::map< std::string, size_t> dropMap;
@@ -0,0 +1,98 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "UDPSendBatch.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+
+#include <asio.hpp>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
+
+#include "System/Log/ILog.h"
+
+namespace netcode
+{
+
+// datagrams per sendmmsg call
+static constexpr size_t MAX_BATCH_MSGS = 64;
+
+
+void UDPSendBatch::Add(const asio::ip::udp::endpoint& endpoint, const std::vector<asio::const_buffer>& buffers)
+{
+	const size_t offset = data.size();
+	const size_t size = asio::buffer_size(buffers);
+
+	data.resize(offset + size);
+	asio::buffer_copy(asio::buffer(&data[offset], size), buffers);
+
+	datagrams.push_back({endpoint, offset, size});
+}
+
+
+size_t UDPSendBatch::Flush(asio::ip::udp::socket& socket)
+{
+	size_t numSyscalls = 0;
+
+	#ifdef __linux__
+	std::array<mmsghdr, MAX_BATCH_MSGS> msgs;
+	std::array<iovec, MAX_BATCH_MSGS> iovs;
+
+	for (size_t i = 0; i < datagrams.size(); ) {
+		const size_t numMsgs = std::min(datagrams.size() - i, MAX_BATCH_MSGS);
+
+		for (size_t j = 0; j < numMsgs; j++) {
+			Datagram& dg = datagrams[i + j];
+			mmsghdr& msg = msgs[j];
+
+			iovs[j].iov_base = &data[dg.offset];
+			iovs[j].iov_len = dg.size;
+
+			std::memset(&msg, 0, sizeof(msg));
+			msg.msg_hdr.msg_name = dg.endpoint.data();
+			msg.msg_hdr.msg_namelen = dg.endpoint.size();
+			msg.msg_hdr.msg_iov = &iovs[j];
+			msg.msg_hdr.msg_iovlen = 1;
+		}
+
+		const int numSent = sendmmsg(socket.native_handle(), msgs.data(), numMsgs, 0);
+
+		numSyscalls += 1;
+
+		if (numSent > 0) {
+			i += numSent;
+			continue;
+		}
+		if (numSent < 0 && errno == EINTR)
+			continue;
+
+		// the first datagram of this call was refused, skip it and go on with the rest
+		LOG_L(L_DEBUG, "[UDPSendBatch::%s] dropped datagram (%s)", __func__, strerror(errno));
+		i += 1;
+	}
+
+	#else
+
+	for (const Datagram& dg: datagrams) {
+		asio::error_code err;
+		socket.send_to(asio::buffer(&data[dg.offset], dg.size), dg.endpoint, 0, err);
+
+		numSyscalls += 1;
+
+		if (err)
+			LOG_L(L_DEBUG, "[UDPSendBatch::%s] dropped datagram (%s)", __func__, err.message().c_str());
+	}
+	#endif
+
+	datagrams.clear();
+	data.clear();
+	return numSyscalls;
+}
+
+} // namespace netcode
+
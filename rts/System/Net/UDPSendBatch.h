@@ -0,0 +1,53 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef UDP_SEND_BATCH_H
+#define UDP_SEND_BATCH_H
+
+#include <asio/ip/udp.hpp>
+#include <cinttypes>
+#include <vector>
+
+namespace netcode
+{
+
+/**
+ * @brief outgoing datagrams of all connections sharing one socket
+ *
+ * UDPListener gives this to its connections so that a whole tick
+ * worth of packets can be handed to the OS at once (by sendmmsg on
+ * Linux, one send_to per datagram elsewhere) instead of each packet
+ * causing its own syscall when it is created.
+ */
+class UDPSendBatch
+{
+public:
+	/// copies the datagram made up of buffers
+	void Add(const asio::ip::udp::endpoint& endpoint, const std::vector<asio::const_buffer>& buffers);
+
+	/**
+	 * @brief send and remove all datagrams added since the last call
+	 * Datagrams the OS does not accept are dropped; the connections
+	 * resend their contents like those of any other lost packet.
+	 * @return number of syscalls made
+	 */
+	size_t Flush(asio::ip::udp::socket& socket);
+
+	bool Empty() const { return datagrams.empty(); }
+	size_t GetNumDatagrams() const { return datagrams.size(); }
+
+private:
+	struct Datagram {
+		asio::ip::udp::endpoint endpoint;
+
+		size_t offset;
+		size_t size;
+	};
+
+	std::vector<Datagram> datagrams;
+	std::vector<std::uint8_t> data;
+};
+
+} // namespace netcode
+
+#endif // UDP_SEND_BATCH_H
+
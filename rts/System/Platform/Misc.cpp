@@ -42,6 +42,7 @@
 #if !defined(_WIN32)
 #include <dlfcn.h> // for dladdr(), dlopen()
 #include <pwd.h> // for getpw*()
+#include <sys/resource.h> // for getrusage()
 #include <sys/statvfs.h>
 #include <sys/types.h>
 #include <sys/utsname.h> // for uname()
@@ -518,6 +519,37 @@ namespace Platform
 	}
 
 
+	uint64_t GetProcessCPUTime() {
+		#ifdef _WIN32
+		FILETIME creationTime;
+		FILETIME exitTime;
+		FILETIME kernelTime;
+		FILETIME userTime;
+
+		if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime))
+			return 0;
+
+		// both in units of 100ns
+		const uint64_t kernelTicks = (uint64_t(kernelTime.dwHighDateTime) << 32) | kernelTime.dwLowDateTime;
+		const uint64_t userTicks = (uint64_t(userTime.dwHighDateTime) << 32) | userTime.dwLowDateTime;
+
+		return ((kernelTicks + userTicks) / 10);
+
+		#else
+
+		struct rusage usage;
+
+		if (getrusage(RUSAGE_SELF, &usage) != 0)
+			return 0;
+
+		const uint64_t userUsecs = uint64_t(usage.ru_utime.tv_sec) * 1000000 + usage.ru_utime.tv_usec;
+		const uint64_t sysUsecs = uint64_t(usage.ru_stime.tv_sec) * 1000000 + usage.ru_stime.tv_usec;
+
+		return (userUsecs + sysUsecs);
+		#endif
+	}
+
+
 	uint32_t NativeWordSize() { return (sizeof(void*)); }
 	uint32_t SystemWordSize() { return ((Is32BitEmulation())? 8: NativeWordSize()); }
 
@@ -93,6 +93,7 @@ namespace Platform
 	bool IsRunningInGDB();
 
 	uint64_t FreeDiskSpace(const std::string& path);
+	uint64_t GetProcessCPUTime(); // user + system, in microseconds
 	uint32_t NativeWordSize(); // compiled process code
 	uint32_t SystemWordSize(); // host operating system
 
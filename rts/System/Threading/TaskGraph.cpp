@@ -0,0 +1,243 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "TaskGraph.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+#include "System/Log/ILog.h"
+#include "System/Threading/ThreadPool.h"
+
+
+int CTaskGraph::AddTask(const char* name, TaskFunc func, const std::vector<int>& deps, bool async)
+{
+	const int id = tasks.size();
+
+	tasks.emplace_back();
+
+	Task& task = tasks.back();
+	task.name = name;
+	task.func = std::move(func);
+	task.deps = deps;
+	task.async = async;
+
+	for (const int dep: deps) {
+		assert(dep >= 0 && dep < id);
+		tasks[dep].dependents.push_back(id);
+	}
+
+	return id;
+}
+
+
+void CTaskGraph::Run(const TaskFunc& waitFunc)
+{
+	std::vector<int> ready;
+
+	{
+		std::lock_guard<spring::mutex> lock(mutex);
+
+		for (size_t i = 0; i < tasks.size(); i++) {
+			Task& task = tasks[i];
+
+			task.numPendingDeps = task.deps.size();
+			task.state = TASK_PENDING;
+			task.skipped = false;
+			task.failed = false;
+			task.error = nullptr;
+
+			if (!task.async || task.numPendingDeps > 0)
+				continue;
+
+			task.state = TASK_QUEUED;
+			ready.push_back(i);
+		}
+
+		runThreadID = spring::this_thread::get_id();
+		startTime = spring_gettime();
+	}
+
+	Dispatch(ready);
+
+	// ordered tasks; each one's predecessors in this loop are done by construction
+	for (size_t i = 0; i < tasks.size(); i++) {
+		if (tasks[i].async)
+			continue;
+
+		for (const int dep: tasks[i].deps) {
+			WaitFor(dep, waitFunc);
+		}
+
+		Execute(i);
+	}
+
+	// asynchronous tasks nothing ordered depended on
+	for (size_t i = 0; i < tasks.size(); i++) {
+		if (!tasks[i].async)
+			continue;
+
+		WaitFor(i, waitFunc);
+	}
+
+	{
+		std::unique_lock<spring::mutex> lock(mutex);
+
+		// jobs for tasks this thread claimed first still hold a pointer to us
+		while (numDispatched > 0)
+			cond.wait(lock);
+
+		endTime = spring_gettime();
+	}
+
+	for (const Task& task: tasks) {
+		if (task.error == nullptr)
+			continue;
+
+		std::rethrow_exception(task.error);
+	}
+}
+
+
+void CTaskGraph::Dispatch(const std::vector<int>& ready)
+{
+	for (const int id: ready) {
+		{
+			std::lock_guard<spring::mutex> lock(mutex);
+			numDispatched += 1;
+		}
+
+		// without worker threads this executes the task right away
+		ThreadPool::Enqueue([this, id]() {
+			Execute(id);
+
+			std::lock_guard<spring::mutex> lock(mutex);
+			numDispatched -= 1;
+			cond.notify_all();
+		});
+	}
+}
+
+
+void CTaskGraph::Execute(int id)
+{
+	Task& task = tasks[id];
+
+	{
+		std::lock_guard<spring::mutex> lock(mutex);
+
+		// asynchronous tasks can be claimed by a worker and the waiting caller
+		if (task.state != (task.async? TASK_QUEUED: TASK_PENDING))
+			return;
+
+		assert(task.numPendingDeps == 0);
+
+		task.state = TASK_RUNNING;
+		task.calledRun = (spring::this_thread::get_id() == runThreadID);
+		task.skipped = std::any_of(task.deps.begin(), task.deps.end(), [&](int dep) { return (tasks[dep].failed || tasks[dep].skipped); });
+		task.startTime = spring_gettime();
+	}
+
+	if (!task.skipped) {
+		try {
+			task.func();
+		} catch (...) {
+			task.error = std::current_exception();
+			task.failed = true;
+		}
+	}
+
+	std::vector<int> ready;
+
+	{
+		std::lock_guard<spring::mutex> lock(mutex);
+
+		task.endTime = spring_gettime();
+		task.state = TASK_DONE;
+
+		for (const int dependentID: task.dependents) {
+			Task& dependent = tasks[dependentID];
+
+			if ((dependent.numPendingDeps -= 1) > 0)
+				continue;
+			if (!dependent.async)
+				continue;
+
+			dependent.state = TASK_QUEUED;
+			ready.push_back(dependentID);
+		}
+
+		cond.notify_all();
+	}
+
+	Dispatch(ready);
+}
+
+
+void CTaskGraph::WaitFor(int id, const TaskFunc& waitFunc)
+{
+	std::unique_lock<spring::mutex> lock(mutex);
+
+	while (tasks[id].state != TASK_DONE) {
+		const int queuedID = FindQueuedTask();
+
+		// rather run something the workers have not gotten to yet than idle
+		if (queuedID != -1) {
+			lock.unlock();
+			Execute(queuedID);
+			lock.lock();
+			continue;
+		}
+
+		if (cond.wait_for(lock, std::chrono::milliseconds(100)) == std::cv_status::no_timeout)
+			continue;
+		if (waitFunc == nullptr)
+			continue;
+
+		lock.unlock();
+		waitFunc();
+		lock.lock();
+	}
+}
+
+
+int CTaskGraph::FindQueuedTask() const
+{
+	for (size_t i = 0; i < tasks.size(); i++) {
+		if (tasks[i].state == TASK_QUEUED)
+			return i;
+	}
+
+	return -1;
+}
+
+
+void CTaskGraph::LogReport(const char* caller) const
+{
+	std::vector<int> order(tasks.size());
+	float workTime = 0.0f;
+
+	for (size_t i = 0; i < tasks.size(); i++) {
+		order[i] = i;
+		workTime += GetTaskTime(i);
+	}
+
+	std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return (tasks[a].startTime < tasks[b].startTime); });
+
+	LOG("[%s] %u tasks finished in %.1fms (%.1fms of work)", caller, unsigned(tasks.size()), GetTotalTime(), workTime);
+
+	for (const int id: order) {
+		const Task& task = tasks[id];
+		const char* status = task.failed? " (failed)": (task.skipped? " (skipped)": "");
+
+		LOG(
+			"[%s]   %-24s %8.1fms at %+8.1fms on %s%s",
+			caller,
+			task.name.c_str(),
+			GetTaskTime(id),
+			(task.startTime - startTime).toMilliSecsf(),
+			task.calledRun? "caller": "worker",
+			status
+		);
+	}
+}
@@ -0,0 +1,110 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef _TASK_GRAPH_H
+#define _TASK_GRAPH_H
+
+#include <deque>
+#include <exception>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "System/Misc/SpringTime.h"
+#include "System/Threading/SpringThreading.h"
+
+/**
+ * @brief runs a set of coarse tasks with explicit dependencies
+ *
+ * Tasks are either bound to the thread calling Run, where they execute one
+ * after another in the order they were added (this is the ordering barrier
+ * for anything touching synced state or the GL context), or asynchronous:
+ * those are handed to the ThreadPool as soon as all of their dependencies
+ * are done. While the calling thread waits for a dependency it executes any
+ * queued asynchronous task itself instead of idling.
+ *
+ * A task that throws does not stop the graph, but every task depending on
+ * it (directly or not) is skipped; Run rethrows the first such exception
+ * once all tasks are finished.
+ */
+class CTaskGraph
+{
+public:
+	typedef std::function<void()> TaskFunc;
+
+	/**
+	 * @param deps ids of tasks which have to finish first, all of them
+	 *   must have been added before (graphs are acyclic by construction)
+	 * @param async if false the task runs on the thread calling Run
+	 * @return id of the new task
+	 */
+	int AddTask(const char* name, TaskFunc func, const std::vector<int>& deps = {}, bool async = false);
+	int AddAsyncTask(const char* name, TaskFunc func, const std::vector<int>& deps = {}) { return (AddTask(name, std::move(func), deps, true)); }
+
+	/**
+	 * @param waitFunc called about every 100ms while the calling thread
+	 *   is blocked on a task running elsewhere (e.g. to feed a watchdog)
+	 */
+	void Run(const TaskFunc& waitFunc = nullptr);
+
+	/// logs when and where each task ran and for how long, in start order
+	void LogReport(const char* caller) const;
+
+	float GetTaskTime(int id) const { return ((tasks[id].endTime - tasks[id].startTime).toMilliSecsf()); }
+	float GetTotalTime() const { return ((endTime - startTime).toMilliSecsf()); }
+
+	bool HasRun(int id) const { return (tasks[id].state == TASK_DONE && !tasks[id].skipped && !tasks[id].failed); }
+	size_t GetNumTasks() const { return (tasks.size()); }
+
+private:
+	enum TaskState {
+		TASK_PENDING, // waiting for dependencies
+		TASK_QUEUED,  // asynchronous and ready, not yet claimed by a thread
+		TASK_RUNNING,
+		TASK_DONE,
+	};
+
+	struct Task {
+		std::string name;
+		TaskFunc func;
+
+		std::vector<int> deps;
+		std::vector<int> dependents;
+
+		bool async = false;
+		bool skipped = false; // because a dependency failed or was skipped
+		bool failed = false;
+		bool calledRun = false; // executed by the thread calling Run
+
+		int numPendingDeps = 0;
+		TaskState state = TASK_PENDING;
+
+		std::exception_ptr error;
+
+		spring_time startTime;
+		spring_time endTime;
+	};
+
+private:
+	void Dispatch(const std::vector<int>& ready);
+	void Execute(int id);
+	void WaitFor(int id, const TaskFunc& waitFunc);
+
+	/// @return id of an asynchronous task nobody has started yet, or -1 (mutex must be held)
+	int FindQueuedTask() const;
+
+private:
+	std::deque<Task> tasks;
+
+	spring::mutex mutex;
+	spring::condition_variable cond;
+
+	// ThreadPool jobs not yet returned; Run may not exit before they have
+	int numDispatched = 0;
+
+	spring::thread::id runThreadID;
+
+	spring_time startTime;
+	spring_time endTime;
+};
+
+#endif
@@ -0,0 +1,54 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+// everything LuaParser links against but which is not needed to run a
+// text chunk and read back the table it returned
+
+#include "Lua/LuaConstEngine.h"
+#include "Lua/LuaConstGame.h"
+#include "Lua/LuaFBOs.h"
+#include "Lua/LuaIO.h"
+#include "Lua/LuaRBOs.h"
+#include "Lua/LuaShaders.h"
+#include "Lua/LuaTextures.h"
+#include "Lua/LuaUtils.h"
+#include "Lua/LuaVFS.h"
+#include "Sim/Misc/GlobalSynced.h"
+#include "System/TimeProfiler.h"
+#include "System/FileSystem/FileHandler.h"
+
+CGlobalSyncedRNG gsRNG;
+
+bool LuaConstEngine::PushEntries(lua_State* L) { return true; }
+bool LuaConstGame::PushEntries(lua_State* L) { return true; }
+bool LuaVFS::PushCommon(lua_State* L) { return true; }
+bool LuaIO::IsSimplePath(const std::string& path) { return false; }
+
+// tests have to call LuaParser::SetLowerKeys(false)
+bool LuaUtils::LowerKeys(lua_State* L, int tableIndex) { return false; }
+bool LuaUtils::CheckTableForNaNs(lua_State* L, int table, const std::string& name) { return false; }
+bool LuaUtils::PushLogEntries(lua_State* L) { return true; }
+void LuaUtils::PushCurrentFuncEnv(lua_State* L, const char* caller) {}
+void LuaUtils::PushStringVector(lua_State* L, const std::vector<std::string>& vec) {}
+int LuaUtils::IsEngineMinVersion(lua_State* L) { return 0; }
+int LuaUtils::Echo(lua_State* L) { return 0; }
+int LuaUtils::Log(lua_State* L) { return 0; }
+
+LuaShaders::LuaShaders() {}
+LuaShaders::~LuaShaders() {}
+LuaFBOs::~LuaFBOs() {}
+LuaRBOs::~LuaRBOs() {}
+void LuaTextures::FreeAll() {}
+
+ScopedOnceTimer::ScopedOnceTimer(const char* name, const char* frmt): startTime() {}
+ScopedOnceTimer::~ScopedOnceTimer() {}
+
+CFileHandler::CFileHandler(const std::string& fileName, const std::string& modes) {}
+void CFileHandler::Close() {}
+bool CFileHandler::LoadStringData(std::string& data) { return false; }
+bool CFileHandler::TryReadFromPWD(const std::string& fileName) { return false; }
+bool CFileHandler::TryReadFromRawFS(const std::string& fileName) { return false; }
+bool CFileHandler::TryReadFromVFS(const std::string& fileName, int section) { return false; }
+bool CFileHandler::FileExists(const std::string& filePath, const std::string& modes) { return false; }
+std::string CFileHandler::AllowModes(const std::string& modes, const std::string& allowed) { return ""; }
+std::vector<std::string> CFileHandler::DirList(const std::string& path, const std::string& pattern, const std::string& modes) { return {}; }
+std::vector<std::string> CFileHandler::SubDirs(const std::string& path, const std::string& pattern, const std::string& modes) { return {}; }
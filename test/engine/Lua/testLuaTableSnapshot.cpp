@@ -0,0 +1,316 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Lua/LuaParser.h"
+#include "System/float3.h"
+#include "System/float4.h"
+#include "System/Misc/SpringTime.h"
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+
+// covers every kind of value and key LuaTable converts between
+static const std::string TEST_CHUNK = R"(
+	local shared = {x = 1, Y = 2}
+	local cycle = {}
+	cycle.self = cycle
+
+	return {
+		Name = "Commander",
+		name = "lowered",
+		MixedCase = {Inner = 1, inner = 2},
+
+		number = 12.75,
+		negative = -3.5,
+		int = 7,
+		huge = 1e30,
+
+		numstr = "42",
+		floatstr = " 3.5 ",
+		hexstr = "0x10",
+		badnumstr = "12abc",
+		emptystr = "",
+
+		yes = true,
+		no = false,
+
+		vec3 = {1, 2.5, -3},
+		vec4 = {1, 2, 3, 4},
+		shortvec = {1, 2},
+		strvec = {"1", "2.5", "x"},
+		holes = {"a", "b", "c", [5] = "e", [7] = true},
+
+		[1] = "one",
+		[2] = 2,
+		[3] = {1, 2, 3},
+		[-1] = "minus",
+		[0] = "zero",
+		[1.5] = "frac",
+		[2.5] = 25,
+		[10] = "ten",
+		["10"] = "ten-string",
+		["07"] = "leading-zero",
+		["-4"] = "negative-string",
+		[true] = "boolean-key",
+
+		["dotted.key"] = "literal",
+		nested = {deeper = {deepest = {value = "bottom", [4] = "four"}}, ["3"] = "three"},
+
+		shared = shared,
+		alias = shared,
+		cycle = cycle,
+
+		func = function() end,
+	}
+)";
+
+static const std::vector<std::string> STRING_PROBES = {
+	"", "missing",
+	"name", "Name", "NAME",
+	"mixedcase", "MixedCase", "inner", "Inner",
+	"number", "negative", "int", "huge",
+	"numstr", "floatstr", "hexstr", "badnumstr", "emptystr",
+	"yes", "no",
+	"vec3", "vec4", "shortvec", "strvec", "holes",
+	"1", "2", "3", "-1", "0", "10", "07", "-4", "1.5", "x", "Y", "y",
+	"dotted.key", "dotted", "nested.deeper", "nested.deeper.deepest", "nested.deeper.deepest.value",
+	"nested.3", "nested.deeper.deepest.4", "nested.missing.value", "vec3.1", "shared.x",
+	"shared", "alias", "cycle", "cycle.self", "func",
+};
+
+static const std::vector<int> INT_PROBES = {-4, -1, 0, 1, 2, 3, 4, 5, 6, 7, 10, 100};
+
+
+template<typename K, typename V, typename M>
+static std::map<K, V> ToMap(const M& map)
+{
+	return std::map<K, V>(map.begin(), map.end());
+}
+
+template<typename Key>
+static void CompareValue(const LuaTable& live, const LuaTable& snap, const Key& key)
+{
+	INFO("key " << key);
+
+	CHECK(snap.KeyExists(key) == live.KeyExists(key));
+	CHECK(snap.GetType(key) == live.GetType(key));
+	CHECK(snap.GetLength(key) == live.GetLength(key));
+	CHECK(snap.SubTable(key).IsValid() == live.SubTable(key).IsValid());
+
+	CHECK(snap.Get(key, -123) == live.Get(key, -123));
+	CHECK(snap.Get(key, true) == live.Get(key, true));
+	CHECK(snap.Get(key, false) == live.Get(key, false));
+	CHECK(snap.Get(key, -1.25f) == live.Get(key, -1.25f));
+	CHECK(snap.Get(key, std::string("default")) == live.Get(key, std::string("default")));
+
+	const float3 def3(-1.0f, -2.0f, -3.0f);
+	const float4 def4(-1.0f, -2.0f, -3.0f, -4.0f);
+
+	CHECK(snap.Get(key, def3) == live.Get(key, def3));
+	CHECK(snap.Get(key, def4) == live.Get(key, def4));
+}
+
+static void CompareTables(const LuaTable& live, const LuaTable& snap, int depth)
+{
+	INFO("table " << live.GetPath());
+
+	REQUIRE(live.IsValid());
+	REQUIRE(snap.IsValid());
+	CHECK(snap.IsSnapshot());
+
+	CHECK(snap.GetLength() == live.GetLength());
+
+	std::vector<int> liveIntKeys, snapIntKeys;
+	std::vector<std::string> liveStrKeys, snapStrKeys;
+
+	CHECK(live.GetKeys(liveIntKeys));
+	CHECK(snap.GetKeys(snapIntKeys));
+	CHECK(snapIntKeys == liveIntKeys);
+	CHECK(live.GetKeys(liveStrKeys));
+	CHECK(snap.GetKeys(snapStrKeys));
+	CHECK(snapStrKeys == liveStrKeys);
+
+	{
+		std::vector<std::pair<int, std::string>> livePairs, snapPairs;
+
+		CHECK(snap.GetPairs(snapPairs) == live.GetPairs(livePairs));
+		CHECK(snapPairs == livePairs);
+	}
+	{
+		std::vector<std::pair<std::string, float>> livePairs, snapPairs;
+
+		CHECK(snap.GetPairs(snapPairs) == live.GetPairs(livePairs));
+		CHECK(snapPairs == livePairs);
+	}
+	{
+		std::vector<std::pair<std::string, std::string>> livePairs, snapPairs;
+
+		CHECK(snap.GetPairs(snapPairs) == live.GetPairs(livePairs));
+		CHECK(snapPairs == livePairs);
+	}
+
+	{
+		spring::unordered_map<int, float> liveMap, snapMap;
+
+		CHECK(snap.GetMap(snapMap) == live.GetMap(liveMap));
+		CHECK((ToMap<int, float>(snapMap) == ToMap<int, float>(liveMap)));
+	}
+	{
+		spring::unordered_map<int, std::string> liveMap, snapMap;
+
+		CHECK(snap.GetMap(snapMap) == live.GetMap(liveMap));
+		CHECK((ToMap<int, std::string>(snapMap) == ToMap<int, std::string>(liveMap)));
+	}
+	{
+		spring::unordered_map<std::string, float> liveMap, snapMap;
+
+		CHECK(snap.GetMap(snapMap) == live.GetMap(liveMap));
+		CHECK((ToMap<std::string, float>(snapMap) == ToMap<std::string, float>(liveMap)));
+	}
+	{
+		spring::unordered_map<std::string, std::string> liveMap, snapMap;
+
+		CHECK(snap.GetMap(snapMap) == live.GetMap(liveMap));
+		CHECK((ToMap<std::string, std::string>(snapMap) == ToMap<std::string, std::string>(liveMap)));
+	}
+
+	for (const int key: INT_PROBES) {
+		CompareValue(live, snap, key);
+	}
+	for (const int key: liveIntKeys) {
+		CompareValue(live, snap, key);
+	}
+	for (const std::string& key: STRING_PROBES) {
+		CompareValue(live, snap, key);
+	}
+	for (const std::string& key: liveStrKeys) {
+		CompareValue(live, snap, key);
+	}
+
+	// the chunk contains a cycle
+	if (depth == 0)
+		return;
+
+	for (const int key: liveIntKeys) {
+		const LuaTable liveSubTable = live.SubTable(key);
+
+		if (liveSubTable.IsValid())
+			CompareTables(liveSubTable, snap.SubTable(key), depth - 1);
+	}
+	for (const std::string& key: liveStrKeys) {
+		const LuaTable liveSubTable = live.SubTable(key);
+
+		if (liveSubTable.IsValid())
+			CompareTables(liveSubTable, snap.SubTable(key), depth - 1);
+	}
+}
+
+
+struct SpringTimeInit {
+	// Lua's random seed is taken from the start-time
+	SpringTimeInit() {
+		spring_clock::PushTickRate();
+		spring_time::setstarttime(spring_time::gettime(true));
+	}
+};
+
+static SpringTimeInit springTimeInit;
+
+
+static void SetupParser(LuaParser& parser, bool lowerCppKeys)
+{
+	// key-lowering on the Lua side is not part of this test (see NullLuaParserEnv)
+	parser.SetLowerKeys(false);
+	parser.SetLowerCppKeys(lowerCppKeys);
+
+	REQUIRE(parser.Execute());
+}
+
+
+TEST_CASE("LuaTableSnapshot")
+{
+	for (const bool lowerCppKeys: {true, false}) {
+		INFO("lowerCppKeys " << lowerCppKeys);
+
+		LuaParser liveParser(TEST_CHUNK, SPRING_VFS_ZIP, 0, {true}, {true});
+		LuaParser snapParser(TEST_CHUNK, SPRING_VFS_ZIP, 0, {true}, {true});
+		// restored without ever running Lua
+		LuaParser readParser(TEST_CHUNK, SPRING_VFS_ZIP, 0, {true}, {false});
+
+		SetupParser(liveParser, lowerCppKeys);
+		SetupParser(snapParser, lowerCppKeys);
+
+		const LuaTable liveRoot = liveParser.GetRoot();
+
+		REQUIRE_FALSE(liveRoot.IsSnapshot());
+		REQUIRE(snapParser.CreateSnapshot());
+
+		std::vector<std::uint8_t> buffer;
+		REQUIRE(snapParser.WriteSnapshot(buffer));
+
+		SECTION("created") {
+			CompareTables(liveRoot, snapParser.GetRoot(), 3);
+		}
+
+		SECTION("serialized") {
+			REQUIRE(readParser.ReadSnapshot(buffer.data(), buffer.size()));
+			CompareTables(liveRoot, readParser.GetRoot(), 3);
+
+			// serializing is deterministic
+			std::vector<std::uint8_t> rewritten;
+			REQUIRE(readParser.WriteSnapshot(rewritten));
+			CHECK(rewritten == buffer);
+		}
+
+		SECTION("truncated") {
+			for (size_t size = 0; size < buffer.size(); size++) {
+				CHECK_FALSE(readParser.ReadSnapshot(buffer.data(), size));
+			}
+
+			CHECK_FALSE(readParser.GetRoot().IsSnapshot());
+		}
+
+		SECTION("trailing data") {
+			buffer.push_back(0);
+			CHECK_FALSE(readParser.ReadSnapshot(buffer.data(), buffer.size()));
+		}
+
+		SECTION("corrupt") {
+			std::vector<std::uint8_t> corrupt = buffer;
+
+			// no nodes, more values than bytes
+			std::fill(corrupt.begin(), corrupt.begin() + 4, 0);
+			CHECK_FALSE(readParser.ReadSnapshot(corrupt.data(), corrupt.size()));
+			std::fill(corrupt.begin(), corrupt.begin() + 8, 0xff);
+			CHECK_FALSE(readParser.ReadSnapshot(corrupt.data(), corrupt.size()));
+
+			// the cache file hash catches changed contents; what is left for
+			// the snapshot is that every single-byte change is either rejected
+			// or yields one that can be traversed without reading out of bounds
+			for (size_t offset = 0; offset < buffer.size(); offset++) {
+				corrupt = buffer;
+				corrupt[offset] ^= 0xff;
+
+				LuaParser corruptParser(TEST_CHUNK, SPRING_VFS_ZIP, 0, {true}, {false});
+
+				if (!corruptParser.ReadSnapshot(corrupt.data(), corrupt.size()))
+					continue;
+
+				const LuaTable root = corruptParser.GetRoot();
+
+				std::vector<std::string> keys;
+				root.GetKeys(keys);
+
+				for (const std::string& key: keys) {
+					root.SubTable(key).GetLength();
+					root.Get(key, std::string());
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,150 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <cstring>
+#include <vector>
+
+#include "Map/SMF/SMFTileStreamer.h"
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+
+static constexpr int NUM_TILES = 16;
+static constexpr int MIP_OFFSETS[] = {0, 512, 512 + 128, 512 + 128 + 32};
+
+// every byte of a tile encodes its index and the offset within the tile
+static std::uint8_t GetTileByte(int tileIdx, int offset) { return ((tileIdx * 7 + offset) & 0xff); }
+
+static void InitStreamer(CSMFTileStreamer& streamer, int numSquaresX, int numSquaresY, size_t maxMemory)
+{
+	std::vector<std::uint8_t> buffer(NUM_TILES * SMALL_TILE_SIZE + 32);
+
+	for (int i = 0; i < NUM_TILES; i++) {
+		for (int j = 0; j < SMALL_TILE_SIZE; j++) {
+			buffer[32 + i * SMALL_TILE_SIZE + j] = GetTileByte(i, j);
+		}
+	}
+
+	streamer.Init(numSquaresX, numSquaresY, maxMemory);
+	streamer.AddTiles(std::move(buffer), 32, NUM_TILES);
+	streamer.AddMissingTiles(1);
+
+	std::vector<int>& tileMap = streamer.GetTileMap();
+
+	for (size_t i = 0; i < tileMap.size(); i++) {
+		tileMap[i] = (i * 5) % (NUM_TILES + 1);
+	}
+}
+
+
+
+TEST_CASE("SMFTileStreamer")
+{
+	SECTION("square layout") {
+		CSMFTileStreamer streamer;
+		InitStreamer(streamer, 2, 2, 0);
+
+		const std::vector<int>& tileMap = streamer.GetTileMap();
+		const int tileMapSizeX = 2 * CSMFTileStreamer::SQUARE_TILES;
+
+		for (int mipLevel = 0; mipLevel < CSMFTileStreamer::NUM_MIP_LEVELS; mipLevel++) {
+			std::vector<std::uint8_t> square(CSMFTileStreamer::GetSquareSize(mipLevel));
+
+			streamer.ExtractSquareTiles(1, 1, mipLevel, square.data());
+
+			// a square is one texture of (8 >> mipLevel) DXT1 blocks per tile
+			// and row; block (bx, by) of the square is 8 bytes at index bx +
+			// by * blocksPerRow
+			const int tileBlocks = 8 >> mipLevel;
+			const int blocksPerRow = tileBlocks * CSMFTileStreamer::SQUARE_TILES;
+
+			bool match = true;
+
+			for (int by = 0; by < blocksPerRow; by++) {
+				for (int bx = 0; bx < blocksPerRow; bx++) {
+					const int tileX = CSMFTileStreamer::SQUARE_TILES + bx / tileBlocks;
+					const int tileY = CSMFTileStreamer::SQUARE_TILES + by / tileBlocks;
+					const int tileIdx = tileMap[tileY * tileMapSizeX + tileX];
+					const int tileOfs = MIP_OFFSETS[mipLevel] + ((by % tileBlocks) * tileBlocks + (bx % tileBlocks)) * 8;
+
+					for (int k = 0; k < 8; k++) {
+						const std::uint8_t expected = (tileIdx == NUM_TILES)? 0xaa: GetTileByte(tileIdx, tileOfs + k);
+						match &= (square[(by * blocksPerRow + bx) * 8 + k] == expected);
+					}
+				}
+			}
+
+			CHECK(match);
+		}
+	}
+
+	SECTION("budget and eviction") {
+		const size_t sizeL0 = CSMFTileStreamer::GetSquareSize(0);
+		const size_t sizeL1 = CSMFTileStreamer::GetSquareSize(1);
+
+		CSMFTileStreamer streamer;
+		InitStreamer(streamer, 2, 1, sizeL0 * 2);
+
+		// decodes run synchronously without a thread-pool
+		CHECK(streamer.RequestSquare(0, 0, 1));
+		CHECK(streamer.RequestSquare(1, 0, 2));
+		// already waiting, only moves it up in the LRU order
+		CHECK(streamer.RequestSquare(0, 0, 3));
+
+		CSMFTileStreamer::Stats stats = streamer.GetStats();
+		CHECK(stats.numRequested == 2);
+		CHECK(stats.numDecoded == 2);
+		CHECK(stats.numWaiting == 2);
+		CHECK(stats.usedMemory == sizeL0 * 2);
+
+		// does not fit, evicts square 1 which was requested least recently
+		CHECK(streamer.RequestSquare(0, 1, 4));
+
+		stats = streamer.GetStats();
+		CHECK(stats.numEvicted == 1);
+		CHECK(stats.usedMemory == (sizeL0 + sizeL1));
+		CHECK(stats.peakMemory == sizeL0 * 2);
+
+		int sqrIdx = -1;
+		int mipLevel = -1;
+		std::vector<std::uint8_t> data;
+		std::vector<std::uint8_t> expected(sizeL1);
+
+		CHECK(streamer.TakeSquare(sqrIdx, mipLevel, data));
+		CHECK(sqrIdx == 0);
+		CHECK(mipLevel == 0);
+		CHECK(data.size() == sizeL0);
+
+		CHECK(streamer.TakeSquare(sqrIdx, mipLevel, data));
+		CHECK(sqrIdx == 0);
+		CHECK(mipLevel == 1);
+
+		streamer.ExtractSquareTiles(0, 0, 1, expected.data());
+		CHECK(data == expected);
+
+		CHECK_FALSE(streamer.TakeSquare(sqrIdx, mipLevel, data));
+
+		stats = streamer.GetStats();
+		CHECK(stats.numTaken == 2);
+		CHECK(stats.numWaiting == 0);
+		CHECK(stats.usedMemory == 0);
+	}
+
+	SECTION("rejection") {
+		const size_t sizeL1 = CSMFTileStreamer::GetSquareSize(1);
+		const size_t sizeL2 = CSMFTileStreamer::GetSquareSize(2);
+
+		CSMFTileStreamer streamer;
+		InitStreamer(streamer, 1, 1, sizeL1);
+
+		// larger than the whole budget
+		CHECK_FALSE(streamer.RequestSquare(0, 0, 1));
+		CHECK(streamer.RequestSquare(0, 1, 1));
+		CHECK(streamer.RequestSquare(0, 2, 2));
+
+		const CSMFTileStreamer::Stats stats = streamer.GetStats();
+		CHECK(stats.numRejected == 1);
+		CHECK(stats.numEvicted == 1);
+		CHECK(stats.usedMemory == sizeL2);
+	}
+}
@@ -0,0 +1,171 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <vector>
+
+#include "Map/HeightMapUpdateScheduler.h"
+#include "Sim/Misc/GlobalConstants.h"
+#include "System/float3.h"
+#include "System/Misc/SpringTime.h"
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+InitSpringTime ist;
+
+
+static bool operator == (const SRectangle& a, const SRectangle& b) {
+	return (a.x1 == b.x1 && a.z1 == b.z1 && a.x2 == b.x2 && a.z2 == b.z2);
+}
+
+static std::ostream& operator << (std::ostream& os, const SRectangle& r) {
+	return (os << "{" << r.x1 << ", " << r.z1 << ", " << r.x2 << ", " << r.z2 << "}");
+}
+
+static float3 HeightMapPos(int x, int z) {
+	return {x * SQUARE_SIZE * 1.0f, 0.0f, z * SQUARE_SIZE * 1.0f};
+}
+
+
+static void NoUpdate(const SRectangle&) {}
+
+// makes the scheduler's per-square time estimate non-zero
+static void SlowUpdate(const SRectangle&) {
+	const spring_time startTime = spring_gettime();
+
+	while ((spring_gettime() - startTime).toMilliSecsf() < 0.5f);
+}
+
+
+TEST_CASE("HeightMapUpdateScheduler")
+{
+	CHeightMapUpdateScheduler scheduler;
+	scheduler.Init();
+
+	SECTION("merging") {
+		// a run of touching strips, as pushed by the LOS-check
+		for (int z = 0; z < 64; z += 8) {
+			scheduler.Push({0, z, 200, z + 8});
+		}
+
+		// overlapping, but merging would mostly add area nobody asked for
+		scheduler.Push({195, 60, 1000, 70});
+		// too far from anything
+		scheduler.Push({500, 500, 510, 510});
+		// empty
+		scheduler.Push({600, 600, 600, 700});
+
+		CHECK(scheduler.size() == 3);
+
+		scheduler.Process(HeightMapPos(0, 0), -1.0f, NoUpdate);
+
+		const std::vector<SRectangle>& rects = scheduler.GetProcessedRects();
+
+		REQUIRE(rects.size() == 3);
+		CHECK(rects[0] == SRectangle(0, 0, 200, 64));
+		CHECK(rects[1] == SRectangle(195, 60, 1000, 70));
+		CHECK(rects[2] == SRectangle(500, 500, 510, 510));
+		CHECK(scheduler.empty());
+	}
+
+	SECTION("unlimited budget") {
+		// the initial full-map update is not cut into tiles
+		scheduler.Push({0, 0, 1024, 1024});
+		scheduler.Process(HeightMapPos(0, 0), 0.0f, SlowUpdate);
+
+		scheduler.Push({0, 0, 1024, 1024});
+		scheduler.Process(HeightMapPos(0, 0), -1.0f, NoUpdate);
+
+		REQUIRE(scheduler.GetProcessedRects().size() == 1);
+		CHECK(scheduler.GetProcessedRects()[0] == SRectangle(0, 0, 1024, 1024));
+		CHECK(scheduler.empty());
+	}
+
+	SECTION("within budget") {
+		scheduler.Push({0, 0, 64, 64});
+		scheduler.Process(HeightMapPos(0, 0), 0.0f, SlowUpdate);
+
+		scheduler.Push({0, 0, 256, 256});
+		scheduler.Process(HeightMapPos(0, 0), 1e9f, NoUpdate);
+
+		REQUIRE(scheduler.GetProcessedRects().size() == 1);
+		CHECK(scheduler.GetProcessedRects()[0] == SRectangle(0, 0, 256, 256));
+		CHECK(scheduler.GetStats().numUpdatedRects == 1);
+		CHECK(scheduler.GetStats().numPendingRects == 0);
+	}
+
+	SECTION("splitting") {
+		// unknown cost, first rectangle is processed as is
+		scheduler.Push({0, 0, 256, 256});
+		scheduler.Process(HeightMapPos(0, 0), 0.0f, SlowUpdate);
+
+		REQUIRE(scheduler.GetProcessedRects().size() == 1);
+		CHECK(scheduler.GetProcessedRects()[0] == SRectangle(0, 0, 256, 256));
+
+		// over budget, only the tile nearest to pos is taken
+		scheduler.Push({0, 0, 256, 256});
+		scheduler.Process(HeightMapPos(200, 100), 0.0f, NoUpdate);
+
+		REQUIRE(scheduler.GetProcessedRects().size() == 1);
+		CHECK(scheduler.GetProcessedRects()[0] == SRectangle(192, 64, 256, 128));
+		CHECK(scheduler.size() == 15);
+
+		// the remaining tiles are not merged again and all get done
+		scheduler.Process(HeightMapPos(200, 100), -1.0f, NoUpdate);
+
+		int area = 0;
+
+		for (const SRectangle& rect: scheduler.GetProcessedRects()) {
+			CHECK(rect.GetWidth() == CHeightMapUpdateScheduler::TILE_SIZE);
+			CHECK(rect.GetHeight() == CHeightMapUpdateScheduler::TILE_SIZE);
+			area += rect.GetArea();
+		}
+
+		CHECK(area == (256 * 256 - 64 * 64));
+		CHECK(scheduler.empty());
+	}
+
+	SECTION("ordering") {
+		scheduler.Push({900, 900, 910, 910});
+		scheduler.Push({100, 100, 110, 110});
+		scheduler.Push({500, 0, 510, 10});
+		scheduler.Push({0, 500, 10, 510});
+
+		std::vector<SRectangle> order;
+
+		// a budget of 0 still processes one rectangle per call
+		while (!scheduler.empty()) {
+			scheduler.Process(HeightMapPos(0, 0), 0.0f, NoUpdate);
+
+			REQUIRE(scheduler.GetProcessedRects().size() == 1);
+			order.push_back(scheduler.GetProcessedRects()[0]);
+		}
+
+		REQUIRE(order.size() == 4);
+		CHECK(order[0] == SRectangle(100, 100, 110, 110));
+		// equally far, pushed first
+		CHECK(order[1] == SRectangle(500, 0, 510, 10));
+		CHECK(order[2] == SRectangle(0, 500, 10, 510));
+		CHECK(order[3] == SRectangle(900, 900, 910, 910));
+	}
+
+	SECTION("aging") {
+		const SRectangle farRect = {1000, 0, 1010, 10};
+		const float farDist = HeightMapPos(1000, 0).x;
+
+		scheduler.Push(farRect);
+
+		int numCalls = 0;
+
+		// something new right under the camera every frame
+		for (; numCalls < 1000; numCalls++) {
+			scheduler.Push({0, 0, 10, 10});
+			scheduler.Process(HeightMapPos(0, 0), 0.0f, NoUpdate);
+
+			if (scheduler.GetProcessedRects()[0] == farRect)
+				break;
+		}
+
+		CHECK(numCalls > 0);
+		CHECK(numCalls <= int(farDist / CHeightMapUpdateScheduler::AGING_DISTANCE) + 1);
+	}
+}
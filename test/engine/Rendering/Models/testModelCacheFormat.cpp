@@ -0,0 +1,174 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Rendering/Models/ModelCacheFormat.h"
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+using ModelCacheFormat::ModelRecord;
+using ModelCacheFormat::PieceRecord;
+
+
+// stands in for SVertexData, the format only cares about its size
+struct TestVertex {
+	float pos[3];
+	std::uint8_t color[3];
+};
+
+struct TestPiece {
+	std::int32_t parentID;
+	std::string name;
+
+	std::vector<TestVertex> vertices;
+	std::vector<std::uint32_t> indices;
+};
+
+static std::vector<TestPiece> GetTestPieces()
+{
+	// root with two children, the second one has no geometry
+	return {
+		{-1, "base", {{{0.0f, 1.0f, 2.0f}, {1, 2, 3}}, {{3.0f, 4.0f, 5.0f}, {4, 5, 6}}, {{6.0f, 7.0f, 8.0f}, {7, 8, 9}}}, {0, 1, 2}},
+		{ 0, "turret", {{{9.0f, 9.5f, 9.75f}, {10, 11, 12}}}, {0, 0, 0, 0, 0}},
+		{ 0, "", {}, {}},
+	};
+}
+
+static std::vector<std::uint8_t> WriteTestModel(const std::vector<TestPiece>& pieces)
+{
+	std::vector<std::uint8_t> buffer;
+
+	ModelRecord modelRecord = {};
+
+	modelRecord.radius = 12.5f;
+	modelRecord.height = 30.0f;
+	modelRecord.mins[1] = -1.0f;
+	modelRecord.maxs[1] = 29.0f;
+
+	ModelCacheFormat::WriteModel(buffer, modelRecord, "tex1.dds", "tex2.png");
+
+	for (const TestPiece& piece: pieces) {
+		PieceRecord pieceRecord = {};
+
+		pieceRecord.parentID = piece.parentID;
+		pieceRecord.numVertices = piece.vertices.size();
+		pieceRecord.numIndices = piece.indices.size();
+		pieceRecord.nameSize = piece.name.size();
+		pieceRecord.offset[0] = piece.vertices.size() * 1.0f;
+		pieceRecord.volumeType = 3;
+		pieceRecord.volumeFlags[ModelCacheFormat::VOLUME_FLAG_PIECE_TREE] = 1;
+
+		ModelCacheFormat::WritePiece(buffer, pieceRecord, piece.name, piece.vertices.data(), sizeof(TestVertex), piece.indices.data());
+	}
+
+	return buffer;
+}
+
+static bool FindTestPieces(const std::vector<std::uint8_t>& buffer, size_t size, std::vector<size_t>& pieceOffsets)
+{
+	return (ModelCacheFormat::FindPieces(buffer.data(), size, GetTestPieces().size(), sizeof(TestVertex), pieceOffsets));
+}
+
+
+TEST_CASE("ModelCacheFormat")
+{
+	const std::vector<TestPiece> pieces = GetTestPieces();
+	const std::vector<std::uint8_t> buffer = WriteTestModel(pieces);
+
+	std::vector<size_t> pieceOffsets;
+
+	SECTION("round-trip") {
+		REQUIRE(FindTestPieces(buffer, buffer.size(), pieceOffsets));
+		REQUIRE(pieceOffsets.size() == pieces.size());
+
+		ModelRecord modelRecord;
+		std::string texs[2];
+
+		ModelCacheFormat::ReadModel(buffer.data(), modelRecord, texs[0], texs[1]);
+
+		CHECK(modelRecord.radius == 12.5f);
+		CHECK(modelRecord.height == 30.0f);
+		CHECK(modelRecord.mins[1] == -1.0f);
+		CHECK(modelRecord.maxs[1] == 29.0f);
+		CHECK(texs[0] == "tex1.dds");
+		CHECK(texs[1] == "tex2.png");
+
+		for (size_t i = 0; i < pieces.size(); i++) {
+			PieceRecord pieceRecord;
+			std::string name;
+
+			const std::uint8_t* vertices = nullptr;
+			const std::uint8_t* indices = nullptr;
+
+			ModelCacheFormat::ReadPiece(buffer.data(), pieceOffsets[i], sizeof(TestVertex), pieceRecord, name, vertices, indices);
+
+			CHECK(pieceRecord.parentID == pieces[i].parentID);
+			CHECK(pieceRecord.offset[0] == pieces[i].vertices.size() * 1.0f);
+			CHECK(pieceRecord.volumeType == 3);
+			CHECK(pieceRecord.volumeFlags[ModelCacheFormat::VOLUME_FLAG_PIECE_TREE] == 1);
+			CHECK(name == pieces[i].name);
+
+			REQUIRE(pieceRecord.numVertices == pieces[i].vertices.size());
+			REQUIRE(pieceRecord.numIndices == pieces[i].indices.size());
+
+			CHECK(std::memcmp(vertices, pieces[i].vertices.data(), pieces[i].vertices.size() * sizeof(TestVertex)) == 0);
+			CHECK(std::memcmp(indices, pieces[i].indices.data(), pieces[i].indices.size() * sizeof(std::uint32_t)) == 0);
+		}
+	}
+
+	SECTION("truncated") {
+		for (size_t size = 0; size < buffer.size(); size++) {
+			CHECK_FALSE(FindTestPieces(buffer, size, pieceOffsets));
+		}
+	}
+
+	SECTION("trailing data") {
+		std::vector<std::uint8_t> longer = buffer;
+		longer.resize(buffer.size() + 4, 0);
+
+		CHECK_FALSE(FindTestPieces(longer, longer.size(), pieceOffsets));
+	}
+
+	SECTION("piece count") {
+		CHECK_FALSE(ModelCacheFormat::FindPieces(buffer.data(), buffer.size(), 0, sizeof(TestVertex), pieceOffsets));
+		CHECK_FALSE(ModelCacheFormat::FindPieces(buffer.data(), buffer.size(), pieces.size() - 1, sizeof(TestVertex), pieceOffsets));
+		CHECK_FALSE(ModelCacheFormat::FindPieces(buffer.data(), buffer.size(), pieces.size() + 1, sizeof(TestVertex), pieceOffsets));
+		CHECK_FALSE(ModelCacheFormat::FindPieces(buffer.data(), buffer.size(), pieces.size(), sizeof(TestVertex) + 4, pieceOffsets));
+	}
+
+	SECTION("malformed tree") {
+		// second root, child before its parent, parent referring to itself
+		for (std::int32_t parentID: {-1, 2, 1}) {
+			std::vector<TestPiece> badPieces = pieces;
+			badPieces[1].parentID = parentID;
+
+			const std::vector<std::uint8_t> badBuffer = WriteTestModel(badPieces);
+
+			CHECK_FALSE(FindTestPieces(badBuffer, badBuffer.size(), pieceOffsets));
+		}
+
+		// root with a parent
+		std::vector<TestPiece> badPieces = pieces;
+		badPieces[0].parentID = 0;
+
+		const std::vector<std::uint8_t> badBuffer = WriteTestModel(badPieces);
+
+		CHECK_FALSE(FindTestPieces(badBuffer, badBuffer.size(), pieceOffsets));
+	}
+
+	SECTION("oversized section") {
+		std::vector<std::uint8_t> badBuffer = buffer;
+		PieceRecord pieceRecord;
+
+		REQUIRE(FindTestPieces(buffer, buffer.size(), pieceOffsets));
+
+		std::memcpy(&pieceRecord, &badBuffer[pieceOffsets[1]], sizeof(pieceRecord));
+		pieceRecord.numVertices = 0x40000000;
+		std::memcpy(&badBuffer[pieceOffsets[1]], &pieceRecord, sizeof(pieceRecord));
+
+		CHECK_FALSE(FindTestPieces(badBuffer, badBuffer.size(), pieceOffsets));
+	}
+}
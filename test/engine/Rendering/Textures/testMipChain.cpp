@@ -0,0 +1,121 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "Rendering/Textures/MipChain.h"
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+
+static std::vector<std::uint8_t> GetTestImage(int xsize, int ysize)
+{
+	std::vector<std::uint8_t> image(xsize * ysize * 4);
+
+	for (size_t i = 0; i < image.size(); i++) {
+		image[i] = (i * 37 + 11) & 0xff;
+	}
+
+	return image;
+}
+
+
+TEST_CASE("GetChainSize")
+{
+	CHECK(MipChain::GetChainSize(1, 1) == 4);
+	CHECK(MipChain::GetChainSize(2, 2) == (4 + 1) * 4);
+	CHECK(MipChain::GetChainSize(4, 4) == (16 + 4 + 1) * 4);
+	// non-square: 8x2, 4x1, 2x1, 1x1
+	CHECK(MipChain::GetChainSize(8, 2) == (16 + 4 + 2 + 1) * 4);
+	CHECK(MipChain::GetChainSize(1, 4) == (4 + 2 + 1) * 4);
+	// non-power-of-two: 5x3, 2x1, 1x1
+	CHECK(MipChain::GetChainSize(5, 3) == (15 + 2 + 1) * 4);
+	CHECK(MipChain::GetChainSize(1024, 1024) == ((size_t(1024) * 1024 * 4 - 1) / 3) * 4);
+}
+
+
+TEST_CASE("DownSample")
+{
+	SECTION("box-filter") {
+		// 2x2 -> 1x1, averages are rounded to nearest
+		const std::vector<std::uint8_t> src = {
+			  0,   0, 255, 10,    1,   0, 255, 20,
+			  2, 255, 255, 30,    2, 255,   0, 41,
+		};
+		std::uint8_t dst[4] = {};
+
+		MipChain::DownSample(src.data(), 2, 2, dst);
+
+		CHECK(int(dst[0]) == 1);
+		CHECK(int(dst[1]) == 128);
+		CHECK(int(dst[2]) == 191);
+		CHECK(int(dst[3]) == 25);
+	}
+
+	SECTION("odd sizes") {
+		// 3x1 -> 1x1, only the first two columns contribute; y is clamped
+		const std::vector<std::uint8_t> src = {
+			 10,  20,  30,  40,   30,  40,  50,  60,   255, 255, 255, 255,
+		};
+		std::uint8_t dst[4] = {};
+
+		MipChain::DownSample(src.data(), 3, 1, dst);
+
+		CHECK(int(dst[0]) == 20);
+		CHECK(int(dst[1]) == 30);
+		CHECK(int(dst[2]) == 40);
+		CHECK(int(dst[3]) == 50);
+	}
+
+	SECTION("uniform") {
+		const std::vector<std::uint8_t> src(7 * 5 * 4, 77);
+		std::vector<std::uint8_t> dst(3 * 2 * 4, 0);
+
+		MipChain::DownSample(src.data(), 7, 5, dst.data());
+
+		for (std::uint8_t value: dst) {
+			CHECK(int(value) == 77);
+		}
+	}
+}
+
+
+TEST_CASE("Create")
+{
+	for (const auto& size: std::vector< std::pair<int, int> >{{1, 1}, {4, 4}, {8, 2}, {5, 3}, {1, 7}}) {
+		const int xsize = size.first;
+		const int ysize = size.second;
+
+		const std::vector<std::uint8_t> image = GetTestImage(xsize, ysize);
+
+		// filled with garbage, Create has to replace all of it
+		std::vector<std::uint8_t> chain(3, 0xff);
+
+		MipChain::Create(image.data(), xsize, ysize, chain);
+
+		REQUIRE(chain.size() == MipChain::GetChainSize(xsize, ysize));
+
+		// level 0 is the source, every further level is DownSample of the previous one
+		CHECK(std::equal(image.begin(), image.end(), chain.begin()));
+
+		size_t offset = 0;
+
+		for (int x = xsize, y = ysize; x > 1 || y > 1; x = std::max(x >> 1, 1), y = std::max(y >> 1, 1)) {
+			const size_t nextOffset = offset + size_t(x) * y * 4;
+			const size_t nextSize = size_t(std::max(x >> 1, 1)) * std::max(y >> 1, 1) * 4;
+
+			std::vector<std::uint8_t> level(nextSize, 0);
+			MipChain::DownSample(&chain[offset], x, y, level.data());
+
+			CHECK(std::equal(level.begin(), level.end(), chain.begin() + nextOffset));
+
+			offset = nextOffset;
+		}
+
+		// ends with the 1x1 level
+		CHECK((offset + 4) == chain.size());
+	}
+}
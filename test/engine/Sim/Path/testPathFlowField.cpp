@@ -0,0 +1,72 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Sim/Path/Default/PathFlowField.hpp"
+#include "Sim/MoveTypes/MoveMath/MoveMath.h"
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+
+// only reached through PathFlowField::GetPath
+float CMoveMath::yLevel(const MoveDef& moveDef, int xSqr, int zSqr) { return 0.0f; }
+
+
+class PathFlowFieldTests {
+public:
+	static void AddField(PathFlowField& flowField, std::uint64_t key, const int2& minBlock, const int2& maxBlock) {
+		PathFlowField::Field& field = flowField.fields[key];
+
+		field.goalBlock = minBlock;
+		field.minBlock = minBlock;
+		field.maxBlock = maxBlock;
+	}
+
+	static bool HasField(const PathFlowField& flowField, std::uint64_t key) {
+		return (flowField.fields.find(key) != flowField.fields.end());
+	}
+};
+
+
+TEST_CASE("PathFlowField")
+{
+	PathFlowField flowField;
+
+	// two fields over [2,2]-[5,6] and [10,0]-[20,4]
+	PathFlowFieldTests::AddField(flowField, 1, {2, 2}, {5, 6});
+	PathFlowFieldTests::AddField(flowField, 2, {10, 0}, {20, 4});
+
+	REQUIRE(flowField.GetNumFields() == 2);
+
+	SECTION("unrelated update") {
+		flowField.Invalidate({0, 0}, {1, 1});
+		flowField.Invalidate({6, 0}, {9, 20});
+		flowField.Invalidate({2, 7}, {5, 7});
+		flowField.Invalidate({21, 0}, {30, 30});
+
+		CHECK(flowField.GetNumFields() == 2);
+	}
+
+	SECTION("overlapping update") {
+		flowField.Invalidate({4, 6}, {4, 6});
+
+		CHECK_FALSE(PathFlowFieldTests::HasField(flowField, 1));
+		CHECK(PathFlowFieldTests::HasField(flowField, 2));
+
+		// corner blocks are part of the field
+		flowField.Invalidate({20, 4}, {25, 9});
+
+		CHECK(flowField.GetNumFields() == 0);
+	}
+
+	SECTION("enclosing update") {
+		flowField.Invalidate({0, 0}, {30, 30});
+
+		CHECK(flowField.GetNumFields() == 0);
+	}
+
+	SECTION("update covering both") {
+		flowField.Invalidate({5, 3}, {10, 3});
+
+		CHECK(flowField.GetNumFields() == 0);
+	}
+}
@@ -0,0 +1,109 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <cstddef>
+#include <cstring>
+
+#include "Game/GlobalUnsynced.h"
+#include "Sim/Projectiles/ExpGenSpawnTemplate.h"
+#include "Sim/Projectiles/ExpGenSpawnableMemberInfo.h"
+#include "System/float3.h"
+#include "System/Misc/SpringTime.h"
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+InitSpringTime ist;
+CGlobalUnsyncedRNG guRNG;
+
+
+// stand-in for a spawnable, laid out like the usual CEG classes
+struct TestSpawnable {
+	float3 pos;
+	float3 speed;
+	float size;
+	float sizeGrowth;
+	float alpha;
+	int ttl;
+	std::int8_t useAirLos;
+	void* texture;
+};
+
+static int dummyTexture = 0;
+
+static SExpGenSpawnableMemberInfo GetMemberInfo(const char* name)
+{
+	const auto PtrCallback = [](const std::string&) -> void* { return &dummyTexture; };
+
+	#define MEMBER_INFO(member, type, length) \
+		SExpGenSpawnableMemberInfo{offsetof(TestSpawnable, member), sizeof(TestSpawnable::member) / (length), (length), 0, SExpGenSpawnableMemberInfo::type, nullptr}
+
+	if (std::strcmp(name, "pos"       ) == 0) return MEMBER_INFO(pos       , TYPE_FLOAT, 3);
+	if (std::strcmp(name, "speed"     ) == 0) return MEMBER_INFO(speed     , TYPE_FLOAT, 3);
+	if (std::strcmp(name, "size"      ) == 0) return MEMBER_INFO(size      , TYPE_FLOAT, 1);
+	if (std::strcmp(name, "sizeGrowth") == 0) return MEMBER_INFO(sizeGrowth, TYPE_FLOAT, 1);
+	if (std::strcmp(name, "alpha"     ) == 0) return MEMBER_INFO(alpha     , TYPE_FLOAT, 1);
+	if (std::strcmp(name, "ttl"       ) == 0) return MEMBER_INFO(ttl       , TYPE_INT  , 1);
+	if (std::strcmp(name, "useAirLos" ) == 0) return MEMBER_INFO(useAirLos , TYPE_INT  , 1);
+
+	#undef MEMBER_INFO
+
+	SExpGenSpawnableMemberInfo info{offsetof(TestSpawnable, texture), sizeof(void*), 1, 0, SExpGenSpawnableMemberInfo::TYPE_PTR, PtrCallback};
+	return info;
+}
+
+static void AddProperty(CExpGenSpawnTemplate& spawnTemplate, const char* name, const char* script)
+{
+	spawnTemplate.AddProperty(script, GetMemberInfo(name));
+}
+
+
+
+TEST_CASE("ExpGenSpawnTemplate")
+{
+	SECTION("constant folding") {
+		CExpGenSpawnTemplate spawnTemplate;
+		TestSpawnable s;
+
+		AddProperty(spawnTemplate, "size", "2 4 p2");
+		AddProperty(spawnTemplate, "sizeGrowth", "-0.5");
+		AddProperty(spawnTemplate, "ttl", "12.7");
+		AddProperty(spawnTemplate, "useAirLos", "1");
+		AddProperty(spawnTemplate, "alpha", "0");
+
+		// one constant and one store per property, none for the zero
+		CHECK(spawnTemplate.GetNumInstrs() == 9);
+		CHECK_FALSE(spawnTemplate.UsesBuffer());
+
+		std::memset(static_cast<void*>(&s), 0xff, sizeof(s));
+		spawnTemplate.Execute(reinterpret_cast<char*>(&s), 0.0f, 0, ZeroVector);
+
+		CHECK(s.size == 36.0f);
+		CHECK(s.sizeGrowth == -0.5f);
+		CHECK(s.ttl == 12);
+		CHECK(s.useAirLos == 1);
+		CHECK(s.alpha == 0.0f);
+	}
+
+	SECTION("dynamic operands") {
+		CExpGenSpawnTemplate spawnTemplate;
+		TestSpawnable s;
+
+		AddProperty(spawnTemplate, "pos", "0, 1 i2, -3 d0.5");
+		AddProperty(spawnTemplate, "speed", "dir");
+		AddProperty(spawnTemplate, "size", "3 y1 2 x1");
+		AddProperty(spawnTemplate, "alpha", "a1 1");
+		AddProperty(spawnTemplate, "texture", "somefx");
+
+		CHECK(spawnTemplate.UsesBuffer());
+
+		std::memset(static_cast<void*>(&s), 0, sizeof(s));
+		spawnTemplate.Execute(reinterpret_cast<char*>(&s), 10.0f, 3, UpVector);
+
+		CHECK(s.pos == float3(0.0f, 7.0f, 2.0f));
+		CHECK(s.speed == UpVector);
+		CHECK(s.size == 6.0f);
+		// buffer is shared by all properties of a spawn
+		CHECK(s.alpha == 4.0f);
+		CHECK(s.texture == &dummyTexture);
+	}
+}
@@ -0,0 +1,213 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "System/BinaryBuffer.h"
+#include "System/FileSystem/CacheFile.h"
+#include "System/FileSystem/FileSystem.h"
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+
+static constexpr char TEST_MAGIC[8] = {'S', 'P', 'R', 'I', 'N', 'G', 'T', 'T'};
+static constexpr char TEST_FILE[] = "testCacheFile.bin";
+
+struct TestInfo {
+	std::int32_t a;
+	float b;
+	std::uint8_t c[4];
+};
+
+static std::vector<std::uint8_t> SerializeTestData()
+{
+	std::vector<std::uint8_t> buffer;
+	BinaryWriter writer(buffer);
+
+	writer.Write(std::uint32_t(3));
+	writer.WriteString("first");
+	writer.WriteString("");
+	writer.WriteString(std::string("with\0nul", 8));
+	writer.Write(1.5f);
+	writer.Write(std::int8_t(-7));
+	return buffer;
+}
+
+static bool DeserializeTestData(const std::uint8_t* data, size_t size, std::vector<std::string>& strings)
+{
+	BinaryReader reader(data, size);
+
+	std::uint32_t numStrings = 0;
+	float f = 0.0f;
+	std::int8_t i = 0;
+
+	if (!reader.Read(numStrings) || numStrings > size)
+		return false;
+
+	strings.resize(numStrings);
+
+	for (std::string& str: strings) {
+		if (!reader.ReadString(str))
+			return false;
+	}
+
+	if (!reader.Read(f) || !reader.Read(i))
+		return false;
+
+	return (f == 1.5f && i == -7 && reader.AtEnd());
+}
+
+static void FlipByte(size_t offset)
+{
+	FILE* file = fopen(TEST_FILE, "r+b");
+	REQUIRE(file != nullptr);
+
+	fseek(file, offset, SEEK_SET);
+	const int value = fgetc(file);
+	fseek(file, offset, SEEK_SET);
+	fputc(value ^ 0xff, file);
+	fclose(file);
+}
+
+static void TruncateFile(size_t size)
+{
+	std::vector<char> contents(size);
+
+	FILE* file = fopen(TEST_FILE, "rb");
+	REQUIRE(file != nullptr);
+	REQUIRE(fread(contents.data(), 1, size, file) == size);
+	fclose(file);
+
+	file = fopen(TEST_FILE, "wb");
+	REQUIRE(file != nullptr);
+	fwrite(contents.data(), 1, size, file);
+	fclose(file);
+}
+
+
+TEST_CASE("BinaryBuffer")
+{
+	const std::vector<std::uint8_t> buffer = SerializeTestData();
+
+	std::vector<std::string> strings;
+
+	SECTION("round-trip") {
+		REQUIRE(DeserializeTestData(buffer.data(), buffer.size(), strings));
+		REQUIRE(strings.size() == 3);
+		CHECK(strings[0] == "first");
+		CHECK(strings[1].empty());
+		CHECK(strings[2] == std::string("with\0nul", 8));
+	}
+
+	SECTION("truncated") {
+		for (size_t size = 0; size < buffer.size(); size++) {
+			CHECK_FALSE(DeserializeTestData(buffer.data(), size, strings));
+		}
+	}
+
+	SECTION("oversized string") {
+		std::vector<std::uint8_t> corrupt = buffer;
+
+		// length of "first"
+		corrupt[sizeof(std::uint32_t)] = 0xff;
+		CHECK_FALSE(DeserializeTestData(corrupt.data(), corrupt.size(), strings));
+	}
+}
+
+
+TEST_CASE("CacheFile")
+{
+	const std::vector<std::uint8_t> data = SerializeTestData();
+	const TestInfo writeInfo = {42, 0.25f, {1, 2, 3, 4}};
+
+	FileSystem::Remove(TEST_FILE);
+	REQUIRE(CCacheFile::Write(TEST_FILE, TEST_MAGIC, 1, 0x1234, writeInfo, data.data(), data.size()));
+
+	const size_t dataOffset = CCacheFile::GetDataOffset(sizeof(TestInfo));
+
+	CHECK((dataOffset % CCacheFile::DATA_ALIGNMENT) == 0);
+	CHECK(FileSystem::GetFileSize(TEST_FILE) == (dataOffset + data.size()));
+
+	CCacheFile cacheFile;
+	TestInfo readInfo;
+
+	SECTION("round-trip") {
+		std::vector<std::string> strings;
+
+		REQUIRE(cacheFile.Open(TEST_FILE, TEST_MAGIC, 1, 0x1234, readInfo));
+		CHECK(std::memcmp(&readInfo, &writeInfo, sizeof(TestInfo)) == 0);
+		CHECK(cacheFile.GetDataSize() == data.size());
+		CHECK(std::memcmp(cacheFile.GetData(), data.data(), data.size()) == 0);
+		CHECK(DeserializeTestData(cacheFile.GetData(), cacheFile.GetDataSize(), strings));
+	}
+
+	SECTION("mismatch") {
+		CHECK_FALSE(cacheFile.Open(TEST_FILE, TEST_MAGIC, 2, 0x1234, readInfo));
+		CHECK_FALSE(cacheFile.Open(TEST_FILE, TEST_MAGIC, 1, 0x1235, readInfo));
+		CHECK_FALSE(cacheFile.Open(TEST_FILE, TEST_MAGIC, 1, 0x1234, sizeof(TestInfo) + 4));
+		CHECK_FALSE(cacheFile.Open(TEST_FILE, "SPRINGXX", 1, 0x1234, readInfo));
+
+		// nothing was wrong with the file itself
+		CHECK(cacheFile.Open(TEST_FILE, TEST_MAGIC, 1, 0x1234, readInfo));
+	}
+
+	SECTION("corrupt") {
+		// the hash covers every byte but the padding
+		const size_t fileSize = FileSystem::GetFileSize(TEST_FILE);
+
+		for (size_t offset = 0; offset < fileSize; offset++) {
+			if (offset >= (sizeof(CCacheFile::Header) + sizeof(TestInfo)) && offset < dataOffset)
+				continue;
+
+			REQUIRE(CCacheFile::Write(TEST_FILE, TEST_MAGIC, 1, 0x1234, writeInfo, data.data(), data.size()));
+			FlipByte(offset);
+
+			CHECK_FALSE(cacheFile.Open(TEST_FILE, TEST_MAGIC, 1, 0x1234, readInfo));
+		}
+
+		CHECK_FALSE(cacheFile.Remove());
+		CHECK_FALSE(FileSystem::FileExists(TEST_FILE));
+	}
+
+	SECTION("truncated") {
+		const size_t fileSize = FileSystem::GetFileSize(TEST_FILE);
+
+		for (size_t size : {size_t(0), sizeof(CCacheFile::Header) - 1, dataOffset, fileSize - 1}) {
+			REQUIRE(CCacheFile::Write(TEST_FILE, TEST_MAGIC, 1, 0x1234, writeInfo, data.data(), data.size()));
+			TruncateFile(size);
+
+			CHECK_FALSE(cacheFile.Open(TEST_FILE, TEST_MAGIC, 1, 0x1234, readInfo));
+		}
+	}
+
+	SECTION("missing") {
+		FileSystem::Remove(TEST_FILE);
+
+		CHECK_FALSE(cacheFile.Open(TEST_FILE, TEST_MAGIC, 1, 0x1234, readInfo));
+		// nothing to delete
+		CHECK_FALSE(cacheFile.Remove());
+	}
+
+	#ifndef _WIN32
+	SECTION("replaced while open") {
+		REQUIRE(cacheFile.Open(TEST_FILE, TEST_MAGIC, 1, 0x1234, readInfo));
+
+		// a shorter file with other contents; the old mapping must stay intact
+		const std::vector<std::uint8_t> otherData = {1, 2, 3};
+		REQUIRE(CCacheFile::Write(TEST_FILE, TEST_MAGIC, 1, 0x1234, writeInfo, otherData.data(), otherData.size()));
+
+		CHECK(std::memcmp(cacheFile.GetData(), data.data(), data.size()) == 0);
+
+		CCacheFile newCacheFile;
+
+		REQUIRE(newCacheFile.Open(TEST_FILE, TEST_MAGIC, 1, 0x1234, readInfo));
+		CHECK(newCacheFile.GetDataSize() == otherData.size());
+	}
+	#endif
+
+	cacheFile.Close();
+	FileSystem::Remove(TEST_FILE);
+}
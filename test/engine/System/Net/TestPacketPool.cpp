@@ -0,0 +1,145 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Net/Protocol/BaseNetProtocol.h"
+#include "System/Net/PacketPool.h"
+#include "System/Net/RawPacket.h"
+#include "System/Net/UDPConnection.h"
+#include "System/GlobalConfig.h"
+#include "System/Log/ILog.h"
+#include "System/Misc/SpringTime.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+InitSpringTime ist;
+
+
+// every heap allocation made by the process goes through here
+static std::atomic<size_t> numHeapAllocs = {0};
+
+void* operator new(size_t size)
+{
+	numHeapAllocs.fetch_add(1, std::memory_order_relaxed);
+
+	if (void* p = std::malloc(size))
+		return p;
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+
+
+static constexpr int NUM_PLAYERS = 16;
+static constexpr int NUM_LUAMSGS = 8; // per player per frame
+static constexpr int NUM_WARMUP_FRAMES = 100;
+static constexpr int NUM_BENCH_FRAMES = 500;
+
+static constexpr int BASE_PORT = 23450;
+
+
+class ServerLoop {
+public:
+	ServerLoop() {
+		// benchmark the code, not the default throttle
+		globalConfig.linkOutgoingBandwidth = 0;
+
+		// each server-side link talks to one client-side link over loopback
+		for (int i = 0; i < NUM_PLAYERS; i++) {
+			serverLinks.emplace_back(new netcode::UDPConnection(BASE_PORT + i * 2 + 0, "127.0.0.1", BASE_PORT + i * 2 + 1));
+			clientLinks.emplace_back(new netcode::UDPConnection(BASE_PORT + i * 2 + 1, "127.0.0.1", BASE_PORT + i * 2 + 0));
+
+			serverLinks.back()->Unmute();
+			clientLinks.back()->Unmute();
+		}
+
+		luaMsgData.resize(200, 0x2A);
+	}
+
+	void RunFrame() {
+		for (int i = 0; i < NUM_PLAYERS; i++) {
+			for (int j = 0; j < NUM_LUAMSGS; j++) {
+				clientLinks[i]->SendData(CBaseNetProtocol::Get().SendLuaMsg(i, 0, 0, luaMsgData));
+			}
+
+			clientLinks[i]->Flush(true);
+		}
+
+		for (const auto& link: serverLinks) {
+			link->Update();
+
+			// what the server does for every NETMSG_LUAMSG; one packet, shared by all links
+			while (link->HasIncomingData()) {
+				Broadcast(link->GetData());
+			}
+		}
+
+		for (const auto& link: serverLinks) {
+			link->Flush(true);
+		}
+
+		for (const auto& link: clientLinks) {
+			link->Update();
+
+			while (link->HasIncomingData()) {
+				numReceived += (link->GetData() != nullptr);
+			}
+		}
+	}
+
+	void Broadcast(std::shared_ptr<const netcode::RawPacket> packet) {
+		for (const auto& link: serverLinks) {
+			link->SendData(packet);
+		}
+	}
+
+	size_t GetNumReceived() const { return numReceived; }
+
+private:
+	std::vector< std::unique_ptr<netcode::UDPConnection> > serverLinks;
+	std::vector< std::unique_ptr<netcode::UDPConnection> > clientLinks;
+
+	std::vector<std::uint8_t> luaMsgData;
+
+	size_t numReceived = 0;
+};
+
+
+
+TEST_CASE("PacketPool")
+{
+	ServerLoop loop;
+
+	for (int i = 0; i < NUM_WARMUP_FRAMES; i++) {
+		loop.RunFrame();
+	}
+
+	const size_t numHeapAllocsPre = numHeapAllocs.load();
+	const size_t numPoolAllocsPre = netcode::PacketPool::GetNumHeapAllocs();
+	const size_t numReceivedPre = loop.GetNumReceived();
+	const spring_time benchStartTime = spring_gettime();
+
+	for (int i = 0; i < NUM_BENCH_FRAMES; i++) {
+		loop.RunFrame();
+	}
+
+	const spring_time benchTime = spring_gettime() - benchStartTime;
+	const size_t numHeapAllocsBench = numHeapAllocs.load() - numHeapAllocsPre;
+	const size_t numPoolAllocsBench = netcode::PacketPool::GetNumHeapAllocs() - numPoolAllocsPre;
+	const size_t numReceivedBench = loop.GetNumReceived() - numReceivedPre;
+
+	LOG("[%s] %d frames, %d players, %zu packets received in %.1fms", __func__, NUM_BENCH_FRAMES, NUM_PLAYERS, numReceivedBench, benchTime.toMilliSecsf());
+	LOG("[%s] %zu heap allocations (%zu by the pool) in steady state", __func__, numHeapAllocsBench, numPoolAllocsBench);
+
+	CHECK(numReceivedBench == size_t(NUM_BENCH_FRAMES * NUM_PLAYERS * NUM_PLAYERS * NUM_LUAMSGS));
+	CHECK(numHeapAllocsBench == 0);
+}
+
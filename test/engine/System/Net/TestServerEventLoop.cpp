@@ -0,0 +1,206 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Net/Protocol/BaseNetProtocol.h"
+#include "Net/Protocol/NetMessageTypes.h"
+#include "System/Net/RawPacket.h"
+#include "System/Net/UDPConnection.h"
+#include "System/Net/UDPListener.h"
+#include "System/GlobalConfig.h"
+#include "System/Log/ILog.h"
+#include "System/Misc/SpringTime.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <time.h>
+#endif
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+InitSpringTime ist;
+
+
+static constexpr int NUM_CLIENTS = 48;
+static constexpr int NUM_FRAMES = 90; // three seconds at GAME_SPEED
+static constexpr int FRAME_TIME = 1000 / 30;
+static constexpr int SLEEP_TIME = 5; // ServerSleepTime default
+static constexpr int MAX_WAIT_TIME = 50;
+
+
+static float GetThreadCPUTime()
+{
+	#ifdef __linux__
+	timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return (ts.tv_sec * 1000.0f + ts.tv_nsec * 1e-6f);
+	#else
+	return 0.0f;
+	#endif
+}
+
+
+// simulates NUM_CLIENTS players; each answers every NEWFRAME with a
+// KEYFRAME, which is about the smallest sustained load a real one causes
+class LoadGenerator {
+public:
+	LoadGenerator(int serverPort) {
+		for (int i = 0; i < NUM_CLIENTS; i++) {
+			links.emplace_back(new netcode::UDPConnection(serverPort + 1 + i, "127.0.0.1", serverPort));
+			links.back()->Unmute();
+		}
+
+		numFramesRecv.resize(NUM_CLIENTS, 0);
+	}
+
+	void Start() { thread = std::thread([this]() { Run(); }); }
+	void Stop() { quit = true; thread.join(); }
+
+	int GetMinFramesReceived() const { return *std::min_element(numFramesRecv.begin(), numFramesRecv.end()); }
+
+private:
+	void Run() {
+		// the first packet of every link makes the server accept it
+		for (const auto& link: links) {
+			link->SendData(CBaseNetProtocol::Get().SendKeyFrame(-1));
+			link->Flush(true);
+		}
+
+		while (!quit) {
+			for (size_t i = 0; i < links.size(); i++) {
+				netcode::UDPConnection* link = links[i].get();
+
+				link->Update();
+
+				while (link->HasIncomingData()) {
+					const std::shared_ptr<const netcode::RawPacket> packet = link->GetData();
+
+					if (packet->data[0] != NETMSG_NEWFRAME)
+						continue;
+
+					link->SendData(CBaseNetProtocol::Get().SendKeyFrame(numFramesRecv[i]++));
+				}
+			}
+
+			spring_msecs(1).sleep(true);
+		}
+	}
+
+private:
+	std::vector< std::unique_ptr<netcode::UDPConnection> > links;
+	std::vector<int> numFramesRecv;
+
+	std::thread thread;
+	std::atomic<bool> quit = {false};
+};
+
+
+// CGameServer::UpdateLoop reduced to its networking; broadcasts a NEWFRAME
+// every FRAME_TIME milliseconds and consumes everything the clients send
+struct ServerStats {
+	float cpuTime = 0.0f;
+	int numIterations = 0;
+	int numFramesRecv = 0;
+};
+
+static ServerStats RunServer(int port, bool eventLoop)
+{
+	netcode::UDPListener listener(port, "127.0.0.1");
+	LoadGenerator loadGen(port);
+
+	std::vector< std::shared_ptr<netcode::UDPConnection> > links;
+
+	listener.SetBatchedSends(eventLoop);
+	loadGen.Start();
+
+	ServerStats stats;
+
+	const float startCPUTime = GetThreadCPUTime();
+	const spring_time startTime = spring_gettime();
+	// one second to connect, plus one to let the last frames arrive
+	const spring_time endTime = startTime + spring_msecs(2000 + NUM_FRAMES * FRAME_TIME);
+
+	spring_time nextFrameTime = startTime + spring_msecs(1000);
+
+	int numFramesSent = 0;
+	int waitTime = SLEEP_TIME;
+
+	while (spring_gettime() < endTime) {
+		if (eventLoop) {
+			listener.WaitForData(waitTime);
+		} else {
+			spring_msecs(SLEEP_TIME).sleep(true);
+		}
+
+		listener.Update();
+
+		while (listener.HasIncomingConnections()) {
+			links.push_back(listener.AcceptConnection());
+			links.back()->Unmute();
+		}
+
+		for (const auto& link: links) {
+			while (link->HasIncomingData()) {
+				link->GetData();
+			}
+		}
+
+		if (numFramesSent < NUM_FRAMES && spring_gettime() >= nextFrameTime) {
+			const std::shared_ptr<const netcode::RawPacket> packet = CBaseNetProtocol::Get().SendNewFrame();
+
+			for (const auto& link: links) {
+				link->SendData(packet);
+			}
+
+			numFramesSent += 1;
+			nextFrameTime += spring_msecs(FRAME_TIME);
+		}
+
+		stats.numIterations += 1;
+
+		if (!eventLoop)
+			continue;
+
+		listener.Update();
+
+		// same policy as CGameServer::GetEventLoopWaitTime
+		if (listener.HasUnsentData()) {
+			waitTime = SLEEP_TIME;
+		} else if (numFramesSent < NUM_FRAMES) {
+			waitTime = std::max(0, std::min(int(std::ceil((nextFrameTime - spring_gettime()).toMilliSecsf())), MAX_WAIT_TIME));
+		} else {
+			waitTime = MAX_WAIT_TIME;
+		}
+	}
+
+	stats.cpuTime = GetThreadCPUTime() - startCPUTime;
+
+	loadGen.Stop();
+
+	stats.numFramesRecv = loadGen.GetMinFramesReceived();
+	return stats;
+}
+
+
+
+TEST_CASE("ServerEventLoop")
+{
+	// benchmark the code, not the default throttle
+	globalConfig.linkOutgoingBandwidth = 0;
+
+	const ServerStats pollStats = RunServer(24450, false);
+	const ServerStats eventStats = RunServer(24550, true);
+
+	LOG("[%s] %d clients, %d frames", __func__, NUM_CLIENTS, NUM_FRAMES);
+	LOG("[%s] polling: %.1fms server CPU, %d loop iterations", __func__, pollStats.cpuTime, pollStats.numIterations);
+	LOG("[%s] event-loop: %.1fms server CPU, %d loop iterations", __func__, eventStats.cpuTime, eventStats.numIterations);
+
+	CHECK(pollStats.numFramesRecv == NUM_FRAMES);
+	CHECK(eventStats.numFramesRecv == NUM_FRAMES);
+}
+
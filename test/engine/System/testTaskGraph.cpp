@@ -0,0 +1,121 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "System/Threading/TaskGraph.h"
+#include "System/Threading/ThreadPool.h"
+#include "System/Threading/SpringThreading.h"
+#include "System/Log/ILog.h"
+#include "System/Misc/SpringTime.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+
+// Catch is not threadsafe
+#define SAFE_CHECK( P )                \
+	do {                                     \
+		std::lock_guard<spring::mutex> _(m); \
+		CHECK( (P) );                  \
+	} while (0);
+
+struct do_once {
+	do_once() { Threading::DetectCores(); } // make GetMaxThreads() work
+};
+
+InitSpringTime ist;
+do_once doonce;
+
+static spring::mutex m;
+
+
+TEST_CASE("test_ordered_tasks")
+{
+	ThreadPool::SetThreadCount(ThreadPool::GetMaxThreads());
+
+	CTaskGraph graph;
+	std::vector<int> order;
+
+	const auto callerID = spring::this_thread::get_id();
+
+	for (int i = 0; i < 8; i++) {
+		graph.AddTask("ordered", [&, i]() {
+			SAFE_CHECK(spring::this_thread::get_id() == callerID);
+			order.push_back(i);
+		});
+	}
+
+	graph.Run();
+
+	REQUIRE(order.size() == 8);
+
+	for (int i = 0; i < 8; i++) {
+		CHECK(order[i] == i);
+	}
+}
+
+TEST_CASE("test_dependencies")
+{
+	LOG("[%s::test_dependencies] {NUM,MAX}_THREADS={%d,%d}", __func__, ThreadPool::GetNumThreads(), ThreadPool::GetMaxThreads());
+
+	CTaskGraph graph;
+
+	std::atomic<int> numSlowDone = {0};
+	std::atomic<int> numFastDone = {0};
+	std::vector<int> slowIDs;
+
+	// independent slow tasks should overlap each other and the ordered ones
+	for (int i = 0; i < 4; i++) {
+		slowIDs.push_back(graph.AddAsyncTask("slow", [&]() {
+			spring_msecs(50).sleep(true);
+			numSlowDone += 1;
+		}));
+	}
+
+	const int fastID = graph.AddTask("fast", [&]() {
+		// without workers the slow tasks ran inline while being dispatched
+		SAFE_CHECK(numSlowDone.load() < 4 || !ThreadPool::HasThreads());
+		numFastDone += 1;
+	});
+
+	const int joinID = graph.AddAsyncTask("join", [&]() {
+		SAFE_CHECK(numSlowDone.load() == 4);
+		SAFE_CHECK(numFastDone.load() == 1);
+	}, {slowIDs[0], slowIDs[1], slowIDs[2], slowIDs[3], fastID});
+
+	graph.AddTask("last", [&]() {
+		SAFE_CHECK(graph.HasRun(joinID));
+	}, {joinID});
+
+	graph.Run();
+	graph.LogReport(__func__);
+
+	for (size_t i = 0; i < graph.GetNumTasks(); i++) {
+		CHECK(graph.HasRun(i));
+	}
+
+	if (ThreadPool::HasThreads())
+		CHECK(graph.GetTotalTime() < 4 * 50.0f);
+}
+
+TEST_CASE("test_failed_task")
+{
+	CTaskGraph graph;
+
+	std::atomic<int> numRun = {0};
+
+	const int failID = graph.AddAsyncTask("fail", []() { throw std::runtime_error("fail"); });
+	const int skipID = graph.AddTask("skip", [&]() { numRun += 1; }, {failID});
+	const int skip2ID = graph.AddAsyncTask("skip2", [&]() { numRun += 1; }, {skipID});
+	const int freeID = graph.AddTask("free", [&]() { numRun += 1; });
+
+	CHECK_THROWS_AS(graph.Run(), std::runtime_error);
+
+	CHECK(numRun.load() == 1);
+	CHECK(!graph.HasRun(failID));
+	CHECK(!graph.HasRun(skipID));
+	CHECK(!graph.HasRun(skip2ID));
+	CHECK(graph.HasRun(freeID));
+}
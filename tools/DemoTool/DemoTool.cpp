@@ -333,6 +333,11 @@ void TrafficDump(CDemoReader& reader, bool trafficStats)
 				if (*(unsigned short*)(buffer+1) != packet->length)
 					std::cout << "      packet length error: expected: " <<  *(unsigned short*)(buffer+1) << " got: " << packet->length << std::endl;
 				break;
+			case NETMSG_COMMANDS:
+				std::cout << "COMMANDS Playernum: " << (int)buffer[3];
+				std::cout << " Size: " << *(unsigned short*)(buffer+1);
+				std::cout << " Commands: " << *(unsigned short*)(buffer+4) << std::endl;
+				break;
 			case NETMSG_SELECT:
 				std::cout << "NETMGS_SELECT: Playernum: " << (unsigned)buffer[3];
 				std::cout << " Length: " << (unsigned)packet->length;